@@ -0,0 +1,134 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <lume/array_annex.h>
+#include <lume/mesh.h>
+
+namespace lume
+{
+
+namespace keys
+{
+  /// Hanging node constraints of tetrahedral meshes refined by `AdaptiveRefiner`.
+  /** Holds the two corners of the edge whose center coincides with a hanging vertex,
+    or `NO_INDEX` twice for regular vertices.*/
+  const TypedAnnexKey <IndexArrayAnnex> hangingNodeConstraints ("hangingNodeConstraints", VERTEX);
+}
+
+/// Adaptively refines the triangles or tetrahedra of a mesh in place.
+/** Triangle meshes are refined using red-green refinement.
+  Marked triangles are refined regularly (red) into 4 children. To keep the mesh
+  conforming, the marks are propagated: triangles with two or three split edges are
+  refined red as well, triangles with a single split edge are bisected (green).
+
+  Green triangles are never refined themselves. If a green triangle is marked or if
+  one of its edges has to be split, its green family is removed and the parent is
+  refined red instead.
+
+  The refiner stores side neighbors and green families of all triangles and updates
+  them locally. The cost of `refine` is thus proportional to the size of the refined
+  region and not to the size of the mesh. If the mesh is modified by other means
+  between two calls to `refine`, `reset` has to be called.
+
+  New vertices and triangles are appended to the mesh. The first child of each refined
+  triangle replaces its parent, i.e., it keeps the parent's index. Floating point
+  vertex annexes are interpolated at new vertices (integral annexes take the minimum
+  of the edge corners), triangle annexes are copied from parents to children.
+
+  Tetrahedra are refined regularly into 8 children as in `RefineMesh`. Their neighbors
+  are not closed, instead the centers of split edges which are still edges of coarser
+  tetrahedra remain as hanging vertices. The corners of those edges are stored in the
+  vertex annex `keys::hangingNodeConstraints`. Tetrahedra with hanging corners are only
+  refined together with the tetrahedra containing the constraining edge, so constraints
+  always reference regular vertices. The refiner stores the tetrahedra of each edge
+  and updates them locally. Children are stored and annexes are transferred as for
+  triangles.
+
+  \note Only meshes consisting of vertices and either triangles or tetrahedra are
+        supported. Each edge of a triangle mesh may be shared by at most two triangles.*/
+class AdaptiveRefiner
+{
+public:
+  explicit AdaptiveRefiner (SPMesh mesh);
+
+  /// Recomputes side neighbors and edges. Existing triangles are no longer considered green.
+  /** For tetrahedral meshes, hanging node constraints stored in the mesh are kept if
+    their constraining edge still exists.*/
+  void reset ();
+
+  SPMesh mesh () const    {return m_mesh;}
+
+  /// Refines the given elements and as many neighbors as required by the closure.
+  /** \{ */
+  void refine (std::vector <index_t> const& markedElems);
+
+  /// Elements `i` with `marks [i] == true` are refined.
+  void refine (std::vector <bool> const& marks);
+
+  /// Elements `i` with `marks [i] != 0` are refined.
+  void refine (IndexArrayAnnex const& marks);
+  /** \} */
+
+  /// The type of the refined elements, i.e., `TRI` or `TET`.
+  GrobType element_type () const  {return m_elemType;}
+
+  /// Returns true if the given triangle was created by a green bisection.
+  /** \note Only valid for triangle meshes.*/
+  bool is_green (index_t tri) const   {return m_greenSiblings [tri] != NO_INDEX;}
+
+  /// Returns the triangle adjacent to the given triangle at its side `side` or `NO_INDEX`.
+  /** \note Only valid for triangle meshes.*/
+  index_t neighbor (index_t tri, index_t side) const  {return m_neighbors [tri * 3 + side];}
+
+private:
+  using EdgeVertexMap = std::unordered_map <std::uint64_t, index_t>;
+  using EdgeElemMap = std::unordered_map <std::uint64_t, std::vector <index_t>>;
+
+  void reset_tets ();
+  void refine_tets (std::vector <index_t> const& markedTets);
+
+  void refine_pass (std::vector <index_t> const& redSeeds,
+                    std::vector <index_t>& touchedSeeds,
+                    std::vector <index_t>& extraAffected,
+                    EdgeVertexMap& edgeVertices);
+
+  index_t first_green_child (index_t tri) const;
+
+  SPMesh                m_mesh;
+  GrobType              m_elemType {TRI};
+  size_t                m_numElems {0};
+  std::vector <index_t> m_neighbors;
+  std::vector <index_t> m_greenSiblings;
+  /// tetrahedra containing each edge of a tetrahedral mesh
+  EdgeElemMap           m_edgeTets;
+  /// centers of split edges which are still edges of some tetrahedra, i.e., hanging vertices
+  EdgeVertexMap         m_edgeCenters;
+};
+
+}// end of namespace lume
@@ -84,6 +84,8 @@ namespace keys
     const TypedAnnexKey <ArrayAnnex <real_t>> vertexCoords  ("coords", VERTEX);
     const TypedAnnexKey <ArrayAnnex <real_t>> vertexNormals ("normal", VERTEX);
     const TypedAnnexKey <ArrayAnnex <real_t>> vertexUV      ("uv",     VERTEX);
+    const TypedAnnexKey <ArrayAnnex <real_t>> triNormals    ("normal", TRI);
+    const TypedAnnexKey <ArrayAnnex <real_t>> quadNormals   ("normal", QUAD);
 }
 
 inline std::string to_string (const AnnexKey& v) {
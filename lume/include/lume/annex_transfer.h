@@ -0,0 +1,79 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <lume/annex_key.h>
+#include <lume/hierarchy.h>
+
+namespace lume
+{
+
+/// Transfers the annexes of the parent mesh of a `Hierarchy` to its child mesh.
+/** By default, the following annexes are transferred:
+  - `ArrayAnnex` at vertices: the values of the corners of a child's parent are
+    interpolated linearly. For integral value types, the minimum of the corner
+    values is used instead.
+  - `ArrayAnnex` at other grob types: the value of a parent is copied to all its
+    children of the same dimension (e.g. subset indices).
+  - `ArrayAnnex` and `SubsetInfoAnnex` without a grob type are copied.
+
+  Other annexes are ignored. Custom policies can be registered for individual
+  annex keys. All default policies run in parallel over the relations of the hierarchy.
+
+  An `AnnexTransfer` can be passed as callback to the refinement methods.*/
+class AnnexTransfer
+{
+public:
+  /// Transfers the annex with the given key from `hierarchy.parent_mesh ()` to `hierarchy.child_mesh ()`.
+  using Policy = std::function <void (Hierarchy& hierarchy, AnnexKey const& key)>;
+
+  /// Replaces the default policy for the annex with the given key.
+  void set_policy (AnnexKey const& key, Policy policy);
+
+  /// The annex with the given key will not be transferred.
+  void ignore (AnnexKey const& key);
+
+  /// Transfers all annexes of `hierarchy.parent_mesh ()` to `hierarchy.child_mesh ()`
+  void operator () (Hierarchy& hierarchy) const;
+
+private:
+  std::map <AnnexKey, Policy> m_policies;
+};
+
+/// Transfers an annex as described in `AnnexTransfer`. Does nothing for unsupported annexes.
+void DefaultAnnexTransferPolicy (Hierarchy& hierarchy, AnnexKey const& key);
+
+/// Interpolates an `ArrayAnnex` at vertices linearly over the corners of the parents.
+void InterpolateVertexAnnex (Hierarchy& hierarchy, AnnexKey const& key);
+
+/// Copies the values of an `ArrayAnnex` at parents to all their children.
+/** The values are written to the annex with the same name at each child grob type
+  whose dimension matches the dimension of the parent type. Annexes of children of
+  lower dimension, in particular vertex annexes, are neither created nor modified.*/
+void CopyAnnexToChildren (Hierarchy& hierarchy, AnnexKey const& key);
+
+}// end of namespace lume
@@ -28,6 +28,7 @@
 #ifndef __H__lume_data_buffer
 #define __H__lume_data_buffer
 
+#include <type_traits>
 #include "annex.h"
 #include "mesh.h"
 #include "tuple_vector.h"
@@ -116,6 +117,52 @@ private:
 using RealArrayAnnex		= ArrayAnnex <real_t>;
 using IndexArrayAnnex		= ArrayAnnex <index_t>;
 
+
+namespace impl {
+	template <class ... TValues>
+	struct ArrayAnnexVisitor
+	{
+		template <class TAnnex, class TFunc>
+		static bool visit (TAnnex&, TFunc&&)	{return false;}
+	};
+
+	template <class T, class ... TRest>
+	struct ArrayAnnexVisitor <T, TRest...>
+	{
+		template <class TAnnex, class TFunc>
+		static bool visit (TAnnex& annex, TFunc&& func)
+		{
+			using array_annex_t = typename std::conditional <std::is_const <TAnnex>::value,
+			                                                 const ArrayAnnex <T>,
+			                                                 ArrayAnnex <T>>::type;
+
+			if (auto arrayAnnex = dynamic_cast <array_annex_t*> (&annex)) {
+				func (*arrayAnnex);
+				return true;
+			}
+			return ArrayAnnexVisitor <TRest...>::visit (annex, std::forward <TFunc> (func));
+		}
+	};
+}// end of namespace impl
+
+///	Calls `func (arrayAnnex)` with `annex` cast to its concrete `ArrayAnnex` type.
+/**	Supported value types are `real_t`, `double`, `index_t` and `int`.
+ * \returns	`true` if `func` was called, `false` if `annex` is not an `ArrayAnnex`
+ *			of a supported value type.
+ * \{ */
+template <class TFunc>
+bool VisitArrayAnnex (const Annex& annex, TFunc&& func)
+{
+	return impl::ArrayAnnexVisitor <real_t, double, index_t, int>::visit (annex, std::forward <TFunc> (func));
+}
+
+template <class TFunc>
+bool VisitArrayAnnex (Annex& annex, TFunc&& func)
+{
+	return impl::ArrayAnnexVisitor <real_t, double, index_t, int>::visit (annex, std::forward <TFunc> (func));
+}
+/** \} */
+
 }//	end of namespace lume
 
 #endif	//__H__lume_data_buffer
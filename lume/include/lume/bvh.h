@@ -0,0 +1,222 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <optional>
+#include <vector>
+#include <lume/grob_index.h>
+#include <lume/grob_set.h>
+#include <lume/mesh.h>
+
+namespace lume
+{
+
+/// Axis aligned bounding box in 3d. 2d coordinates are embedded with `z = 0`.
+struct BoundingBox
+{
+  std::array <real_t, 3> min {std::numeric_limits <real_t>::max (),
+                              std::numeric_limits <real_t>::max (),
+                              std::numeric_limits <real_t>::max ()};
+  std::array <real_t, 3> max {std::numeric_limits <real_t>::lowest (),
+                              std::numeric_limits <real_t>::lowest (),
+                              std::numeric_limits <real_t>::lowest ()};
+
+  bool empty () const  {return min [0] > max [0];}
+
+  void extend (real_t const* p)
+  {
+    for (int i = 0; i < 3; ++i) {
+      min [i] = std::min (min [i], p [i]);
+      max [i] = std::max (max [i], p [i]);
+    }
+  }
+
+  void extend (BoundingBox const& box)
+  {
+    for (int i = 0; i < 3; ++i) {
+      min [i] = std::min (min [i], box.min [i]);
+      max [i] = std::max (max [i], box.max [i]);
+    }
+  }
+
+  bool overlaps (BoundingBox const& box) const
+  {
+    for (int i = 0; i < 3; ++i) {
+      if (box.max [i] < min [i] || box.min [i] > max [i])
+        return false;
+    }
+    return true;
+  }
+
+  /// Returns the squared distance of the point `p` to the box (0 for points inside the box).
+  real_t distance_sq (real_t const* p) const
+  {
+    real_t d = 0;
+    for (int i = 0; i < 3; ++i) {
+      real_t const v = std::max (real_t (0), std::max (min [i] - p [i], p [i] - max [i]));
+      d += v * v;
+    }
+    return d;
+  }
+
+  real_t half_area () const
+  {
+    real_t const dx = max [0] - min [0];
+    real_t const dy = max [1] - min [1];
+    real_t const dz = max [2] - min [2];
+    return dx * dy + dy * dz + dz * dx;
+  }
+};
+
+/// A ray `origin + t * direction` with `t` in `[tMin, tMax]`.
+/** `direction` does not have to be normalized. Parameters `t` of hits are given in
+  multiples of `direction`.*/
+struct Ray
+{
+  std::array <real_t, 3> origin {0, 0, 0};
+  std::array <real_t, 3> direction {0, 0, 1};
+  real_t tMin {0};
+  real_t tMax {std::numeric_limits <real_t>::max ()};
+};
+
+struct RayHit
+{
+  GrobIndex grob;
+  real_t    t;
+};
+
+struct ClosestPoint
+{
+  GrobIndex              grob;
+  std::array <real_t, 3> point;
+  real_t                 distanceSq;
+};
+
+/// Bounding volume hierarchy over the grobs of a mesh.
+/** The hierarchy is built top-down with a binned surface area heuristic over the
+  bounding boxes of the grobs, which are computed from `keys::vertexCoords` (tuple
+  size 2 or 3). Large subtrees are built in parallel.
+
+  Nodes are stored in a flat array in depth-first order. The first child of an inner
+  node directly follows its parent, the index of the second child is stored in the
+  node. The grobs of a leaf are stored consecutively in `grobs ()`.
+
+  Ray queries are only meaningful for faces and volume elements (for the latter the
+  faces of the element are tested). Quadrilaterals are split into two triangles along
+  the diagonal from corner 0 to corner 2. Closest point queries are supported for all
+  grob types. Volume elements are treated as convex solids, i.e., points inside an
+  element have distance 0.
+
+  The hierarchy references the grobs and copies the coordinates of the mesh. It has
+  to be rebuilt if the mesh is changed.*/
+class BVH
+{
+public:
+  struct Node
+  {
+    BoundingBox box;
+    /// For leaves the index of the first grob in `grobs ()`, otherwise the index of the second child.
+    index_t     offset;
+    /// Number of grobs in a leaf, 0 for inner nodes.
+    index_t     numGrobs;
+
+    bool is_leaf () const  {return numGrobs > 0;}
+  };
+
+  /// Maximum number of rays traversed together by `ray_first_hits`.
+  static constexpr index_t packetSize = 8;
+
+  BVH (CSPMesh mesh, GrobSet grobSet, index_t maxLeafSize = 4);
+
+  CSPMesh mesh () const                       {return m_mesh;}
+  GrobSet grob_set () const                   {return m_grobSet;}
+  BoundingBox const& bounds () const          {return m_nodes.front ().box;}
+
+  /// Coordinates of the mesh's vertices as used by the hierarchy (3 components per vertex).
+  std::vector <real_t> const& coordinates () const {return m_coords;}
+
+  std::vector <Node> const& nodes () const    {return m_nodes;}
+  std::vector <GrobIndex> const& grobs () const {return m_grobs;}
+
+  /// Returns the closest hit of the ray with a grob in `[ray.tMin, ray.tMax]`.
+  std::optional <RayHit> ray_first_hit (Ray const& ray) const;
+
+  /// Collects all hits of the ray with grobs in `[ray.tMin, ray.tMax]` into `hitsOut`, sorted by `t`.
+  /** `hitsOut` is cleared first. A grob may appear multiple times, e.g., if a ray
+    enters and leaves a volume element.*/
+  void ray_all_hits (Ray const& ray, std::vector <RayHit>& hitsOut) const;
+
+  /// Collects all grobs whose bounding box overlaps the given box into `grobsOut`.
+  /** `grobsOut` is cleared first.*/
+  void box_overlaps (BoundingBox const& box, std::vector <GrobIndex>& grobsOut) const;
+
+  /// Returns the point on the grobs which is closest to `p` (3 components).
+  /** Only grobs closer than `sqrt (maxDistanceSq)` are considered.*/
+  std::optional <ClosestPoint>
+  closest_point (real_t const* p,
+                 real_t maxDistanceSq = std::numeric_limits <real_t>::max ()) const;
+
+  /// Computes the first hits of many rays.
+  /** Rays are traversed in packets of `packetSize` rays, i.e., each node is loaded
+    once for all rays of a packet which intersect its box. Coherent rays (e.g. rays
+    through neighboring pixels) should thus be stored consecutively. Packets are
+    processed in parallel.*/
+  std::vector <std::optional <RayHit>> ray_first_hits (std::vector <Ray> const& rays) const;
+
+  /// Computes the closest points for many query points in parallel.
+  /** `points` contains 3 components for each query point.*/
+  std::vector <std::optional <ClosestPoint>>
+  closest_points (std::vector <real_t> const& points,
+                  real_t maxDistanceSq = std::numeric_limits <real_t>::max ()) const;
+
+private:
+  void build (index_t maxLeafSize);
+  void build_recursive (std::vector <index_t>& prims,
+                        index_t begin,
+                        index_t end,
+                        std::vector <Node>& nodesOut,
+                        index_t maxLeafSize,
+                        int parallelDepth,
+                        index_t depth) const;
+
+  bool intersect (ConstGrob const& grob, Ray const& ray, real_t& tInOut) const;
+  void intersect_all (GrobIndex const& grob, Ray const& ray, std::vector <RayHit>& hitsOut) const;
+  real_t closest_point_on_grob (GrobIndex const& grob, real_t const* p, real_t* pointOut) const;
+
+  CSPMesh                  m_mesh;
+  GrobSet                  m_grobSet;
+  std::vector <real_t>     m_coords;
+  std::vector <Node>       m_nodes;
+  std::vector <GrobIndex>  m_grobs;
+
+  // temporary data which is only used during construction
+  std::vector <BoundingBox>  m_primBoxes;
+  std::vector <real_t>       m_primCenters;
+};
+
+}// end of namespace lume
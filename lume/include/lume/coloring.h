@@ -0,0 +1,119 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <lume/grob_index.h>
+#include <lume/grob_set.h>
+#include <lume/mesh.h>
+#include <lume/parallel_for.h>
+#include <lume/types.h>
+#include <lume/vertex_incidence.h>
+
+namespace lume
+{
+
+/** Assigns a color to each grob of a grob set, so that grobs which share a vertex
+  have different colors. All grobs of one color can thus scatter values to their
+  corners concurrently without synchronization, see `parallel_for_colored`.
+
+  The coloring is computed with the parallel Jones-Plassmann algorithm: in each round,
+  every uncolored grob whose (pseudo random) priority exceeds the priorities of all of
+  its uncolored neighbors receives the smallest color which isn't used by any of its
+  neighbors. The priorities are derived from the grob indices, so the coloring is
+  reproducible.
+
+  The grobs of each color are stored in compressed rows, segmented by grob type in the
+  order of the grob set and sorted by index.*/
+class GrobColoring
+{
+public:
+  GrobColoring () = default;
+  GrobColoring (Mesh const& mesh, GrobSet grobSet);
+
+  GrobSet grob_set () const     {return m_grobSet;}
+  index_t num_colors () const   {return m_numColors;}
+
+  /// Returns the number of grobs of the given color
+  index_t num_grobs (index_t const color) const
+  {
+    return m_offsets [(color + 1) * m_numSlots] - m_offsets [color * m_numSlots];
+  }
+
+  /// Returns the indices of the grobs of the given type and color
+  /** The returned span is empty, if `grobType` is not contained in the grob set.*/
+  IndexSpan grobs (index_t const color, GrobType const grobType) const
+  {
+    index_t const slot = m_typeSlots [grobType];
+    if (slot == NO_INDEX)
+      return {};
+    index_t const i = color * m_numSlots + slot;
+    return IndexSpan (m_grobs.data () + m_offsets [i], m_grobs.data () + m_offsets [i + 1]);
+  }
+
+private:
+  GrobSet                               m_grobSet;
+  index_t                               m_numColors {0};
+  index_t                               m_numSlots {1};
+  std::array <index_t, NUM_GROB_TYPES>  m_typeSlots {NO_INDEX, NO_INDEX, NO_INDEX, NO_INDEX,
+                                                     NO_INDEX, NO_INDEX, NO_INDEX, NO_INDEX};
+  std::vector <index_t>                 m_offsets {0};
+  std::vector <index_t>                 m_grobs;
+};
+
+
+/// Calls `func (GrobIndex)` for all grobs of the coloring, one color after the other.
+/** The grobs of each color are processed in parallel. Since grobs of the same color
+  don't share vertices, `func` may write to data associated with the corners of its
+  grob without synchronization.*/
+template <class TFunc>
+void parallel_for_colored (GrobColoring const& coloring, TFunc const& func)
+{
+  for (index_t color = 0; color < coloring.num_colors (); ++color) {
+    for (auto const grobType : coloring.grob_set ()) {
+      IndexSpan const grobs = coloring.grobs (color, grobType);
+      parallel_for_blocks (size_t (0), grobs.size (), [&, grobType] (size_t const begin, size_t const end) {
+        for (size_t i = begin; i < end; ++i)
+          func (GrobIndex (grobType, grobs [i]));
+      });
+    }
+  }
+}
+
+/// Returns the coloring of the given grobs. Equivalent to `GrobColoring (mesh, grobSet)`.
+/** The coloring is stored in the derived data cache of `mesh` (see `Mesh::derived_data`).*/
+std::shared_ptr <GrobColoring const>
+CachedGrobColoring (Mesh const& mesh, GrobSet grobSet);
+
+/// Calls `func (GrobIndex)` for all grobs of `grobSet` using the cached coloring of `mesh`.
+template <class TFunc>
+void parallel_for_colored (Mesh const& mesh, GrobSet const grobSet, TFunc const& func)
+{
+  parallel_for_colored (*CachedGrobColoring (mesh, grobSet), func);
+}
+
+}// end of namespace lume
@@ -0,0 +1,69 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <vector>
+#include <lume/array_annex.h>
+#include <lume/grob_set.h>
+#include <lume/mesh.h>
+#include <lume/types.h>
+
+namespace lume
+{
+
+/// Returns the key of the annex which stores the component index of each grob of the given type.
+inline TypedAnnexKey <IndexArrayAnnex> ComponentAnnexKey (GrobType const grobType)
+{
+  return TypedAnnexKey <IndexArrayAnnex> ("component", grobType);
+}
+
+/// Number and sizes of the connected components of a grob set
+struct ComponentInfo
+{
+  index_t               numComponents {0};
+  std::vector <index_t> componentSizes;   ///< number of grobs in each component
+};
+
+/// Labels the connected components of the grobs of a grob set.
+/** Two grobs are connected if they share a grob of dimension `connectionDim`, i.e.,
+  a vertex (0), an edge (1), or a face (2). `connectionDim` has to be smaller than
+  `grobSet.dim ()`.
+
+  The component index of each grob is stored in the annex `ComponentAnnexKey (grobType)`
+  for each grob type of the grob set which has grobs in `mesh`. Components are numbered
+  in the order of their first grob.
+
+  Connectivity is computed by a concurrent union-find over the index space of the
+  connecting grobs (i.e. over the vertex indices for `connectionDim == 0`), which is
+  fed in parallel from the grob arrays.*/
+ComponentInfo LabelComponents (Mesh& mesh, GrobSet grobSet, index_t connectionDim = 0);
+
+/// Creates one mesh for each connected component of the given grob set.
+/** The components are labeled through `LabelComponents`. The meshes are created through
+  `ExtractPartitions`, i.e., they receive compact vertex indices, maps to the indices of
+  the grobs in `mesh` and sliced copies of all array annexes.*/
+std::vector <SPMesh> SplitComponents (Mesh& mesh, GrobSet grobSet, index_t connectionDim = 0);
+
+}// end of namespace lume
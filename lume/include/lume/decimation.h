@@ -0,0 +1,82 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <limits>
+#include <vector>
+#include <lume/mesh.h>
+
+namespace lume
+{
+
+struct DecimationOptions
+{
+  /// Decimation stops once the number of triangles is smaller or equal to this value.
+  index_t targetNumTris {0};
+
+  /// Edges whose collapse would introduce a larger quadric error are not collapsed.
+  double maxError {std::numeric_limits <double>::max ()};
+
+  /// If true, vertices on boundary and non-manifold edges are not removed.
+  bool preserveBoundaries {true};
+
+  /// If true, vertices on edges between triangles of different subsets are not removed.
+  /** Subsets are given by the triangle annexes associated with the `SubsetInfoAnnex`
+    instances of the mesh.*/
+  bool preserveSubsetBorders {true};
+
+  /// Number of slabs which are decimated in parallel. If 0, one slab per hardware thread is used.
+  index_t numPartitions {0};
+};
+
+/// Reduces the number of triangles of a mesh by collapsing edges with small quadric error.
+/** Each vertex is associated with the sum of the squared distance quadrics of its
+  adjacent triangles. Edges are collapsed to the position minimizing the combined
+  quadric of their corners (Garland-Heckbert).
+
+  The mesh is split into slabs along the longest axis of its bounding box, one for
+  each hardware thread unless `DecimationOptions::numPartitions` is set. Each slab is decimated in parallel using its own priority
+  queue, where only collapses whose neighborhood lies completely inside the slab are
+  considered. A second parallel pass with shifted slabs and a final pass over the
+  whole mesh remove the remaining triangles. Collapses which would violate the link
+  condition or flip a triangle are rejected.
+
+  The returned mesh only contains vertices and triangles. Floating point vertex
+  annexes are interpolated along collapsed edges, integral vertex annexes keep the
+  value of the remaining vertex. Triangle annexes and `SubsetInfoAnnex` instances
+  are copied.
+
+  \note The mesh may only contain vertices, edges and triangles. Edges are ignored.*/
+SPMesh DecimateTriangles (CSPMesh mesh, DecimationOptions const& options);
+
+/// Creates a chain of decimated meshes, one for each target number of triangles.
+/** `targetNumTris` has to be sorted in descending order. All meshes are created in
+  a single decimation run, i.e., the mesh for target `i+1` is obtained by further
+  decimating the mesh for target `i`. `options.targetNumTris` is ignored.*/
+std::vector <SPMesh> DecimateTrianglesLOD (CSPMesh mesh,
+                                           std::vector <index_t> const& targetNumTris,
+                                           DecimationOptions const& options = {});
+
+}// end of namespace lume
@@ -0,0 +1,67 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <lume/array_annex.h>
+#include <lume/grob_array.h>
+#include <lume/mesh.h>
+#include <lume/types.h>
+
+namespace lume
+{
+
+/// Computes the (constrained) Delaunay triangulation of a set of points in the plane.
+/** The points are given by `coords`, which has to have tuple size 2 or 3. In the
+  latter case, the points are projected to the xy-plane.
+
+  Points are inserted incrementally in a biased randomized insertion order (BRIO),
+  where the points of each round are sorted along a Hilbert curve, so that
+  consecutive insertions can be located by a short walk from the previous one.
+
+  The edges in `constrainedEdges` are inserted after all points and are contained
+  in the resulting triangulation. Constrained edges must not cross each other.
+  If a point lies on a constrained edge, the edge is split at that point.
+
+  Duplicate points are not referenced by the resulting triangulation.
+
+  \returns  counterclockwise oriented triangles which cover the convex hull of the points.*/
+GrobArray DelaunayTriangulation (RealArrayAnnex const& coords,
+                                 GrobArray const& constrainedEdges = GrobArray (EDGE));
+
+/// Flips the edges of the triangles of `mesh` until the triangulation is Delaunay.
+/** The triangles have to be consistently oriented. Boundary edges, non-manifold edges,
+  and the edges in `constrainedEdges` are never flipped. If the mesh has 3d coordinates,
+  the triangles are projected to the xy-plane.
+
+  The Lawson flips are performed in rounds. In each round, all candidate edges are
+  tested in parallel and a set of independent, illegal edges is flipped in parallel.
+  Only the edges of the quadrilaterals of flipped edges become candidates again.
+
+  The number of triangles doesn't change, however annex values associated with
+  triangles will no longer match the flipped triangles.
+  \returns  the number of performed flips.*/
+index_t MakeDelaunay (Mesh& mesh, GrobArray const& constrainedEdges = GrobArray (EDGE));
+
+}// end of namespace lume
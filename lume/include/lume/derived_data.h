@@ -0,0 +1,68 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <lume/bvh.h>
+#include <lume/grob_sides.h>
+#include <lume/mesh.h>
+#include <lume/neighborhoods.h>
+#include <lume/vertex_incidence.h>
+
+namespace lume
+{
+
+/** \name Cached derived data
+  The following functions return data derived from a mesh. The data is built on
+  first request and stored in the mesh's derived data cache (see `Mesh::derived_data`).
+  Subsequent calls with the same parameters return the cached instance until the
+  grobs (or annexes) it depends on change.
+  \{ */
+
+/// Returns the sides of the given grobs. Equivalent to `GrobSides (mesh, grobSet, sideSet)`.
+std::shared_ptr <GrobSides const>
+CachedGrobSides (Mesh const& mesh, GrobSet grobSet, GrobSet sideSet);
+
+/// Returns the sides of the given grobs. Equivalent to `GrobSides (mesh, grobTypes, sideSet)`.
+std::shared_ptr <GrobSides const>
+CachedGrobSides (Mesh const& mesh, std::vector <GrobType> const& grobTypes, GrobSet sideSet);
+
+/// Returns the neighborhoods between the given grob sets. Equivalent to `Neighborhoods (mesh, centerGrobSet, neighborGrobSet)`.
+/** The returned instance keeps `mesh` alive.*/
+std::shared_ptr <Neighborhoods const>
+CachedNeighborhoods (SPMesh mesh, GrobSet centerGrobSet, GrobSet neighborGrobSet);
+
+/// Returns the bounding box of the coordinates in `keys::vertexCoords`.
+/** The box is invalidated if vertices are added or removed or if the coordinate annex
+  is replaced. Call `Mesh::invalidate_derived_data` after modifying coordinates in place.*/
+BoundingBox CachedBoundingBox (Mesh const& mesh);
+
+/// Returns the grobs of `grobSet` incident to each vertex. Equivalent to `VertexIncidence (mesh, grobSet)`.
+std::shared_ptr <VertexIncidence const>
+CachedVertexIncidence (Mesh const& mesh, GrobSet grobSet);
+/** \} */
+
+}// end of namespace lume
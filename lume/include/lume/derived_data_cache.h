@@ -0,0 +1,183 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <bitset>
+#include <future>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "annex_key.h"
+#include "grob_set.h"
+#include "grob_types.h"
+
+namespace lume
+{
+
+/** Stores data which is derived from a mesh, e.g. side arrays or neighborhoods.
+  Each entry is identified by a key, which should encode the kind of the data and
+  all parameters used during its construction. An entry is built on first request
+  and is shared by all subsequent requests until it is invalidated.
+
+  Each entry depends on a set of grob types and optionally on a set of annexes. It
+  is removed from the cache as soon as grobs of one of those types or one of those
+  annexes change.
+
+  \note Concurrent calls to `get` are thread safe. If several threads request the same
+        entry, it is only built once and all threads receive the same instance.
+*/
+class DerivedDataCache
+{
+public:
+  using GrobTypeMask = std::bitset <NUM_GROB_TYPES>;
+
+  DerivedDataCache () = default;
+  DerivedDataCache (DerivedDataCache const&) = delete;
+  DerivedDataCache& operator = (DerivedDataCache const&) = delete;
+
+  /// Returns a mask which contains all grob types of the given grob sets
+  static GrobTypeMask grob_type_mask (std::initializer_list <GrobSet> grobSets)
+  {
+    GrobTypeMask mask;
+    for (auto const& grobSet : grobSets) {
+      for (auto const grobType : grobSet)
+        mask.set (grobType);
+    }
+    return mask;
+  }
+
+  /// Returns the entry for the given key. If it doesn't exist, it is created from the return value of `build ()`.
+  /** \param key          identifies the entry. Has to encode all parameters of `build`.
+      \param grobTypes    the entry is invalidated if grobs of one of these types change.
+      \param annexKeys    the entry is invalidated if one of these annexes is replaced or removed.
+      \param build        a callable without arguments which returns an instance of `T`.
+                          If it throws, no entry is created and the exception is propagated
+                          to all threads waiting for the entry.*/
+  template <class T, class TBuilder>
+  std::shared_ptr <T const> get (std::string const& key,
+                                 GrobTypeMask const& grobTypes,
+                                 std::vector <AnnexKey> annexKeys,
+                                 TBuilder const& build)
+  {
+    std::promise <std::shared_ptr <void const>> promise;
+    std::shared_future <std::shared_ptr <void const>> value;
+    bool mustBuild = false;
+    size_t id = 0;
+    {
+      std::lock_guard <std::mutex> lock (m_mutex);
+      auto const entry = m_entries.find (key);
+      if (entry == m_entries.end ()) {
+        value = promise.get_future ().share ();
+        id = ++m_lastId;
+        m_entries.emplace (key, Entry {grobTypes, std::move (annexKeys), value, id});
+        mustBuild = true;
+      }
+      else
+        value = entry->second.value;
+    }
+
+    if (mustBuild) {
+      try {
+        promise.set_value (std::make_shared <T const> (build ()));
+      }
+      catch (...) {
+        erase_if_same (key, id);
+        promise.set_exception (std::current_exception ());
+      }
+    }
+
+    return std::static_pointer_cast <T const> (value.get ());
+  }
+
+  /// Removes all entries which depend on the given grob type
+  void invalidate (GrobType const grobType)
+  {
+    std::lock_guard <std::mutex> lock (m_mutex);
+    for (auto i = m_entries.begin (); i != m_entries.end ();) {
+      if (i->second.grobTypes.test (grobType))
+        i = m_entries.erase (i);
+      else
+        ++i;
+    }
+  }
+
+  /// Removes all entries which depend on the given annex
+  void invalidate (AnnexKey const& annexKey)
+  {
+    std::lock_guard <std::mutex> lock (m_mutex);
+    for (auto i = m_entries.begin (); i != m_entries.end ();) {
+      bool dependsOnAnnex = false;
+      for (auto const& key : i->second.annexKeys)
+        dependsOnAnnex |= !(key < annexKey) && !(annexKey < key);
+
+      if (dependsOnAnnex)
+        i = m_entries.erase (i);
+      else
+        ++i;
+    }
+  }
+
+  /// Removes all entries
+  void clear ()
+  {
+    std::lock_guard <std::mutex> lock (m_mutex);
+    m_entries.clear ();
+  }
+
+  /// Returns the number of entries in the cache
+  size_t size () const
+  {
+    std::lock_guard <std::mutex> lock (m_mutex);
+    return m_entries.size ();
+  }
+
+private:
+  struct Entry
+  {
+    GrobTypeMask                                      grobTypes;
+    std::vector <AnnexKey>                            annexKeys;
+    std::shared_future <std::shared_ptr <void const>> value;
+    size_t                                            id;
+  };
+
+  /// Removes the entry for `key`, if it wasn't replaced by another entry in the meantime
+  void erase_if_same (std::string const& key, size_t const id)
+  {
+    std::lock_guard <std::mutex> lock (m_mutex);
+    auto const entry = m_entries.find (key);
+    if (entry != m_entries.end () && entry->second.id == id)
+      m_entries.erase (entry);
+  }
+
+  mutable std::mutex              m_mutex;
+  std::map <std::string, Entry>   m_entries;
+  size_t                          m_lastId {0};
+};
+
+}// end of namespace lume
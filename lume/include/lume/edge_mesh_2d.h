@@ -24,7 +24,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <optional>
 #include <vector>
 
 #include <lume/mesh.h>
@@ -33,6 +35,15 @@
 namespace lume
 {
 
+/** The connections of all vertices are stored in one flat array. Each vertex owns a
+  contiguous range of slots in this array, in which its connections are sorted
+  counterclockwise by their pseudo angle. Each range contains a few free slots, so
+  that edges can be inserted without reallocation in most cases. If a range is full,
+  it is moved to the end of the array with doubled capacity. Once the abandoned
+  slots make up more than half of the array, all ranges are compacted.
+
+  Coordinates are copied to an internal array, so that coordinate lookups in the
+  geometric predicates are simple inlined array accesses.*/
 class EdgeMesh2d
 {
 public:
@@ -41,7 +52,7 @@ public:
     index_t to;
   };
 
-  enum class Boundary
+  enum class Boundary : uint8_t
   {
     None,
     Left, ///< Adacent triangle is on the right of the edge
@@ -50,30 +61,50 @@ public:
 
   struct Connection {
     index_t to;
-    double pseudoAngle;
     Boundary boundary;
+    double pseudoAngle;
   };
 
-  using Connections = std::vector <Connection>;
+  /// A view on the connections of a vertex, sorted counterclockwise by their pseudo angle.
+  /** The view is invalidated by any modification of the edge mesh.*/
+  class Connections
+  {
+  public:
+    Connections (Connection const* begin, index_t size) : m_begin (begin), m_size (size) {}
+
+    Connection const* begin () const {return m_begin;}
+    Connection const* end () const   {return m_begin + m_size;}
+    size_t size () const             {return m_size;}
+    bool empty () const              {return m_size == 0;}
+
+    Connection const& operator [] (size_t i) const {return m_begin [i];}
+
+  private:
+    Connection const* m_begin;
+    index_t           m_size;
+  };
 
 public:
   /** Constructs an edge mesh from the given array of counterclockwise oriented triangle and the
     given vector of positions.
     Positions::value_type is expected to be 2-tuples (e.g. through lume::TupleView) or
-    compatible types (e.g. glm::vec2).
-
-    Note: positions has to be a valid reference for the whole lifetime of the created instance.
-  */
+    compatible types (e.g. glm::vec2).*/
   template <class Positions>
   static EdgeMesh2d fromTrianglesCCW (GrobArray const& triangles, Positions const& positions);
 
-  /** The specified callback has to provide 2d coordinates given a vertex index.*/
+  /** Copies the coordinates of the first `numVertices` entries of `positions`.
+    Positions::value_type is expected to be 2-tuples or compatible types.*/
+  template <class Positions>
+  EdgeMesh2d (Positions const& positions, index_t numVertices);
+
+  /** The specified callback has to provide 2d coordinates given a vertex index.
+    It is called once for each vertex, when the vertex is referenced for the first time.*/
   EdgeMesh2d (std::function <std::tuple <double, double> (index_t)> coordinateCallback);
-  EdgeMesh2d (EdgeMesh2d const& other);
-  EdgeMesh2d (EdgeMesh2d&& other);
+  EdgeMesh2d (EdgeMesh2d const& other) = default;
+  EdgeMesh2d (EdgeMesh2d&& other) = default;
 
-  EdgeMesh2d& operator = (EdgeMesh2d const& other);
-  EdgeMesh2d& operator = (EdgeMesh2d&& other);
+  EdgeMesh2d& operator = (EdgeMesh2d const& other) = default;
+  EdgeMesh2d& operator = (EdgeMesh2d&& other) = default;
 
   /** If an edge is already present in the edge mesh, no action is performed and false is returned.*/
   bool add_edge (Edge const& edge, Boundary boundary = Boundary::None);
@@ -83,7 +114,7 @@ public:
   
   size_t num_vertices () const;
   
-  Connections const& connections (index_t vertex) const;
+  Connections connections (index_t vertex) const;
 
   bool swap_edge (Edge const& edge);
   
@@ -93,9 +124,27 @@ public:
 
 private:
   using CoordinateCallback = std::function <std::tuple <double, double> (index_t)>;
-  using Coordinate = math::TupleWithStorage <double>;
+  using Coordinate = math::TupleWithStorage <double, 2>;
+
+  struct VertexSlots {
+    index_t offset   {0};
+    index_t size     {0};
+    index_t capacity {0};
+  };
 
 private:
+  /** Initializes the connections of an empty edge mesh from a set of unique edges in one pass.*/
+  void init_connections (std::vector <Edge> const& edges, std::vector <Boundary> const& boundaries);
+
+  void ensure_vertex (index_t vertex);
+  void reserve_slot (index_t vertex);
+  void compact_slots ();
+
+  Connection*       slots_begin (index_t vertex)       {return m_slots.data () + m_vertexSlots [vertex].offset;}
+  Connection const* slots_begin (index_t vertex) const {return m_slots.data () + m_vertexSlots [vertex].offset;}
+  Connection*       slots_end (index_t vertex)         {return slots_begin (vertex) + m_vertexSlots [vertex].size;}
+  Connection const* slots_end (index_t vertex) const   {return slots_begin (vertex) + m_vertexSlots [vertex].size;}
+
   bool insert_connection (index_t const from, index_t const to, Boundary boundary);
   void remove_connection (index_t const from, index_t const to);
   double compute_pseudo_angle (index_t const from, index_t const to) const;
@@ -108,20 +157,20 @@ private:
 
   bool is_valid (Edge const& edge) const;
 
-  Connections const& vertex_connections (index_t vertex) const;
-  Connections& vertex_connections (index_t vertex);
-
   bool has_connection (index_t const from, index_t const to) const;
 
-  Connections::iterator find_connection (Connections& connections, index_t const to);
-  Connections::const_iterator find_connection (Connections const& connections, index_t const to) const;
+  Connection*       find_connection (index_t const from, index_t const to);
+  Connection const* find_connection (index_t const from, index_t const to) const;
 
-  Connections::iterator find_connection_lower_bound (Connections& connections,
-                                                     double const pseudoAngle);
-  
   std::optional <Edge> swap_candidate (Edge const& edge) const;
 
-  Coordinate coordinate (index_t vertex) const;
+  Coordinate coordinate (index_t vertex) const
+  {
+    auto c = Coordinate::uninitialized ();
+    c [0] = m_coordinates [2 * vertex];
+    c [1] = m_coordinates [2 * vertex + 1];
+    return c;
+  }
 
   Coordinate direction (index_t const from, index_t const to) const;
 
@@ -134,10 +183,13 @@ private:
                                 index_t const vertex2) const;
 
 private:
-  std::vector <Connections> m_connections;
-  CoordinateCallback m_coordinateCallback;
+  std::vector <VertexSlots> m_vertexSlots;
+  std::vector <Connection>  m_slots;
+  size_t                    m_numAbandonedSlots {0};
+  std::vector <double>      m_coordinates;
+  CoordinateCallback        m_coordinateCallback;
 };
 
 }// end of namespace lume
 
-#include "edge_mesh_2d_impl.h"
\ No newline at end of file
+#include "edge_mesh_2d_impl.h"
@@ -24,40 +24,57 @@
 
 #pragma once
 
+#include <algorithm>
 #include "lume/edge_mesh_2d.h"
 #include "lume/topology.h"
 
 namespace lume
 {
   template <class Positions>
-  EdgeMesh2d EdgeMesh2d::fromTrianglesCCW (GrobArray const& triangles, Positions const& positions)
+  EdgeMesh2d::EdgeMesh2d (Positions const& positions, index_t const numVertices)
+    : m_vertexSlots (numVertices)
+    , m_coordinates (2 * static_cast <size_t> (numVertices))
   {
-    auto coordinateCallback = [&positions] (index_t i)
-                              {
-                                return std::make_tuple (static_cast <double> (positions [i][0]),
-                                                        static_cast <double> (positions [i][1]));
-                              };
-
-    lume::EdgeMesh2d edgeMesh {std::move (coordinateCallback)};
+    for (index_t i = 0; i < numVertices; ++i)
+    {
+      m_coordinates [2 * i]     = static_cast <double> (positions [i][0]);
+      m_coordinates [2 * i + 1] = static_cast <double> (positions [i][1]);
+    }
+  }
 
+  template <class Positions>
+  EdgeMesh2d EdgeMesh2d::fromTrianglesCCW (GrobArray const& triangles, Positions const& positions)
+  {
     if (triangles.grob_desc ().grob_type () != TRI ||
         triangles.empty ())
     {
       assert (triangles.grob_desc ().grob_type () == TRI);
-      return edgeMesh;
+      return lume::EdgeMesh2d {positions, 0};
     }
 
+    index_t const numVertices = *std::max_element (triangles.data (),
+                                                   triangles.data () + 3 * triangles.size ()) + 1;
+
+    lume::EdgeMesh2d edgeMesh {positions, numVertices};
+
     auto const edgeRefs = lume::FindUniqueSidesRefCounted (triangles, 1);
 
+    std::vector <Edge> edges;
+    std::vector <Boundary> boundaries;
+    edges.reserve (edgeRefs.size ());
+    boundaries.reserve (edgeRefs.size ());
+
     for (auto const& edgeRef : edgeRefs)
     {
       auto const& edge = edgeRef.first;
+      edges.push_back ({edge [0], edge [1]});
       if (edgeRef.second == 1)
-        edgeMesh.add_edge ({edge [0], edge [1]}, lume::EdgeMesh2d::Boundary::Right);
+        boundaries.push_back (lume::EdgeMesh2d::Boundary::Right);
       else
-        edgeMesh.add_edge ({edge [0], edge [1]});
+        boundaries.push_back (lume::EdgeMesh2d::Boundary::None);
     }
 
+    edgeMesh.init_connections (edges, boundaries);
     return edgeMesh;
   }
 }// end of namespace lume
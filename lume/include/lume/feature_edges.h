@@ -0,0 +1,71 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <lume/grob_array.h>
+#include <lume/mesh.h>
+#include <lume/types.h>
+
+namespace lume
+{
+
+enum class FeatureEdgeType : uint8_t
+{
+  Sharp,        ///< an edge of two faces whose dihedral angle exceeds the threshold
+  Boundary,     ///< an edge of exactly one face
+  NonManifold   ///< an edge of more than two faces
+};
+
+/// Feature edges of a surface and the curves formed by them
+struct FeatureEdges
+{
+  GrobArray                       edges {EDGE};
+  std::vector <FeatureEdgeType>   types;            ///< the type of each edge in `edges`
+  std::vector <real_t>            dihedralAngles;   ///< in degrees, for sharp edges. 0 for other edges.
+
+  /// The vertices of curve `i` are `curveVertices [curveOffsets [i]], ..., curveVertices [curveOffsets [i+1] - 1]`.
+  /** The first and the last vertex of a closed curve are identical.*/
+  std::vector <index_t>           curveOffsets {0};
+  std::vector <index_t>           curveVertices;
+
+  index_t num_curves () const {return static_cast <index_t> (curveOffsets.size () - 1);}
+};
+
+/// Extracts the sharp, boundary, and non-manifold edges of the triangles and quadrilaterals of a mesh.
+/** The dihedral angle of an edge shared by two faces is the angle between the normals
+  of the faces, i.e., 0 for coplanar faces. If the faces are oriented inconsistently,
+  one of the normals is inverted first. Edges whose dihedral angle exceeds
+  `featureAngle` (in degrees) are considered sharp.
+
+  The extracted edges are chained into curves. A curve ends at vertices which are
+  incident to more or less than two feature edges. The remaining edges form closed curves.
+
+  Requires 3d coordinates in `keys::vertexCoords`. The edges are obtained from
+  `CachedGrobSides (mesh, FACES, EDGES)` and the dihedral angles are computed in parallel.*/
+FeatureEdges ExtractFeatureEdges (Mesh const& mesh, real_t featureAngle, bool includeBoundary = true);
+
+}// end of namespace lume
@@ -0,0 +1,114 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <lume/grob_array.h>
+#include <lume/grob_index.h>
+#include <lume/grob_set.h>
+#include <lume/mesh.h>
+#include <lume/tuple_vector.h>
+
+namespace lume
+{
+
+/** Numbers the sides of a set of grobs and links each grob to its sides.
+  The sides are not found through hashing. Instead each side instance is assigned
+  to the bucket of its smallest corner index, which is a counting sort over the
+  vertex indices. The small buckets are then sorted and deduplicated independently
+  of each other. All steps are executed in parallel.
+
+  Sides are numbered consecutively for each side type. The corners of a side are
+  stored in the order of the first grob (in the order of the given grob types and
+  grob indices) in which it appears.
+
+  Grobs of the given grob set whose dimension equals the side dimension and whose
+  type is contained in the side set are regarded as their own (single) side. This way
+  e.g. explicitly stored edges of a mesh receive the same index as the corresponding
+  edges of the mesh's faces.
+
+  \note The side dimension has to be smaller than 3.
+*/
+class GrobSides
+{
+public:
+  /// Describes the occurrence of a side in one of the grobs
+  struct Incidence
+  {
+    GrobIndex grob;
+    index_t   localSide;  ///< index of the side in the local side numbering of `grob`
+  };
+
+  GrobSides (Mesh const& mesh, GrobSet grobSet, GrobSet sideSet);
+  GrobSides (Mesh const& mesh, std::vector <GrobType> const& grobTypes, GrobSet sideSet);
+
+  GrobSet side_set () const {return m_sideSet;}
+  index_t side_dim () const {return m_sideSet.dim ();}
+
+  /// Returns the number of local sides of a grob of the given type, i.e., the tuple size of `side_indices`.
+  index_t num_local_sides (GrobType grobType) const {return m_numLocalSides [grobType];}
+
+  size_t num_sides (GrobType sideType) const            {return m_sides [sideType].size ();}
+  GrobArray const& sides (GrobType sideType) const      {return m_sides [sideType];}
+
+  /// Returns the index into `sides (side_type)` of the `localSide`-th side of the given grob.
+  /** `NO_INDEX` is returned if the type of the side is not contained in the side set.*/
+  index_t side_index (GrobIndex const& grob, index_t const localSide) const
+  {
+    return m_sideIndices [grob.grob_type ()][grob.index () * m_numLocalSides [grob.grob_type ()] + localSide];
+  }
+
+  /// Returns an array with `num_local_sides (grobType)` side indices for each grob of the given type.
+  /** The array is empty if the grob type was not considered.*/
+  std::vector <index_t> const& side_indices (GrobType grobType) const {return m_sideIndices [grobType];}
+
+  /// Returns the number of grobs in which the given side appears
+  index_t num_incidences (GrobIndex const& side) const
+  {
+    auto const& offsets = m_incidenceOffsets [side.grob_type ()];
+    return offsets [side.index () + 1] - offsets [side.index ()];
+  }
+
+  /// Returns the i-th occurrence of the given side in one of the grobs.
+  /** Incidences are ordered by grob type (in the order given in the constructor) and grob index.*/
+  Incidence incidence (GrobIndex const& side, index_t const i) const;
+
+private:
+  void init (Mesh const& mesh, std::vector <GrobType> const& grobTypes);
+  void collect_sides (Mesh const& mesh, GrobType sideType);
+  Incidence slot_to_incidence (index_t slot) const;
+
+  GrobSet                                            m_sideSet;
+  std::array <index_t, NUM_GROB_TYPES>               m_numLocalSides {};
+  std::array <index_t, NUM_GROB_TYPES>               m_slotBaseInds {};
+  std::vector <GrobType>                             m_grobTypes;
+  std::vector <GrobArray>                            m_sides;
+  std::array <std::vector <index_t>, NUM_GROB_TYPES> m_sideIndices;
+  std::array <std::vector <index_t>, NUM_GROB_TYPES> m_incidenceOffsets;
+  std::array <std::vector <index_t>, NUM_GROB_TYPES> m_incidences;
+};
+
+}// end of namespace lume
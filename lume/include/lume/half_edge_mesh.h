@@ -0,0 +1,168 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <vector>
+#include <lume/grob_array.h>
+#include <lume/grob_index.h>
+#include <lume/mesh.h>
+#include <lume/types.h>
+
+namespace lume
+{
+
+/** A half-edge representation of the triangles and quadrilaterals of a mesh.
+
+  Each face is represented by a cycle of half-edges, one for each of its edges.
+  The half-edges of the triangles are stored first, followed by the half-edges of
+  the quadrilaterals. The half-edges of face `f` are stored contiguously, starting
+  at `face_half_edge (f)`, in the order of the corners of the face. Half-edge `h`
+  starts at vertex `vertex (h)` and ends at `vertex (next (h))`.
+
+  All connectivity is stored in separate arrays (next, twin, vertex, face), so that
+  one-ring traversals only touch the arrays they need. All queries are O(1).
+
+  Twins are found by sorting the half-edges by their smaller vertex with a parallel
+  counting sort, followed by a parallel sort of each bucket by the larger vertex.
+
+  Edges which are shared by more than two faces, or by two faces which traverse the
+  edge in the same direction, are non-manifold. Their half-edges don't have twins.
+  Vertices whose incident faces don't form a single fan are non-manifold, too.
+  Both are reported by `non_manifold_half_edges` and `non_manifold_vertices`.
+
+  The instance doesn't reference the mesh it was created from.*/
+class HalfEdgeMesh
+{
+public:
+  HalfEdgeMesh () = default;
+  explicit HalfEdgeMesh (Mesh const& mesh);
+  HalfEdgeMesh (GrobArray const& tris, GrobArray const& quads, index_t numVertices);
+
+  index_t num_vertices () const                     {return static_cast <index_t> (m_vertexHalfEdges.size ());}
+  index_t num_faces () const                        {return m_numTris + m_numQuads;}
+  index_t num_half_edges () const                   {return static_cast <index_t> (m_next.size ());}
+
+  index_t next (index_t const h) const              {return m_next [h];}
+  index_t prev (index_t const h) const
+  {
+    index_t const quadBase = 3 * m_numTris;
+    if (h < quadBase)
+      return h % 3 == 0 ? h + 2 : h - 1;
+    return (h - quadBase) % 4 == 0 ? h + 3 : h - 1;
+  }
+
+  /// Returns the opposite half-edge or `NO_INDEX` for boundary and non-manifold edges
+  index_t twin (index_t const h) const              {return m_twin [h];}
+  /// Returns the vertex at which the half-edge starts
+  index_t vertex (index_t const h) const            {return m_vertex [h];}
+  /// Returns the vertex at which the half-edge ends
+  index_t dest (index_t const h) const              {return m_vertex [m_next [h]];}
+  index_t face (index_t const h) const              {return m_face [h];}
+  bool is_boundary (index_t const h) const          {return m_twin [h] == NO_INDEX;}
+
+  /// Returns an outgoing half-edge of a vertex or `NO_INDEX` for isolated vertices
+  /** For boundary vertices, the outgoing boundary half-edge is returned, so that
+    `for_each_outgoing` visits the complete fan.*/
+  index_t vertex_half_edge (index_t const v) const  {return m_vertexHalfEdges [v];}
+
+  index_t face_half_edge (index_t const f) const
+  {
+    return f < m_numTris ? 3 * f : 3 * m_numTris + 4 * (f - m_numTris);
+  }
+
+  index_t face_size (index_t const f) const         {return f < m_numTris ? 3 : 4;}
+
+  GrobIndex face_grob_index (index_t const f) const
+  {
+    return f < m_numTris ? GrobIndex (TRI, f) : GrobIndex (QUAD, f - m_numTris);
+  }
+
+  /// Calls `func (h)` for the outgoing half-edges of `v` in counterclockwise order.
+  /** Exactly one half-edge per incident face of the fan is visited.*/
+  template <class TFunc>
+  void for_each_outgoing (index_t const v, TFunc const& func) const
+  {
+    index_t const first = m_vertexHalfEdges [v];
+    if (first == NO_INDEX)
+      return;
+
+    index_t h = first;
+    do {
+      func (h);
+      h = m_twin [prev (h)];
+    } while (h != NO_INDEX && h != first);
+  }
+
+  /// Calls `func (w)` for each vertex `w` in the one-ring of `v` in counterclockwise order.
+  template <class TFunc>
+  void for_each_neighbor (index_t const v, TFunc const& func) const
+  {
+    index_t const first = m_vertexHalfEdges [v];
+    if (first == NO_INDEX)
+      return;
+
+    index_t h = first;
+    for (;;) {
+      func (dest (h));
+      index_t const p = prev (h);
+      h = m_twin [p];
+      if (h == NO_INDEX) {
+        // the last neighbor of a boundary vertex is only reached by an incoming half-edge
+        func (m_vertex [p]);
+        return;
+      }
+      if (h == first)
+        return;
+    }
+  }
+
+  /// Returns the faces of the given type (`TRI` or `QUAD`) with the corner order they were created with.
+  GrobArray grobs (GrobType grobType) const;
+
+  /// Half-edges of edges which are shared by more than two faces or by inconsistently oriented faces
+  std::vector <index_t> const& non_manifold_half_edges () const  {return m_nonManifoldHalfEdges;}
+  /// Vertices whose incident faces don't form a single fan
+  std::vector <index_t> const& non_manifold_vertices () const    {return m_nonManifoldVertices;}
+
+  bool is_manifold () const
+  {
+    return m_nonManifoldHalfEdges.empty () && m_nonManifoldVertices.empty ();
+  }
+
+private:
+  index_t m_numTris {0};
+  index_t m_numQuads {0};
+
+  std::vector <index_t> m_next;
+  std::vector <index_t> m_twin;
+  std::vector <index_t> m_vertex;
+  std::vector <index_t> m_face;
+  std::vector <index_t> m_vertexHalfEdges;
+
+  std::vector <index_t> m_nonManifoldHalfEdges;
+  std::vector <index_t> m_nonManifoldVertices;
+};
+
+}// end of namespace lume
@@ -49,9 +49,11 @@ public:
       index_t m_index;
     };
 
-    ConstGrob parent;
-    index_t firstChild;
-    index_t numChildren;
+    ConstGrob parent {VERTEX};
+    index_t firstChild {0};
+    index_t numChildren {0};
+    /// index of `parent` in the parent mesh. `NO_INDEX` if `parent` is not stored in the parent mesh.
+    index_t parentIndex {NO_INDEX};
 
     ChildIterator begin () const {return ChildIterator (firstChild);}
     ChildIterator end   () const {return ChildIterator (firstChild + numChildren);}
@@ -77,14 +79,25 @@ public:
 
   Mesh const& parent_mesh () const {return *m_parentMesh;}
   Mesh&       child_mesh  ()       {return *m_childMesh;}
+  Mesh const& child_mesh  () const {return *m_childMesh;}
+
+  SPMesh shared_child_mesh () const {return m_childMesh;}
 
   void reserve (GrobType childType, size_t const numParents)
   {
     m_relationsByChildType [childType].reserve (numParents);
   }
 
+  /** Resizes the array of relations for the given child type.
+    Use `set_relation` to fill the array afterwards. Different relations may be set
+    concurrently, e.g. from within a `parallel_for`.*/
+  void resize (GrobType childType, size_t const numRelations)
+  {
+    m_relationsByChildType [childType].resize (numRelations);
+  }
+
   /** Returns an array of relations between parents and their consecutive children.*/
-  std::vector <Relation> const& relationsForChildType (GrobType childType)
+  std::vector <Relation> const& relationsForChildType (GrobType childType) const
   {
     return m_relationsByChildType [childType];
   }
@@ -92,9 +105,20 @@ public:
   void add_relation (const ConstGrob& parent,
                      GrobType const childType,
                      index_t const firstChild,
-                     index_t const numChildren)
+                     index_t const numChildren,
+                     index_t const parentIndex = NO_INDEX)
+  {
+    m_relationsByChildType [childType].emplace_back (Relation {parent, firstChild, numChildren, parentIndex});
+  }
+
+  void set_relation (size_t const relationIndex,
+                     const ConstGrob& parent,
+                     GrobType const childType,
+                     index_t const firstChild,
+                     index_t const numChildren,
+                     index_t const parentIndex = NO_INDEX)
   {
-    m_relationsByChildType [childType].emplace_back (Relation {parent, firstChild, numChildren});
+    m_relationsByChildType [childType][relationIndex] = Relation {parent, firstChild, numChildren, parentIndex};
   }
 
 private:
@@ -0,0 +1,80 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <lume/grob.h>
+#include <lume/types.h>
+
+namespace lume
+{
+namespace impl
+{
+
+/// Children of a regularly refined tetrahedron, given through local refinement vertices.
+/** Local refinement vertices are the corners of the tetrahedron followed by the centers
+  of its edges in the local numbering of `GrobDesc`. The four corner tetrahedra are
+  followed by the inner octahedron, which is split along the diagonal between the
+  centers of the edges 0 and 5, 1 and 3, or 2 and 4.*/
+inline constexpr index_t g_tetChildren [3][32] = {
+  {0, 4, 6, 7,  4, 1, 5, 8,  6, 5, 2, 9,  7, 8, 9, 3,
+   4, 9, 8, 5,  4, 9, 5, 6,  4, 9, 6, 7,  4, 9, 7, 8},
+  {0, 4, 6, 7,  4, 1, 5, 8,  6, 5, 2, 9,  7, 8, 9, 3,
+   5, 7, 6, 4,  5, 7, 4, 8,  5, 7, 8, 9,  5, 7, 9, 6},
+  {0, 4, 6, 7,  4, 1, 5, 8,  6, 5, 2, 9,  7, 8, 9, 3,
+   6, 8, 7, 4,  6, 8, 4, 5,  6, 8, 5, 9,  6, 8, 9, 7}};
+
+/// Returns the variant of `g_tetChildren` whose inner octahedron is split along the shortest diagonal.
+inline index_t ShortestOctahedronDiagonal (ConstGrob const& tet, real_t const* coords, index_t const tupleSize)
+{
+//  the diagonal between the centers of the opposite edges (a,b) and (c,d)
+//  has the length |a + b - c - d| / 2.
+  static index_t const oppositeEdges [3][4] = {{0, 1, 2, 3}, {1, 2, 0, 3}, {2, 0, 1, 3}};
+
+  index_t bestVariant = 0;
+  real_t  bestLengthSq = 0;
+  for (index_t variant = 0; variant < 3; ++variant)
+  {
+    index_t const* c = oppositeEdges [variant];
+    real_t const* a = coords + tet.corner (c [0]) * tupleSize;
+    real_t const* b = coords + tet.corner (c [1]) * tupleSize;
+    real_t const* d = coords + tet.corner (c [2]) * tupleSize;
+    real_t const* e = coords + tet.corner (c [3]) * tupleSize;
+
+    real_t lengthSq = 0;
+    for (index_t i = 0; i < tupleSize; ++i) {
+      real_t const v = a [i] + b [i] - d [i] - e [i];
+      lengthSq += v * v;
+    }
+
+    if (variant == 0 || lengthSq < bestLengthSq) {
+      bestVariant = variant;
+      bestLengthSq = lengthSq;
+    }
+  }
+  return bestVariant;
+}
+
+}// end of namespace impl
+}// end of namespace lume
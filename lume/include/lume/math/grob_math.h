@@ -30,13 +30,15 @@
 namespace lume::math
 {
 
-template <class T>
-TupleWithStorage <T>
-GrobCenter (ConstGrob const& grob, ConstTupleView <T> const& coords)
+/// Returns the average of the corner coordinates of `grob`.
+/** If `coords` has a compile-time tuple size, the returned tuple has the same compile-time size.*/
+template <class T, size_t N>
+TupleWithStorage <T, N>
+GrobCenter (ConstGrob const& grob, ConstTupleView <T, N> const& coords)
 {
   assert (grob.num_corners ());
 
-  auto sum = TupleWithStorage <T>::uninitialized (coords.tuple_size ());
+  auto sum = TupleWithStorage <T, N>::uninitialized (coords.tuple_size ());
   sum = T (0);
 
   index_t const numCorners = grob.num_corners ();
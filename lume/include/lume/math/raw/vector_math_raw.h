@@ -26,8 +26,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 #include "lume/types.h"
+#include "lume/math/tuple_size.h"
 
 namespace lume::math::raw
 {
@@ -99,6 +101,16 @@ real_t* VecScaleInplace (real_t* vInOut, const size_t n, const value_t s)
 	return vInOut;
 }
 
+///	Adds `s * v` to `vInOut`
+template <class real_t, class value_t>
+real_t* VecAxpy (real_t* vInOut, const size_t n, const value_t s, const real_t* v)
+{
+	const real_t ts = static_cast <real_t> (s);
+	for (size_t i = 0; i < n; ++i)
+		vInOut [i] += ts * v [i];
+	return vInOut;
+}
+
 template <class real_t>
 real_t VecDot (const real_t* v0, const size_t n, const real_t* v1)
 {
@@ -162,6 +174,79 @@ real_t* VecNormalizeInplace (real_t* v, const size_t n)
 	return v;
 }
 
+/**	\name Kernels for a compile-time tuple size
+ * The following overloads take the tuple size `N` as template argument. The
+ * tuples are processed in blocks so that the loops over a block have a constant
+ * trip count and can be vectorized by the compiler. The runtime tuple size
+ * overloads below dispatch to these kernels for tuple sizes 1 to 4.
+ * \{
+ */
+template <size_t N, class real_t>
+real_t* VecTupNormalizeInplace (real_t* vInOut, const size_t n)
+{
+	static_assert (N != dynamicSize, "A compile-time tuple size is required");
+	constexpr size_t blockSize = 64;
+	real_t scale [blockSize];
+
+	const size_t numTuples = n / N;
+	for(size_t first = 0; first < numTuples; first += blockSize) {
+		const size_t num = std::min (blockSize, numTuples - first);
+		real_t* v = vInOut + first * N;
+
+		for(size_t i = 0; i < num; ++i) {
+			real_t lenSq = 0;
+			for(size_t j = 0; j < N; ++j)
+				lenSq += v [i * N + j] * v [i * N + j];
+			scale [i] = lenSq;
+		}
+
+	//	tuples of length 0 are left untouched
+		for(size_t i = 0; i < num; ++i)
+			scale [i] = scale [i] != 0 ? real_t (1) / std::sqrt (scale [i]) : real_t (1);
+
+		for(size_t i = 0; i < num; ++i) {
+			for(size_t j = 0; j < N; ++j)
+				v [i * N + j] *= scale [i];
+		}
+	}
+	return vInOut;
+}
+
+template <size_t N, class real_t>
+real_t* VecTupSum (real_t* tupOut, const real_t* v, const size_t n)
+{
+	static_assert (N != dynamicSize, "A compile-time tuple size is required");
+	real_t sum [N] = {};
+	for(size_t i = 0; i < n; i += N) {
+		for(size_t j = 0; j < N; ++j)
+			sum [j] += v [i + j];
+	}
+	VecCopy (tupOut, N, sum);
+	return tupOut;
+}
+
+template <size_t N, class real_t>
+void VecTupBoundingBox (real_t* minOut, real_t* maxOut, const real_t* v, const size_t n)
+{
+	static_assert (N != dynamicSize, "A compile-time tuple size is required");
+	if (n < N)
+		return;
+
+	real_t lo [N], hi [N];
+	VecCopy (lo, N, v);
+	VecCopy (hi, N, v);
+	for(size_t i = N; i < n; i += N) {
+		for(size_t j = 0; j < N; ++j) {
+			lo [j] = std::min (lo [j], v [i + j]);
+			hi [j] = std::max (hi [j], v [i + j]);
+		}
+	}
+	VecCopy (minOut, N, lo);
+	VecCopy (maxOut, N, hi);
+}
+/** \} */
+
+
 ///	Adds the tuple `vtup` to each tuple in `vInOut`
 /** Considers the contents of `v` to be a sequence of tuples of size `ntup`.
  * \param vInOut	resulting vector of size `n`
@@ -173,7 +258,7 @@ template <class real_t>
 real_t* VecTupAddInplace (real_t* vInOut, const size_t n, const size_t ntup, const real_t* vtup)
 {
 	for(size_t i = 0; i < n; i += ntup)
-		VecAppend (vInOut + i, ntup, vtup);
+		VecAddInplace (vInOut + i, ntup, vtup);
 	return vInOut;
 }
 
@@ -205,37 +290,44 @@ template <class real_t>
 real_t* VecTupSubtract (real_t* vOut, const real_t* v, const size_t n, const size_t ntup, const real_t* vtup)
 {
 	for(size_t i = 0; i < n; i += ntup)
-		VecSub (vOut + i, ntup, v + i, vtup);
+		VecSubtract (vOut + i, ntup, v + i, vtup);
 	return vOut;
 }
 
-///	Normalizes each tuple in `v`
-/** Considers the contents of `v` to be a sequence of tuples of size `ntup`.
- * \param vOut		resulting vector of size `n`
- * \param v			vector of size `n`
+///	Normalizes each tuple in `vInOut`
+/** Considers the contents of `vInOut` to be a sequence of tuples of size `ntup`.
+ * \param vInOut	resulting vector of size `n`
  * \param n			number of entries in `v`
  * \param ntup		number of entries of one tuple
  */
 template <class real_t>
-real_t* VecTupNormalize (real_t* vOut, const size_t n, const size_t ntup, const real_t* v)
+real_t* VecTupNormalizeInplace (real_t* vInOut, const size_t n, const size_t ntup)
 {
-	for(size_t i = 0; i < n; i += ntup)
-		VecNormalize (vOut + i, ntup, v + i);
-	return vOut;
+	return DispatchTupleSize (ntup, [&] (auto tupleSize) {
+		constexpr size_t N = decltype (tupleSize)::value;
+		if constexpr (N != dynamicSize)
+			return VecTupNormalizeInplace <N> (vInOut, n);
+		else {
+			for(size_t i = 0; i < n; i += ntup)
+				VecNormalizeInplace (vInOut + i, ntup);
+			return vInOut;
+		}
+	});
 }
 
-///	Normalizes each tuple in `vInOut`
-/** Considers the contents of `vInOut` to be a sequence of tuples of size `ntup`.
- * \param vInOut	resulting vector of size `n`
+///	Normalizes each tuple in `v`
+/** Considers the contents of `v` to be a sequence of tuples of size `ntup`.
+ * \param vOut		resulting vector of size `n`
+ * \param v			vector of size `n`
  * \param n			number of entries in `v`
  * \param ntup		number of entries of one tuple
  */
 template <class real_t>
-real_t* VecTupNormalizeInplace (real_t* vInOut, const size_t n, const size_t ntup)
+real_t* VecTupNormalize (real_t* vOut, const size_t n, const size_t ntup, const real_t* v)
 {
-	for(size_t i = 0; i < n; i += ntup)
-		VecNormalizeInplace (vInOut + i, ntup);
-	return vInOut;
+	if (vOut != v)
+		VecCopy (vOut, n, v);
+	return VecTupNormalizeInplace (vOut, n, ntup);
 }
 
 ///	Computes the sum of all tuples in `v`.
@@ -248,10 +340,17 @@ real_t* VecTupNormalizeInplace (real_t* vInOut, const size_t n, const size_t ntu
 template <class real_t>
 real_t* VecTupSum (real_t* tupOut, const real_t* v, const size_t n, const size_t ntup)
 {
-	VecSet (tupOut, ntup, 0);
-	for(size_t i = 0; i < n; i += ntup)
-		VecAddInplace (tupOut, ntup, v + i);
-	return tupOut;
+	return DispatchTupleSize (ntup, [&] (auto tupleSize) {
+		constexpr size_t N = decltype (tupleSize)::value;
+		if constexpr (N != dynamicSize)
+			return VecTupSum <N> (tupOut, v, n);
+		else {
+			VecSet (tupOut, ntup, 0);
+			for(size_t i = 0; i < n; i += ntup)
+				VecAddInplace (tupOut, ntup, v + i);
+			return tupOut;
+		}
+	});
 }
 
 ///	Computes the average of all tuples in `v`.
@@ -270,6 +369,35 @@ real_t* VecTupAverage (real_t* tupOut, const real_t* v, const size_t n, const si
 	return tupOut;
 }
 
+///	Computes the component-wise minimum and maximum of all tuples in `v`.
+/** Considers the contents of `v` to be a sequence of tuples of size `ntup`.
+ * If `v` is empty, `minOut` and `maxOut` are left untouched.
+ * \param minOut	the component-wise minimum. Array of size `ntup`
+ * \param maxOut	the component-wise maximum. Array of size `ntup`
+ * \param v			vector of size `n`
+ * \param n			number of entries in `v`
+ * \param ntup		number of entries of one tuple
+ */
+template <class real_t>
+void VecTupBoundingBox (real_t* minOut, real_t* maxOut, const real_t* v, const size_t n, const size_t ntup)
+{
+	DispatchTupleSize (ntup, [&] (auto tupleSize) {
+		constexpr size_t N = decltype (tupleSize)::value;
+		if constexpr (N != dynamicSize)
+			VecTupBoundingBox <N> (minOut, maxOut, v, n);
+		else if (n >= ntup) {
+			VecCopy (minOut, ntup, v);
+			VecCopy (maxOut, ntup, v);
+			for(size_t i = ntup; i < n; i += ntup) {
+				for(size_t j = 0; j < ntup; ++j) {
+					minOut [j] = std::min (minOut [j], v [i + j]);
+					maxOut [j] = std::max (maxOut [j], v [i + j]);
+				}
+			}
+		}
+	});
+}
+
 
 template <class real_t>
 real_t* VecCross3 (real_t* vOut, const real_t* v0, const real_t* v1)
@@ -25,8 +25,10 @@
 #pragma once
 
 #include <array>
+#include <cassert>
 
 #include <lume/math/raw/vector_math_raw.h>
+#include <lume/math/tuple_size.h>
 
 namespace lume::math::detail::tuple_storage
 {
@@ -70,7 +72,7 @@ private:
     T const* const m_data;
 };
 
-template <class T>
+template <class T, size_t N = dynamicSize>
 struct Array
 {
     using value_type     = T;
@@ -78,14 +80,13 @@ struct Array
     using const_ptr_type = const T*;
     using ref_type       = T&;
 
-    static constexpr size_t maxSize = 4;
+    static constexpr size_t maxSize = N == dynamicSize ? 4 : N;
 
     Array () = default;
 
     Array (T const* data, size_t const size)
-        : m_data (data)
     {
-        assert (size < m_data.size ());
+        assert (size <= m_data.size ());
         lume::math::raw::VecCopy (m_data.data (), size, data);
     }
 
@@ -102,7 +103,9 @@ private:
 namespace lume::math::detail
 {
 
-template <class Storage>
+/** If `N != dynamicSize`, the size of the tuple is the compile-time constant `N`,
+    which allows the compiler to unroll and vectorize all element loops.*/
+template <class Storage, size_t N = dynamicSize>
 class TupleTemplate
 {
 public:
@@ -110,15 +113,18 @@ public:
     using ptr_type             = typename Storage::ptr_type;
     using const_ptr_type       = typename Storage::const_ptr_type;
     using ref_type             = typename Storage::ref_type;
-    using array_storage_t      = tuple_storage::Array <value_type>;
-    using tuple_with_storage_t = TupleTemplate <array_storage_t>;
+    using array_storage_t      = tuple_storage::Array <value_type, N>;
+    using tuple_with_storage_t = TupleTemplate <array_storage_t, N>;
+
+    static constexpr size_t staticSize = N;
 
-    size_t size () const {return m_size;}
+    size_t size () const {return m_size.value ();}
 
-    static TupleTemplate <tuple_storage::Array <value_type>>
-    uninitialized (size_t const size)
+    static tuple_with_storage_t
+    uninitialized (size_t const size = N)
     {
-        assert (size < array_storage_t::maxSize);
+        assert (size <= array_storage_t::maxSize);
+        assert (N == dynamicSize || size == N);
         return tuple_with_storage_t (size);
     }
 
@@ -137,7 +143,9 @@ public:
     TupleTemplate (T* data, size_t const size)
         : m_storage (data, size)
         , m_size (size)
-    {}
+    {
+        assert (N == dynamicSize || size == N);
+    }
 
     TupleTemplate& operator = (value_type const& v);
     
@@ -187,15 +195,15 @@ public:
     TupleTemplate& normalize ();
 
 private:
-    TupleTemplate () = default;
-    
+    template <class, size_t> friend class TupleTemplate;
+
     TupleTemplate (size_t const size)
         : m_size (size)
     {}
 
 private:
     Storage m_storage;
-    size_t const m_size;
+    TupleSize <N> m_size;
 };
 
 }
@@ -208,41 +216,54 @@ namespace lume::math
     \warning Make sure that the underlying memory region is valid as long as the associated tuple exists.
     \{
 */
-template <class T>
-using Tuple            = detail::TupleTemplate <detail::tuple_storage::Pointer <T>>;
+template <class T, size_t N = dynamicSize>
+using Tuple            = detail::TupleTemplate <detail::tuple_storage::Pointer <T>, N>;
 
-template <class T>
-using ConstTuple       = detail::TupleTemplate <detail::tuple_storage::ConstPointer <T>>;
+template <class T, size_t N = dynamicSize>
+using ConstTuple       = detail::TupleTemplate <detail::tuple_storage::ConstPointer <T>, N>;
 /** \} */
 
-template <class T>
-using TupleWithStorage = detail::TupleTemplate <detail::tuple_storage::Array <T>>;
+template <class T, size_t N = dynamicSize>
+using TupleWithStorage = detail::TupleTemplate <detail::tuple_storage::Array <T, N>, N>;
+
+}
+
+namespace lume::math::detail
+{
+
+/// Size of the result of a binary operation on tuples with sizes `NA` and `NB`.
+template <size_t NA, size_t NB>
+struct CommonTupleSize
+{
+    static_assert (NA == NB || NA == dynamicSize || NB == dynamicSize, "Tuple sizes don't match");
+    static constexpr size_t value = NA != dynamicSize ? NA : NB;
+};
 
 }
 
-template <class StorageA, class StorageB>
-lume::math::TupleWithStorage <typename StorageA::value_type>
-operator + (lume::math::detail::TupleTemplate <StorageA> const& a,
-            lume::math::detail::TupleTemplate <StorageB> const& b);
+template <class StorageA, size_t NA, class StorageB, size_t NB>
+lume::math::TupleWithStorage <typename StorageA::value_type, lume::math::detail::CommonTupleSize <NA, NB>::value>
+operator + (lume::math::detail::TupleTemplate <StorageA, NA> const& a,
+            lume::math::detail::TupleTemplate <StorageB, NB> const& b);
 
-template <class StorageA, class StorageB>
-lume::math::TupleWithStorage <typename StorageA::value_type>
-operator - (lume::math::detail::TupleTemplate <StorageA> const& a,
-            lume::math::detail::TupleTemplate <StorageB> const& b);
+template <class StorageA, size_t NA, class StorageB, size_t NB>
+lume::math::TupleWithStorage <typename StorageA::value_type, lume::math::detail::CommonTupleSize <NA, NB>::value>
+operator - (lume::math::detail::TupleTemplate <StorageA, NA> const& a,
+            lume::math::detail::TupleTemplate <StorageB, NB> const& b);
 
-template <class Storage>
-lume::math::TupleWithStorage <typename Storage::value_type>
+template <class Storage, size_t N>
+lume::math::TupleWithStorage <typename Storage::value_type, N>
 operator * (const typename Storage::value_type s,
-            lume::math::detail::TupleTemplate <Storage> const& a);
+            lume::math::detail::TupleTemplate <Storage, N> const& a);
 
-template <class Storage>
-lume::math::TupleWithStorage <typename Storage::value_type>
-operator * (lume::math::detail::TupleTemplate <Storage> const& a,
+template <class Storage, size_t N>
+lume::math::TupleWithStorage <typename Storage::value_type, N>
+operator * (lume::math::detail::TupleTemplate <Storage, N> const& a,
             const typename Storage::value_type s);
 
-template <class Storage>
-lume::math::TupleWithStorage <typename Storage::value_type>
-operator / (lume::math::detail::TupleTemplate <Storage> const& a,
+template <class Storage, size_t N>
+lume::math::TupleWithStorage <typename Storage::value_type, N>
+operator / (lume::math::detail::TupleTemplate <Storage, N> const& a,
             const typename Storage::value_type s);
 
 #include <lume/math/tuple_impl.h>
@@ -29,8 +29,8 @@
 namespace lume::math::detail
 {
 
-template <class Storage>
-TupleTemplate <Storage>& TupleTemplate <Storage>:: operator = (value_type const& v)
+template <class Storage, size_t N>
+TupleTemplate <Storage, N>& TupleTemplate <Storage, N>:: operator = (value_type const& v)
 {
     for(size_t i = 0; i < size (); ++i) {
         value (i) = v;
@@ -38,9 +38,9 @@ TupleTemplate <Storage>& TupleTemplate <Storage>:: operator = (value_type const&
     return *this;
 }
 
-template <class Storage>
+template <class Storage, size_t N>
 template <class Array>
-TupleTemplate <Storage>& TupleTemplate <Storage>:: operator = (Array const& v)
+TupleTemplate <Storage, N>& TupleTemplate <Storage, N>:: operator = (Array const& v)
 {
     assert (size () == v.size ());
     for(size_t i = 0; i < size (); ++i) {
@@ -49,9 +49,9 @@ TupleTemplate <Storage>& TupleTemplate <Storage>:: operator = (Array const& v)
     return *this;
 }
 
-template <class Storage>
+template <class Storage, size_t N>
 template <class Array>
-TupleTemplate <Storage>& TupleTemplate <Storage>:: operator += (Array const& v)
+TupleTemplate <Storage, N>& TupleTemplate <Storage, N>:: operator += (Array const& v)
 {
     assert (size () == v.size ());
     for(size_t i = 0; i < size (); ++i) {
@@ -60,9 +60,9 @@ TupleTemplate <Storage>& TupleTemplate <Storage>:: operator += (Array const& v)
     return *this;
 }
 
-template <class Storage>
+template <class Storage, size_t N>
 template <class Array>
-TupleTemplate <Storage>& TupleTemplate <Storage>:: operator -= (Array const& v)
+TupleTemplate <Storage, N>& TupleTemplate <Storage, N>:: operator -= (Array const& v)
 {
     assert (size () == v.size ());
     for(size_t i = 0; i < size (); ++i) {
@@ -71,8 +71,8 @@ TupleTemplate <Storage>& TupleTemplate <Storage>:: operator -= (Array const& v)
     return *this;
 }
 
-template <class Storage>
-TupleTemplate <Storage>& TupleTemplate <Storage>:: operator *= (value_type const& v)
+template <class Storage, size_t N>
+TupleTemplate <Storage, N>& TupleTemplate <Storage, N>:: operator *= (value_type const& v)
 {
     for(size_t i = 0; i < size (); ++i) {
         value (i) *= v;
@@ -80,8 +80,8 @@ TupleTemplate <Storage>& TupleTemplate <Storage>:: operator *= (value_type const
     return *this;
 }
 
-template <class Storage>
-TupleTemplate <Storage>& TupleTemplate <Storage>:: operator /= (value_type const& v)
+template <class Storage, size_t N>
+TupleTemplate <Storage, N>& TupleTemplate <Storage, N>:: operator /= (value_type const& v)
 {
     for(size_t i = 0; i < size (); ++i) {
         value (i) /= v;
@@ -89,9 +89,9 @@ TupleTemplate <Storage>& TupleTemplate <Storage>:: operator /= (value_type const
     return *this;
 }
 
-template <class Storage>
+template <class Storage, size_t N>
 template <class Array>
-bool TupleTemplate <Storage>:: operator == (Array const& v) const
+bool TupleTemplate <Storage, N>:: operator == (Array const& v) const
 {
     assert (size () == v.size ());
 
@@ -104,17 +104,17 @@ bool TupleTemplate <Storage>:: operator == (Array const& v) const
     return true;
 }
 
-template <class Storage>
+template <class Storage, size_t N>
 template <class Array>
-bool TupleTemplate <Storage>:: operator != (Array const& v) const
+bool TupleTemplate <Storage, N>:: operator != (Array const& v) const
 {
     return ! (*this == v);
 }
 
-template <class Storage>
+template <class Storage, size_t N>
 template <class Array>
-typename TupleTemplate <Storage>:: value_type
-TupleTemplate <Storage>:: 
+typename TupleTemplate <Storage, N>:: value_type
+TupleTemplate <Storage, N>:: 
 dot (Array const& v) const
 {
     assert (size () == v.size ());
@@ -128,43 +128,43 @@ dot (Array const& v) const
     return d;
 }
 
-template <class Storage>
-typename TupleTemplate <Storage>:: value_type
-TupleTemplate <Storage>::
+template <class Storage, size_t N>
+typename TupleTemplate <Storage, N>:: value_type
+TupleTemplate <Storage, N>::
 length_squared () const
 {
     return dot (*this);
 }
 
-template <class Storage>
-typename TupleTemplate <Storage>:: value_type
-TupleTemplate <Storage>::
+template <class Storage, size_t N>
+typename TupleTemplate <Storage, N>:: value_type
+TupleTemplate <Storage, N>::
 length () const
 {
     return sqrt (length_squared ());
 }
 
-template <class Storage>
+template <class Storage, size_t N>
 template <class Array>
-typename TupleTemplate <Storage>:: value_type
-TupleTemplate <Storage>:: 
+typename TupleTemplate <Storage, N>:: value_type
+TupleTemplate <Storage, N>:: 
 distance_squared (Array const& v) const
 {
     return (v - *this).length_squared ();
 }
 
-template <class Storage>
+template <class Storage, size_t N>
 template <class Array>
-typename TupleTemplate <Storage>:: value_type
-TupleTemplate <Storage>::
+typename TupleTemplate <Storage, N>:: value_type
+TupleTemplate <Storage, N>::
 distance (Array const& v) const
 {
     return sqrt (distance_squared (v));
 }
 
-template <class Storage>
-typename TupleTemplate <Storage>:: tuple_with_storage_t
-TupleTemplate <Storage>::
+template <class Storage, size_t N>
+typename TupleTemplate <Storage, N>:: tuple_with_storage_t
+TupleTemplate <Storage, N>::
 normalized () const
 {
     auto const len = length ();
@@ -175,9 +175,9 @@ normalized () const
     return (*this) / len;
 }
 
-template <class Storage>
-TupleTemplate <Storage>&
-TupleTemplate <Storage>::
+template <class Storage, size_t N>
+TupleTemplate <Storage, N>&
+TupleTemplate <Storage, N>::
 normalize ()
 {
     auto const len = length ();
@@ -193,59 +193,63 @@ normalize ()
 
 }// end of namespace lume::math::detail
 
-template <class StorageA, class StorageB>
-lume::math::TupleWithStorage <typename StorageA::value_type>
-operator + (lume::math::detail::TupleTemplate <StorageA> const& a,
-            lume::math::detail::TupleTemplate <StorageB> const& b)
+template <class StorageA, size_t NA, class StorageB, size_t NB>
+lume::math::TupleWithStorage <typename StorageA::value_type, lume::math::detail::CommonTupleSize <NA, NB>::value>
+operator + (lume::math::detail::TupleTemplate <StorageA, NA> const& a,
+            lume::math::detail::TupleTemplate <StorageB, NB> const& b)
 {
+    using result_t = lume::math::TupleWithStorage <typename StorageA::value_type,
+                                                   lume::math::detail::CommonTupleSize <NA, NB>::value>;
     assert (a.size () == b.size ());
-    auto r = lume::math::TupleWithStorage <typename StorageA::value_type>::uninitialized (a.size ());
-    for(size_t i = 0; i < a.size (); ++i) {
+    auto r = result_t::uninitialized (a.size ());
+    for(size_t i = 0; i < r.size (); ++i) {
         r [i] = a[i] + b[i];
     }
     return r;
 }
 
-template <class StorageA, class StorageB>
-lume::math::TupleWithStorage <typename StorageA::value_type>
-operator - (lume::math::detail::TupleTemplate <StorageA> const& a,
-            lume::math::detail::TupleTemplate <StorageB> const& b)
+template <class StorageA, size_t NA, class StorageB, size_t NB>
+lume::math::TupleWithStorage <typename StorageA::value_type, lume::math::detail::CommonTupleSize <NA, NB>::value>
+operator - (lume::math::detail::TupleTemplate <StorageA, NA> const& a,
+            lume::math::detail::TupleTemplate <StorageB, NB> const& b)
 {
+    using result_t = lume::math::TupleWithStorage <typename StorageA::value_type,
+                                                   lume::math::detail::CommonTupleSize <NA, NB>::value>;
     assert (a.size () == b.size ());
-    auto r = lume::math::TupleWithStorage <typename StorageA::value_type>::uninitialized (a.size ());
-    for(size_t i = 0; i < a.size (); ++i) {
+    auto r = result_t::uninitialized (a.size ());
+    for(size_t i = 0; i < r.size (); ++i) {
         r [i] = a[i] - b[i];
     }
     return r;
 }
 
-template <class Storage>
-lume::math::TupleWithStorage <typename Storage::value_type>
+template <class Storage, size_t N>
+lume::math::TupleWithStorage <typename Storage::value_type, N>
 operator * (const typename Storage::value_type s,
-            lume::math::detail::TupleTemplate <Storage> const& a)
+            lume::math::detail::TupleTemplate <Storage, N> const& a)
 {
-    auto r = lume::math::TupleWithStorage <typename Storage::value_type>::uninitialized (a.size ());
-    for(size_t i = 0; i < a.size (); ++i) {
+    auto r = lume::math::TupleWithStorage <typename Storage::value_type, N>::uninitialized (a.size ());
+    for(size_t i = 0; i < r.size (); ++i) {
         r [i] = s * a[i];
     }
     return r;
 }
 
-template <class Storage>
-lume::math::TupleWithStorage <typename Storage::value_type>
-operator * (lume::math::detail::TupleTemplate <Storage> const& a,
+template <class Storage, size_t N>
+lume::math::TupleWithStorage <typename Storage::value_type, N>
+operator * (lume::math::detail::TupleTemplate <Storage, N> const& a,
             const typename Storage::value_type s)
 {
     return s * a;
 }
 
-template <class Storage>
-lume::math::TupleWithStorage <typename Storage::value_type>
-operator / (lume::math::detail::TupleTemplate <Storage> const& a,
+template <class Storage, size_t N>
+lume::math::TupleWithStorage <typename Storage::value_type, N>
+operator / (lume::math::detail::TupleTemplate <Storage, N> const& a,
             const typename Storage::value_type s)
 {
-    auto r = lume::math::TupleWithStorage <typename Storage:: value_type>:: uninitialized (a.size ());
-    for(size_t i = 0; i < a.size (); ++i) {
+    auto r = lume::math::TupleWithStorage <typename Storage:: value_type, N>:: uninitialized (a.size ());
+    for(size_t i = 0; i < r.size (); ++i) {
         r [i] = a[i] / s;
     }
     return r;
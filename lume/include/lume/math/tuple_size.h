@@ -0,0 +1,86 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace lume::math
+{
+
+/// Used as tuple size template argument for tuples whose size is only known at runtime.
+static constexpr size_t dynamicSize = 0;
+
+namespace detail
+{
+
+/// Holds the size of a tuple. For `N != dynamicSize` the size is a compile-time constant.
+template <size_t N>
+class TupleSize
+{
+public:
+    TupleSize () = default;
+    TupleSize (size_t const)                      {}
+    static constexpr size_t value ()              {return N;}
+};
+
+template <>
+class TupleSize <dynamicSize>
+{
+public:
+    TupleSize (size_t const size) : m_size (size) {}
+    size_t value () const                         {return m_size;}
+
+private:
+    size_t m_size;
+};
+
+}// end of namespace detail
+
+/// Calls `f (std::integral_constant <size_t, N> ())` with `N == tupleSize` for tuple sizes 1, 2, 3 and 4.
+/** For all other tuple sizes `N == dynamicSize` is passed to `f`. This allows to
+    dispatch from a runtime tuple size to code which is specialized for a compile-time
+    tuple size:
+    \code
+    DispatchTupleSize (coords.tuple_size (), [&] (auto n) {
+        constexpr size_t N = decltype (n)::value;
+        TupleView <real_t, N> view (coords);
+        // ...
+    });
+    \endcode
+*/
+template <class F>
+decltype (auto) DispatchTupleSize (size_t const tupleSize, F&& f)
+{
+    switch (tupleSize) {
+        case 1:  return f (std::integral_constant <size_t, 1> ());
+        case 2:  return f (std::integral_constant <size_t, 2> ());
+        case 3:  return f (std::integral_constant <size_t, 3> ());
+        case 4:  return f (std::integral_constant <size_t, 4> ());
+        default: return f (std::integral_constant <size_t, dynamicSize> ());
+    }
+}
+
+}// end of namespace lume::math
@@ -24,37 +24,48 @@
 
 #pragma once
 
+#include <cassert>
 #include <lume/math/vector_math.h>
 #include <lume/math/tuple.h>
 #include <lume/math/raw/vector_math_raw.h>
+#include <lume/math/tuple_size.h>
 
 namespace lume::math
 {
 
-template <class T>
+/// A view on a contiguous sequence of tuples, e.g. the contents of an `ArrayAnnex`.
+/** If `N != dynamicSize`, the tuple size is the compile-time constant `N` and the tuples
+    returned by the index operator have a compile-time size, too. Use `DispatchTupleSize`
+    to select a fixed-size view for a runtime tuple size.*/
+template <class T, size_t N = dynamicSize>
 class TupleView
 {
 public:
     using value_type = T;
     using value_t = value_type;
 
+    static constexpr size_t staticTupleSize = N;
+
     template <class Container>
     TupleView (Container& container)
         : TupleView (container.data (), container.num_tuples (), container.tuple_size ())
     {}
 
-    TupleView (T* data, size_t const numTuples, size_t const tupleSize)
+    TupleView (T* data, size_t const numTuples, size_t const tupleSize = N)
         : m_data (data)
         , m_numTuples (numTuples)
         , m_tupleSize (tupleSize)
-    {}
+    {
+        assert (N == dynamicSize || tupleSize == N);
+    }
 
-    Tuple <T>      operator [] (size_t const itup)       {return Tuple <T> (m_data + m_tupleSize * itup, m_tupleSize);}
-    ConstTuple <T> operator [] (size_t const itup) const {return Tuple <T> (m_data + m_tupleSize * itup, m_tupleSize);}
+    Tuple <T, N>      operator [] (size_t const itup)       {return Tuple <T, N> (m_data + tuple_size () * itup, tuple_size ());}
+    ConstTuple <T, N> operator [] (size_t const itup) const {return ConstTuple <T, N> (m_data + tuple_size () * itup, tuple_size ());}
 
+    T*       data ()                 {return m_data;}
     T const* data ()           const {return m_data;}
     size_t   size ()           const {return m_numTuples;}
-    size_t   tuple_size ()     const {return m_tupleSize;}
+    size_t   tuple_size ()     const {return m_tupleSize.value ();}
     size_t   num_components () const {return size () * tuple_size ();}
 
     TupleView& operator = (T const v) 
@@ -65,51 +76,58 @@ public:
     
     TupleView& normalize ()
     {
-        lume::math::raw::VecTupNormalizeInplace (m_data, num_components (), tuple_size ());
+        if constexpr (N == dynamicSize)
+            lume::math::raw::VecTupNormalizeInplace (m_data, num_components (), tuple_size ());
+        else
+            lume::math::raw::VecTupNormalizeInplace <N> (m_data, num_components ());
         return *this;
     }
 
 private:
-    T*     const m_data;
-    size_t const m_numTuples;
-    size_t const m_tupleSize;
+    T*                     const m_data;
+    size_t                 const m_numTuples;
+    detail::TupleSize <N>  const m_tupleSize;
 };
 
-template <class T>
+template <class T, size_t N = dynamicSize>
 class ConstTupleView
 {
 public:
     using value_type = T;
     using value_t = value_type;
 
+    static constexpr size_t staticTupleSize = N;
+
     template <class Container>
     ConstTupleView (Container& container)
         : ConstTupleView (container.data (), container.num_tuples (), container.tuple_size ())
     {}
 
-    ConstTupleView (T const* data, size_t const numTuples, size_t const tupleSize)
+    ConstTupleView (T const* data, size_t const numTuples, size_t const tupleSize = N)
         : m_data (data)
         , m_numTuples (numTuples)
         , m_tupleSize (tupleSize)
-    {}
+    {
+        assert (N == dynamicSize || tupleSize == N);
+    }
 
-    ConstTupleView (const TupleView <T>& t)
+    ConstTupleView (const TupleView <T, N>& t)
         : m_data (t.data ())
         , m_numTuples (t.size ())
         , m_tupleSize (t.tuple_size ())
     {}
 
-    ConstTuple <T> operator [] (size_t const itup) const {return ConstTuple <T> (m_data + m_tupleSize * itup, m_tupleSize);}
+    ConstTuple <T, N> operator [] (size_t const itup) const {return ConstTuple <T, N> (m_data + tuple_size () * itup, tuple_size ());}
 
     T const* data ()           const {return m_data;}
     size_t   size ()           const {return m_numTuples;}
-    size_t   tuple_size ()     const {return m_tupleSize;}
+    size_t   tuple_size ()     const {return m_tupleSize.value ();}
     size_t   num_components () const {return size () * tuple_size ();}
     
 private:
-    T const* const m_data;
-    size_t   const m_numTuples;
-    size_t   const m_tupleSize;
+    T const*               const m_data;
+    size_t                 const m_numTuples;
+    detail::TupleSize <N>  const m_tupleSize;
 };
 
 template <class Container>
@@ -126,4 +144,21 @@ MakeTupleView (Container const& c)
     return ConstTupleView <typename Container::value_type> (c.data (), c.num_tuples (), c.tuple_size ());
 }
 
+/// Creates a view with compile-time tuple size `N`. The tuple size of `c` has to be `N`.
+/** \{ */
+template <size_t N, class Container>
+TupleView <typename Container::value_type, N>
+MakeTupleView (Container& c)
+{
+    return TupleView <typename Container::value_type, N> (c.data (), c.num_tuples (), c.tuple_size ());
+}
+
+template <size_t N, class Container>
+ConstTupleView <typename Container::value_type, N>
+MakeTupleView (Container const& c)
+{
+    return ConstTupleView <typename Container::value_type, N> (c.data (), c.num_tuples (), c.tuple_size ());
+}
+/** \} */
+
 }// end of namespace lume::math
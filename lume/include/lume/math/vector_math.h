@@ -124,6 +124,16 @@ VecScale (VecOut& out, const VecIn& in, typename VecIn::value_type const s)
     return out;
 }
 
+/// Adds `s * in` to `inOut`
+template <class VecInOut, class VecIn>
+VecInOut&
+VecAxpy (VecInOut& inOut, typename VecInOut::value_type const s, const VecIn& in)
+{
+    assert (SizesMatch (inOut, in));
+    raw::VecAxpy (inOut.data (), inOut.size (), s, in.data ());
+    return inOut;
+}
+
 template <class Vec1, class Vec2>
 typename Vec1::value_type
 VecDot (const Vec1& a, const Vec2& b)
@@ -241,6 +251,16 @@ Tuple& VecTupAverage (Tuple& out, VecIn const& in)
     return out;
 }
 
+/// Computes the component-wise minimum and maximum of all tuples in `in`.
+/** Considers the contents of `in` to be a sequence of tuples, each of size `minOut.size ()`.*/
+template <class Tuple, class VecIn>
+void VecTupBoundingBox (Tuple& minOut, Tuple& maxOut, VecIn const& in)
+{
+    assert (SizesMatch (minOut, maxOut));
+    raw::VecTupBoundingBox (minOut.data (), maxOut.data (), in.data (), in.size (), minOut.size ());
+}
+
+
 
 template <class VecOut, class VecIn1, class VecIn2>
 VecOut& VecCross3 (VecOut& out, VecIn1 const& v0, VecIn2 const& v1)
@@ -37,6 +37,7 @@
 
 #include "annex.h"
 #include "annex_key.h"
+#include "derived_data_cache.h"
 #include "grob.h"
 #include "grob_array.h"
 #include "grob_hash.h"
@@ -244,6 +245,37 @@ public:
       link.reset ();
   }
 
+  /// Returns data derived from this mesh, which is built on first request and then cached.
+  /** The cached instance is shared by all callers until grobs of one of the given
+      `grobTypes` are changed through the non-const interface of the mesh or until one
+      of the given annexes is replaced or removed. See `DerivedDataCache::get` for a
+      description of the parameters. The cached accessors in `derived_data.h` should
+      be preferred over calling this method directly.
+
+      \note  Changes through references obtained from `grobs (GrobType)` or from
+             `annex (key)` can't be detected. Call `invalidate_derived_data` after
+             such modifications.*/
+  template <class T, class TBuilder>
+  std::shared_ptr <T const> derived_data (std::string const& key,
+                                          DerivedDataCache::GrobTypeMask const& grobTypes,
+                                          std::vector <AnnexKey> annexKeys,
+                                          TBuilder const& build) const
+  {
+    return m_derivedData.get <T> (key, grobTypes, std::move (annexKeys), build);
+  }
+
+  /// Removes all cached derived data, see `derived_data`.
+  void invalidate_derived_data ()
+  {
+    m_derivedData.clear ();
+  }
+
+  /// Returns the number of cached derived data entries, see `derived_data`.
+  size_t num_derived_data () const
+  {
+    return m_derivedData.size ();
+  }
+
   bool has_annex (const AnnexKey& key) const
   {
     return m_annexMap.find (key) != m_annexMap.end ();
@@ -263,17 +295,30 @@ public:
     const auto ret = m_annexMap.insert_or_assign (key, std::make_unique <T> (std::move (annex)));
     T& newAnnex = *static_cast <T*> (ret.first->second.get ());
     newAnnex.update (*this, key.grob_type ());
+    m_derivedData.invalidate (key);
     return newAnnex;
   }
 
   void remove_annex (const AnnexKey& key)
   {
     m_annexMap.erase (key);
+    m_derivedData.invalidate (key);
   }
 
-  template <class T>
-  const typename TypedAnnexKey <T>::type&
-  annex (const TypedAnnexKey <T>& key) const
+  /// Returns the keys of all annexes of this mesh. Annexes of linked meshes are not included.
+  std::vector <AnnexKey> annex_keys () const
+  {
+    std::vector <AnnexKey> keys;
+    keys.reserve (m_annexMap.size ());
+    for (auto const& e : m_annexMap)
+      keys.push_back (e.first);
+    return keys;
+  }
+
+  /// Returns the annex for the given key regardless of its type.
+  /** Use `annex (const TypedAnnexKey <T>&)` if the type of the annex is known.
+   * \{ */
+  const Annex& untyped_annex (const AnnexKey& key) const
   {
     const Annex* annex = nullptr;
     auto annexIter = m_annexMap.find (key);
@@ -294,6 +339,20 @@ public:
     {
       throw NoSuchAnnexError () << "no annex found for the given key '" << key.name () << "'.";
     }
+    return *annex;
+  }
+
+  Annex& untyped_annex (const AnnexKey& key)
+  {
+    return const_cast <Annex&> (const_cast <const Mesh*> (this)->untyped_annex (key));
+  }
+  /** \} */
+
+  template <class T>
+  const typename TypedAnnexKey <T>::type&
+  annex (const TypedAnnexKey <T>& key) const
+  {
+    const Annex* annex = &untyped_annex (key);
 
     const T* typedAnnex = dynamic_cast<const T*> (annex);
 
@@ -364,7 +423,12 @@ private:
   {
     if (linked_mesh (grobType) != nullptr)
       linked_mesh (grobType)->annex_update (grobType);
-      
+
+    if (grobType)
+      m_derivedData.invalidate (*grobType);
+    else
+      m_derivedData.clear ();
+
     for (auto& e: m_annexMap)
     {
       if (e.first.grob_type () == grobType)
@@ -375,6 +439,7 @@ private:
   std::array <std::unique_ptr <GrobArray>, NUM_GROB_TYPES>   m_grobArrays;
   std::array <std::shared_ptr <Mesh>, NUM_GROB_TYPES + 1>    m_linkedMeshes;
   std::map <AnnexKey, std::unique_ptr <Annex>>               m_annexMap;
+  mutable DerivedDataCache                                   m_derivedData;
 };
 
 using SPMesh = std::shared_ptr <Mesh>;
@@ -0,0 +1,214 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <lume/array_annex.h>
+#include <lume/grob_index.h>
+#include <lume/hierarchy.h>
+#include <lume/mesh.h>
+#include <lume/refinement.h>
+
+namespace lume
+{
+
+/// Specifies how values are restricted from a fine level to a coarse level of a `MeshHierarchy`.
+enum class RestrictionType
+{
+  /// vertices only: the value of the child vertex which coincides with the parent vertex is used.
+  Injection,
+  /// the transpose of the prolongation, i.e., the weighted sum of the values of all children.
+  Transposed,
+  /// like `Transposed`, but the weighted sum is divided by the sum of weights.
+  Average
+};
+
+/// A stack of meshes, where each mesh was created by refining its predecessor.
+/** Relations between consecutive levels are stored index based:
+  - each child grob stores the index and type of its parent,
+  - each parent grob stores its first child and the number of its children for
+    each child type,
+  - each child vertex stores the vertices of its parent (its stencil), from which
+    it is interpolated during prolongation. The transposed stencils are stored
+    for restriction.
+
+  Parents which are not stored in the parent mesh (e.g. edges which are only
+  implicitly given as sides of faces) are only represented in the vertex stencils.
+
+  Prolongation and restriction of `ArrayAnnex` data are executed in parallel.
+  Element values are copied to children during prolongation. Vertex values are
+  interpolated linearly.*/
+class MeshHierarchy
+{
+public:
+  MeshHierarchy () = default;
+  explicit MeshHierarchy (SPMesh baseMesh);
+
+  /// Clears the hierarchy and sets the mesh of level 0.
+  void set_base_mesh (SPMesh baseMesh);
+
+  size_t num_levels () const                {return m_levels.size ();}
+
+  SPMesh mesh (size_t const level)          {return m_levels.at (level).mesh;}
+  CSPMesh mesh (size_t const level) const   {return m_levels.at (level).mesh;}
+
+  SPMesh top_mesh ()                        {return m_levels.back ().mesh;}
+  CSPMesh top_mesh () const                 {return m_levels.back ().mesh;}
+
+  /// Refines the top mesh through `RefineMesh` and adds the refined mesh as new level.
+  /** `callback` is executed during refinement, before the relations of the new level are stored.*/
+  SPMesh refine (RefinementCallback const& callback = AnnexTransfer ());
+
+  /// Adds the child mesh of `hierarchy` as new level. The parent mesh of `hierarchy` has to be the current top mesh.
+  /** This allows to build a hierarchy through custom refinement routines.*/
+  void add_level (Hierarchy const& hierarchy);
+
+  /// Returns the parent (in level `level - 1`) of the given grob of level `level`.
+  /** The returned index is invalid if the parent is not stored in the parent mesh.*/
+  GrobIndex parent (size_t level, GrobIndex const& child) const;
+
+  /// Returns the number of children of the given type (in level `level + 1`) of a grob of level `level`.
+  index_t num_children (size_t level, GrobIndex const& parent, GrobType childType) const;
+
+  /// Returns the index of the first child of the given type (in level `level + 1`) of a grob of level `level`.
+  /** The children of a parent are stored consecutively.*/
+  index_t first_child (size_t level, GrobIndex const& parent, GrobType childType) const;
+
+  /// Returns the number of vertices in level `level - 1` from which the given vertex of level `level` is interpolated.
+  index_t num_stencil_vertices (size_t level, index_t vertex) const;
+
+  /// Returns the vertices in level `level - 1` from which the given vertex of level `level` is interpolated.
+  index_t const* stencil_vertices (size_t level, index_t vertex) const;
+
+  /// Prolongates values of parents of type `coarseType` to their children of type `fineType` in level `fineLevel`.
+  /** `fineValuesOut` is resized to the number of grobs of type `fineType` in level `fineLevel`.
+    Values of children whose parent is not of type `coarseType` are left untouched.
+    Both annexes have to have the same tuple size.*/
+  template <class T>
+  void prolongate_annex (size_t fineLevel,
+                         ArrayAnnex <T> const& coarseValues,
+                         GrobType coarseType,
+                         ArrayAnnex <T>& fineValuesOut,
+                         GrobType fineType) const;
+
+  /// Restricts values of children of type `fineType` in level `coarseLevel + 1` to their parents of type `coarseType`.
+  /** `coarseValuesOut` is resized to the number of grobs of type `coarseType` in level `coarseLevel`.
+    Values of parents without children of type `fineType` are left untouched.
+    Both annexes have to have the same tuple size.*/
+  template <class T>
+  void restrict_annex (size_t coarseLevel,
+                       ArrayAnnex <T> const& fineValues,
+                       GrobType fineType,
+                       ArrayAnnex <T>& coarseValuesOut,
+                       GrobType coarseType,
+                       RestrictionType restrictionType) const;
+
+  /// Prolongates the annex with the given key from level `fineLevel - 1` to level `fineLevel`.
+  /** The annex is created in the fine mesh if it doesn't exist yet.*/
+  template <class T>
+  void prolongate_annex (TypedAnnexKey <ArrayAnnex <T>> const& key, size_t fineLevel);
+
+  /// Restricts the annex with the given key from level `coarseLevel + 1` to level `coarseLevel`.
+  /** The annex is created in the coarse mesh if it doesn't exist yet.*/
+  template <class T>
+  void restrict_annex (TypedAnnexKey <ArrayAnnex <T>> const& key,
+                       size_t coarseLevel,
+                       RestrictionType restrictionType);
+
+private:
+  struct ChildRange
+  {
+    std::vector <index_t> firstChild;
+    std::vector <index_t> numChildren;
+  };
+
+  struct Level
+  {
+    SPMesh mesh;
+
+  //  relations to the parent level. Empty for level 0.
+    std::array <std::vector <index_t>, NUM_GROB_TYPES>      parentIndices;
+    std::array <std::vector <std::uint8_t>, NUM_GROB_TYPES> parentTypes;
+    std::vector <index_t> stencilOffsets;
+    std::vector <index_t> stencilVertices;
+
+  //  relations to the child level. Empty for the top level.
+    std::array <std::array <ChildRange, NUM_GROB_TYPES>, NUM_GROB_TYPES> childRanges;
+    std::vector <index_t> transposedStencilOffsets;
+    std::vector <index_t> transposedStencilVertices;
+  };
+
+  template <class T>
+  ArrayAnnex <T>& get_or_create_annex (Mesh& mesh,
+                                       TypedAnnexKey <ArrayAnnex <T>> const& key,
+                                       index_t tupleSize);
+
+  std::vector <Level> m_levels;
+};
+
+
+template <class T>
+void MeshHierarchy::
+prolongate_annex (TypedAnnexKey <ArrayAnnex <T>> const& key, size_t const fineLevel)
+{
+  Mesh const& coarseMesh = *mesh (fineLevel - 1);
+  Mesh&       fineMesh   = *mesh (fineLevel);
+  GrobType const grobType = *key.grob_type ();
+
+  auto const& coarseValues = coarseMesh.annex (key);
+  auto& fineValues = get_or_create_annex (fineMesh, key, static_cast <index_t> (coarseValues.tuple_size ()));
+  prolongate_annex (fineLevel, coarseValues, grobType, fineValues, grobType);
+}
+
+template <class T>
+void MeshHierarchy::
+restrict_annex (TypedAnnexKey <ArrayAnnex <T>> const& key,
+                size_t const coarseLevel,
+                RestrictionType const restrictionType)
+{
+  Mesh&       coarseMesh = *mesh (coarseLevel);
+  Mesh const& fineMesh   = *mesh (coarseLevel + 1);
+  GrobType const grobType = *key.grob_type ();
+
+  auto const& fineValues = fineMesh.annex (key);
+  auto& coarseValues = get_or_create_annex (coarseMesh, key, static_cast <index_t> (fineValues.tuple_size ()));
+  restrict_annex (coarseLevel, fineValues, grobType, coarseValues, grobType, restrictionType);
+}
+
+template <class T>
+ArrayAnnex <T>& MeshHierarchy::
+get_or_create_annex (Mesh& mesh,
+                     TypedAnnexKey <ArrayAnnex <T>> const& key,
+                     index_t const tupleSize)
+{
+  if (!mesh.has_annex (key)) {
+    return mesh.set_annex (key, ArrayAnnex <T> (tupleSize, T (0)));
+  }
+  return mesh.annex (key);
+}
+
+}// end of namespace lume
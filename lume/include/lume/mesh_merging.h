@@ -0,0 +1,59 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <vector>
+#include <lume/mesh.h>
+
+namespace lume
+{
+
+struct MergeOptions
+{
+  /// If true, vertices closer than `weldTolerance` are merged through `WeldVertices`.
+  bool   weldVertices {false};
+  real_t weldTolerance {0};
+};
+
+/// Combines the given meshes into a single new mesh.
+/** The grobs of the meshes are appended in the order of the meshes, their corner
+  indices are offset by the number of vertices of the preceding meshes.
+
+  Array annexes of vertices and grobs are merged if their keys match, i.e., if
+  they share name and grob type. Meshes which lack an annex contribute
+  default-initialized values. All instances of an annex have to have the same value
+  type and tuple size.
+
+  `SubsetInfoAnnex` tables with the same name are merged. Subsets are identified by
+  their names, i.e., subsets with equal names in different meshes are mapped to the
+  same subset of the merged table. The grob annexes which store subset indices (the
+  `IndexArrayAnnex` instances with the name of a `SubsetInfoAnnex`) are renumbered
+  accordingly. Other global annexes are not transferred.
+
+  Output sizes are computed up front, after which all grob arrays and annexes are
+  copied in parallel in chunks of bounded size.*/
+SPMesh MergeMeshes (std::vector <CSPMesh> const& meshes, MergeOptions const& options = {});
+
+}// end of namespace lume
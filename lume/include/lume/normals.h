@@ -37,9 +37,22 @@
 
 namespace lume {
 
+/// Defines how the normals of faces are weighted when averaged at a vertex.
+enum class NormalWeighting
+{
+    /// All faces contribute equally.
+    Uniform,
+    /// Faces are weighted by their area.
+    Area,
+    /// Faces are weighted by their interior angle at the vertex.
+    Angle
+};
+
 /**	Computes the 3 dimensional vertex normals of a mesh by averaging the normals of associated faces
     and stores them in an annex of the mesh's vertices.
 
+    Faces are weighted uniformly, see `ComputeVertexNormals3` for other weightings.
+
     If not provided, the key `lume::keys::vertexCoords` is used to access vertex coordinates and
     `lume::keys::vertexNormals` is used to access vertex normals. The latter annex is created if
     not present during call-time. Both have to have a tuple size of 3.
@@ -53,6 +66,34 @@ void ComputeFaceVertexNormals3 (Mesh& mesh,
                                 math::TupleView <real_t> normals);
 /** \} */
 
+/**	Computes the 3 dimensional vertex normals of a mesh from the normals of adjacent triangles
+    and quadrilaterals, weighted as specified by `weighting`.
+
+    Face normals are computed in one parallel pass. The normal of each vertex is then
+    gathered from its adjacent faces through a vertex to face incidence table, so that
+    vertices can be processed in parallel without write conflicts.
+
+    The normals are stored in the annex `lume::keys::vertexNormals`, which is created if
+    not present during call-time. Vertex coordinates have to have a tuple size of 3.
+    Normals of vertices without adjacent faces are set to 0.
+    \{
+*/
+void ComputeVertexNormals3 (Mesh& mesh, NormalWeighting weighting = NormalWeighting::Area);
+
+void ComputeVertexNormals3 (Mesh const& mesh,
+                            math::ConstTupleView <real_t> coords,
+                            math::TupleView <real_t> normals,
+                            NormalWeighting weighting = NormalWeighting::Area);
+/** \} */
+
+/**	Computes unit normals of all triangles and quadrilaterals of a mesh and stores them in
+    the annexes `lume::keys::triNormals` and `lume::keys::quadNormals`.
+
+    The normal of a quadrilateral is the normal of the plane spanned by its diagonals.
+    Degenerated faces receive the normal 0. Vertex coordinates have to have a tuple size of 3.
+*/
+void ComputeFaceNormals3 (Mesh& mesh);
+
 }// end of namespace lume
 
 #endif	//__H__lume__normals
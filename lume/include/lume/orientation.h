@@ -0,0 +1,62 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <vector>
+#include <lume/grob_index.h>
+#include <lume/mesh.h>
+#include <lume/types.h>
+
+namespace lume
+{
+
+/// Summarizes the changes performed by `OrientFacesConsistently`
+struct OrientationInfo
+{
+  index_t                 numComponents {0};    ///< number of components of faces connected through manifold edges
+  index_t                 numFlippedFaces {0};
+  /// One face of each component which couldn't be oriented consistently
+  std::vector <GrobIndex> nonOrientableComponents;
+};
+
+/// Flips triangles and quadrilaterals so that neighboring faces are oriented consistently.
+/** Faces are considered neighbors if they share an edge which is contained in exactly
+  two faces. Starting from the first face of each component, the orientation is
+  propagated with a level synchronous breadth first search whose frontiers are processed
+  in parallel.
+
+  The orientation of each component is then chosen as follows:
+  - closed components (no boundary or non-manifold edges) are oriented so that their
+    signed volume is positive, i.e., so that their normals point outwards. This requires
+    3d vertex coordinates in `keys::vertexCoords`.
+  - open components receive the orientation which requires fewer flips.
+
+  Non-orientable components (e.g. Moebius strips) are reported and left unchanged.
+
+  Faces are flipped in place by reversing the order of their corners, while keeping
+  the first corner. Derived data of the mesh is invalidated.*/
+OrientationInfo OrientFacesConsistently (Mesh& mesh);
+
+}// end of namespace lume
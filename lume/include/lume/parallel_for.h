@@ -208,6 +208,62 @@ void parallel_for (TRandAccContainer& container, const TFunc& func, const int bl
 }
 /** \} */
 
+
+///	Executes a parallel for and calls `func` once for each block of the integer range `[begin, end)`.
+/**
+ * The range is split into blocks in the same way as in `parallel_for`. Instead of
+ * calling `func` for each value, `func (blockBegin, blockEnd)` is called once per
+ * block. This is useful if the loop body requires temporary storage, which can then
+ * be allocated once per block instead of once per iterate:
+ *
+ * \code
+ * parallel_for_blocks (0, numBuckets, [&] (size_t bucketBegin, size_t bucketEnd) {
+ *   std::vector <int> scratch;
+ *   for (size_t i = bucketBegin; i < bucketEnd; ++i) {
+ *     // ...
+ *   }
+ * });
+ * \endcode
+ *
+ * \param blockSize	(optional, default = 0) see `parallel_for`.
+ */
+template <class TInt, class TFunc>
+void parallel_for_blocks (TInt begin,
+                          TInt end,
+                          const TFunc& func,
+                          const int blockSize = 0)
+{
+	if(end <= begin)
+		return;
+
+	const auto len = end - begin;
+	const size_t numBlocks = blockSize ?
+							 std::max <size_t> (1, static_cast<size_t> (len / blockSize)) :
+							 std::max<int> (1, std::thread::hardware_concurrency());
+
+	std::vector <std::future<void>> futures;
+	futures.reserve (numBlocks);
+
+	for(size_t iblock = 0; iblock < numBlocks; ++iblock) {
+		const auto restLen = (end - begin);
+		const auto restBlocks = (numBlocks - iblock);
+		auto curBlockSize = restLen / restBlocks;
+
+		if (curBlockSize * restBlocks < static_cast <size_t> (restLen))
+			++curBlockSize;
+
+		const TInt tend = static_cast <TInt> (begin + curBlockSize);
+		if (tend > begin) {
+			futures.push_back (std::async (std::launch::async,
+			                               [begin, tend, func] () {func (begin, tend);}));
+		}
+		begin = tend;
+	}
+
+	for(auto& f : futures)
+		f.wait();
+}
+
 }//	end of namespace lume
 
 #endif	//__H__lume_parallel_for
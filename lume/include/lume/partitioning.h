@@ -0,0 +1,121 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <lume/array_annex.h>
+#include <lume/grob_set.h>
+#include <lume/mesh.h>
+#include <lume/types.h>
+
+namespace lume
+{
+
+/// Returns the key of the annex which stores the partition index of each grob of the given type.
+inline TypedAnnexKey <IndexArrayAnnex> PartitionAnnexKey (GrobType const grobType)
+{
+  return TypedAnnexKey <IndexArrayAnnex> ("partition", grobType);
+}
+
+/// Returns the key of the annex which maps the grobs of an extracted partition to the grobs of the source mesh.
+inline TypedAnnexKey <IndexArrayAnnex> GlobalIndexAnnexKey (GrobType const grobType)
+{
+  return TypedAnnexKey <IndexArrayAnnex> ("globalIndex", grobType);
+}
+
+/// Describes the quality of a partition of a grob set
+struct PartitionInfo
+{
+  index_t               numPartitions {0};
+  std::vector <index_t> partitionSizes;   ///< number of grobs in each partition
+  index_t               edgeCut {0};      ///< number of sides shared by grobs of different partitions
+  real_t                imbalance {0};    ///< size of the largest partition divided by the average partition size
+};
+
+/** \name Partitioning
+  The following functions assign a partition index in `[0, numPartitions)` to each grob
+  of the given grob set. The results are stored in one `IndexArrayAnnex` for each grob
+  type of the grob set which has grobs in `mesh`, using the key `PartitionAnnexKey (grobType)`.
+
+  Partitions are evaluated on the dual graph of the grob set, in which two grobs are
+  connected if they share a side of dimension `grobSet.dim () - 1`.
+  \{ */
+
+/// Partitions the grobs by recursive coordinate bisection of their centers.
+/** The centers are split at the median of the coordinate with the largest extent.
+  This is fast and yields perfectly balanced partitions, however, the edge cut is
+  typically larger than the one of `PartitionMultilevel`.
+  Requires the annex `keys::vertexCoords`.*/
+PartitionInfo PartitionRCB (Mesh& mesh, index_t numPartitions, GrobSet grobSet = CELLS);
+
+/// Partitions the dual graph of the grobs with a multilevel scheme.
+/** The graph is split by recursive bisection, where each bisection is computed on a
+  hierarchy of graphs obtained by heavy edge matching: the coarsest graph is bisected
+  by growing one side from a seed and refining it with the Fiduccia-Mattheyses heuristic.
+  The bisection is then projected back to the finer graphs and refined on each level.
+  Finally, the k-way partition is improved by greedily moving boundary grobs between
+  adjacent partitions.
+
+  The result is reproducible, since a fixed seed is used for all random choices.
+
+  \param maxImbalance  The admissible ratio between the size of the largest partition
+                       and the average partition size.*/
+PartitionInfo PartitionMultilevel (Mesh& mesh,
+                                   index_t numPartitions,
+                                   GrobSet grobSet = CELLS,
+                                   real_t maxImbalance = real_t (1.03));
+
+/// Evaluates the partition stored in the annexes `PartitionAnnexKey (grobType)` of `mesh`.
+PartitionInfo ComputePartitionInfo (Mesh const& mesh, index_t numPartitions, GrobSet grobSet = CELLS);
+
+/// Creates one mesh for each partition stored in the annexes `PartitionAnnexKey (grobType)` of `mesh`.
+/** The submesh of a partition contains the grobs of `grobSet` which belong to the
+  partition, followed by `numGhostLayers` layers of ghost grobs. The i-th ghost layer
+  consists of the grobs of `grobSet` which share a vertex with a grob of the previous
+  layer. Ghost grobs can be recognized through their sliced partition annex. Grobs of
+  types outside of `grobSet` are contained if all of their corners are contained.
+
+  Vertices are numbered compactly in the order of their indices in `mesh`. For each
+  grob type, the index of each grob in `mesh` is stored in the annex
+  `GlobalIndexAnnexKey (grobType)`. All array annexes of vertices and grobs are sliced
+  accordingly, `SubsetInfoAnnex` instances are copied.
+
+  The grobs of all submeshes are collected in a single pass over the grobs of `mesh`,
+  the submeshes are then assembled concurrently.*/
+std::vector <SPMesh> ExtractPartitions (Mesh const& mesh,
+                                        index_t numPartitions,
+                                        GrobSet grobSet = CELLS,
+                                        index_t numGhostLayers = 0);
+
+/// Like `ExtractPartitions` above, but reads the partition of the grobs from the `IndexArrayAnnex` instances with the given name.
+std::vector <SPMesh> ExtractPartitions (Mesh const& mesh,
+                                        std::string const& partitionAnnexName,
+                                        index_t numPartitions,
+                                        GrobSet grobSet,
+                                        index_t numGhostLayers = 0);
+/** \} */
+
+}// end of namespace lume
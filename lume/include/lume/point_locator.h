@@ -0,0 +1,105 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <vector>
+#include <lume/bvh.h>
+#include <lume/grob_index.h>
+#include <lume/mesh.h>
+
+namespace lume
+{
+
+struct PointLocation
+{
+  GrobIndex              cell;
+  /// Coordinates of the point in the reference element of `cell`.
+  std::array <real_t, 3> localCoords;
+};
+
+/// Finds the volume elements which contain given points.
+/** Supported are tetrahedra, hexahedra, prisms and pyramids with 3d vertex
+  coordinates. Local coordinates refer to the following reference elements:
+  - TET:   (0,0,0), (1,0,0), (0,1,0), (0,0,1)
+  - HEX:   the unit cube, corners counter-clockwise at z=0, then at z=1
+  - PRISM: (0,0,0), (1,0,0), (0,1,0), (0,0,1), (1,0,1), (0,1,1)
+  - PYRA:  (0,0,0), (1,0,0), (1,1,0), (0,1,0), (0,0,1)
+
+  Local coordinates of tetrahedra are computed directly, for all other elements
+  the (multi-)linear mapping is inverted with Newton's method.
+
+  Candidates are found through a `BVH` over all cells. If a seed cell is given,
+  the locator first walks from the seed through the face neighbors of the cells
+  towards the point (leaving each cell through the face which faces the point), which is much cheaper than a hierarchy traversal for coherent
+  queries. If the walk leaves the mesh or takes too many steps, the hierarchy is
+  used instead.
+
+  The locator references the mesh and has to be recreated if the mesh is changed.*/
+class PointLocator
+{
+public:
+  /// `tolerance` is the amount by which local coordinates may lie outside of the reference element.
+  explicit PointLocator (CSPMesh mesh, real_t tolerance = 1.e-5f);
+
+  CSPMesh mesh () const      {return m_bvh.mesh ();}
+  BVH const& bvh () const    {return m_bvh;}
+
+  /// Returns the cell containing the point `p` (3 components).
+  std::optional <PointLocation> locate (real_t const* p) const;
+
+  /// Returns the cell containing the point `p`, starting the search at the cell `seed`.
+  std::optional <PointLocation> locate (real_t const* p, GrobIndex const& seed) const;
+
+  /// Locates many points in parallel.
+  /** `points` contains 3 components for each point. Each thread processes a
+    consecutive block of points and uses the cell of the previous point as seed for
+    the next one. Points which are close to each other should thus be stored
+    consecutively.*/
+  std::vector <std::optional <PointLocation>> locate (std::vector <real_t> const& points) const;
+
+  /// Computes the local coordinates of `p` in the given cell.
+  /** \returns true if `p` lies inside the cell (up to the tolerance).*/
+  bool local_coordinates (GrobIndex const& cell, real_t const* p, real_t* localCoordsOut) const;
+
+private:
+  std::optional <PointLocation> locate_bvh (real_t const* p, std::vector <GrobIndex>& candidates) const;
+  std::optional <PointLocation> locate_walk (real_t const* p, GrobIndex cell) const;
+
+  /// Returns false if the local coordinates couldn't be computed.
+  bool compute_local_coordinates (GrobIndex const& cell,
+                                  real_t const* p,
+                                  double* xi,
+                                  bool& insideOut) const;
+
+  BVH        m_bvh;
+  /// For each cell the neighbors across its faces (in the order of the local faces).
+  std::array <std::vector <GrobIndex>, NUM_GROB_TYPES> m_neighbors;
+  real_t     m_tolerance;
+  index_t    m_maxWalkSteps;
+};
+
+}// end of namespace lume
@@ -0,0 +1,76 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <lume/array_annex.h>
+#include <lume/mesh.h>
+
+namespace lume
+{
+
+enum class QualityMetric
+{
+  /// Area of faces.
+  Area,
+  /// Volume of cells.
+  Volume,
+  /// 1 for equilateral triangles and regular tetrahedra, larger for worse shapes.
+  /** For triangles and tetrahedra the ratio of the longest edge to the inradius,
+    normalized by the value of the regular element. For all other elements the ratio
+    of the longest to the shortest edge.*/
+  AspectRatio,
+  /// Minimum interior angle of faces and minimum dihedral angle of cells, in degrees.
+  MinAngle,
+  /// Minimum over all corners of the determinant of the corner Jacobian.
+  /** The corner Jacobian consists of the edges leaving a corner (two for faces,
+    three for cells). For faces the determinant is measured along the face normal,
+    or along the z-axis if the mesh has 2d coordinates.*/
+  JacobianDeterminant,
+  /// Minimum corner Jacobian determinant divided by the product of the edge lengths.
+  /** The value is normalized so that ideal elements have value 1. Inverted
+    elements have negative values.*/
+  ScaledJacobian
+};
+
+/// Returns the name of the metric, e.g. "ScaledJacobian".
+std::string QualityMetricName (QualityMetric metric);
+
+/// Returns true if `metric` can be computed for grobs of the given type.
+/** Area is supported for TRI and QUAD, Volume for TET, HEX, PRISM and PYRA, all
+  other metrics for all faces and cells.*/
+bool IsQualityMetricSupported (QualityMetric metric, GrobType grobType);
+
+/// Computes the given metric for all grobs of the given type.
+/** The grobs are processed in blocks. The corner coordinates of a block are gathered
+  into a structure of arrays and each metric is evaluated in a loop over the block,
+  which is specialized for each grob type at compile time. Blocks are processed in
+  parallel.
+
+  \returns an annex with tuple size 1 and one entry for each grob of type `grobType`.*/
+RealArrayAnnex ComputeQuality (Mesh const& mesh, GrobType grobType, QualityMetric metric);
+
+}// end of namespace lume
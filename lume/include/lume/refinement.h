@@ -25,14 +25,34 @@
 #pragma once
 
 #include <functional>
+#include <lume/annex_transfer.h>
+#include <lume/hierarchy.h>
 #include <lume/mesh.h>
 
 namespace lume
 {
 
-// using RefinementCallback = std::function <void (Mesh& newMesh,
-//                                                 Mesh const& srcMesh)>;
+/// Called by the refinement methods once all children have been created.
+/** The hierarchy relates the grobs of the refined mesh to their parents. The default
+  callback is an `AnnexTransfer`, which transfers the annexes of the parent mesh to
+  the refined mesh.*/
+using RefinementCallback = std::function <void (Hierarchy& hierarchy)>;
 
-SPMesh RefineTriangles (CSPMesh mesh);
+/// Uniformly refines all edges, faces and cells of the given mesh.
+/** New vertices are created at the centers of all edges, of all quadrilaterals
+  (including the quadrilateral sides of cells) and of all hexahedra. Vertices
+  are ordered as follows: old vertices, edge centers, quadrilateral centers, hexahedron centers.
+
+  Edges, triangles and quadrilaterals are split into 2 and 4 children, hexahedra and
+  prisms into 8 children of the same type. Tetrahedra are split into 8 tetrahedra,
+  where the inner octahedron is split along its shortest diagonal. Pyramids are split
+  into 6 pyramids and 4 tetrahedra.
+
+  The children of each parent grob are stored consecutively. Once all children have
+  been created, `callback` is executed.*/
+SPMesh RefineMesh (CSPMesh mesh, RefinementCallback const& callback = AnnexTransfer ());
+
+/// Refines the triangles of the given mesh. All other grobs are ignored.
+SPMesh RefineTriangles (CSPMesh mesh, RefinementCallback const& callback = AnnexTransfer ());
 
 }// end of namespace lume
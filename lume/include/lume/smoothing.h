@@ -0,0 +1,75 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <string>
+#include <lume/grob_set.h>
+#include <lume/mesh.h>
+#include <lume/types.h>
+
+namespace lume
+{
+
+enum class SmoothingWeights
+{
+  Uniform,    ///< all neighbors of a vertex are weighted equally
+  Cotangent   ///< edges are weighted by the cotangents of their opposite angles. Requires triangles.
+};
+
+struct SmoothingOptions
+{
+  SmoothingWeights weights {SmoothingWeights::Uniform};
+
+  index_t numIterations {10};
+
+  /// Each iteration moves a vertex by `lambda` times its Laplacian
+  real_t lambda {0.5f};
+
+  /// If not 0, every second iteration uses `mu` instead of `lambda` (Taubin smoothing).
+  /** `mu` has to be negative with `-mu > lambda`, e.g. `lambda = 0.5, mu = -0.53`.
+    The inflating steps compensate the shrinkage of the smoothing steps.*/
+  real_t mu {0};
+
+  /// If true, the vertices of boundary sides of the smoothed grobs are not moved.
+  bool pinBoundary {true};
+
+  /// Vertices with a nonzero value in the vertex `IndexArrayAnnex` of this name are not moved.
+  /** The annex is optional. It can e.g. be filled with the corners of `ExtractFeatureEdges`.*/
+  std::string pinMaskName {"pinned"};
+};
+
+/// Smoothes `keys::vertexCoords` by Jacobi iterations of a discrete Laplacian.
+/** The Laplacian of a vertex is the weighted average of its neighbors minus its own
+  position, where the neighbors are connected to the vertex by an edge of a grob in
+  `grobSet`. `grobSet` has to consist of faces or cells, i.e., surfaces and volume
+  meshes can both be smoothed.
+
+  Neighbors and normalized weights are stored in compressed rows and are computed
+  once before the first iteration. Negative cotangent weights are clamped to 0.
+  Each iteration reads the positions of the previous iteration from one buffer and
+  writes the new positions to a second buffer, processing all vertices in parallel.*/
+void SmoothVertices (Mesh& mesh, GrobSet grobSet, SmoothingOptions const& options = {});
+
+}// end of namespace lume
@@ -0,0 +1,130 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <lume/array_annex.h>
+#include <lume/types.h>
+
+namespace lume
+{
+
+/// A static k-d tree over a set of points with 1 to 3 components.
+/** The tree is implicit: the points are reordered so that the median of each
+  range splits it along the axis of its largest extent. Only the reordered points,
+  their original indices and the split axes are stored. Ranges with few points are
+  searched linearly. The upper levels of the tree are built in parallel.
+
+  All query points have to have `dim ()` components.*/
+class KdTree
+{
+public:
+  explicit KdTree (RealArrayAnnex const& coords);
+  KdTree (real_t const* coords, size_t numPoints, index_t dim);
+
+  index_t dim () const         {return m_dim;}
+  size_t  num_points () const  {return m_indices.size ();}
+
+  /// Returns the index of the point closest to `p` or `NO_INDEX` if the tree is empty.
+  index_t nearest (real_t const* p) const;
+
+  /// Collects the indices of the `k` points closest to `p`, sorted by increasing distance.
+  /** `indicesOut` is cleared first. Less than `k` indices are returned if the tree
+    contains less than `k` points.*/
+  void k_nearest (real_t const* p, index_t k, std::vector <index_t>& indicesOut) const;
+
+  /// Collects the indices of all points whose distance to `p` is at most `radius`.
+  /** `indicesOut` is cleared first. The indices are not sorted.*/
+  void in_radius (real_t const* p, real_t radius, std::vector <index_t>& indicesOut) const;
+
+  /// Computes the `k` nearest points for many query points in parallel.
+  /** \returns `k` indices for each query point. Missing entries are `NO_INDEX`.*/
+  std::vector <index_t> k_nearest (std::vector <real_t> const& points, index_t k) const;
+
+  /// Computes the points in the given radius of many query points in parallel.
+  /** The indices of the points close to query point `i` are stored in
+    `indicesOut [offsetsOut [i]], ..., indicesOut [offsetsOut [i+1] - 1]`.*/
+  void in_radius (std::vector <real_t> const& points,
+                  real_t radius,
+                  std::vector <index_t>& offsetsOut,
+                  std::vector <index_t>& indicesOut) const;
+
+private:
+  void build (index_t begin, index_t end, int parallelDepth);
+
+  template <class TVisitor>
+  void search (index_t begin, index_t end, real_t const* p, TVisitor& visitor) const;
+
+  index_t                m_dim;
+  std::vector <real_t>   m_points;   ///< reordered points, 3 components each
+  std::vector <index_t>  m_indices;  ///< original index of each reordered point
+  std::vector <int8_t>   m_axes;     ///< split axis of the range whose median is the i-th point
+};
+
+
+/// A hashed uniform grid for fixed radius queries on points with 1 to 3 components.
+/** Points are assigned to the cells of a uniform grid with the given cell size.
+  Cells are hashed into a table of buckets, which is filled with a counting sort,
+  i.e., the points of each bucket are stored consecutively. Radius queries only
+  visit the cells overlapping the query box. They are fastest if the radius is
+  similar to the cell size.*/
+class PointGrid
+{
+public:
+  PointGrid (RealArrayAnnex const& coords, real_t cellSize);
+  PointGrid (real_t const* coords, size_t numPoints, index_t dim, real_t cellSize);
+
+  index_t dim () const          {return m_dim;}
+  size_t  num_points () const   {return m_indices.size ();}
+  real_t  cell_size () const    {return m_cellSize;}
+
+  /// Collects the indices of all points whose distance to `p` is at most `radius`.
+  /** `indicesOut` is cleared first. The indices are not sorted.*/
+  void in_radius (real_t const* p, real_t radius, std::vector <index_t>& indicesOut) const;
+
+  /// Computes the points in the given radius of many query points in parallel.
+  /** \sa KdTree::in_radius*/
+  void in_radius (std::vector <real_t> const& points,
+                  real_t radius,
+                  std::vector <index_t>& offsetsOut,
+                  std::vector <index_t>& indicesOut) const;
+
+private:
+  using Cell = std::array <int64_t, 3>;
+
+  Cell   cell (real_t const* p) const;
+  size_t bucket (Cell const& c) const;
+
+  index_t                m_dim;
+  real_t                 m_cellSize;
+  size_t                 m_bucketMask;
+  std::vector <index_t>  m_bucketOffsets;
+  std::vector <real_t>   m_points;   ///< points sorted by bucket, 3 components each
+  std::vector <index_t>  m_indices;  ///< original index of each sorted point
+};
+
+}// end of namespace lume
@@ -104,6 +104,7 @@ public:
 	
 	SubsetInfoAnnex ();
 	SubsetInfoAnnex (const std::string& name);
+    SubsetInfoAnnex (const SubsetInfoAnnex& sia);
     SubsetInfoAnnex (SubsetInfoAnnex&& sia);
 
 	virtual ~SubsetInfoAnnex ();
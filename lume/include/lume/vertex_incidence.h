@@ -0,0 +1,120 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include <lume/grob_set.h>
+#include <lume/mesh.h>
+#include <lume/types.h>
+
+namespace lume
+{
+
+/// A read-only view on a contiguous range of indices
+class IndexSpan
+{
+public:
+  IndexSpan () = default;
+  IndexSpan (index_t const* begin, index_t const* end) : m_begin (begin), m_end (end) {}
+
+  index_t const* begin () const                 {return m_begin;}
+  index_t const* end () const                   {return m_end;}
+  index_t const* data () const                  {return m_begin;}
+  size_t size () const                          {return static_cast <size_t> (m_end - m_begin);}
+  bool empty () const                           {return m_begin == m_end;}
+  index_t operator [] (size_t const i) const    {return m_begin [i];}
+
+private:
+  index_t const* m_begin {nullptr};
+  index_t const* m_end {nullptr};
+};
+
+/** Lists for each vertex the grobs of a grob set which contain that vertex as a corner.
+  The incidences are stored in compressed rows: for each vertex and each grob type of
+  the grob set, the indices of the incident grobs of that type are stored contiguously
+  and in ascending order. The incidences of a vertex are thus segmented by grob type
+  in the order of the grob set.
+
+  Since vertices are indexed densely, the table is built by a counting sort which
+  consists of two parallel passes over the grobs: the first counts the incidences of
+  each vertex, the second scatters the grob indices to their final positions.
+
+  All accessors are const and return views into the table, so they can be used
+  concurrently, e.g. inside `parallel_for`.
+
+  \note Grobs which contain a vertex multiple times are listed multiple times for that vertex.
+*/
+class VertexIncidence
+{
+public:
+  VertexIncidence () = default;
+  VertexIncidence (Mesh const& mesh, GrobSet grobSet);
+
+  GrobSet grob_set () const                     {return m_grobSet;}
+  size_t num_vertices () const                  {return m_numVertices;}
+
+  /// Returns the total number of grobs incident to the given vertex
+  index_t num_incidences (index_t const vertex) const
+  {
+    return m_offsets [(vertex + 1) * m_numSlots] - m_offsets [vertex * m_numSlots];
+  }
+
+  /// Returns the indices of all grobs of the given type which contain the given vertex.
+  /** The returned span is empty, if `grobType` is not contained in the grob set.*/
+  IndexSpan incidences (index_t const vertex, GrobType const grobType) const
+  {
+    index_t const slot = m_typeSlots [grobType];
+    if (slot == NO_INDEX)
+      return {};
+    index_t const i = vertex * m_numSlots + slot;
+    return IndexSpan (m_grobs.data () + m_offsets [i], m_grobs.data () + m_offsets [i + 1]);
+  }
+
+  /// Returns the indices of all grobs which contain the given vertex, segmented by grob type.
+  /** Use `incidences (vertex, grobType)` to access the segment of a specific grob type.*/
+  IndexSpan incidences (index_t const vertex) const
+  {
+    return IndexSpan (m_grobs.data () + m_offsets [vertex * m_numSlots],
+                      m_grobs.data () + m_offsets [(vertex + 1) * m_numSlots]);
+  }
+
+  /// Offsets into `grobs ()`. The segment of vertex `v` and the `i`-th grob type of the grob set starts at `offsets () [v * grob_set ().size () + i]`.
+  std::vector <index_t> const& offsets () const {return m_offsets;}
+
+  /// The packed grob indices of all segments
+  std::vector <index_t> const& grobs () const   {return m_grobs;}
+
+private:
+  GrobSet                               m_grobSet;
+  size_t                                m_numVertices {0};
+  index_t                               m_numSlots {1};
+  std::array <index_t, NUM_GROB_TYPES>  m_typeSlots {NO_INDEX, NO_INDEX, NO_INDEX, NO_INDEX,
+                                                     NO_INDEX, NO_INDEX, NO_INDEX, NO_INDEX};
+  std::vector <index_t>                 m_offsets {0};
+  std::vector <index_t>                 m_grobs;
+};
+
+}// end of namespace lume
@@ -0,0 +1,703 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/adaptive_refinement.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include <unordered_set>
+#include <lume/grob_sides.h>
+#include <lume/impl/tet_refinement.h>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+namespace
+{
+  std::uint64_t EdgeKey (index_t a, index_t b)
+  {
+    if (a > b)
+      std::swap (a, b);
+    return (static_cast <std::uint64_t> (a) << 32) | b;
+  }
+
+  /// Sets the values of new vertices to the values at the centers of their edges.
+  /** `edgeCorners` holds two corners for each new vertex, starting at `firstNewVertex`.*/
+  template <class T>
+  void InterpolateEdgeCenters (ArrayAnnex <T>& annex,
+                               std::vector <index_t> const& edgeCorners,
+                               index_t const firstNewVertex)
+  {
+    index_t const tupleSize = static_cast <index_t> (annex.tuple_size ());
+    T* data = annex.data ();
+
+    for (size_t i = 0; i < edgeCorners.size () / 2; ++i)
+    {
+      T const* a = data + edgeCorners [2 * i] * tupleSize;
+      T const* b = data + edgeCorners [2 * i + 1] * tupleSize;
+      T* v = data + (firstNewVertex + i) * tupleSize;
+
+      for (index_t j = 0; j < tupleSize; ++j)
+      {
+        if constexpr (std::is_floating_point <T>::value)
+          v [j] = (a [j] + b [j]) / T (2);
+        else
+          v [j] = std::min (a [j], b [j]);
+      }
+    }
+  }
+}// end of unnamed namespace
+
+AdaptiveRefiner::AdaptiveRefiner (SPMesh mesh)
+  : m_mesh (std::move (mesh))
+{
+  reset ();
+}
+
+void AdaptiveRefiner::reset ()
+{
+  Mesh const& mesh = *m_mesh;
+  m_elemType = mesh.has (TET) ? TET : TRI;
+  for (auto grobType : mesh.grob_types ())
+  {
+    if (grobType != VERTEX && grobType != m_elemType) {
+      throw LumeError () << "AdaptiveRefiner: Unsupported grob type '" << GrobTypeName (grobType)
+                         << "'. Only pure triangle or tetrahedral meshes are supported.";
+    }
+  }
+
+  m_numElems = mesh.num (m_elemType);
+  m_neighbors.clear ();
+  m_greenSiblings.clear ();
+  m_edgeTets.clear ();
+  m_edgeCenters.clear ();
+
+  if (m_elemType == TET) {
+    reset_tets ();
+    return;
+  }
+
+  index_t const numTris = static_cast <index_t> (mesh.num (TRI));
+  m_neighbors.assign (numTris * 3, NO_INDEX);
+  m_greenSiblings.assign (numTris, NO_INDEX);
+
+  GrobSides const edges (mesh, TRIS, EDGES);
+  std::atomic <bool> nonManifold {false};
+
+  parallel_for (index_t (0), edges.num_sides (EDGE), [&] (index_t const edge)
+  {
+    GrobIndex const edgeIndex (EDGE, edge);
+    index_t const numIncidences = edges.num_incidences (edgeIndex);
+    if (numIncidences > 2) {
+      nonManifold = true;
+      return;
+    }
+
+    if (numIncidences == 2) {
+      auto const i0 = edges.incidence (edgeIndex, 0);
+      auto const i1 = edges.incidence (edgeIndex, 1);
+      m_neighbors [i0.grob.index () * 3 + i0.localSide] = i1.grob.index ();
+      m_neighbors [i1.grob.index () * 3 + i1.localSide] = i0.grob.index ();
+    }
+  });
+
+  if (nonManifold)
+    throw LumeError () << "AdaptiveRefiner: Edges shared by more than two triangles are not supported.";
+}
+
+void AdaptiveRefiner::reset_tets ()
+{
+  Mesh& mesh = *m_mesh;
+  index_t const* corners = mesh.grobs (TET).data ();
+  GrobDesc const tetDesc (TET);
+
+  for (index_t tet = 0; tet < m_numElems; ++tet)
+  {
+    for (index_t i = 0; i < tetDesc.num_sides (1); ++i)
+    {
+      index_t const* edge = tetDesc.local_side_corners (1, i);
+      m_edgeTets [EdgeKey (corners [tet * 4 + edge [0]], corners [tet * 4 + edge [1]])].push_back (tet);
+    }
+  }
+
+  if (!mesh.has_annex (keys::hangingNodeConstraints)) {
+    mesh.set_annex (keys::hangingNodeConstraints, IndexArrayAnnex (2, NO_INDEX));
+    return;
+  }
+
+  auto& constraints = mesh.annex (keys::hangingNodeConstraints);
+  if (constraints.tuple_size () != 2) {
+    throw BadTupleSizeError () << "AdaptiveRefiner: Hanging node constraints have to have a tuple size of 2, not "
+                               << constraints.tuple_size ();
+  }
+
+  for (index_t vrt = 0; vrt < constraints.num_tuples (); ++vrt)
+  {
+    index_t* c = constraints.data () + vrt * 2;
+    if (c [0] != NO_INDEX && m_edgeTets.count (EdgeKey (c [0], c [1])) > 0)
+      m_edgeCenters [EdgeKey (c [0], c [1])] = vrt;
+    else
+      c [0] = c [1] = NO_INDEX;
+  }
+}
+
+void AdaptiveRefiner::refine (std::vector <bool> const& marks)
+{
+  std::vector <index_t> markedElems;
+  for (size_t i = 0; i < marks.size (); ++i)
+  {
+    if (marks [i])
+      markedElems.push_back (static_cast <index_t> (i));
+  }
+  refine (markedElems);
+}
+
+void AdaptiveRefiner::refine (IndexArrayAnnex const& marks)
+{
+  std::vector <index_t> markedElems;
+  for (size_t i = 0; i < marks.size (); ++i)
+  {
+    if (marks [i] != 0)
+      markedElems.push_back (static_cast <index_t> (i / marks.tuple_size ()));
+  }
+  markedElems.erase (std::unique (markedElems.begin (), markedElems.end ()), markedElems.end ());
+  refine (markedElems);
+}
+
+void AdaptiveRefiner::refine (std::vector <index_t> const& markedElems)
+{
+  size_t const numElems = m_mesh->num (m_elemType);
+  if (numElems != m_numElems)
+    throw LumeError () << "AdaptiveRefiner::refine: The mesh was modified. Please call 'reset' first.";
+
+  for (index_t elem : markedElems)
+  {
+    if (elem >= numElems)
+      throw LumeError () << "AdaptiveRefiner::refine: Invalid element index " << elem;
+  }
+
+  if (m_elemType == TET)
+    refine_tets (markedElems);
+  else
+  {
+  // Splitting the edge of a green triangle's sibling may require the replacing red children
+  // to be refined again. Those are handled in subsequent passes.
+    EdgeVertexMap edgeVertices;
+    std::vector <index_t> touchedSeeds;
+    std::vector <index_t> extraAffected;
+
+    refine_pass (markedElems, touchedSeeds, extraAffected, edgeVertices);
+    while (!touchedSeeds.empty ())
+      refine_pass ({}, touchedSeeds, extraAffected, edgeVertices);
+  }
+
+  m_numElems = m_mesh->num (m_elemType);
+}
+
+index_t AdaptiveRefiner::first_green_child (index_t const tri) const
+{
+// green children of a parent (a, b, c) are (a, m, c) and (m, b, c)
+  index_t const sibling = m_greenSiblings [tri];
+  index_t const* corners = m_mesh->grobs (TRI).data ();
+  return corners [tri * 3 + 1] == corners [sibling * 3] ? tri : sibling;
+}
+
+void AdaptiveRefiner::refine_pass (std::vector <index_t> const& redSeeds,
+                                   std::vector <index_t>& touchedSeeds,
+                                   std::vector <index_t>& extraAffected,
+                                   EdgeVertexMap& edgeVertices)
+{
+  Mesh& mesh = *m_mesh;
+  index_t const numTris = static_cast <index_t> (mesh.num (TRI));
+  index_t const* triCorners = mesh.grobs (TRI).data ();
+
+  auto corner = [&triCorners] (index_t const tri, index_t const i)
+  {
+    return triCorners [tri * 3 + i % 3];
+  };
+
+  auto isMarked = [&] (index_t const tri, index_t const side)
+  {
+    return edgeVertices.count (EdgeKey (corner (tri, side), corner (tri, side + 1))) > 0;
+  };
+
+// determine the closure of the marked triangles
+  std::unordered_set <index_t> red;
+  std::unordered_set <index_t> families;
+  std::unordered_set <index_t> touched;
+  std::vector <index_t> redTris;
+  std::vector <index_t> familyTris;
+  std::vector <index_t> touchedTris;
+  std::vector <index_t> work (touchedSeeds);
+  touchedSeeds.clear ();
+
+  auto markEdge = [&] (index_t const tri, index_t const side)
+  {
+    auto const key = EdgeKey (corner (tri, side), corner (tri, side + 1));
+    if (edgeVertices.emplace (key, NO_INDEX).second) {
+      index_t const neighbor = m_neighbors [tri * 3 + side];
+      if (neighbor != NO_INDEX)
+        work.push_back (neighbor);
+    }
+  };
+
+  auto refineRed = [&] (index_t const tri)
+  {
+    if (!red.insert (tri).second)
+      return;
+    redTris.push_back (tri);
+    for (index_t side = 0; side < 3; ++side)
+      markEdge (tri, side);
+  };
+
+  auto removeFamily = [&] (index_t const tri)
+  {
+    index_t const first = first_green_child (tri);
+    if (!families.insert (first).second)
+      return;
+    familyTris.push_back (first);
+
+  // first = (a, m, c), second = (m, b, c). The parent edge (a, b) is already split at m.
+    index_t const second = m_greenSiblings [first];
+    edgeVertices [EdgeKey (corner (first, 0), corner (second, 1))] = corner (first, 1);
+    markEdge (second, 1);
+    markEdge (first, 2);
+  };
+
+  auto process = [&] (index_t const tri)
+  {
+    if (red.count (tri) > 0)
+      return;
+
+    int numMarked = 0;
+    for (index_t side = 0; side < 3; ++side)
+      numMarked += isMarked (tri, side) ? 1 : 0;
+
+    if (is_green (tri)) {
+      if (numMarked > 0)
+        removeFamily (tri);
+    }
+    else if (numMarked >= 2)
+      refineRed (tri);
+    else if (numMarked == 1 && touched.insert (tri).second)
+      touchedTris.push_back (tri);
+  };
+
+  for (index_t tri : redSeeds)
+  {
+    if (is_green (tri))
+      removeFamily (tri);
+    else
+      refineRed (tri);
+  }
+
+  while (!work.empty ())
+  {
+    index_t const tri = work.back ();
+    work.pop_back ();
+    process (tri);
+  }
+
+// create vertices at the centers of all split edges
+  index_t const firstNewVertex = static_cast <index_t> (mesh.num (VERTEX));
+  index_t numVertices = firstNewVertex;
+  std::vector <index_t> edgeCorners;
+
+  for (auto& entry : edgeVertices)
+  {
+    if (entry.second == NO_INDEX) {
+      entry.second = numVertices++;
+      edgeCorners.push_back (static_cast <index_t> (entry.first >> 32));
+      edgeCorners.push_back (static_cast <index_t> (entry.first & 0xFFFFFFFF));
+    }
+  }
+
+  if (numVertices > firstNewVertex) {
+    mesh.resize_vertices (numVertices);
+    for (auto const& key : mesh.annex_keys ())
+    {
+      if (key.grob_type () != VERTEX)
+        continue;
+      VisitArrayAnnex (mesh.untyped_annex (key), [&] (auto& annex)
+                       {InterpolateEdgeCenters (annex, edgeCorners, firstNewVertex);});
+    }
+  }
+
+// create children. The first child of each parent replaces the parent.
+  auto midpoint = [&edgeVertices] (index_t const a, index_t const b)
+  {
+    return edgeVertices.at (EdgeKey (a, b));
+  };
+
+  std::vector <index_t> newCorners;
+  std::vector <index_t> newSlots;
+  std::vector <index_t> newSources;
+  std::vector <index_t> newSiblings;
+  index_t nextSlot = numTris;
+
+  auto addTri = [&] (index_t const c0, index_t const c1, index_t const c2,
+                     index_t const slot, index_t const source, index_t const sibling)
+  {
+    newCorners.insert (newCorners.end (), {c0, c1, c2});
+    newSlots.push_back (slot);
+    newSources.push_back (source);
+    newSiblings.push_back (sibling);
+  };
+
+  auto addRedChildren = [&] (index_t const a, index_t const b, index_t const c,
+                             index_t const slot0, index_t const slot1, index_t const source)
+  {
+    index_t const m0 = midpoint (a, b);
+    index_t const m1 = midpoint (b, c);
+    index_t const m2 = midpoint (c, a);
+    addTri (a, m0, m2, slot0, source, NO_INDEX);
+    addTri (b, m1, m0, slot1, source, NO_INDEX);
+    addTri (c, m2, m1, nextSlot++, source, NO_INDEX);
+    addTri (m0, m1, m2, nextSlot++, source, NO_INDEX);
+  };
+
+  for (index_t tri : redTris)
+  {
+    index_t const slot1 = nextSlot++;
+    addRedChildren (corner (tri, 0), corner (tri, 1), corner (tri, 2), tri, slot1, tri);
+  }
+
+  for (index_t first : familyTris)
+  {
+    index_t const second = m_greenSiblings [first];
+    addRedChildren (corner (first, 0), corner (second, 1), corner (first, 2), first, second, first);
+  }
+
+  for (index_t tri : touchedTris)
+  {
+    if (red.count (tri) > 0)
+      continue;
+
+    index_t side = 0;
+    while (!isMarked (tri, side))
+      ++side;
+
+    index_t const a = corner (tri, side);
+    index_t const b = corner (tri, side + 1);
+    index_t const c = corner (tri, side + 2);
+    index_t const m = midpoint (a, b);
+    index_t const slot1 = nextSlot++;
+    addTri (a, m, c, tri, tri, slot1);
+    addTri (m, b, c, slot1, tri, tri);
+  }
+
+// collect the triangles whose neighbors may change, before modifying the mesh
+  std::unordered_set <index_t> affectedSet (newSlots.begin (), newSlots.end ());
+  std::vector <index_t> affected (newSlots);
+  auto addAffected = [&] (index_t const tri)
+  {
+    if (tri != NO_INDEX && affectedSet.insert (tri).second)
+      affected.push_back (tri);
+  };
+
+  for (index_t slot : newSlots)
+  {
+    if (slot < numTris) {
+      for (index_t side = 0; side < 3; ++side)
+        addAffected (m_neighbors [slot * 3 + side]);
+    }
+  }
+
+  for (index_t tri : extraAffected)
+    addAffected (tri);
+  extraAffected.clear ();
+
+// write the children to the mesh
+  {
+    GrobArray appendedTris (TRI);
+    appendedTris.resize (nextSlot - numTris);
+    index_t* appendedCorners = appendedTris.data ();
+    for (size_t i = 0; i < newSlots.size (); ++i)
+    {
+      if (newSlots [i] >= numTris)
+        std::copy_n (&newCorners [i * 3], 3, appendedCorners + (newSlots [i] - numTris) * 3);
+    }
+    mesh.insert_grobs (appendedTris.begin (), appendedTris.end ());
+  }
+
+  index_t* corners = mesh.grobs (TRI).data ();
+  triCorners = corners;
+  for (size_t i = 0; i < newSlots.size (); ++i)
+  {
+    if (newSlots [i] < numTris)
+      std::copy_n (&newCorners [i * 3], 3, corners + newSlots [i] * 3);
+  }
+
+  for (auto const& key : mesh.annex_keys ())
+  {
+    if (key.grob_type () != TRI)
+      continue;
+
+    VisitArrayAnnex (mesh.untyped_annex (key), [&] (auto& annex)
+    {
+      size_t const tupleSize = annex.tuple_size ();
+      auto* data = annex.data ();
+      for (size_t i = 0; i < newSlots.size (); ++i)
+      {
+        if (newSlots [i] >= numTris)
+          std::copy_n (data + newSources [i] * tupleSize, tupleSize, data + newSlots [i] * tupleSize);
+      }
+    });
+  }
+
+// update green families and neighbors of affected triangles
+  m_neighbors.resize (nextSlot * 3, NO_INDEX);
+  m_greenSiblings.resize (nextSlot, NO_INDEX);
+
+  for (size_t i = 0; i < newSlots.size (); ++i)
+  {
+    m_greenSiblings [newSlots [i]] = newSiblings [i];
+    std::fill_n (&m_neighbors [newSlots [i] * 3], 3, NO_INDEX);
+  }
+
+  std::unordered_map <std::uint64_t, index_t> sides;
+  for (index_t tri : affected)
+  {
+    for (index_t side = 0; side < 3; ++side)
+    {
+      auto const result = sides.emplace (EdgeKey (corner (tri, side), corner (tri, side + 1)),
+                                         tri * 3 + side);
+      if (!result.second) {
+        index_t const other = result.first->second;
+        m_neighbors [tri * 3 + side] = other / 3;
+        m_neighbors [other] = tri;
+      }
+    }
+  }
+
+// children of removed green families may contain edges which were split on the other side
+  for (index_t slot : newSlots)
+  {
+    for (index_t side = 0; side < 3; ++side)
+    {
+      if (m_neighbors [slot * 3 + side] != NO_INDEX)
+        continue;
+
+      index_t const a = corner (slot, side);
+      index_t const b = corner (slot, side + 1);
+      auto const iter = edgeVertices.find (EdgeKey (a, b));
+      if (iter == edgeVertices.end ())
+        continue;
+
+      touchedSeeds.push_back (slot);
+      for (index_t const c : {a, b})
+      {
+        auto const half = sides.find (EdgeKey (c, iter->second));
+        if (half != sides.end ())
+          extraAffected.push_back (half->second / 3);
+      }
+    }
+  }
+}
+
+void AdaptiveRefiner::refine_tets (std::vector <index_t> const& markedTets)
+{
+  Mesh& mesh = *m_mesh;
+  index_t const numTets = static_cast <index_t> (mesh.num (TET));
+  GrobDesc const tetDesc (TET);
+  index_t const numEdges = tetDesc.num_sides (1);
+
+  if (!mesh.has_annex (keys::hangingNodeConstraints))
+    mesh.set_annex (keys::hangingNodeConstraints, IndexArrayAnnex (2, NO_INDEX));
+
+  auto edgeKey = [&] (index_t const* corners, index_t const edge)
+  {
+    index_t const* localCorners = tetDesc.local_side_corners (1, edge);
+    return EdgeKey (corners [localCorners [0]], corners [localCorners [1]]);
+  };
+
+// determine the closure of the marked tetrahedra. Tetrahedra with a hanging corner
+// are refined together with all tetrahedra containing the constraining edge.
+  std::unordered_set <index_t> refinedSet;
+  std::vector <index_t> refinedTets;
+  {
+    index_t const* tetCorners = mesh.grobs (TET).data ();
+    index_t const* constraints = mesh.annex (keys::hangingNodeConstraints).data ();
+    std::vector <index_t> work (markedTets);
+    while (!work.empty ())
+    {
+      index_t const tet = work.back ();
+      work.pop_back ();
+      if (!refinedSet.insert (tet).second)
+        continue;
+      refinedTets.push_back (tet);
+
+      for (index_t i = 0; i < 4; ++i)
+      {
+        index_t const* c = constraints + tetCorners [tet * 4 + i] * 2;
+        if (c [0] == NO_INDEX)
+          continue;
+        auto const& coarseTets = m_edgeTets.at (EdgeKey (c [0], c [1]));
+        work.insert (work.end (), coarseTets.begin (), coarseTets.end ());
+      }
+    }
+  }
+
+// remove the refined tetrahedra from their edges and create vertices at the centers
+// of all edges which haven't been split yet
+  index_t const* tetCorners = mesh.grobs (TET).data ();
+  std::vector <std::uint64_t> refinedEdges;
+  for (index_t tet : refinedTets)
+  {
+    for (index_t i = 0; i < numEdges; ++i)
+    {
+      auto const key = edgeKey (tetCorners + tet * 4, i);
+      auto& tets = m_edgeTets.at (key);
+      tets.erase (std::find (tets.begin (), tets.end (), tet));
+      refinedEdges.push_back (key);
+    }
+  }
+  std::sort (refinedEdges.begin (), refinedEdges.end ());
+  refinedEdges.erase (std::unique (refinedEdges.begin (), refinedEdges.end ()), refinedEdges.end ());
+
+  index_t const firstNewVertex = static_cast <index_t> (mesh.num (VERTEX));
+  index_t numVertices = firstNewVertex;
+  std::vector <index_t> edgeCorners;
+  for (auto const key : refinedEdges)
+  {
+    if (m_edgeCenters.emplace (key, numVertices).second) {
+      ++numVertices;
+      edgeCorners.push_back (static_cast <index_t> (key >> 32));
+      edgeCorners.push_back (static_cast <index_t> (key & 0xFFFFFFFF));
+    }
+  }
+
+  if (numVertices > firstNewVertex) {
+    mesh.resize_vertices (numVertices);
+    for (auto const& key : mesh.annex_keys ())
+    {
+      if (key.grob_type () != VERTEX)
+        continue;
+      VisitArrayAnnex (mesh.untyped_annex (key), [&] (auto& annex)
+                       {InterpolateEdgeCenters (annex, edgeCorners, firstNewVertex);});
+    }
+  }
+
+// create children. The first child of each parent replaces the parent.
+  real_t const* coords = nullptr;
+  index_t coordsTupleSize = 0;
+  if (mesh.has_annex (keys::vertexCoords)) {
+    auto const& coordsAnnex = mesh.annex (keys::vertexCoords);
+    coords = coordsAnnex.data ();
+    coordsTupleSize = static_cast <index_t> (coordsAnnex.tuple_size ());
+  }
+
+  std::vector <index_t> newCorners;
+  std::vector <index_t> newSlots;
+  std::vector <index_t> newSources;
+  index_t nextSlot = numTets;
+
+  for (index_t tet : refinedTets)
+  {
+    ConstGrob const parent = mesh.grobs (TET) [tet];
+    std::array <index_t, 10> refVrts;
+    for (index_t i = 0; i < 4; ++i)
+      refVrts [i] = parent.corner (i);
+    for (index_t i = 0; i < numEdges; ++i)
+      refVrts [4 + i] = m_edgeCenters.at (edgeKey (tetCorners + tet * 4, i));
+
+    index_t const variant = coords ? impl::ShortestOctahedronDiagonal (parent, coords, coordsTupleSize) : 0;
+    index_t const* childCorners = impl::g_tetChildren [variant];
+    for (index_t child = 0; child < 8; ++child)
+    {
+      for (index_t i = 0; i < 4; ++i)
+        newCorners.push_back (refVrts [childCorners [child * 4 + i]]);
+      newSlots.push_back (child == 0 ? tet : nextSlot++);
+      newSources.push_back (tet);
+    }
+  }
+
+// write the children to the mesh
+  {
+    GrobArray appendedTets (TET);
+    appendedTets.resize (nextSlot - numTets);
+    index_t* appendedCorners = appendedTets.data ();
+    for (size_t i = 0; i < newSlots.size (); ++i)
+    {
+      if (newSlots [i] >= numTets)
+        std::copy_n (&newCorners [i * 4], 4, appendedCorners + (newSlots [i] - numTets) * 4);
+    }
+    mesh.insert_grobs (appendedTets.begin (), appendedTets.end ());
+  }
+
+  index_t* corners = mesh.grobs (TET).data ();
+  for (size_t i = 0; i < newSlots.size (); ++i)
+  {
+    if (newSlots [i] < numTets)
+      std::copy_n (&newCorners [i * 4], 4, corners + newSlots [i] * 4);
+  }
+
+  for (auto const& key : mesh.annex_keys ())
+  {
+    if (key.grob_type () != TET)
+      continue;
+
+    VisitArrayAnnex (mesh.untyped_annex (key), [&] (auto& annex)
+    {
+      size_t const tupleSize = annex.tuple_size ();
+      auto* data = annex.data ();
+      for (size_t i = 0; i < newSlots.size (); ++i)
+      {
+        if (newSlots [i] >= numTets)
+          std::copy_n (data + newSources [i] * tupleSize, tupleSize, data + newSlots [i] * tupleSize);
+      }
+    });
+  }
+
+// children of coarse tetrahedra from the closure may contain split edges of finer
+// tetrahedra, so they have to be registered before the hanging vertices are determined
+  for (size_t i = 0; i < newSlots.size (); ++i)
+  {
+    for (index_t j = 0; j < numEdges; ++j)
+      m_edgeTets [edgeKey (corners + newSlots [i] * 4, j)].push_back (newSlots [i]);
+  }
+
+// centers of split edges which are still used by coarser tetrahedra are hanging
+  index_t* constraints = mesh.annex (keys::hangingNodeConstraints).data ();
+  for (auto const key : refinedEdges)
+  {
+    index_t const center = m_edgeCenters.at (key);
+    auto const tets = m_edgeTets.find (key);
+    if (tets->second.empty ()) {
+      m_edgeTets.erase (tets);
+      m_edgeCenters.erase (key);
+      constraints [center * 2] = constraints [center * 2 + 1] = NO_INDEX;
+    }
+    else {
+      constraints [center * 2] = static_cast <index_t> (key >> 32);
+      constraints [center * 2 + 1] = static_cast <index_t> (key & 0xFFFFFFFF);
+    }
+  }
+}
+
+}// end of namespace lume
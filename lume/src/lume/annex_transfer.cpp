@@ -0,0 +1,221 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/annex_transfer.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <lume/array_annex.h>
+#include <lume/math/tuple_size.h>
+#include <lume/parallel_for.h>
+#include <lume/subset_info_annex.h>
+
+namespace lume
+{
+
+namespace
+{
+  template <class T>
+  ArrayAnnex <T>& GetOrCreateArrayAnnex (Mesh& mesh,
+                                         TypedAnnexKey <ArrayAnnex <T>> const& key,
+                                         index_t const tupleSize)
+  {
+    if (!mesh.has_annex (key)) {
+      return mesh.set_annex (key, ArrayAnnex <T> (tupleSize, T (0)));
+    }
+
+    auto& annex = mesh.annex (key);
+    if (annex.tuple_size () != tupleSize) {
+      throw BadTupleSizeError () << "Tuple size of existing annex '" << key.name ()
+                                 << "' (" << annex.tuple_size () << ") doesn't match "
+                                 << "expected tuple size (" << tupleSize << ")";
+    }
+    return annex;
+  }
+
+  /// Interpolates vertex values. If `N != math::dynamicSize`, the tuple size is the compile-time constant `N`.
+  template <size_t N, class T>
+  void InterpolateVertexValues (Hierarchy& hierarchy,
+                                AnnexKey const& key,
+                                ArrayAnnex <T> const& parentAnnex)
+  {
+    index_t const tupleSize = N == math::dynamicSize ?
+                              static_cast <index_t> (parentAnnex.tuple_size ()) :
+                              static_cast <index_t> (N);
+    auto& childAnnex = GetOrCreateArrayAnnex (hierarchy.child_mesh (),
+                                              TypedAnnexKey <ArrayAnnex <T>> (key.name (), VERTEX),
+                                              tupleSize);
+
+    T const* parentData = parentAnnex.data ();
+    T*       childData  = childAnnex.data ();
+
+    auto const& relations = hierarchy.relationsForChildType (VERTEX);
+    parallel_for (relations.begin (), relations.end (), [=] (Hierarchy::Relation const& relation)
+    {
+      ConstGrob const& parent = relation.parent;
+      index_t const numCorners = parent.num_corners ();
+
+      for (index_t i = 0; i < tupleSize; ++i)
+      {
+        T value = parentData [parent.corner (0) * tupleSize + i];
+        for (index_t j = 1; j < numCorners; ++j)
+        {
+          T const cornerValue = parentData [parent.corner (j) * tupleSize + i];
+          if constexpr (std::is_floating_point <T>::value)
+            value += cornerValue;
+          else
+            value = std::min (value, cornerValue);
+        }
+
+        if constexpr (std::is_floating_point <T>::value)
+          value /= static_cast <T> (numCorners);
+
+        for (index_t child : relation) {
+          childData [child * tupleSize + i] = value;
+        }
+      }
+    });
+  }
+
+  template <class T>
+  void CopyValuesToChildren (Hierarchy& hierarchy,
+                             AnnexKey const& key,
+                             ArrayAnnex <T> const& parentAnnex)
+  {
+    GrobType const parentType = *key.grob_type ();
+    index_t const parentDim = GrobDesc (parentType).dim ();
+    index_t const tupleSize = static_cast <index_t> (parentAnnex.tuple_size ());
+    T const* parentData = parentAnnex.data ();
+
+    for (index_t ichild = 0; ichild < NUM_GROB_TYPES; ++ichild)
+    {
+      GrobType const childType = static_cast <GrobType> (ichild);
+    // e.g. the center vertex of a quad must not receive the quad's value
+      if (GrobDesc (childType).dim () != parentDim) {
+        continue;
+      }
+
+      auto const& relations = hierarchy.relationsForChildType (childType);
+
+      bool const hasParentType = std::any_of (relations.begin (), relations.end (),
+                                              [parentType] (Hierarchy::Relation const& r)
+                                              {return r.parent.grob_type () == parentType;});
+      if (!hasParentType) {
+        continue;
+      }
+
+      auto& childAnnex = GetOrCreateArrayAnnex (hierarchy.child_mesh (),
+                                                TypedAnnexKey <ArrayAnnex <T>> (key.name (), childType),
+                                                tupleSize);
+      T* childData = childAnnex.data ();
+
+      parallel_for (relations.begin (), relations.end (), [=] (Hierarchy::Relation const& relation)
+      {
+        if (relation.parent.grob_type () != parentType || relation.parentIndex == NO_INDEX) {
+          return;
+        }
+
+        T const* value = parentData + relation.parentIndex * tupleSize;
+        for (index_t child : relation) {
+          std::copy (value, value + tupleSize, childData + child * tupleSize);
+        }
+      });
+    }
+  }
+}// end of unnamed namespace
+
+
+void AnnexTransfer::set_policy (AnnexKey const& key, Policy policy)
+{
+  m_policies [key] = std::move (policy);
+}
+
+void AnnexTransfer::ignore (AnnexKey const& key)
+{
+  m_policies [key] = Policy ();
+}
+
+void AnnexTransfer::operator () (Hierarchy& hierarchy) const
+{
+  for (auto const& key : hierarchy.parent_mesh ().annex_keys ())
+  {
+    auto const policy = m_policies.find (key);
+    if (policy == m_policies.end ()) {
+      DefaultAnnexTransferPolicy (hierarchy, key);
+    }
+    else if (policy->second) {
+      policy->second (hierarchy, key);
+    }
+  }
+}
+
+void DefaultAnnexTransferPolicy (Hierarchy& hierarchy, AnnexKey const& key)
+{
+  Annex const& annex = hierarchy.parent_mesh ().untyped_annex (key);
+
+  if (!key.grob_type ())
+  {
+    if (auto subsetInfo = dynamic_cast <SubsetInfoAnnex const*> (&annex)) {
+      hierarchy.child_mesh ().set_annex (key, SubsetInfoAnnex (*subsetInfo));
+      return;
+    }
+
+    VisitArrayAnnex (annex, [&hierarchy, &key] (auto const& arrayAnnex) {
+      using annex_t = typename std::decay <decltype (arrayAnnex)>::type;
+      using value_t = typename annex_t::value_type;
+      std::vector <value_t> values (arrayAnnex.begin (), arrayAnnex.end ());
+      hierarchy.child_mesh ().set_annex (key, annex_t (arrayAnnex.tuple_size (), std::move (values)));
+    });
+  }
+  else if (*key.grob_type () == VERTEX) {
+    InterpolateVertexAnnex (hierarchy, key);
+  }
+  else {
+    CopyAnnexToChildren (hierarchy, key);
+  }
+}
+
+void InterpolateVertexAnnex (Hierarchy& hierarchy, AnnexKey const& key)
+{
+  Annex const& annex = hierarchy.parent_mesh ().untyped_annex (key);
+  VisitArrayAnnex (annex, [&hierarchy, &key] (auto const& arrayAnnex) {
+    math::DispatchTupleSize (arrayAnnex.tuple_size (), [&] (auto tupleSize) {
+      InterpolateVertexValues <decltype (tupleSize)::value> (hierarchy, key, arrayAnnex);
+    });
+  });
+}
+
+void CopyAnnexToChildren (Hierarchy& hierarchy, AnnexKey const& key)
+{
+  if (!key.grob_type ()) {
+    return;
+  }
+
+  Annex const& annex = hierarchy.parent_mesh ().untyped_annex (key);
+  VisitArrayAnnex (annex, [&hierarchy, &key] (auto const& arrayAnnex) {
+    CopyValuesToChildren (hierarchy, key, arrayAnnex);
+  });
+}
+
+}// end of namespace lume
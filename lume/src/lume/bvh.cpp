@@ -0,0 +1,868 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/bvh.h>
+
+#include <cmath>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <lume/array_annex.h>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+namespace
+{
+  using vec3 = std::array <real_t, 3>;
+
+  constexpr int     g_numBins = 16;
+  constexpr index_t g_parallelBuildThreshold = 4096;
+  constexpr index_t g_maxSAHDepth = 48;
+  /// Trees are at most `g_maxSAHDepth + 32` levels deep, since median splits are used below `g_maxSAHDepth`.
+  constexpr int     g_maxStackSize = 128;
+
+  inline real_t Dot (vec3 const& a, vec3 const& b)
+  {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  }
+
+  inline vec3 Sub (real_t const* a, real_t const* b)
+  {
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+  }
+
+  inline vec3 Cross (vec3 const& a, vec3 const& b)
+  {
+    return {a[1] * b[2] - a[2] * b[1],
+            a[2] * b[0] - a[0] * b[2],
+            a[0] * b[1] - a[1] * b[0]};
+  }
+
+  inline vec3 Madd (real_t const* a, vec3 const& d, real_t const s)
+  {
+    return {a[0] + s * d[0], a[1] + s * d[1], a[2] + s * d[2]};
+  }
+
+  inline real_t DistSq (real_t const* a, real_t const* b)
+  {
+    vec3 const d = Sub (a, b);
+    return Dot (d, d);
+  }
+
+  inline vec3 Reciprocal (vec3 const& d)
+  {
+    return {real_t (1) / d[0], real_t (1) / d[1], real_t (1) / d[2]};
+  }
+
+  /// Slab test. On success `tEntryOut` holds the parameter at which the ray enters the box.
+  inline bool IntersectBox (BoundingBox const& box,
+                            vec3 const& origin,
+                            vec3 const& invDir,
+                            real_t const tMin,
+                            real_t const tMax,
+                            real_t& tEntryOut)
+  {
+    real_t t0 = tMin;
+    real_t t1 = tMax;
+    for (int i = 0; i < 3; ++i) {
+      real_t tNear = (box.min [i] - origin [i]) * invDir [i];
+      real_t tFar  = (box.max [i] - origin [i]) * invDir [i];
+      if (tNear > tFar)
+        std::swap (tNear, tFar);
+      // written so that NaNs (origin on a slab of a flat box) don't reject the box
+      t0 = tNear > t0 ? tNear : t0;
+      t1 = tFar < t1 ? tFar : t1;
+      if (t0 > t1)
+        return false;
+    }
+    tEntryOut = t0;
+    return true;
+  }
+
+  /// Möller-Trumbore ray-triangle intersection. Returns true for hits with `t` in `(tMin, tMax)`.
+  inline bool IntersectTriangle (Ray const& ray,
+                                 real_t const* c0,
+                                 real_t const* c1,
+                                 real_t const* c2,
+                                 real_t const tMax,
+                                 real_t& tOut)
+  {
+    vec3 const e1 = Sub (c1, c0);
+    vec3 const e2 = Sub (c2, c0);
+    vec3 const p = Cross (ray.direction, e2);
+    real_t const det = Dot (e1, p);
+    if (det == 0)
+      return false;
+
+    real_t const invDet = real_t (1) / det;
+    vec3 const s = Sub (ray.origin.data (), c0);
+    real_t const u = Dot (s, p) * invDet;
+    if (u < 0 || u > 1)
+      return false;
+
+    vec3 const q = Cross (s, e1);
+    real_t const v = Dot (ray.direction, q) * invDet;
+    if (v < 0 || u + v > 1)
+      return false;
+
+    real_t const t = Dot (e2, q) * invDet;
+    if (t < ray.tMin || t >= tMax)
+      return false;
+
+    tOut = t;
+    return true;
+  }
+
+  /// Returns the squared distance of `p` to the segment `[a, b]`
+  inline real_t ClosestPointOnSegment (real_t const* p, real_t const* a, real_t const* b, real_t* out)
+  {
+    vec3 const ab = Sub (b, a);
+    real_t const lenSq = Dot (ab, ab);
+    real_t t = lenSq > 0 ? Dot (Sub (p, a), ab) / lenSq : 0;
+    t = std::min (real_t (1), std::max (real_t (0), t));
+    vec3 const c = Madd (a, ab, t);
+    std::copy (c.begin (), c.end (), out);
+    return DistSq (p, out);
+  }
+
+  /// Returns the squared distance of `p` to the triangle `(a, b, c)` (Ericson, Real-Time Collision Detection, 5.1.5)
+  inline real_t ClosestPointOnTriangle (real_t const* p,
+                                        real_t const* a,
+                                        real_t const* b,
+                                        real_t const* c,
+                                        real_t* out)
+  {
+    vec3 const ab = Sub (b, a);
+    vec3 const ac = Sub (c, a);
+    vec3 const ap = Sub (p, a);
+
+    auto result = [&] (vec3 const& q) {
+      std::copy (q.begin (), q.end (), out);
+      return DistSq (p, out);
+    };
+
+    real_t const d1 = Dot (ab, ap);
+    real_t const d2 = Dot (ac, ap);
+    if (d1 <= 0 && d2 <= 0)
+      return result ({a[0], a[1], a[2]});
+
+    vec3 const bp = Sub (p, b);
+    real_t const d3 = Dot (ab, bp);
+    real_t const d4 = Dot (ac, bp);
+    if (d3 >= 0 && d4 <= d3)
+      return result ({b[0], b[1], b[2]});
+
+    real_t const vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+      return result (Madd (a, ab, d1 / (d1 - d3)));
+
+    vec3 const cp = Sub (p, c);
+    real_t const d5 = Dot (ab, cp);
+    real_t const d6 = Dot (ac, cp);
+    if (d6 >= 0 && d5 <= d6)
+      return result ({c[0], c[1], c[2]});
+
+    real_t const vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+      return result (Madd (a, ac, d2 / (d2 - d6)));
+
+    real_t const va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+      return result (Madd (b, Sub (c, b), (d4 - d3) / ((d4 - d3) + (d5 - d6))));
+
+    real_t const denom = real_t (1) / (va + vb + vc);
+    real_t const v = vb * denom;
+    real_t const w = vc * denom;
+    vec3 const q = Madd (a, ab, v);
+    return result (Madd (q.data (), ac, w));
+  }
+
+  struct Bin
+  {
+    BoundingBox box;
+    index_t     count {0};
+  };
+
+  using BinArray = std::array <std::array <Bin, g_numBins>, 3>;
+
+  inline int BinIndex (real_t const c, real_t const min, real_t const scale)
+  {
+    return std::min (g_numBins - 1, std::max (0, static_cast <int> ((c - min) * scale)));
+  }
+}// end of unnamed namespace
+
+
+BVH::BVH (CSPMesh mesh, GrobSet grobSet, index_t maxLeafSize)
+  : m_mesh (std::move (mesh))
+  , m_grobSet (grobSet)
+{
+  if (!m_mesh)
+    throw LumeError () << "BVH: No mesh specified";
+
+  auto const& coords = m_mesh->annex (keys::vertexCoords);
+  index_t const tupleSize = coords.tuple_size ();
+  if (tupleSize < 1 || tupleSize > 3)
+    throw BadTupleSizeError () << "BVH: Unsupported coordinate tuple size " << tupleSize;
+
+  index_t const numVertices = static_cast <index_t> (coords.num_tuples ());
+  m_coords.resize (numVertices * 3, 0);
+  for (index_t i = 0; i < numVertices; ++i) {
+    for (index_t j = 0; j < tupleSize; ++j)
+      m_coords [i * 3 + j] = coords [i * tupleSize + j];
+  }
+
+  for (auto gt : m_grobSet) {
+    index_t const num = static_cast <index_t> (m_mesh->num (gt));
+    for (index_t i = 0; i < num; ++i)
+      m_grobs.push_back (GrobIndex (gt, i));
+  }
+
+  build (std::max <index_t> (1, maxLeafSize));
+}
+
+
+void BVH::build (index_t const maxLeafSize)
+{
+  index_t const numPrims = static_cast <index_t> (m_grobs.size ());
+  m_nodes.clear ();
+  if (numPrims == 0) {
+    m_nodes.push_back (Node {BoundingBox {}, 0, 0});
+    return;
+  }
+
+  m_primBoxes.resize (numPrims);
+  m_primCenters.resize (numPrims * 3);
+
+  parallel_for_blocks (index_t (0), numPrims, [this] (index_t const begin, index_t const end) {
+    for (index_t iprim = begin; iprim < end; ++iprim) {
+      auto const grob = m_mesh->grob (m_grobs [iprim]);
+      BoundingBox box;
+      index_t const numCorners = grob.num_corners ();
+      for (index_t i = 0; i < numCorners; ++i)
+        box.extend (m_coords.data () + grob.corner (i) * 3);
+      m_primBoxes [iprim] = box;
+      for (int i = 0; i < 3; ++i)
+        m_primCenters [iprim * 3 + i] = real_t (0.5) * (box.min [i] + box.max [i]);
+    }
+  });
+
+  std::vector <index_t> prims (numPrims);
+  std::iota (prims.begin (), prims.end (), 0);
+
+  int parallelDepth = 0;
+  for (unsigned numThreads = std::thread::hardware_concurrency (); numThreads > 1; numThreads /= 2)
+    ++parallelDepth;
+  if (parallelDepth > 0)
+    ++parallelDepth;
+
+  m_nodes.reserve (2 * numPrims / maxLeafSize + 1);
+  build_recursive (prims, 0, numPrims, m_nodes, maxLeafSize, parallelDepth, 0);
+
+  std::vector <GrobIndex> grobs;
+  grobs.reserve (numPrims);
+  for (auto p : prims)
+    grobs.push_back (m_grobs [p]);
+  m_grobs.swap (grobs);
+
+  m_primBoxes = std::vector <BoundingBox> ();
+  m_primCenters = std::vector <real_t> ();
+}
+
+
+void BVH::build_recursive (std::vector <index_t>& prims,
+                           index_t const begin,
+                           index_t const end,
+                           std::vector <Node>& nodesOut,
+                           index_t const maxLeafSize,
+                           int const parallelDepth,
+                           index_t const depth) const
+{
+  index_t const nodeIndex = static_cast <index_t> (nodesOut.size ());
+  nodesOut.push_back (Node {});
+
+  index_t const numPrims = end - begin;
+  bool const parallel = parallelDepth > 0 && numPrims >= g_parallelBuildThreshold;
+
+  BoundingBox box;
+  BoundingBox centerBox;
+  for (index_t i = begin; i < end; ++i) {
+    box.extend (m_primBoxes [prims [i]]);
+    centerBox.extend (m_primCenters.data () + prims [i] * 3);
+  }
+
+  if (numPrims <= maxLeafSize) {
+    nodesOut [nodeIndex] = Node {box, begin, numPrims};
+    return;
+  }
+
+  std::array <real_t, 3> binScales;
+  for (int axis = 0; axis < 3; ++axis) {
+    real_t const extent = centerBox.max [axis] - centerBox.min [axis];
+    binScales [axis] = extent > 0 ? real_t (g_numBins) / extent : 0;
+  }
+
+  // bin the primitives along all three axes at once
+  auto binPrims = [&] (index_t const first, index_t const last, BinArray& bins) {
+    for (index_t i = first; i < last; ++i) {
+      index_t const p = prims [i];
+      for (int axis = 0; axis < 3; ++axis) {
+        auto& bin = bins [axis][BinIndex (m_primCenters [p * 3 + axis],
+                                          centerBox.min [axis],
+                                          binScales [axis])];
+        bin.box.extend (m_primBoxes [p]);
+        ++bin.count;
+      }
+    }
+  };
+
+  BinArray bins;
+  if (parallel) {
+    std::mutex binMutex;
+    parallel_for_blocks (begin, end, [&] (index_t const first, index_t const last) {
+      BinArray localBins;
+      binPrims (first, last, localBins);
+      std::lock_guard <std::mutex> lock (binMutex);
+      for (int axis = 0; axis < 3; ++axis) {
+        for (int i = 0; i < g_numBins; ++i) {
+          bins [axis][i].box.extend (localBins [axis][i].box);
+          bins [axis][i].count += localBins [axis][i].count;
+        }
+      }
+    });
+  }
+  else
+    binPrims (begin, end, bins);
+
+  // evaluate the surface area heuristic for the splits between bins
+  int    bestAxis = -1;
+  int    bestBin = 0;
+  real_t bestCost = std::numeric_limits <real_t>::max ();
+  for (int axis = 0; axis < 3; ++axis) {
+    if (binScales [axis] == 0)
+      continue;
+
+    std::array <real_t, g_numBins> rightCosts;
+    BoundingBox rightBox;
+    index_t rightCount = 0;
+    for (int i = g_numBins - 1; i > 0; --i) {
+      rightBox.extend (bins [axis][i].box);
+      rightCount += bins [axis][i].count;
+      rightCosts [i] = rightCount ? rightBox.half_area () * real_t (rightCount) : 0;
+    }
+
+    BoundingBox leftBox;
+    index_t leftCount = 0;
+    for (int i = 0; i < g_numBins - 1; ++i) {
+      leftBox.extend (bins [axis][i].box);
+      leftCount += bins [axis][i].count;
+      if (leftCount == 0 || leftCount == numPrims)
+        continue;
+      real_t const cost = leftBox.half_area () * real_t (leftCount) + rightCosts [i + 1];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestBin = i;
+      }
+    }
+  }
+
+  index_t mid = begin;
+  if (bestAxis >= 0 && depth < g_maxSAHDepth) {
+    real_t const min = centerBox.min [bestAxis];
+    real_t const scale = binScales [bestAxis];
+    mid = static_cast <index_t> (
+            std::partition (prims.begin () + begin,
+                            prims.begin () + end,
+                            [&] (index_t const p) {
+                              return BinIndex (m_primCenters [p * 3 + bestAxis], min, scale) <= bestBin;
+                            })
+            - prims.begin ());
+  }
+
+  if (mid == begin || mid == end) {
+    // median split along the longest axis of the centers
+    int axis = 0;
+    for (int i = 1; i < 3; ++i) {
+      if (centerBox.max [i] - centerBox.min [i] > centerBox.max [axis] - centerBox.min [axis])
+        axis = i;
+    }
+    mid = begin + numPrims / 2;
+    std::nth_element (prims.begin () + begin,
+                      prims.begin () + mid,
+                      prims.begin () + end,
+                      [&] (index_t const a, index_t const b) {
+                        return m_primCenters [a * 3 + axis] < m_primCenters [b * 3 + axis];
+                      });
+  }
+
+  index_t secondChild;
+  if (parallel) {
+    std::vector <Node> secondNodes;
+    secondNodes.reserve (2 * (end - mid) / maxLeafSize + 1);
+    auto future = std::async (std::launch::async, [&] () {
+      build_recursive (prims, mid, end, secondNodes, maxLeafSize, parallelDepth - 1, depth + 1);
+    });
+
+    build_recursive (prims, begin, mid, nodesOut, maxLeafSize, parallelDepth - 1, depth + 1);
+    future.get ();
+
+    secondChild = static_cast <index_t> (nodesOut.size ());
+    for (auto node : secondNodes) {
+      if (!node.is_leaf ())
+        node.offset += secondChild;
+      nodesOut.push_back (node);
+    }
+  }
+  else {
+    build_recursive (prims, begin, mid, nodesOut, maxLeafSize, 0, depth + 1);
+    secondChild = static_cast <index_t> (nodesOut.size ());
+    build_recursive (prims, mid, end, nodesOut, maxLeafSize, 0, depth + 1);
+  }
+
+  nodesOut [nodeIndex] = Node {box, secondChild, 0};
+}
+
+
+bool BVH::intersect (ConstGrob const& grob, Ray const& ray, real_t& tInOut) const
+{
+  auto const c = [this] (ConstGrob const& g, index_t const i) {
+    return m_coords.data () + g.corner (i) * 3;
+  };
+
+  auto intersectFace = [&] (ConstGrob const& face) {
+    bool hit = IntersectTriangle (ray, c (face, 0), c (face, 1), c (face, 2), tInOut, tInOut);
+    if (face.num_corners () == 4)
+      hit |= IntersectTriangle (ray, c (face, 0), c (face, 2), c (face, 3), tInOut, tInOut);
+    return hit;
+  };
+
+  switch (grob.dim ()) {
+    case 2:
+      return intersectFace (grob);
+    case 3: {
+      bool hit = false;
+      index_t const numSides = grob.num_sides (2);
+      for (index_t i = 0; i < numSides; ++i)
+        hit |= intersectFace (grob.side (2, i));
+      return hit;
+    }
+    default:
+      return false;
+  }
+}
+
+
+void BVH::intersect_all (GrobIndex const& grobIndex, Ray const& ray, std::vector <RayHit>& hitsOut) const
+{
+  auto const grob = m_mesh->grob (grobIndex);
+  auto const c = [this] (ConstGrob const& g, index_t const i) {
+    return m_coords.data () + g.corner (i) * 3;
+  };
+
+  auto intersectFace = [&] (ConstGrob const& face) {
+    real_t t;
+    if (IntersectTriangle (ray, c (face, 0), c (face, 1), c (face, 2), ray.tMax, t))
+      hitsOut.push_back (RayHit {grobIndex, t});
+    else if (face.num_corners () == 4
+             && IntersectTriangle (ray, c (face, 0), c (face, 2), c (face, 3), ray.tMax, t))
+    {
+      hitsOut.push_back (RayHit {grobIndex, t});
+    }
+  };
+
+  if (grob.dim () == 2)
+    intersectFace (grob);
+  else if (grob.dim () == 3) {
+    index_t const numSides = grob.num_sides (2);
+    for (index_t i = 0; i < numSides; ++i)
+      intersectFace (grob.side (2, i));
+  }
+}
+
+
+real_t BVH::closest_point_on_grob (GrobIndex const& grobIndex, real_t const* p, real_t* pointOut) const
+{
+  auto const grob = m_mesh->grob (grobIndex);
+  auto const c = [this] (ConstGrob const& g, index_t const i) {
+    return m_coords.data () + g.corner (i) * 3;
+  };
+
+  auto closestOnFace = [&] (ConstGrob const& face, real_t* out) {
+    real_t distSq = ClosestPointOnTriangle (p, c (face, 0), c (face, 1), c (face, 2), out);
+    if (face.num_corners () == 4) {
+      real_t tmp [3];
+      real_t const d = ClosestPointOnTriangle (p, c (face, 0), c (face, 2), c (face, 3), tmp);
+      if (d < distSq) {
+        distSq = d;
+        std::copy (tmp, tmp + 3, out);
+      }
+    }
+    return distSq;
+  };
+
+  switch (grob.dim ()) {
+    case 0:
+      std::copy (c (grob, 0), c (grob, 0) + 3, pointOut);
+      return DistSq (p, pointOut);
+
+    case 1:
+      return ClosestPointOnSegment (p, c (grob, 0), c (grob, 1), pointOut);
+
+    case 2:
+      return closestOnFace (grob, pointOut);
+
+    default: {
+      // the element is treated as a convex solid. Face normals are oriented away from its center.
+      vec3 center {0, 0, 0};
+      index_t const numCorners = grob.num_corners ();
+      for (index_t i = 0; i < numCorners; ++i) {
+        for (int j = 0; j < 3; ++j)
+          center [j] += c (grob, i) [j];
+      }
+      for (int j = 0; j < 3; ++j)
+        center [j] /= real_t (numCorners);
+
+      bool inside = true;
+      real_t distSq = std::numeric_limits <real_t>::max ();
+      index_t const numSides = grob.num_sides (2);
+      for (index_t i = 0; i < numSides; ++i) {
+        auto const face = grob.side (2, i);
+        real_t const* f0 = c (face, 0);
+        vec3 const n = Cross (Sub (c (face, 1), f0), Sub (c (face, 2), f0));
+        real_t const side = Dot (n, Sub (p, f0));
+        if (Dot (n, Sub (center.data (), f0)) > 0 ? side < 0 : side > 0)
+          inside = false;
+
+        real_t tmp [3];
+        real_t const d = closestOnFace (face, tmp);
+        if (d < distSq) {
+          distSq = d;
+          std::copy (tmp, tmp + 3, pointOut);
+        }
+      }
+
+      if (inside) {
+        std::copy (p, p + 3, pointOut);
+        return 0;
+      }
+      return distSq;
+    }
+  }
+}
+
+
+std::optional <RayHit> BVH::ray_first_hit (Ray const& ray) const
+{
+  vec3 const invDir = Reciprocal (ray.direction);
+  real_t tBest = ray.tMax;
+  GrobIndex bestGrob;
+  bool hit = false;
+
+  real_t tEntry;
+  if (!IntersectBox (m_nodes [0].box, ray.origin, invDir, ray.tMin, tBest, tEntry))
+    return std::nullopt;
+
+  index_t stack [g_maxStackSize];
+  int stackSize = 0;
+  index_t nodeIndex = 0;
+
+  while (true) {
+    Node const& node = m_nodes [nodeIndex];
+    if (node.is_leaf ()) {
+      for (index_t i = node.offset; i < node.offset + node.numGrobs; ++i) {
+        if (intersect (m_mesh->grob (m_grobs [i]), ray, tBest)) {
+          bestGrob = m_grobs [i];
+          hit = true;
+        }
+      }
+    }
+    else {
+      index_t const first = nodeIndex + 1;
+      index_t const second = node.offset;
+      real_t tFirst, tSecond;
+      bool const hitFirst = IntersectBox (m_nodes [first].box, ray.origin, invDir, ray.tMin, tBest, tFirst);
+      bool const hitSecond = IntersectBox (m_nodes [second].box, ray.origin, invDir, ray.tMin, tBest, tSecond);
+
+      if (hitFirst && hitSecond) {
+        // visit the nearer child first
+        if (tSecond < tFirst) {
+          stack [stackSize++] = first;
+          nodeIndex = second;
+        }
+        else {
+          stack [stackSize++] = second;
+          nodeIndex = first;
+        }
+        continue;
+      }
+      if (hitFirst) {
+        nodeIndex = first;
+        continue;
+      }
+      if (hitSecond) {
+        nodeIndex = second;
+        continue;
+      }
+    }
+
+    // pop nodes which are still closer than the best hit
+    bool found = false;
+    while (stackSize > 0) {
+      nodeIndex = stack [--stackSize];
+      if (IntersectBox (m_nodes [nodeIndex].box, ray.origin, invDir, ray.tMin, tBest, tEntry)) {
+        found = true;
+        break;
+      }
+    }
+    if (!found)
+      break;
+  }
+
+  if (!hit)
+    return std::nullopt;
+  return RayHit {bestGrob, tBest};
+}
+
+
+void BVH::ray_all_hits (Ray const& ray, std::vector <RayHit>& hitsOut) const
+{
+  hitsOut.clear ();
+  vec3 const invDir = Reciprocal (ray.direction);
+
+  index_t stack [g_maxStackSize];
+  int stackSize = 0;
+  stack [stackSize++] = 0;
+
+  while (stackSize > 0) {
+    index_t const nodeIndex = stack [--stackSize];
+    Node const& node = m_nodes [nodeIndex];
+    real_t tEntry;
+    if (!IntersectBox (node.box, ray.origin, invDir, ray.tMin, ray.tMax, tEntry))
+      continue;
+
+    if (node.is_leaf ()) {
+      for (index_t i = node.offset; i < node.offset + node.numGrobs; ++i)
+        intersect_all (m_grobs [i], ray, hitsOut);
+    }
+    else {
+      stack [stackSize++] = node.offset;
+      stack [stackSize++] = nodeIndex + 1;
+    }
+  }
+
+  std::sort (hitsOut.begin (), hitsOut.end (),
+             [] (RayHit const& a, RayHit const& b) {return a.t < b.t;});
+}
+
+
+void BVH::box_overlaps (BoundingBox const& box, std::vector <GrobIndex>& grobsOut) const
+{
+  grobsOut.clear ();
+
+  index_t stack [g_maxStackSize];
+  int stackSize = 0;
+  stack [stackSize++] = 0;
+
+  while (stackSize > 0) {
+    index_t const nodeIndex = stack [--stackSize];
+    Node const& node = m_nodes [nodeIndex];
+    if (!node.box.overlaps (box))
+      continue;
+
+    if (node.is_leaf ()) {
+      for (index_t i = node.offset; i < node.offset + node.numGrobs; ++i) {
+        auto const grob = m_mesh->grob (m_grobs [i]);
+        BoundingBox grobBox;
+        index_t const numCorners = grob.num_corners ();
+        for (index_t j = 0; j < numCorners; ++j)
+          grobBox.extend (m_coords.data () + grob.corner (j) * 3);
+        if (grobBox.overlaps (box))
+          grobsOut.push_back (m_grobs [i]);
+      }
+    }
+    else {
+      stack [stackSize++] = node.offset;
+      stack [stackSize++] = nodeIndex + 1;
+    }
+  }
+}
+
+
+std::optional <ClosestPoint>
+BVH::closest_point (real_t const* p, real_t const maxDistanceSq) const
+{
+  ClosestPoint best {GrobIndex (), {0, 0, 0}, maxDistanceSq};
+  bool found = false;
+
+  index_t stack [g_maxStackSize];
+  int stackSize = 0;
+  stack [stackSize++] = 0;
+
+  while (stackSize > 0) {
+    index_t const nodeIndex = stack [--stackSize];
+    Node const& node = m_nodes [nodeIndex];
+    if (node.box.distance_sq (p) >= best.distanceSq)
+      continue;
+
+    if (node.is_leaf ()) {
+      for (index_t i = node.offset; i < node.offset + node.numGrobs; ++i) {
+        real_t point [3];
+        real_t const distSq = closest_point_on_grob (m_grobs [i], p, point);
+        if (distSq < best.distanceSq) {
+          best.grob = m_grobs [i];
+          best.distanceSq = distSq;
+          std::copy (point, point + 3, best.point.begin ());
+          found = true;
+        }
+      }
+    }
+    else {
+      // push the farther child first, so that the nearer child is visited first
+      index_t const first = nodeIndex + 1;
+      index_t const second = node.offset;
+      if (m_nodes [first].box.distance_sq (p) < m_nodes [second].box.distance_sq (p)) {
+        stack [stackSize++] = second;
+        stack [stackSize++] = first;
+      }
+      else {
+        stack [stackSize++] = first;
+        stack [stackSize++] = second;
+      }
+    }
+  }
+
+  if (!found)
+    return std::nullopt;
+  return best;
+}
+
+
+std::vector <std::optional <RayHit>> BVH::ray_first_hits (std::vector <Ray> const& rays) const
+{
+  std::vector <std::optional <RayHit>> hits (rays.size ());
+  size_t const numPackets = (rays.size () + packetSize - 1) / packetSize;
+
+  parallel_for_blocks (size_t (0), numPackets, [&] (size_t const packetsBegin, size_t const packetsEnd) {
+    for (size_t ipacket = packetsBegin; ipacket < packetsEnd; ++ipacket) {
+      size_t const firstRay = ipacket * packetSize;
+      index_t const numRays = static_cast <index_t> (std::min <size_t> (packetSize, rays.size () - firstRay));
+      Ray const* packet = rays.data () + firstRay;
+
+      std::array <vec3, packetSize> invDirs;
+      std::array <real_t, packetSize> tBest;
+      for (index_t i = 0; i < numRays; ++i) {
+        invDirs [i] = Reciprocal (packet [i].direction);
+        tBest [i] = packet [i].tMax;
+      }
+
+      // each stack entry holds a node and the mask of rays which hit its parent
+      std::pair <index_t, unsigned> stack [g_maxStackSize];
+      int stackSize = 0;
+      stack [stackSize++] = {0, (1u << numRays) - 1};
+
+      while (stackSize > 0) {
+        auto const [nodeIndex, parentMask] = stack [--stackSize];
+        Node const& node = m_nodes [nodeIndex];
+
+        unsigned activeMask = 0;
+        for (index_t i = 0; i < numRays; ++i) {
+          real_t tEntry;
+          if ((parentMask & (1u << i))
+              && IntersectBox (node.box, packet [i].origin, invDirs [i], packet [i].tMin, tBest [i], tEntry))
+          {
+            activeMask |= 1u << i;
+          }
+        }
+        if (!activeMask)
+          continue;
+
+        if (node.is_leaf ()) {
+          for (index_t igrob = node.offset; igrob < node.offset + node.numGrobs; ++igrob) {
+            auto const grob = m_mesh->grob (m_grobs [igrob]);
+            for (index_t i = 0; i < numRays; ++i) {
+              if ((activeMask & (1u << i)) && intersect (grob, packet [i], tBest [i]))
+                hits [firstRay + i] = RayHit {m_grobs [igrob], tBest [i]};
+            }
+          }
+        }
+        else {
+          // order the children by the direction of the first active ray along
+          // the axis on which the children are separated the most
+          BoundingBox const& b0 = m_nodes [nodeIndex + 1].box;
+          BoundingBox const& b1 = m_nodes [node.offset].box;
+          int axis = 0;
+          real_t maxSep = std::numeric_limits <real_t>::lowest ();
+          for (int i = 0; i < 3; ++i) {
+            real_t const sep = std::abs ((b1.min [i] + b1.max [i]) - (b0.min [i] + b0.max [i]));
+            if (sep > maxSep) {
+              maxSep = sep;
+              axis = i;
+            }
+          }
+
+          index_t firstActive = 0;
+          while (!(activeMask & (1u << firstActive)))
+            ++firstActive;
+
+          bool const firstIsNear =   (packet [firstActive].direction [axis] >= 0)
+                                  == (b0.min [axis] + b0.max [axis] <= b1.min [axis] + b1.max [axis]);
+          if (firstIsNear) {
+            stack [stackSize++] = {node.offset, activeMask};
+            stack [stackSize++] = {nodeIndex + 1, activeMask};
+          }
+          else {
+            stack [stackSize++] = {nodeIndex + 1, activeMask};
+            stack [stackSize++] = {node.offset, activeMask};
+          }
+        }
+      }
+    }
+  });
+
+  return hits;
+}
+
+
+std::vector <std::optional <ClosestPoint>>
+BVH::closest_points (std::vector <real_t> const& points, real_t const maxDistanceSq) const
+{
+  if (points.size () % 3 != 0)
+    throw BadTupleSizeError () << "BVH::closest_points: The number of components has to be a multiple of 3";
+
+  size_t const numPoints = points.size () / 3;
+  std::vector <std::optional <ClosestPoint>> result (numPoints);
+
+  parallel_for_blocks (size_t (0), numPoints, [&] (size_t const begin, size_t const end) {
+    for (size_t i = begin; i < end; ++i)
+      result [i] = closest_point (points.data () + i * 3, maxDistanceSq);
+  });
+
+  return result;
+}
+
+}// end of namespace lume
@@ -0,0 +1,173 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/coloring.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <lume/derived_data.h>
+
+namespace lume
+{
+
+namespace
+{
+
+/// Pseudo random priority of a grob, ties are broken by the grob index.
+uint64_t Priority (index_t const globalIndex)
+{
+  uint32_t h = globalIndex;
+  h ^= h >> 16;
+  h *= 0x7feb352du;
+  h ^= h >> 15;
+  h *= 0x846ca68bu;
+  h ^= h >> 16;
+  return (uint64_t (h) << 32) | globalIndex;
+}
+
+}// end of unnamed namespace
+
+
+GrobColoring::GrobColoring (Mesh const& mesh, GrobSet const grobSet)
+  : m_grobSet (grobSet)
+  , m_numSlots (std::max <index_t> (1, grobSet.size ()))
+{
+  std::array <index_t, NUM_GROB_TYPES> baseInds {};
+  index_t numGrobs = 0;
+  for (index_t i = 0; i < grobSet.size (); ++i) {
+    GrobType const grobType = grobSet.grob_type (i);
+    m_typeSlots [grobType] = i;
+    baseInds [grobType] = numGrobs;
+    numGrobs += static_cast <index_t> (mesh.num (grobType));
+  }
+
+  auto const incidence = CachedVertexIncidence (mesh, grobSet);
+
+  // calls `func (globalIndex)` for each neighbor of the given grob. Neighbors may be visited multiple times.
+  auto forEachNeighbor = [&] (index_t const globalIndex, auto const& func) {
+    index_t slot = grobSet.size () - 1;
+    while (baseInds [grobSet.grob_type (slot)] > globalIndex)
+      --slot;
+    GrobType const grobType = grobSet.grob_type (slot);
+    index_t const numCorners = GrobDesc (grobType).num_corners ();
+    index_t const* corners = mesh.grobs (grobType).data () + (globalIndex - baseInds [grobType]) * numCorners;
+
+    for (index_t i = 0; i < numCorners; ++i) {
+      for (auto const nbrType : grobSet) {
+        for (index_t const nbr : incidence->incidences (corners [i], nbrType)) {
+          index_t const nbrGlobal = baseInds [nbrType] + nbr;
+          if (nbrGlobal != globalIndex)
+            func (nbrGlobal);
+        }
+      }
+    }
+  };
+
+  std::vector <index_t> colors (numGrobs, NO_INDEX);
+  std::vector <index_t> uncolored (numGrobs);
+  for (index_t i = 0; i < numGrobs; ++i)
+    uncolored [i] = i;
+
+  std::vector <char> selected (numGrobs, 0);
+  while (!uncolored.empty ()) {
+    // select the uncolored grobs whose priority is a local maximum
+    parallel_for_blocks (size_t (0), uncolored.size (), [&] (size_t const begin, size_t const end) {
+      for (size_t i = begin; i < end; ++i) {
+        index_t const g = uncolored [i];
+        uint64_t const priority = Priority (g);
+        bool isMax = true;
+        forEachNeighbor (g, [&] (index_t const nbr) {
+          if (colors [nbr] == NO_INDEX && Priority (nbr) > priority)
+            isMax = false;
+        });
+        selected [g] = isMax;
+      }
+    });
+
+    // selected grobs are independent, so they only read colors of grobs colored in earlier rounds
+    parallel_for_blocks (size_t (0), uncolored.size (), [&] (size_t const begin, size_t const end) {
+      std::vector <index_t> nbrColors;
+      for (size_t i = begin; i < end; ++i) {
+        index_t const g = uncolored [i];
+        if (!selected [g])
+          continue;
+
+        nbrColors.clear ();
+        forEachNeighbor (g, [&] (index_t const nbr) {
+          if (colors [nbr] != NO_INDEX)
+            nbrColors.push_back (colors [nbr]);
+        });
+        std::sort (nbrColors.begin (), nbrColors.end ());
+
+        index_t color = 0;
+        for (index_t const c : nbrColors) {
+          if (c == color)
+            ++color;
+          else if (c > color)
+            break;
+        }
+        colors [g] = color;
+      }
+    });
+
+    uncolored.erase (std::remove_if (uncolored.begin (), uncolored.end (),
+                                     [&] (index_t const g) {return colors [g] != NO_INDEX;}),
+                     uncolored.end ());
+  }
+
+  for (index_t const c : colors)
+    m_numColors = std::max (m_numColors, c + 1);
+
+  // counting sort by color and grob type
+  m_offsets.assign (m_numColors * m_numSlots + 1, 0);
+  for (index_t slot = 0; slot < grobSet.size (); ++slot) {
+    GrobType const grobType = grobSet.grob_type (slot);
+    for (index_t i = 0; i < mesh.num (grobType); ++i)
+      ++m_offsets [colors [baseInds [grobType] + i] * m_numSlots + slot + 1];
+  }
+
+  for (size_t i = 1; i < m_offsets.size (); ++i)
+    m_offsets [i] += m_offsets [i - 1];
+
+  m_grobs.resize (numGrobs);
+  std::vector <index_t> cursors (m_offsets.begin (), m_offsets.end () - 1);
+  for (index_t slot = 0; slot < grobSet.size (); ++slot) {
+    GrobType const grobType = grobSet.grob_type (slot);
+    for (index_t i = 0; i < mesh.num (grobType); ++i)
+      m_grobs [cursors [colors [baseInds [grobType] + i] * m_numSlots + slot]++] = i;
+  }
+}
+
+
+std::shared_ptr <GrobColoring const>
+CachedGrobColoring (Mesh const& mesh, GrobSet const grobSet)
+{
+  return mesh.derived_data <GrobColoring> (
+    "GrobColoring:" + grobSet.name (),
+    DerivedDataCache::grob_type_mask ({VERTICES, grobSet}),
+    {},
+    [&] () {return GrobColoring (mesh, grobSet);});
+}
+
+}// end of namespace lume
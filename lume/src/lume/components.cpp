@@ -0,0 +1,200 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/components.h>
+
+#include <atomic>
+#include <memory>
+#include <lume/derived_data.h>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+#include <lume/partitioning.h>
+
+namespace lume
+{
+
+namespace
+{
+
+/// A union-find structure which supports concurrent calls to `unite` and `find`.
+/** Roots are always linked below smaller roots, so that the root of each set is its
+  smallest element and the result does not depend on the order of the operations.
+  `find` compresses paths by path splitting.*/
+class ConcurrentUnionFind
+{
+public:
+  explicit ConcurrentUnionFind (index_t const size)
+    : m_parents (new std::atomic <index_t> [size])
+  {
+    parallel_for_blocks (index_t (0), size, [this] (index_t const begin, index_t const end) {
+      for (index_t i = begin; i < end; ++i)
+        m_parents [i].store (i, std::memory_order_relaxed);
+    });
+  }
+
+  index_t find (index_t x) const
+  {
+    index_t parent = m_parents [x].load (std::memory_order_relaxed);
+    while (parent != x) {
+      index_t const grandParent = m_parents [parent].load (std::memory_order_relaxed);
+      if (grandParent != parent)
+        m_parents [x].compare_exchange_weak (parent, grandParent, std::memory_order_relaxed);
+      x = parent;
+      parent = grandParent;
+    }
+    return x;
+  }
+
+  void unite (index_t a, index_t b)
+  {
+    while (true) {
+      a = find (a);
+      b = find (b);
+      if (a == b)
+        return;
+      if (a > b)
+        std::swap (a, b);
+
+      index_t expected = b;
+      if (m_parents [b].compare_exchange_strong (expected, a, std::memory_order_relaxed))
+        return;
+    }
+  }
+
+private:
+  std::unique_ptr <std::atomic <index_t> []> m_parents;
+};
+
+}// end of unnamed namespace
+
+
+ComponentInfo LabelComponents (Mesh& mesh, GrobSet const grobSet, index_t const connectionDim)
+{
+  if (connectionDim >= grobSet.dim ()) {
+    throw LumeError () << "LabelComponents: The connection dimension " << connectionDim
+                       << " has to be smaller than the dimension of " << grobSet.name ();
+  }
+
+  // connections of each grob, given as indices into the union-find index space
+  std::shared_ptr <GrobSides const> sides;
+  std::array <index_t, NUM_GROB_TYPES> sideBaseInds {};
+  index_t numConnectors = static_cast <index_t> (mesh.num (VERTEX));
+
+  if (connectionDim > 0) {
+    GrobSet const sideSet = GrobSetTypeByDim (connectionDim);
+    sides = CachedGrobSides (mesh, grobSet, sideSet);
+    numConnectors = 0;
+    for (auto const sideType : sideSet) {
+      sideBaseInds [sideType] = numConnectors;
+      numConnectors += static_cast <index_t> (sides->num_sides (sideType));
+    }
+  }
+
+  auto forEachConnector = [&] (GrobType const grobType, index_t const grobIndex, auto const& func) {
+    if (connectionDim == 0) {
+      index_t const numCorners = GrobDesc (grobType).num_corners ();
+      index_t const* corners = mesh.grobs (grobType).data () + grobIndex * numCorners;
+      for (index_t i = 0; i < numCorners; ++i)
+        func (corners [i]);
+    }
+    else {
+      GrobDesc const desc (grobType);
+      GrobIndex const grob (grobType, grobIndex);
+      index_t const numSides = sides->num_local_sides (grobType);
+      for (index_t i = 0; i < numSides; ++i) {
+        index_t const side = sides->side_index (grob, i);
+        if (side != NO_INDEX)
+          func (sideBaseInds [desc.side_type (connectionDim, i)] + side);
+      }
+    }
+  };
+
+  ConcurrentUnionFind unionFind (numConnectors);
+  for (auto const grobType : grobSet) {
+    parallel_for_blocks (index_t (0), static_cast <index_t> (mesh.num (grobType)),
+                         [&] (index_t const begin, index_t const end)
+    {
+      for (index_t i = begin; i < end; ++i) {
+        index_t first = NO_INDEX;
+        forEachConnector (grobType, i, [&] (index_t const c) {
+          if (first == NO_INDEX)
+            first = c;
+          else
+            unionFind.unite (first, c);
+        });
+      }
+    });
+  }
+
+  // the roots of the grobs are collected in parallel, components are numbered sequentially
+  std::vector <std::vector <index_t>> roots;
+  for (auto const grobType : grobSet) {
+    std::vector <index_t> grobRoots (mesh.num (grobType));
+    parallel_for_blocks (index_t (0), static_cast <index_t> (grobRoots.size ()),
+                         [&] (index_t const begin, index_t const end)
+    {
+      for (index_t i = begin; i < end; ++i) {
+        index_t root = NO_INDEX;
+        forEachConnector (grobType, i, [&] (index_t const c) {
+          if (root == NO_INDEX)
+            root = unionFind.find (c);
+        });
+        grobRoots [i] = root;
+      }
+    });
+    roots.push_back (std::move (grobRoots));
+  }
+
+  ComponentInfo info;
+  std::vector <index_t> rootComponents (numConnectors, NO_INDEX);
+  index_t iset = 0;
+  for (auto const grobType : grobSet) {
+    std::vector <index_t>& components = roots [iset++];
+    for (index_t& c : components) {
+      index_t& component = rootComponents [c];
+      if (component == NO_INDEX) {
+        component = info.numComponents++;
+        info.componentSizes.push_back (0);
+      }
+      ++info.componentSizes [component];
+      c = component;
+    }
+
+    if (!components.empty ())
+      mesh.set_annex (ComponentAnnexKey (grobType), IndexArrayAnnex (1, std::move (components)));
+  }
+
+  return info;
+}
+
+
+std::vector <SPMesh> SplitComponents (Mesh& mesh, GrobSet const grobSet, index_t const connectionDim)
+{
+  ComponentInfo const info = LabelComponents (mesh, grobSet, connectionDim);
+  if (info.numComponents == 0)
+    return {};
+  return ExtractPartitions (mesh, ComponentAnnexKey (VERTEX).name (), info.numComponents, grobSet);
+}
+
+}// end of namespace lume
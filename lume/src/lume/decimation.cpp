@@ -0,0 +1,861 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/decimation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <lume/array_annex.h>
+#include <lume/grob_sides.h>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+#include <lume/subset_info_annex.h>
+
+namespace lume
+{
+
+namespace
+{
+  /// Symmetric quadric `x^T A x + 2 b^T x + c`
+  struct Quadric
+  {
+    double a00 {0}, a01 {0}, a02 {0}, a11 {0}, a12 {0}, a22 {0};
+    double b0 {0}, b1 {0}, b2 {0};
+    double c {0};
+
+    /// Creates the squared distance quadric of the plane `n^T x + d = 0`, weighted by `w`.
+    static Quadric plane (double const* n, double const d, double const w)
+    {
+      Quadric q;
+      q.a00 = w * n[0] * n[0];  q.a01 = w * n[0] * n[1];  q.a02 = w * n[0] * n[2];
+      q.a11 = w * n[1] * n[1];  q.a12 = w * n[1] * n[2];  q.a22 = w * n[2] * n[2];
+      q.b0  = w * n[0] * d;     q.b1  = w * n[1] * d;     q.b2  = w * n[2] * d;
+      q.c   = w * d * d;
+      return q;
+    }
+
+    Quadric& operator += (Quadric const& q)
+    {
+      a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+      b0 += q.b0; b1 += q.b1; b2 += q.b2;
+      c += q.c;
+      return *this;
+    }
+
+    double evaluate (double const* x) const
+    {
+      return   a00 * x[0] * x[0] + a11 * x[1] * x[1] + a22 * x[2] * x[2]
+             + 2 * (a01 * x[0] * x[1] + a02 * x[0] * x[2] + a12 * x[1] * x[2])
+             + 2 * (b0 * x[0] + b1 * x[1] + b2 * x[2])
+             + c;
+    }
+
+    /// Computes the minimizer of the quadric. Returns false if `A` is (nearly) singular.
+    bool minimizer (double* x) const
+    {
+      double const c00 = a11 * a22 - a12 * a12;
+      double const c01 = a02 * a12 - a01 * a22;
+      double const c02 = a01 * a12 - a02 * a11;
+      double const c11 = a00 * a22 - a02 * a02;
+      double const c12 = a01 * a02 - a00 * a12;
+      double const c22 = a00 * a11 - a01 * a01;
+      double const det = a00 * c00 + a01 * c01 + a02 * c02;
+      double const trace = a00 + a11 + a22;
+
+      if (std::abs (det) <= 1.e-10 * trace * trace * trace)
+        return false;
+
+      x[0] = -(c00 * b0 + c01 * b1 + c02 * b2) / det;
+      x[1] = -(c01 * b0 + c11 * b1 + c12 * b2) / det;
+      x[2] = -(c02 * b0 + c12 * b1 + c22 * b2) / det;
+      return true;
+    }
+  };
+
+  struct CollapseKey
+  {
+    double  cost {std::numeric_limits <double>::max ()};
+    index_t lo {NO_INDEX};
+    index_t hi {NO_INDEX};
+
+    bool operator < (CollapseKey const& k) const
+    {
+      if (cost != k.cost)
+        return cost < k.cost;
+      if (lo != k.lo)
+        return lo < k.lo;
+      return hi < k.hi;
+    }
+  };
+
+  /// Collapse of a vertex into its neighbor `target`.
+  struct Collapse
+  {
+    CollapseKey key;
+    index_t     target {NO_INDEX};
+    double      pos [3];
+    /// position of the collapsed vertex along the edge, seen from `target`.
+    double      s {0};
+  };
+
+  void Cross (double const* a, double const* b, double* n)
+  {
+    n[0] = a[1] * b[2] - a[2] * b[1];
+    n[1] = a[2] * b[0] - a[0] * b[2];
+    n[2] = a[0] * b[1] - a[1] * b[0];
+  }
+
+  double Dot (double const* a, double const* b)
+  {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  }
+
+  void TriNormal (double const* p0, double const* p1, double const* p2, double* n)
+  {
+    double const d1[] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double const d2[] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    Cross (d1, d2, n);
+  }
+
+  /// Copy of an array annex, which is written to the decimated mesh in compacted form.
+  class ArrayAnnexCopy
+  {
+  public:
+    virtual ~ArrayAnnexCopy () = default;
+
+    /// Sets the value of `dst` to `(1 - s) * value (dst) + s * value (src)` (floating point types only).
+    virtual void interpolate (index_t dst, index_t src, double s) = 0;
+
+    /// Adds the values of the entries `oldIndices` to the given mesh.
+    virtual void write (Mesh& mesh, std::vector <index_t> const& oldIndices) const = 0;
+  };
+
+  template <class T>
+  class TypedArrayAnnexCopy : public ArrayAnnexCopy
+  {
+  public:
+    TypedArrayAnnexCopy (AnnexKey const& key, ArrayAnnex <T> const& annex)
+      : m_name (key.name ())
+      , m_grobType (*key.grob_type ())
+      , m_tupleSize (static_cast <index_t> (annex.tuple_size ()))
+      , m_values (annex.data (), annex.data () + annex.size ())
+    {}
+
+    void interpolate (index_t const dst, index_t const src, double const s) override
+    {
+      if constexpr (std::is_floating_point <T>::value) {
+        for (index_t i = 0; i < m_tupleSize; ++i)
+        {
+          T& d = m_values [dst * m_tupleSize + i];
+          d = static_cast <T> ((1. - s) * d + s * m_values [src * m_tupleSize + i]);
+        }
+      }
+    }
+
+    void write (Mesh& mesh, std::vector <index_t> const& oldIndices) const override
+    {
+      std::vector <T> values (oldIndices.size () * m_tupleSize);
+      for (size_t i = 0; i < oldIndices.size (); ++i)
+      {
+        std::copy_n (&m_values [oldIndices [i] * m_tupleSize], m_tupleSize, &values [i * m_tupleSize]);
+      }
+
+      mesh.set_annex (TypedAnnexKey <ArrayAnnex <T>> (m_name, m_grobType),
+                      ArrayAnnex <T> (m_tupleSize, std::move (values)));
+    }
+
+  private:
+    std::string     m_name;
+    GrobType        m_grobType;
+    index_t         m_tupleSize;
+    std::vector <T> m_values;
+  };
+
+  class Decimator
+  {
+  public:
+    Decimator (Mesh const& mesh, DecimationOptions const& options);
+
+    /// Collapses edges until the mesh contains at most `targetNumTris` triangles or until no valid collapses remain.
+    void decimate (index_t targetNumTris);
+
+    SPMesh create_mesh () const;
+
+  private:
+    struct Scratch
+    {
+      std::vector <Collapse> collapses;
+      std::vector <index_t>  trisV;
+      std::vector <index_t>  trisW;
+      std::vector <index_t>  neighbors;
+    };
+
+    struct QueueEntry
+    {
+      CollapseKey key;
+      index_t     vertex;
+      index_t     version;
+
+      bool operator > (QueueEntry const& e) const {return e.key < key;}
+    };
+
+    /// Decimates the vertices of spatial partitions in parallel, each using its own priority queue.
+    /** The partitions are slabs along the longest axis of the mesh's bounding box. `offset`
+      shifts the slab boundaries by the given fraction of a slab. Only collapses whose
+      neighborhood lies completely inside one partition are performed.*/
+    void decimate_partitions (index_t targetNumTris, index_t numPartitions, double offset);
+
+    index_t decimate_partition (index_t partition,
+                                std::vector <index_t> const& vertices,
+                                index_t maxNumRemovedTris);
+
+    void collect_tris (index_t v, std::vector <index_t>& trisOut) const;
+
+    void find_collapse (index_t v, index_t partition, Scratch& scratch, Collapse& collapseOut) const;
+
+    bool is_valid_collapse (index_t v, index_t w, double const* pos, index_t partition, Scratch& scratch) const;
+
+    /// Collapses `v` into `collapse.target`. Returns the number of removed triangles.
+    index_t collapse (index_t v, Collapse const& collapse);
+
+    void unlink_corner (index_t v, index_t corner);
+
+    bool contains (index_t const tri, index_t const v) const
+    {
+      index_t const* c = &m_tris [tri * 3];
+      return c[0] == v || c[1] == v || c[2] == v;
+    }
+
+    double const* coords (index_t v) const  {return &m_coords [v * 3];}
+
+    Mesh const&                                    m_mesh;
+    DecimationOptions                              m_options;
+    index_t                                        m_coordDim;
+    std::vector <double>                           m_coords;
+    std::vector <Quadric>                          m_quadrics;
+    std::vector <index_t>                          m_tris;
+    std::vector <char>                             m_triAlive;
+    index_t                                        m_numTris;
+  // the corners of each vertex are stored in a linked list
+    std::vector <index_t>                          m_firstCorner;
+    std::vector <index_t>                          m_nextCorner;
+    std::vector <char>                             m_vrtAlive;
+    std::vector <char>                             m_vrtLocked;
+    std::vector <index_t>                          m_vrtPartitions;
+    std::vector <index_t>                          m_vrtVersions;
+    std::vector <std::unique_ptr <ArrayAnnexCopy>> m_vertexAnnexes;
+    std::vector <std::unique_ptr <ArrayAnnexCopy>> m_triAnnexes;
+  };
+
+  Decimator::Decimator (Mesh const& mesh, DecimationOptions const& options)
+    : m_mesh (mesh)
+    , m_options (options)
+  {
+    for (auto grobType : mesh.grob_types ())
+    {
+      if (grobType != VERTEX && grobType != EDGE && grobType != TRI) {
+        throw LumeError () << "DecimateTriangles: Unsupported grob type '"
+                           << GrobTypeName (grobType) << "'. Only triangle meshes are supported.";
+      }
+    }
+
+    auto const& coordAnnex = mesh.annex (keys::vertexCoords);
+    m_coordDim = static_cast <index_t> (coordAnnex.tuple_size ());
+    if (m_coordDim < 2 || m_coordDim > 3)
+      throw BadTupleSizeError () << "DecimateTriangles: Unsupported coordinate tuple size " << m_coordDim;
+
+    index_t const numVertices = static_cast <index_t> (mesh.num (VERTEX));
+    m_coords.assign (numVertices * 3, 0);
+    for (index_t i = 0; i < numVertices; ++i)
+    {
+      for (index_t j = 0; j < m_coordDim; ++j)
+        m_coords [i * 3 + j] = coordAnnex [i * m_coordDim + j];
+    }
+
+    auto const& tris = mesh.grobs (TRI);
+    m_numTris = static_cast <index_t> (tris.size ());
+    m_tris.assign (tris.data (), tris.data () + tris.num_indices ());
+    m_triAlive.assign (m_numTris, 1);
+    m_vrtAlive.assign (numVertices, 1);
+    m_vrtLocked.assign (numVertices, 0);
+    m_vrtPartitions.assign (numVertices, 0);
+    m_vrtVersions.assign (numVertices, 0);
+
+    m_firstCorner.assign (numVertices, NO_INDEX);
+    m_nextCorner.resize (m_tris.size ());
+    for (index_t c = 0; c < m_tris.size (); ++c)
+    {
+      m_nextCorner [c] = m_firstCorner [m_tris [c]];
+      m_firstCorner [m_tris [c]] = c;
+    }
+
+  // accumulate area weighted plane quadrics of adjacent triangles
+    m_quadrics.resize (numVertices);
+    for (index_t t = 0; t < m_numTris; ++t)
+    {
+      index_t const* c = &m_tris [t * 3];
+      double n[3];
+      TriNormal (coords (c[0]), coords (c[1]), coords (c[2]), n);
+      double const len = std::sqrt (Dot (n, n));
+      if (len == 0)
+        continue;
+
+      for (double& ni : n)
+        ni /= len;
+
+      Quadric const q = Quadric::plane (n, -Dot (n, coords (c[0])), 0.5 * len);
+      for (index_t i = 0; i < 3; ++i)
+        m_quadrics [c[i]] += q;
+    }
+
+  // lock boundary and subset border vertices
+    std::vector <IndexArrayAnnex const*> subsetAnnexes;
+    if (options.preserveSubsetBorders) {
+      for (auto const& key : mesh.annex_keys ())
+      {
+        if (key.grob_type () || !dynamic_cast <SubsetInfoAnnex const*> (&mesh.untyped_annex (key)))
+          continue;
+
+        TypedAnnexKey <IndexArrayAnnex> const subsetKey (key.name (), TRI);
+        if (mesh.has_annex (subsetKey))
+          subsetAnnexes.push_back (&mesh.annex (subsetKey));
+      }
+    }
+
+    if (options.preserveBoundaries || !subsetAnnexes.empty ()) {
+      GrobSides const edges (mesh, TRIS, EDGES);
+      auto const& edgeArray = edges.sides (EDGE);
+
+      for (index_t e = 0; e < edges.num_sides (EDGE); ++e)
+      {
+        GrobIndex const edge (EDGE, e);
+        index_t const numIncidences = edges.num_incidences (edge);
+        bool lock = options.preserveBoundaries && numIncidences != 2;
+
+        if (numIncidences == 2) {
+          index_t const t0 = edges.incidence (edge, 0).grob.index ();
+          index_t const t1 = edges.incidence (edge, 1).grob.index ();
+          for (auto subsets : subsetAnnexes)
+            lock |= (*subsets) [t0] != (*subsets) [t1];
+        }
+
+        if (lock) {
+          m_vrtLocked [edgeArray [e].corner (0)] = 1;
+          m_vrtLocked [edgeArray [e].corner (1)] = 1;
+        }
+      }
+    }
+
+  // copy annexes, so that they can be carried along during decimation
+    for (auto const& key : mesh.annex_keys ())
+    {
+      bool const isCoords = key.grob_type () == VERTEX && key.name () == keys::vertexCoords.name ();
+      if (isCoords || (key.grob_type () != VERTEX && key.grob_type () != TRI))
+        continue;
+
+      auto& annexCopies = key.grob_type () == VERTEX ? m_vertexAnnexes : m_triAnnexes;
+      VisitArrayAnnex (mesh.untyped_annex (key), [&] (auto const& annex)
+      {
+        using value_t = typename std::decay_t <decltype (annex)>::value_type;
+        annexCopies.push_back (std::make_unique <TypedArrayAnnexCopy <value_t>> (key, annex));
+      });
+    }
+  }
+
+  void Decimator::collect_tris (index_t const v, std::vector <index_t>& trisOut) const
+  {
+    trisOut.clear ();
+    for (index_t c = m_firstCorner [v]; c != NO_INDEX; c = m_nextCorner [c])
+      trisOut.push_back (c / 3);
+  }
+
+  void Decimator::unlink_corner (index_t const v, index_t const corner)
+  {
+    index_t* link = &m_firstCorner [v];
+    while (*link != corner)
+      link = &m_nextCorner [*link];
+    *link = m_nextCorner [corner];
+  }
+
+  bool Decimator::is_valid_collapse (index_t const v,
+                                     index_t const w,
+                                     double const* pos,
+                                     index_t const partition,
+                                     Scratch& scratch) const
+  {
+    auto const& trisV = scratch.trisV;
+    auto& trisW = scratch.trisW;
+    collect_tris (w, trisW);
+    std::vector <index_t> const* const triLists [] = {&trisV, &trisW};
+
+  // the modified neighborhood has to be contained in the partition
+    for (auto const* tris : triLists)
+    {
+      for (index_t t : *tris)
+      {
+        for (index_t i = 0; i < 3; ++i)
+        {
+          if (m_vrtPartitions [m_tris [t * 3 + i]] != partition)
+            return false;
+        }
+      }
+    }
+
+  // link condition: the common neighbors of v and w have to be the opposite corners
+  // of the triangles containing the edge (v, w).
+    auto& neighbors = scratch.neighbors;
+    neighbors.clear ();
+    index_t numSharedTris = 0;
+    for (index_t t : trisV)
+    {
+      if (contains (t, w))
+        ++numSharedTris;
+
+      for (index_t i = 0; i < 3; ++i)
+      {
+        index_t const x = m_tris [t * 3 + i];
+        if (x != v && x != w && std::find (neighbors.begin (), neighbors.end (), x) == neighbors.end ())
+          neighbors.push_back (x);
+      }
+    }
+
+    index_t numCommonNeighbors = 0;
+    for (index_t x : neighbors)
+    {
+      if (std::any_of (trisW.begin (), trisW.end (), [&] (index_t t) {return contains (t, x);}))
+        ++numCommonNeighbors;
+    }
+
+    if (numCommonNeighbors != numSharedTris)
+      return false;
+
+  // triangles which remain after the collapse must not flip
+    for (auto const* tris : triLists)
+    {
+      index_t const u = tris == &trisV ? v : w;
+      index_t const other = u == v ? w : v;
+      for (index_t t : *tris)
+      {
+        index_t const* c = &m_tris [t * 3];
+        if (contains (t, other))
+          continue;
+
+        double const* p [3];
+        double const* q [3];
+        for (index_t i = 0; i < 3; ++i)
+        {
+          p [i] = coords (c[i]);
+          q [i] = c[i] == u ? pos : p [i];
+        }
+
+        double nOld [3], nNew [3];
+        TriNormal (p[0], p[1], p[2], nOld);
+        TriNormal (q[0], q[1], q[2], nNew);
+        if (Dot (nOld, nNew) <= 0)
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+  void Decimator::find_collapse (index_t const v,
+                                 index_t const partition,
+                                 Scratch& scratch,
+                                 Collapse& collapseOut) const
+  {
+    collapseOut = Collapse ();
+    if (!m_vrtAlive [v] || m_vrtLocked [v] || m_vrtPartitions [v] != partition)
+      return;
+
+    auto& candidates = scratch.collapses;
+    candidates.clear ();
+    collect_tris (v, scratch.trisV);
+    double const* pv = coords (v);
+
+    for (index_t t : scratch.trisV)
+    {
+      for (index_t i = 0; i < 3; ++i)
+      {
+        index_t const w = m_tris [t * 3 + i];
+      // neighbors of other partitions may be modified concurrently and must
+      // not be read
+        if (w == v || m_vrtPartitions [w] != partition ||
+            std::any_of (candidates.begin (), candidates.end (),
+                       [w] (Collapse const& c) {return c.target == w;}))
+        {
+          continue;
+        }
+
+        double const* pw = coords (w);
+        double const edge [] = {pv[0] - pw[0], pv[1] - pw[1], pv[2] - pw[2]};
+        double const edgeLenSq = Dot (edge, edge);
+
+        Quadric q = m_quadrics [v];
+        q += m_quadrics [w];
+
+        Collapse c;
+        c.target = w;
+        c.key.lo = std::min (v, w);
+        c.key.hi = std::max (v, w);
+
+        bool useMinimizer = !m_vrtLocked [w] && q.minimizer (c.pos);
+        if (useMinimizer) {
+        // reject minimizers far away from the edge, which may result from bad conditioning
+          double const d [] = {c.pos[0] - 0.5 * (pv[0] + pw[0]),
+                               c.pos[1] - 0.5 * (pv[1] + pw[1]),
+                               c.pos[2] - 0.5 * (pv[2] + pw[2])};
+          useMinimizer = Dot (d, d) <= edgeLenSq;
+        }
+
+        if (useMinimizer)
+          c.key.cost = q.evaluate (c.pos);
+        else {
+          double const mid [] = {0.5 * (pv[0] + pw[0]), 0.5 * (pv[1] + pw[1]), 0.5 * (pv[2] + pw[2])};
+          int const numOptions = m_vrtLocked [w] ? 1 : 3;
+          double const* options [3] = {mid, pw, pv};
+          if (m_vrtLocked [w])
+            options [0] = pw;
+          for (int j = 0; j < numOptions; ++j)
+          {
+            double const cost = q.evaluate (options [j]);
+            if (j == 0 || cost < c.key.cost) {
+              c.key.cost = cost;
+              std::copy_n (options [j], 3, c.pos);
+            }
+          }
+        }
+
+        c.key.cost = std::max (0., c.key.cost);
+        if (c.key.cost > m_options.maxError)
+          continue;
+
+      // in flat regions many collapses have zero cost. Preferring short edges keeps triangles well shaped.
+        c.key.cost += 1.e-6 * edgeLenSq * edgeLenSq;
+
+        if (edgeLenSq > 0) {
+          double const d [] = {c.pos[0] - pw[0], c.pos[1] - pw[1], c.pos[2] - pw[2]};
+          c.s = std::clamp (Dot (d, edge) / edgeLenSq, 0., 1.);
+        }
+
+        candidates.push_back (c);
+      }
+    }
+
+    std::sort (candidates.begin (), candidates.end (),
+               [] (Collapse const& c0, Collapse const& c1) {return c0.key < c1.key;});
+
+    for (auto const& c : candidates)
+    {
+      if (is_valid_collapse (v, c.target, c.pos, partition, scratch)) {
+        collapseOut = c;
+        return;
+      }
+    }
+  }
+
+  index_t Decimator::collapse (index_t const v, Collapse const& collapse)
+  {
+    index_t const w = collapse.target;
+    index_t numRemovedTris = 0;
+
+  // remove the triangles containing the collapsed edge
+    for (index_t c = m_firstCorner [v]; c != NO_INDEX; c = m_nextCorner [c])
+    {
+      index_t const t = c / 3;
+      if (!contains (t, w))
+        continue;
+
+      m_triAlive [t] = 0;
+      ++numRemovedTris;
+      for (index_t i = 0; i < 3; ++i)
+      {
+        if (m_tris [t * 3 + i] != v)
+          unlink_corner (m_tris [t * 3 + i], t * 3 + i);
+      }
+    }
+
+  // move the remaining corners of v to w
+    index_t c = m_firstCorner [v];
+    while (c != NO_INDEX)
+    {
+      index_t const next = m_nextCorner [c];
+      if (m_triAlive [c / 3]) {
+        m_tris [c] = w;
+        m_nextCorner [c] = m_firstCorner [w];
+        m_firstCorner [w] = c;
+      }
+      c = next;
+    }
+    m_firstCorner [v] = NO_INDEX;
+
+    std::copy_n (collapse.pos, 3, &m_coords [w * 3]);
+    m_quadrics [w] += m_quadrics [v];
+    m_vrtAlive [v] = 0;
+    for (auto& annex : m_vertexAnnexes)
+      annex->interpolate (w, v, collapse.s);
+
+    return numRemovedTris;
+  }
+
+  index_t Decimator::decimate_partition (index_t const partition,
+                                         std::vector <index_t> const& vertices,
+                                         index_t const maxNumRemovedTris)
+  {
+    std::priority_queue <QueueEntry, std::vector <QueueEntry>, std::greater <QueueEntry>> queue;
+    Scratch scratch;
+    Collapse c;
+
+    auto update = [&] (index_t const x)
+    {
+      ++m_vrtVersions [x];
+      find_collapse (x, partition, scratch, c);
+      if (c.target != NO_INDEX)
+        queue.push ({c.key, x, m_vrtVersions [x]});
+    };
+
+    for (index_t v : vertices)
+      update (v);
+
+    index_t numRemovedTris = 0;
+    std::vector <index_t> neighbors;
+
+    while (numRemovedTris < maxNumRemovedTris && !queue.empty ())
+    {
+      QueueEntry const entry = queue.top ();
+      queue.pop ();
+
+      index_t const v = entry.vertex;
+      if (entry.version != m_vrtVersions [v])
+        continue;
+
+    // changes in the 2-neighborhood may have altered the collapse
+      find_collapse (v, partition, scratch, c);
+      if (c.target == NO_INDEX)
+        continue;
+
+      if (entry.key < c.key || c.key < entry.key) {
+        queue.push ({c.key, v, ++m_vrtVersions [v]});
+        continue;
+      }
+
+      index_t const w = c.target;
+      numRemovedTris += collapse (v, c);
+
+      neighbors.clear ();
+      for (index_t corner = m_firstCorner [w]; corner != NO_INDEX; corner = m_nextCorner [corner])
+      {
+        for (index_t i = 0; i < 3; ++i)
+        {
+          index_t const x = m_tris [corner / 3 * 3 + i];
+          if (std::find (neighbors.begin (), neighbors.end (), x) == neighbors.end ())
+            neighbors.push_back (x);
+        }
+      }
+
+      for (index_t x : neighbors)
+        update (x);
+    }
+
+    return numRemovedTris;
+  }
+
+  void Decimator::decimate_partitions (index_t const targetNumTris,
+                                       index_t const numPartitions,
+                                       double const offset)
+  {
+    if (m_numTris <= targetNumTris)
+      return;
+
+    std::vector <index_t> vertices;
+    for (index_t v = 0; v < m_vrtAlive.size (); ++v)
+    {
+      if (m_vrtAlive [v] && !m_vrtLocked [v])
+        vertices.push_back (v);
+    }
+
+    size_t const numVertices = vertices.size ();
+    std::vector <std::vector <index_t>> partitionVertices (numPartitions);
+    if (numPartitions == 1) {
+      std::fill (m_vrtPartitions.begin (), m_vrtPartitions.end (), 0);
+      partitionVertices [0] = std::move (vertices);
+    }
+    else {
+      double const inf = std::numeric_limits <double>::max ();
+      double minCoords [] = {inf, inf, inf};
+      double maxCoords [] = {-inf, -inf, -inf};
+      for (index_t v : vertices)
+      {
+        for (index_t i = 0; i < 3; ++i)
+        {
+          minCoords [i] = std::min (minCoords [i], coords (v) [i]);
+          maxCoords [i] = std::max (maxCoords [i], coords (v) [i]);
+        }
+      }
+
+      index_t axis = 0;
+      for (index_t i = 1; i < 3; ++i)
+      {
+        if (maxCoords [i] - minCoords [i] > maxCoords [axis] - minCoords [axis])
+          axis = i;
+      }
+
+      std::sort (vertices.begin (), vertices.end (), [this, axis] (index_t v0, index_t v1)
+                 {return coords (v0) [axis] < coords (v1) [axis];});
+
+    // locked vertices are never collapsed, but they may be part of the neighborhood of a
+    // collapse. They are assigned to the partition of one of their neighbors.
+      std::fill (m_vrtPartitions.begin (), m_vrtPartitions.end (), NO_INDEX);
+      for (size_t i = 0; i < vertices.size (); ++i)
+      {
+        index_t const p = std::min (numPartitions - 1,
+                                    static_cast <index_t> (double (i) * numPartitions / vertices.size () + offset));
+        m_vrtPartitions [vertices [i]] = p;
+        partitionVertices [p].push_back (vertices [i]);
+      }
+
+      for (index_t v = 0; v < m_vrtAlive.size (); ++v)
+      {
+        if (m_vrtAlive [v] && m_vrtLocked [v] && m_firstCorner [v] != NO_INDEX) {
+          index_t const neighbor = m_tris [m_firstCorner [v] / 3 * 3 + (m_firstCorner [v] + 1) % 3];
+          m_vrtPartitions [v] = m_vrtPartitions [neighbor];
+        }
+      }
+    }
+
+  // each partition removes its share of triangles
+    index_t const numTrisToRemove = m_numTris - targetNumTris;
+    std::atomic <index_t> numRemovedTris {0};
+    parallel_for (index_t (0), numPartitions, [&] (index_t const p)
+    {
+      index_t const share = static_cast <index_t> (
+          std::ceil (double (numTrisToRemove) * partitionVertices [p].size () / std::max <size_t> (1, numVertices)));
+      numRemovedTris += decimate_partition (p, partitionVertices [p], share);
+    }, 1);
+
+    m_numTris -= numRemovedTris;
+  }
+
+  void Decimator::decimate (index_t const targetNumTris)
+  {
+    index_t const numThreads =
+        m_options.numPartitions > 0 ?
+          m_options.numPartitions :
+          std::max <index_t> (1, std::thread::hardware_concurrency ());
+    if (numThreads > 1) {
+      decimate_partitions (targetNumTris, numThreads, 0);
+      decimate_partitions (targetNumTris, numThreads, 0.5);
+    }
+
+  // a single partition without borders removes the remaining triangles
+    decimate_partitions (targetNumTris, 1, 0);
+  }
+
+  SPMesh Decimator::create_mesh () const
+  {
+    index_t const numVertices = static_cast <index_t> (m_vrtAlive.size ());
+    std::vector <index_t> newVertexIndices (numVertices, NO_INDEX);
+    std::vector <index_t> oldVertexIndices;
+    std::vector <index_t> oldTriIndices;
+    std::vector <index_t> triCorners;
+
+    for (index_t t = 0; t < m_triAlive.size (); ++t)
+    {
+      if (!m_triAlive [t])
+        continue;
+
+      oldTriIndices.push_back (t);
+      for (index_t i = 0; i < 3; ++i)
+      {
+        index_t& newIndex = newVertexIndices [m_tris [t * 3 + i]];
+        if (newIndex == NO_INDEX) {
+          newIndex = static_cast <index_t> (oldVertexIndices.size ());
+          oldVertexIndices.push_back (m_tris [t * 3 + i]);
+        }
+        triCorners.push_back (newIndex);
+      }
+    }
+
+    auto mesh = std::make_shared <Mesh> ();
+    mesh->resize_vertices (oldVertexIndices.size ());
+    mesh->set_grobs (GrobArray (TRI, std::move (triCorners)));
+
+    std::vector <real_t> coords (oldVertexIndices.size () * m_coordDim);
+    for (size_t i = 0; i < oldVertexIndices.size (); ++i)
+    {
+      for (index_t j = 0; j < m_coordDim; ++j)
+        coords [i * m_coordDim + j] = static_cast <real_t> (m_coords [oldVertexIndices [i] * 3 + j]);
+    }
+    mesh->set_annex (keys::vertexCoords, RealArrayAnnex (m_coordDim, std::move (coords)));
+
+    for (auto const& annex : m_vertexAnnexes)
+      annex->write (*mesh, oldVertexIndices);
+
+    for (auto const& annex : m_triAnnexes)
+      annex->write (*mesh, oldTriIndices);
+
+    for (auto const& key : m_mesh.annex_keys ())
+    {
+      if (key.grob_type ())
+        continue;
+
+      if (auto subsetInfo = dynamic_cast <SubsetInfoAnnex const*> (&m_mesh.untyped_annex (key)))
+        mesh->set_annex (key, SubsetInfoAnnex (*subsetInfo));
+    }
+
+    return mesh;
+  }
+}// end of unnamed namespace
+
+SPMesh DecimateTriangles (CSPMesh mesh, DecimationOptions const& options)
+{
+  Decimator decimator (*mesh, options);
+  decimator.decimate (options.targetNumTris);
+  return decimator.create_mesh ();
+}
+
+std::vector <SPMesh> DecimateTrianglesLOD (CSPMesh mesh,
+                                           std::vector <index_t> const& targetNumTris,
+                                           DecimationOptions const& options)
+{
+  if (!std::is_sorted (targetNumTris.rbegin (), targetNumTris.rend ()))
+    throw LumeError () << "DecimateTrianglesLOD: Target triangle counts have to be sorted in descending order.";
+
+  Decimator decimator (*mesh, options);
+  std::vector <SPMesh> lods;
+  for (index_t target : targetNumTris)
+  {
+    decimator.decimate (target);
+    lods.push_back (decimator.create_mesh ());
+  }
+  return lods;
+}
+
+}// end of namespace lume
@@ -0,0 +1,792 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/delaunay.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+namespace
+{
+
+/// Rounds with fewer candidates or flips are processed serially
+constexpr size_t g_minParallelBatch = 256;
+/// Size of the first round of the biased randomized insertion order
+constexpr index_t g_firstBrioRound = 64;
+/// The bounding triangle is this many times larger than the bounding box of the points
+constexpr double g_superTriangleScale = 1.e6;
+/// Relative threshold of the in-circle test, to avoid cycles of flips on cocircular points
+constexpr double g_inCircleEpsilon = 1.e-12;
+
+struct Point2
+{
+  double x;
+  double y;
+};
+
+double Orient (Point2 const& a, Point2 const& b, Point2 const& c)
+{
+  return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+/// Returns a positive value if `d` lies inside the circumcircle of the counterclockwise triangle `a, b, c`
+/** Values whose magnitude is below the rounding error bound are returned as 0.*/
+double InCircle (Point2 const& a, Point2 const& b, Point2 const& c, Point2 const& d)
+{
+  double const adx = a.x - d.x, ady = a.y - d.y;
+  double const bdx = b.x - d.x, bdy = b.y - d.y;
+  double const cdx = c.x - d.x, cdy = c.y - d.y;
+
+  double const alift = adx * adx + ady * ady;
+  double const blift = bdx * bdx + bdy * bdy;
+  double const clift = cdx * cdx + cdy * cdy;
+
+  double const det = alift * (bdx * cdy - bdy * cdx)
+                   + blift * (cdx * ady - cdy * adx)
+                   + clift * (adx * bdy - ady * bdx);
+
+  double const permanent = alift * (std::abs (bdx * cdy) + std::abs (bdy * cdx))
+                         + blift * (std::abs (cdx * ady) + std::abs (cdy * adx))
+                         + clift * (std::abs (adx * bdy) + std::abs (ady * bdx));
+
+  return std::abs (det) > g_inCircleEpsilon * permanent ? det : 0;
+}
+
+index_t Next (index_t const h) {return h % 3 == 2 ? h - 2 : h + 1;}
+index_t Prev (index_t const h) {return h % 3 == 0 ? h + 2 : h - 1;}
+
+uint64_t EdgeKey (index_t const c0, index_t const c1)
+{
+  return (static_cast <uint64_t> (std::min (c0, c1)) << 32) | std::max (c0, c1);
+}
+
+/// Triangles with half-edge adjacency.
+/** Half-edge `h` of triangle `h / 3` leads from `corners [h]` to `corners [Next (h)]`.*/
+struct Triangulation
+{
+  std::vector <Point2>  points;
+  std::vector <index_t> corners;
+  std::vector <index_t> twins;
+  std::vector <char>    constrained;
+  /// Sign of the orientation of all triangles
+  double                orientation {1};
+
+  index_t num_triangles () const          {return static_cast <index_t> (corners.size () / 3);}
+  index_t origin (index_t const h) const  {return corners [h];}
+  index_t dest (index_t const h) const    {return corners [Next (h)];}
+  Point2 const& point (index_t const h) const {return points [corners [h]];}
+
+  index_t add_triangle ()
+  {
+    index_t const t = num_triangles ();
+    corners.resize (corners.size () + 3);
+    twins.resize (twins.size () + 3, NO_INDEX);
+    constrained.resize (constrained.size () + 3, 0);
+    return t;
+  }
+
+  void set_triangle (index_t const t, index_t const c0, index_t const c1, index_t const c2)
+  {
+    corners [3 * t]     = c0;
+    corners [3 * t + 1] = c1;
+    corners [3 * t + 2] = c2;
+  }
+
+  /// Makes `h0` and `h1` twins. `h1` may be `NO_INDEX`.
+  void link (index_t const h0, index_t const h1, char const isConstrained = 0)
+  {
+    twins [h0] = h1;
+    constrained [h0] = isConstrained;
+    if (h1 != NO_INDEX) {
+      twins [h1] = h0;
+      constrained [h1] = isConstrained;
+    }
+  }
+
+  /// Returns true if the quadrilateral of the two triangles at `h` is strictly convex
+  bool is_flippable (index_t const h) const
+  {
+    index_t const g = twins [h];
+    if (g == NO_INDEX)
+      return false;
+
+    Point2 const& a = point (h);
+    Point2 const& b = point (Next (h));
+    Point2 const& c = point (Prev (h));
+    Point2 const& d = point (Prev (g));
+    return orientation * Orient (c, a, d) > 0 && orientation * Orient (d, b, c) > 0;
+  }
+
+  /// Returns true if `h` is an unconstrained edge which violates the Delaunay criterion
+  bool is_illegal (index_t const h) const
+  {
+    index_t const g = twins [h];
+    if (g == NO_INDEX || constrained [h])
+      return false;
+
+    return orientation * InCircle (point (h), point (Next (h)), point (Prev (h)), point (Prev (g))) > 0
+           && is_flippable (h);
+  }
+
+  /// Replaces the diagonal `h` of the quadrilateral formed by its two triangles by the other diagonal.
+  /** If `h` leads from `a` to `b` in triangle `(a, b, c)` and its twin is in `(b, a, d)`,
+    the triangles become `(c, a, d)` and `(d, b, c)`. The new diagonal is half-edge 2
+    of both triangles, and half-edges 0 and 1 of both triangles are the old outer edges.*/
+  void flip (index_t const h)
+  {
+    index_t const g = twins [h];
+    index_t const t0 = h / 3;
+    index_t const t1 = g / 3;
+
+    index_t const a = origin (h);
+    index_t const b = dest (h);
+    index_t const c = origin (Prev (h));
+    index_t const d = origin (Prev (g));
+
+    index_t const bc = twins [Next (h)], ca = twins [Prev (h)];
+    index_t const ad = twins [Next (g)], db = twins [Prev (g)];
+    char const bcc = constrained [Next (h)], cac = constrained [Prev (h)];
+    char const adc = constrained [Next (g)], dbc = constrained [Prev (g)];
+
+    set_triangle (t0, c, a, d);
+    set_triangle (t1, d, b, c);
+
+    link (3 * t0, ca, cac);
+    link (3 * t0 + 1, ad, adc);
+    link (3 * t0 + 2, 3 * t1 + 2);
+    link (3 * t1, db, dbc);
+    link (3 * t1 + 1, bc, bcc);
+  }
+
+  /// Appends the triangles which are read or written by `flip (h)` to `trisOut`
+  void collect_flip_triangles (index_t const h, std::vector <index_t>& trisOut) const
+  {
+    index_t const g = twins [h];
+    trisOut.push_back (h / 3);
+    trisOut.push_back (g / 3);
+    for (index_t const outer : {Next (h), Prev (h), Next (g), Prev (g)}) {
+      if (twins [outer] != NO_INDEX)
+        trisOut.push_back (twins [outer] / 3);
+    }
+  }
+};
+
+
+/// Performs Lawson flips on all unconstrained edges until the triangulation is Delaunay
+/** \sa MakeDelaunay*/
+index_t LawsonFlips (Triangulation& tri)
+{
+  index_t const numHalfEdges = static_cast <index_t> (tri.twins.size ());
+
+  std::vector <index_t> candidates;
+  for (index_t h = 0; h < numHalfEdges; ++h) {
+    if (tri.twins [h] != NO_INDEX && h < tri.twins [h])
+      candidates.push_back (h);
+  }
+
+  std::vector <index_t> lockStamps (tri.num_triangles (), 0);
+  std::vector <index_t> candidateStamps (numHalfEdges, 0);
+  std::vector <char> illegal;
+  std::vector <index_t> selected;
+  std::vector <index_t> deferred;
+  std::vector <index_t> flipTris;
+
+  index_t numFlips = 0;
+  index_t round = 0;
+
+  while (!candidates.empty ()) {
+    ++round;
+
+    illegal.assign (candidates.size (), 0);
+    auto testCandidates = [&] (size_t const begin, size_t const end) {
+      for (size_t i = begin; i < end; ++i)
+        illegal [i] = tri.is_illegal (candidates [i]);
+    };
+
+    if (candidates.size () < g_minParallelBatch)
+      testCandidates (0, candidates.size ());
+    else
+      parallel_for_blocks (size_t (0), candidates.size (), testCandidates);
+
+    // greedily select flips whose triangles don't overlap
+    selected.clear ();
+    deferred.clear ();
+    for (size_t i = 0; i < candidates.size (); ++i) {
+      if (!illegal [i])
+        continue;
+
+      flipTris.clear ();
+      tri.collect_flip_triangles (candidates [i], flipTris);
+      bool const locked = std::any_of (flipTris.begin (), flipTris.end (),
+                                       [&] (index_t const t) {return lockStamps [t] == round;});
+      if (locked)
+        deferred.push_back (candidates [i]);
+      else {
+        for (index_t const t : flipTris)
+          lockStamps [t] = round;
+        selected.push_back (candidates [i]);
+      }
+    }
+
+    auto flipSelected = [&] (size_t const begin, size_t const end) {
+      for (size_t i = begin; i < end; ++i)
+        tri.flip (selected [i]);
+    };
+
+    if (selected.size () < g_minParallelBatch)
+      flipSelected (0, selected.size ());
+    else
+      parallel_for_blocks (size_t (0), selected.size (), flipSelected);
+
+    numFlips += static_cast <index_t> (selected.size ());
+
+    // the outer edges of flipped quadrilaterals and the deferred edges are tested again
+    candidates.clear ();
+    auto enqueue = [&] (index_t const h) {
+      index_t const g = tri.twins [h];
+      if (g == NO_INDEX)
+        return;
+      index_t const canonical = std::min (h, g);
+      if (candidateStamps [canonical] != round) {
+        candidateStamps [canonical] = round;
+        candidates.push_back (canonical);
+      }
+    };
+
+    for (index_t const h : selected) {
+      index_t const t0 = h / 3;
+      index_t const t1 = tri.twins [3 * t0 + 2] / 3;
+      enqueue (3 * t0);
+      enqueue (3 * t0 + 1);
+      enqueue (3 * t1);
+      enqueue (3 * t1 + 1);
+    }
+
+    for (index_t const h : deferred)
+      enqueue (h);
+  }
+
+  return numFlips;
+}
+
+
+/// Index of a point on a Hilbert curve of order 16 through the unit square
+uint32_t HilbertIndex (uint32_t x, uint32_t y)
+{
+  uint32_t d = 0;
+  for (uint32_t s = 1u << 15; s > 0; s /= 2) {
+    uint32_t const rx = (x & s) > 0;
+    uint32_t const ry = (y & s) > 0;
+    d += s * s * ((3 * rx) ^ ry);
+    if (ry == 0) {
+      if (rx == 1) {
+        x = 0xFFFF - x;
+        y = 0xFFFF - y;
+      }
+      std::swap (x, y);
+    }
+  }
+  return d;
+}
+
+/// Returns the first `numPoints` point indices in a biased randomized insertion order.
+/** The points are shuffled and split into rounds of doubling size. The points of
+  each round are sorted along a Hilbert curve.*/
+std::vector <index_t> BrioOrder (std::vector <Point2> const& points,
+                                 index_t const numPoints,
+                                 Point2 const& minCorner,
+                                 double const extent)
+{
+  std::vector <uint32_t> keys (numPoints);
+  parallel_for_blocks (index_t (0), numPoints, [&] (index_t const begin, index_t const end) {
+    double const scale = extent > 0 ? 65535. / extent : 0;
+    for (index_t i = begin; i < end; ++i) {
+      keys [i] = HilbertIndex (static_cast <uint32_t> ((points [i].x - minCorner.x) * scale),
+                               static_cast <uint32_t> ((points [i].y - minCorner.y) * scale));
+    }
+  });
+
+  std::vector <index_t> order (numPoints);
+  std::iota (order.begin (), order.end (), 0);
+  std::shuffle (order.begin (), order.end (), std::mt19937 (numPoints));
+
+  for (index_t begin = 0, end = std::min (numPoints, g_firstBrioRound);
+       begin < numPoints;
+       begin = end, end = std::min <index_t> (numPoints, 2 * end))
+  {
+    std::sort (order.begin () + begin, order.begin () + end,
+               [&keys] (index_t const i, index_t const j) {return keys [i] < keys [j];});
+  }
+
+  return order;
+}
+
+
+/// Builds a Delaunay triangulation by incremental point insertion into a bounding triangle
+class DelaunayBuilder
+{
+public:
+  DelaunayBuilder (std::vector <Point2>&& points, index_t const numPoints)
+    : m_numPoints (numPoints)
+  {
+    m_tri.points = std::move (points);
+    m_tri.points.resize (numPoints + 3);
+  }
+
+  void insert_points ()
+  {
+    Point2 minCorner = m_tri.points [0];
+    Point2 maxCorner = m_tri.points [0];
+    for (index_t i = 0; i < m_numPoints; ++i) {
+      auto const& p = m_tri.points [i];
+      minCorner = {std::min (minCorner.x, p.x), std::min (minCorner.y, p.y)};
+      maxCorner = {std::max (maxCorner.x, p.x), std::max (maxCorner.y, p.y)};
+    }
+
+    double const extent = std::max (maxCorner.x - minCorner.x, maxCorner.y - minCorner.y);
+    Point2 const center {0.5 * (minCorner.x + maxCorner.x), 0.5 * (minCorner.y + maxCorner.y)};
+    double const s = g_superTriangleScale * (extent > 0 ? extent : 1);
+
+    index_t const super = m_numPoints;
+    m_tri.points [super]     = {center.x - std::sqrt (3.) * s, center.y - s};
+    m_tri.points [super + 1] = {center.x + std::sqrt (3.) * s, center.y - s};
+    m_tri.points [super + 2] = {center.x, center.y + 2 * s};
+    m_tri.set_triangle (m_tri.add_triangle (), super, super + 1, super + 2);
+
+    index_t lastTri = 0;
+    for (index_t const v : BrioOrder (m_tri.points, m_numPoints, minCorner, extent))
+      lastTri = insert_point (v, lastTri);
+  }
+
+  void insert_constraints (GrobArray const& constrainedEdges)
+  {
+    if (constrainedEdges.empty ())
+      return;
+
+    m_vertexTris.assign (m_tri.points.size (), NO_INDEX);
+    for (index_t h = 0; h < m_tri.corners.size (); ++h)
+      m_vertexTris [m_tri.corners [h]] = h / 3;
+
+    for (auto const& edge : constrainedEdges) {
+      if (edge.corner (0) >= m_numPoints || edge.corner (1) >= m_numPoints) {
+        throw LumeError () << "DelaunayTriangulation: Constrained edge (" << edge.corner (0)
+                           << ", " << edge.corner (1) << ") references a point which doesn't exist";
+      }
+      insert_constraint (edge.corner (0), edge.corner (1));
+    }
+  }
+
+  void legalize ()
+  {
+    LawsonFlips (m_tri);
+  }
+
+  /// Returns the triangles which don't touch the bounding triangle
+  GrobArray triangles () const
+  {
+    std::vector <index_t> corners;
+    for (index_t t = 0; t < m_tri.num_triangles (); ++t) {
+      index_t const* c = m_tri.corners.data () + 3 * t;
+      if (c [0] < m_numPoints && c [1] < m_numPoints && c [2] < m_numPoints)
+        corners.insert (corners.end (), c, c + 3);
+    }
+    return GrobArray (TRI, std::move (corners));
+  }
+
+private:
+  /// Returns a triangle which contains `p`, walking from `startTri`
+  index_t locate (Point2 const& p, index_t const startTri) const
+  {
+    index_t t = startTri;
+    index_t offset = 0;
+    for (;;) {
+      bool moved = false;
+      for (index_t i = 0; i < 3; ++i) {
+        index_t const h = 3 * t + (i + offset) % 3;
+        if (Orient (m_tri.point (h), m_tri.point (Next (h)), p) < 0 && m_tri.twins [h] != NO_INDEX) {
+          t = m_tri.twins [h] / 3;
+          moved = true;
+          break;
+        }
+      }
+
+      if (!moved)
+        return t;
+      // rotating the first tested edge prevents the walk from cycling
+      offset = (offset + 1) % 3;
+    }
+  }
+
+  index_t insert_point (index_t const v, index_t const startTri)
+  {
+    Point2 const& p = m_tri.points [v];
+    index_t const t = locate (p, startTri);
+
+    index_t onEdge = NO_INDEX;
+    for (index_t h = 3 * t; h < 3 * t + 3; ++h) {
+      Point2 const& c = m_tri.point (h);
+      if (c.x == p.x && c.y == p.y)
+        return t; // duplicate point
+      if (Orient (c, m_tri.point (Next (h)), p) == 0)
+        onEdge = h;
+    }
+
+    if (onEdge != NO_INDEX && m_tri.twins [onEdge] != NO_INDEX)
+      split_edge (onEdge, v);
+    else
+      split_triangle (t, v);
+
+    while (!m_stack.empty ()) {
+      index_t const h = m_stack.back ();
+      m_stack.pop_back ();
+      if (m_tri.is_illegal (h)) {
+        m_tri.flip (h);
+        // after the flip, `v` is the first corner of the first and the last corner of the second triangle
+        index_t const t1 = m_tri.twins [h - h % 3 + 2] / 3;
+        m_stack.push_back (h - h % 3 + 1);
+        m_stack.push_back (3 * t1);
+      }
+    }
+
+    return t;
+  }
+
+  /// Splits triangle `t` into three triangles which share the new vertex `v`
+  void split_triangle (index_t const t, index_t const v)
+  {
+    index_t const a = m_tri.corners [3 * t];
+    index_t const b = m_tri.corners [3 * t + 1];
+    index_t const c = m_tri.corners [3 * t + 2];
+    index_t const ab = m_tri.twins [3 * t];
+    index_t const bc = m_tri.twins [3 * t + 1];
+    index_t const ca = m_tri.twins [3 * t + 2];
+
+    index_t const t1 = m_tri.add_triangle ();
+    index_t const t2 = m_tri.add_triangle ();
+
+    m_tri.set_triangle (t, a, b, v);
+    m_tri.set_triangle (t1, b, c, v);
+    m_tri.set_triangle (t2, c, a, v);
+
+    m_tri.link (3 * t, ab);
+    m_tri.link (3 * t1, bc);
+    m_tri.link (3 * t2, ca);
+    m_tri.link (3 * t + 1, 3 * t1 + 2);
+    m_tri.link (3 * t1 + 1, 3 * t2 + 2);
+    m_tri.link (3 * t2 + 1, 3 * t + 2);
+
+    m_stack.insert (m_stack.end (), {3 * t, 3 * t1, 3 * t2});
+  }
+
+  /// Splits the edge `h` and its two adjacent triangles at the new vertex `v`
+  void split_edge (index_t const h, index_t const v)
+  {
+    index_t const g = m_tri.twins [h];
+    index_t const t = h / 3;
+    index_t const u = g / 3;
+
+    index_t const a = m_tri.origin (h);
+    index_t const b = m_tri.dest (h);
+    index_t const c = m_tri.origin (Prev (h));
+    index_t const d = m_tri.origin (Prev (g));
+
+    index_t const bc = m_tri.twins [Next (h)], ca = m_tri.twins [Prev (h)];
+    index_t const ad = m_tri.twins [Next (g)], db = m_tri.twins [Prev (g)];
+
+    index_t const t1 = m_tri.add_triangle ();
+    index_t const u1 = m_tri.add_triangle ();
+
+    m_tri.set_triangle (t, c, a, v);
+    m_tri.set_triangle (t1, c, v, b);
+    m_tri.set_triangle (u, d, b, v);
+    m_tri.set_triangle (u1, d, v, a);
+
+    m_tri.link (3 * t, ca);
+    m_tri.link (3 * t1 + 2, bc);
+    m_tri.link (3 * u, db);
+    m_tri.link (3 * u1 + 2, ad);
+    m_tri.link (3 * t + 1, 3 * u1 + 1);
+    m_tri.link (3 * t + 2, 3 * t1);
+    m_tri.link (3 * t1 + 1, 3 * u + 1);
+    m_tri.link (3 * u + 2, 3 * u1);
+
+    m_stack.insert (m_stack.end (), {3 * t, 3 * t1 + 2, 3 * u, 3 * u1 + 2});
+  }
+
+  /// Returns a half-edge which starts at vertex `v`
+  index_t outgoing_half_edge (index_t const v) const
+  {
+    index_t h = 3 * m_vertexTris [v];
+    while (m_tri.corners [h] != v)
+      ++h;
+    return h;
+  }
+
+  /// Returns the half-edge from `from` to `to` or `NO_INDEX`
+  index_t find_half_edge (index_t const from, index_t const to) const
+  {
+    index_t h = outgoing_half_edge (from);
+    index_t const first = h;
+    do {
+      if (m_tri.dest (h) == to)
+        return h;
+      h = m_tri.twins [Prev (h)];
+    } while (h != NO_INDEX && h != first);
+
+    return NO_INDEX;
+  }
+
+  void flip_and_track (index_t const h)
+  {
+    m_tri.flip (h);
+    index_t const t0 = h / 3;
+    index_t const t1 = m_tri.twins [3 * t0 + 2] / 3;
+    for (index_t i = 0; i < 3; ++i) {
+      m_vertexTris [m_tri.corners [3 * t0 + i]] = t0;
+      m_vertexTris [m_tri.corners [3 * t1 + i]] = t1;
+    }
+  }
+
+  void mark_constrained (index_t const h)
+  {
+    m_tri.constrained [h] = 1;
+    if (m_tri.twins [h] != NO_INDEX)
+      m_tri.constrained [m_tri.twins [h]] = 1;
+  }
+
+  /// Inserts the segment from `from` to `to` by flipping all crossing edges
+  void insert_constraint (index_t const from, index_t const to)
+  {
+    std::vector <std::pair <index_t, index_t>> segments {{from, to}};
+    std::vector <std::pair <index_t, index_t>> crossing;
+
+    while (!segments.empty ()) {
+      auto [u, v] = segments.back ();
+      segments.pop_back ();
+      if (u == v)
+        continue;
+
+      index_t const existing = find_half_edge (u, v);
+      if (existing != NO_INDEX) {
+        mark_constrained (existing);
+        continue;
+      }
+
+      Point2 const pu = m_tri.points [u];
+      Point2 const pv = m_tri.points [v];
+
+      // find the triangle at `u` whose opposite edge is crossed by the segment
+      index_t cur = NO_INDEX;
+      {
+        index_t h = outgoing_half_edge (u);
+        index_t const first = h;
+        do {
+          Point2 const& pa = m_tri.point (Next (h));
+          Point2 const& pb = m_tri.point (Prev (h));
+          double const oa = Orient (pu, pa, pv);
+          if (oa == 0 && (pa.x - pu.x) * (pv.x - pu.x) + (pa.y - pu.y) * (pv.y - pu.y) > 0) {
+            // a vertex lies on the segment
+            segments.push_back ({m_tri.dest (h), v});
+            segments.push_back ({u, m_tri.dest (h)});
+            break;
+          }
+          if (oa > 0 && Orient (pu, pv, pb) > 0) {
+            cur = Next (h);
+            break;
+          }
+          h = m_tri.twins [Prev (h)];
+        } while (h != first);
+      }
+
+      if (cur == NO_INDEX)
+        continue;
+
+      // collect the crossed edges
+      crossing.clear ();
+      index_t target = v;
+      for (;;) {
+        if (m_tri.constrained [cur]) {
+          throw LumeError () << "DelaunayTriangulation: Constrained edges (" << from << ", " << to
+                             << ") and (" << m_tri.origin (cur) << ", " << m_tri.dest (cur) << ") intersect";
+        }
+        crossing.push_back ({m_tri.origin (cur), m_tri.dest (cur)});
+
+        index_t const g = m_tri.twins [cur];
+        index_t const w = m_tri.origin (Prev (g));
+        if (w == v)
+          break;
+
+        double const ow = Orient (pu, pv, m_tri.points [w]);
+        if (ow == 0) {
+          segments.push_back ({w, v});
+          target = w;
+          break;
+        }
+
+        double const og = Orient (pu, pv, m_tri.point (Next (g)));
+        cur = (og > 0) != (ow > 0) ? Next (g) : Prev (g);
+      }
+
+      // flip crossing edges until the segment is part of the triangulation
+      Point2 const pt = m_tri.points [target];
+      size_t numTrials = 0;
+      size_t const maxTrials = 100 * crossing.size () * crossing.size () + 100;
+      while (!crossing.empty ()) {
+        if (++numTrials > maxTrials) {
+          throw LumeError () << "DelaunayTriangulation: Couldn't insert constrained edge ("
+                             << from << ", " << to << ")";
+        }
+
+        auto const edge = crossing.front ();
+        crossing.erase (crossing.begin ());
+        index_t const h = find_half_edge (edge.first, edge.second);
+        if (!m_tri.is_flippable (h)) {
+          crossing.push_back (edge);
+          continue;
+        }
+
+        flip_and_track (h);
+        index_t const c = m_tri.corners [h - h % 3];
+        index_t const d = m_tri.corners [h - h % 3 + 2];
+        if (c != u && c != target && d != u && d != target &&
+            Orient (pu, pt, m_tri.points [c]) * Orient (pu, pt, m_tri.points [d]) < 0)
+        {
+          crossing.push_back ({c, d});
+        }
+      }
+
+      mark_constrained (find_half_edge (u, target));
+    }
+  }
+
+private:
+  Triangulation           m_tri;
+  index_t                 m_numPoints;
+  std::vector <index_t>   m_stack;
+  std::vector <index_t>   m_vertexTris;
+};
+
+}// end of unnamed namespace
+
+
+GrobArray DelaunayTriangulation (RealArrayAnnex const& coords, GrobArray const& constrainedEdges)
+{
+  index_t const tupleSize = static_cast <index_t> (coords.tuple_size ());
+  if (tupleSize != 2 && tupleSize != 3)
+    throw BadTupleSizeError () << "DelaunayTriangulation: Unsupported tuple size " << tupleSize;
+
+  index_t const numPoints = static_cast <index_t> (coords.num_tuples ());
+  if (numPoints < 3)
+    return GrobArray (TRI);
+
+  std::vector <Point2> points (numPoints);
+  for (index_t i = 0; i < numPoints; ++i)
+    points [i] = {coords [tupleSize * i], coords [tupleSize * i + 1]};
+
+  DelaunayBuilder builder (std::move (points), numPoints);
+  builder.insert_points ();
+  builder.insert_constraints (constrainedEdges);
+  builder.legalize ();
+  return builder.triangles ();
+}
+
+
+index_t MakeDelaunay (Mesh& mesh, GrobArray const& constrainedEdges)
+{
+  auto const& coords = mesh.annex (keys::vertexCoords);
+  index_t const tupleSize = static_cast <index_t> (coords.tuple_size ());
+  if (tupleSize != 2 && tupleSize != 3)
+    throw BadTupleSizeError () << "MakeDelaunay: Unsupported tuple size " << tupleSize;
+
+  GrobArray& tris = mesh.grobs (TRI);
+  if (tris.empty ())
+    return 0;
+
+  Triangulation tri;
+  tri.points.resize (coords.num_tuples ());
+  for (index_t i = 0; i < tri.points.size (); ++i)
+    tri.points [i] = {coords [tupleSize * i], coords [tupleSize * i + 1]};
+
+  tri.corners.assign (tris.data (), tris.data () + 3 * tris.size ());
+  index_t const numHalfEdges = static_cast <index_t> (tri.corners.size ());
+  tri.twins.assign (numHalfEdges, NO_INDEX);
+  tri.constrained.assign (numHalfEdges, 0);
+
+  // all triangles have to share the orientation of the first non-degenerate one
+  for (index_t t = 0; t < tri.num_triangles (); ++t) {
+    double const o = Orient (tri.point (3 * t), tri.point (3 * t + 1), tri.point (3 * t + 2));
+    if (o != 0) {
+      tri.orientation = o > 0 ? 1 : -1;
+      break;
+    }
+  }
+
+  // pair half-edges which are traversed in opposite directions by exactly two triangles
+  std::vector <std::pair <uint64_t, index_t>> halfEdges (numHalfEdges);
+  parallel_for_blocks (index_t (0), numHalfEdges, [&] (index_t const begin, index_t const end) {
+    for (index_t h = begin; h < end; ++h)
+      halfEdges [h] = {EdgeKey (tri.origin (h), tri.dest (h)), h};
+  });
+  std::sort (halfEdges.begin (), halfEdges.end ());
+
+  std::vector <uint64_t> constraintKeys;
+  for (auto const& edge : constrainedEdges)
+    constraintKeys.push_back (EdgeKey (edge.corner (0), edge.corner (1)));
+  std::sort (constraintKeys.begin (), constraintKeys.end ());
+
+  for (index_t i = 0; i < numHalfEdges;) {
+    index_t j = i + 1;
+    while (j < numHalfEdges && halfEdges [j].first == halfEdges [i].first)
+      ++j;
+
+    index_t const h = halfEdges [i].second;
+    index_t const g = halfEdges [j - 1].second;
+    if (j == i + 2 && tri.origin (h) == tri.dest (g)) {
+      char const isConstrained = std::binary_search (constraintKeys.begin (), constraintKeys.end (),
+                                                     halfEdges [i].first);
+      tri.link (h, g, isConstrained);
+    }
+    i = j;
+  }
+
+  index_t const numFlips = LawsonFlips (tri);
+  if (numFlips > 0) {
+    std::copy (tri.corners.begin (), tri.corners.end (), tris.underlying_array ().begin ());
+    mesh.invalidate_derived_data ();
+  }
+
+  return numFlips;
+}
+
+}// end of namespace lume
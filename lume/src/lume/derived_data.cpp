@@ -0,0 +1,112 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/derived_data.h>
+
+#include <lume/array_annex.h>
+#include <lume/math/raw/vector_math_raw.h>
+
+namespace lume
+{
+
+std::shared_ptr <GrobSides const>
+CachedGrobSides (Mesh const& mesh, GrobSet const grobSet, GrobSet const sideSet)
+{
+  std::vector <GrobType> grobTypes;
+  for (auto const grobType : grobSet)
+    grobTypes.push_back (grobType);
+  return CachedGrobSides (mesh, grobTypes, sideSet);
+}
+
+
+std::shared_ptr <GrobSides const>
+CachedGrobSides (Mesh const& mesh, std::vector <GrobType> const& grobTypes, GrobSet const sideSet)
+{
+  std::string key = "GrobSides:" + sideSet.name ();
+  DerivedDataCache::GrobTypeMask grobTypeMask;
+  for (auto const grobType : grobTypes) {
+    key += ":" + GrobTypeName (grobType);
+    grobTypeMask.set (grobType);
+  }
+
+  return mesh.derived_data <GrobSides> (key, grobTypeMask, {}, [&] () {
+    return GrobSides (mesh, grobTypes, sideSet);
+  });
+}
+
+
+std::shared_ptr <Neighborhoods const>
+CachedNeighborhoods (SPMesh mesh, GrobSet const centerGrobSet, GrobSet const neighborGrobSet)
+{
+  std::string const key = "Neighborhoods:" + centerGrobSet.name () + ":" + neighborGrobSet.name ();
+  auto const nbrhds = mesh->derived_data <Neighborhoods> (
+    key,
+    DerivedDataCache::grob_type_mask ({centerGrobSet, neighborGrobSet}),
+    {},
+    [&] () {
+      // the cached instance must not own the mesh, since the mesh owns the cache
+      return Neighborhoods (SPMesh (SPMesh (), mesh.get ()), centerGrobSet, neighborGrobSet);
+    });
+
+  // the returned instance keeps both, the mesh and the neighborhoods, alive
+  return std::shared_ptr <Neighborhoods const> (nbrhds.get (), [mesh, nbrhds] (Neighborhoods const*) {});
+}
+
+
+BoundingBox CachedBoundingBox (Mesh const& mesh)
+{
+  auto const box = mesh.derived_data <BoundingBox> (
+    "BoundingBox",
+    DerivedDataCache::grob_type_mask ({VERTICES}),
+    {keys::vertexCoords},
+    [&] () {
+      auto const& coords = mesh.annex (keys::vertexCoords);
+      index_t const tupleSize = static_cast <index_t> (coords.tuple_size ());
+      if (tupleSize > 3)
+        throw BadTupleSizeError () << "CachedBoundingBox: Unsupported tuple size " << tupleSize;
+
+      BoundingBox box;
+      if (coords.num_tuples () > 0) {
+        box.min = {0, 0, 0};
+        box.max = {0, 0, 0};
+        math::raw::VecTupBoundingBox (box.min.data (), box.max.data (), coords.data (), coords.size (), tupleSize);
+      }
+      return box;
+    });
+
+  return *box;
+}
+
+
+std::shared_ptr <VertexIncidence const>
+CachedVertexIncidence (Mesh const& mesh, GrobSet const grobSet)
+{
+  return mesh.derived_data <VertexIncidence> (
+    "VertexIncidence:" + grobSet.name (),
+    DerivedDataCache::grob_type_mask ({VERTICES, grobSet}),
+    {},
+    [&] () {return VertexIncidence (mesh, grobSet);});
+}
+
+}// end of namespace lume
@@ -22,8 +22,10 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
 #include <fstream>
 #include <lume/edge_mesh_2d.h>
+#include <lume/parallel_for.h>
 
 namespace lume
 {
@@ -32,6 +34,11 @@ namespace
 {
   using Boundary = EdgeMesh2d::Boundary;
 
+  /// Number of free slots per vertex after compaction
+  constexpr index_t g_numSlackSlots = 2;
+  /// Minimal capacity of a vertex whose connections had to be relocated
+  constexpr index_t g_minSlotCapacity = 4;
+
   Boundary InverseBoundary (Boundary const boundary)
   {
     switch (boundary)
@@ -51,32 +58,6 @@ EdgeMesh2d::EdgeMesh2d (std::function <std::tuple <double, double> (index_t)> co
 {
 }
 
-EdgeMesh2d::EdgeMesh2d (EdgeMesh2d const& other)
-  : m_connections (other.m_connections)
-  , m_coordinateCallback (other.m_coordinateCallback)
-{
-}
-
-EdgeMesh2d::EdgeMesh2d (EdgeMesh2d&& other)
-  : m_connections (std::move (other.m_connections))
-  , m_coordinateCallback (std::move (other.m_coordinateCallback))
-{
-}
-
-EdgeMesh2d& EdgeMesh2d::operator = (EdgeMesh2d const& other)
-{
-  m_connections = other.m_connections;
-  m_coordinateCallback = other.m_coordinateCallback;
-  return *this;
-}
-
-EdgeMesh2d& EdgeMesh2d::operator = (EdgeMesh2d&& other)
-{
-  m_connections = std::move (other.m_connections);
-  m_coordinateCallback = std::move (other.m_coordinateCallback);
-  return *this;
-}
-
 bool EdgeMesh2d::add_edge (Edge const& edge, Boundary boundary)
 {
   if (edge.from == edge.to) {
@@ -84,6 +65,9 @@ bool EdgeMesh2d::add_edge (Edge const& edge, Boundary boundary)
     return false;
   }
 
+  ensure_vertex (edge.from);
+  ensure_vertex (edge.to);
+
   bool success = true;
   success &= insert_connection (edge.from, edge.to, boundary);
   success &= insert_connection (edge.to, edge.from, InverseBoundary (boundary));
@@ -93,8 +77,7 @@ bool EdgeMesh2d::add_edge (Edge const& edge, Boundary boundary)
 
 bool EdgeMesh2d::has_edge (Edge const& edge) const
 {
-  auto const& connections = vertex_connections (edge.from);
-  return find_connection (connections, edge.to) != connections.end ();
+  return has_connection (edge.from, edge.to);
 }
 
 bool EdgeMesh2d::swap_edge (Edge const& edge)
@@ -124,96 +107,103 @@ void EdgeMesh2d::remove_edge (Edge const& edge)
 
 void EdgeMesh2d::remove_edges_with_vertex (index_t vertex, bool addBoundaryMarkers)
 {
-  auto& connections = vertex_connections (vertex);
+  if (vertex >= m_vertexSlots.size ())
+    return;
+
+  // removing connections never relocates slots, so the view stays valid
+  auto const cons = connections (vertex);
   auto const p = coordinate (vertex);
 
   if (addBoundaryMarkers &&
-      connections.size () > 1)
+      cons.size () > 1)
   {
-    for (size_t i = 0; i < connections.size (); ++i)
+    for (size_t i = 0; i < cons.size (); ++i)
     {
-      size_t const j = (i + 1) % connections.size ();
+      size_t const j = (i + 1) % cons.size ();
 
-      auto const iTo = connections [i].to;
-      auto const jTo = connections [j].to;
+      auto const iTo = cons [i].to;
+      auto const jTo = cons [j].to;
 
-      if (connections [i].boundary == Boundary::Left ||
-          connections [j].boundary == Boundary::Right ||
+      if (cons [i].boundary == Boundary::Left ||
+          cons [j].boundary == Boundary::Right ||
           !triangle_is_ccw (p, coordinate (iTo), coordinate (jTo)))
       {
         continue;
       }
 
-      auto& iCons = vertex_connections (iTo);
-      auto jIter = find_connection (iCons, jTo);
-      if (jIter != iCons.end ())
-        jIter->boundary = Boundary::Left;
+      if (auto* c = find_connection (iTo, jTo))
+        c->boundary = Boundary::Left;
 
-      auto& jCons = vertex_connections (jTo);
-      auto iIter = find_connection (jCons, iTo);
-      if (iIter != jCons.end ())
-        iIter->boundary = Boundary::Right;
+      if (auto* c = find_connection (jTo, iTo))
+        c->boundary = Boundary::Right;
     }
   }
 
   // remove connections from connected vertices to this one
-  for (auto const& c : connections) {
+  for (auto const& c : cons) {
     assert (c.to != vertex);
     remove_connection (c.to, vertex);
   }
 
-  connections.clear ();
+  m_vertexSlots [vertex].size = 0;
 }
 
 size_t EdgeMesh2d::num_vertices () const
 {
-  return m_connections.size ();
-}
-
-auto EdgeMesh2d::vertex_connections (index_t vertex) -> Connections&
-{
-  if (vertex >= m_connections.size ())
-    m_connections.resize (vertex + 1);
-  return m_connections [vertex];
-}
-
-auto EdgeMesh2d::vertex_connections (index_t vertex) const -> Connections const&
-{
-  assert (vertex < m_connections.size ());
-  return m_connections [vertex];
+  return m_vertexSlots.size ();
 }
 
-auto EdgeMesh2d::connections (index_t vertex) const -> Connections const&
+auto EdgeMesh2d::connections (index_t vertex) const -> Connections
 {
-  return vertex_connections (vertex);
+  assert (vertex < m_vertexSlots.size ());
+  return Connections (slots_begin (vertex), m_vertexSlots [vertex].size);
 }
 
 GrobArray EdgeMesh2d::create_triangles () const
 {
-  GrobArray tris {TRI};
-  for (index_t iVrt = 0; iVrt < static_cast <index_t> (m_connections.size ()); ++iVrt)
+  index_t const numVertices = static_cast <index_t> (m_vertexSlots.size ());
+  std::vector <std::vector <index_t>> blockCorners (std::max <size_t> (1, std::thread::hardware_concurrency ()));
+  std::vector <size_t> blockOffsets (blockCorners.size () + 1, numVertices);
+  for (size_t i = 0; i < blockCorners.size (); ++i)
+    blockOffsets [i] = i * numVertices / blockCorners.size ();
+
+  parallel_for (size_t (0), blockCorners.size (), [&] (size_t const iBlock)
   {
-    auto const p = coordinate (iVrt);
-    auto const connections = m_connections [iVrt];
-    auto const numConnections = connections.size ();
-    for (size_t iCon = 0; iCon < numConnections; ++iCon)
+    auto& corners = blockCorners [iBlock];
+    for (index_t iVrt = static_cast <index_t> (blockOffsets [iBlock]);
+         iVrt < blockOffsets [iBlock + 1]; ++iVrt)
     {
-      if (connections [iCon].boundary == Boundary::Left)
-        continue;
+      auto const p = coordinate (iVrt);
+      auto const cons = connections (iVrt);
+      auto const numConnections = cons.size ();
+      for (size_t iCon = 0; iCon < numConnections; ++iCon)
+      {
+        if (cons [iCon].boundary == Boundary::Left)
+          continue;
 
-      auto const to0 = connections [iCon].to;
-      auto const to1 = connections [(iCon + 1) % numConnections].to;
+        auto const to0 = cons [iCon].to;
+        auto const to1 = cons [(iCon + 1) % numConnections].to;
 
-      if (iVrt < to0 &&
-          iVrt < to1 &&
-          triangle_is_ccw (p, coordinate (to0), coordinate (to1)))
-      {
-        tris.push_back ({iVrt, to0, to1});
+        if (iVrt < to0 &&
+            iVrt < to1 &&
+            triangle_is_ccw (p, coordinate (to0), coordinate (to1)))
+        {
+          corners.insert (corners.end (), {iVrt, to0, to1});
+        }
       }
     }
-  }
+  }, 1);
+
+  size_t numCorners = 0;
+  for (auto const& corners : blockCorners)
+    numCorners += corners.size ();
+
+  std::vector <index_t> triCorners;
+  triCorners.reserve (numCorners);
+  for (auto const& corners : blockCorners)
+    triCorners.insert (triCorners.end (), corners.begin (), corners.end ());
 
-  return tris;
+  return GrobArray (TRI, std::move (triCorners));
 }
 
 void EdgeMesh2d::save_connections (std::string const& filename) const
@@ -236,9 +226,9 @@ void EdgeMesh2d::save_connections (std::string const& filename) const
     out << "usemtl (null)" << std::endl;
 
     Boundary boundary = static_cast <Boundary> (iSubset);
-    for (size_t iVrt = 0; iVrt < num_vertices (); ++iVrt)
+    for (index_t iVrt = 0; iVrt < num_vertices (); ++iVrt)
     {
-      for (auto const& c : m_connections [iVrt])
+      for (auto const& c : connections (iVrt))
       {
         if (c.boundary == boundary)
         {
@@ -249,29 +239,145 @@ void EdgeMesh2d::save_connections (std::string const& filename) const
   }
 }
 
-bool EdgeMesh2d::insert_connection (index_t const from, index_t const to, Boundary boundary)
+void EdgeMesh2d::init_connections (std::vector <Edge> const& edges,
+                                   std::vector <Boundary> const& boundaries)
 {
-  auto const pseudoAngle = compute_pseudo_angle (from, to);
-  auto& connections = vertex_connections (from);
-  auto const nextIter = find_connection_lower_bound (connections, pseudoAngle);
-  if (nextIter == connections.end ()) {
-    connections.push_back ({to, pseudoAngle, boundary});
-    return true;
+  assert (m_slots.empty ());
+  assert (edges.size () == boundaries.size ());
+
+  index_t const numVertices = static_cast <index_t> (m_vertexSlots.size ());
+
+  for (auto const& edge : edges) {
+    assert (edge.from < numVertices && edge.to < numVertices);
+    ++m_vertexSlots [edge.from].capacity;
+    ++m_vertexSlots [edge.to].capacity;
   }
-  else if (nextIter->to != to) {
-    connections.insert (nextIter, {to, pseudoAngle, boundary});
-    return true;
+
+  index_t offset = 0;
+  for (auto& vs : m_vertexSlots) {
+    vs.offset = offset;
+    vs.capacity += g_numSlackSlots;
+    offset += vs.capacity;
+  }
+
+  m_slots.resize (offset);
+  for (size_t i = 0; i < edges.size (); ++i) {
+    auto const& edge = edges [i];
+    auto& fromSlots = m_vertexSlots [edge.from];
+    auto& toSlots = m_vertexSlots [edge.to];
+    m_slots [fromSlots.offset + fromSlots.size++] = {edge.to, boundaries [i], 0};
+    m_slots [toSlots.offset + toSlots.size++] = {edge.from, InverseBoundary (boundaries [i]), 0};
   }
-  return false;
+
+  parallel_for_blocks (index_t (0), numVertices, [this] (index_t const begin, index_t const end)
+  {
+    for (index_t iVrt = begin; iVrt < end; ++iVrt)
+    {
+      for (auto* c = slots_begin (iVrt); c != slots_end (iVrt); ++c)
+        c->pseudoAngle = compute_pseudo_angle (iVrt, c->to);
+
+      std::sort (slots_begin (iVrt), slots_end (iVrt),
+                 [] (auto const& c0, auto const& c1) {return c0.pseudoAngle < c1.pseudoAngle;});
+    }
+  });
+}
+
+void EdgeMesh2d::ensure_vertex (index_t const vertex)
+{
+  if (vertex < m_vertexSlots.size ())
+    return;
+
+  index_t const oldSize = static_cast <index_t> (m_vertexSlots.size ());
+  m_vertexSlots.resize (vertex + 1);
+
+  if (m_coordinateCallback) {
+    m_coordinates.resize (2 * m_vertexSlots.size ());
+    for (index_t i = oldSize; i <= vertex; ++i)
+      std::tie (m_coordinates [2 * i], m_coordinates [2 * i + 1]) = m_coordinateCallback (i);
+  }
+
+  assert (m_coordinates.size () >= 2 * m_vertexSlots.size ());
+}
+
+void EdgeMesh2d::reserve_slot (index_t const vertex)
+{
+  if (m_vertexSlots [vertex].size < m_vertexSlots [vertex].capacity)
+    return;
+
+  if (m_numAbandonedSlots > m_slots.size () / 2) {
+    compact_slots ();
+    if (m_vertexSlots [vertex].size < m_vertexSlots [vertex].capacity)
+      return;
+  }
+
+  auto& vs = m_vertexSlots [vertex];
+  index_t const newCapacity = std::max (g_minSlotCapacity, 2 * vs.capacity);
+
+  if (vs.offset + vs.capacity == m_slots.size ()) {
+    // the last range can grow in place
+    m_slots.resize (vs.offset + newCapacity);
+  }
+  else {
+    index_t const newOffset = static_cast <index_t> (m_slots.size ());
+    m_slots.resize (newOffset + newCapacity);
+    std::copy (m_slots.begin () + vs.offset,
+               m_slots.begin () + vs.offset + vs.size,
+               m_slots.begin () + newOffset);
+    m_numAbandonedSlots += vs.capacity;
+    vs.offset = newOffset;
+  }
+
+  vs.capacity = newCapacity;
+}
+
+void EdgeMesh2d::compact_slots ()
+{
+  size_t numSlots = 0;
+  for (auto const& vs : m_vertexSlots)
+    numSlots += vs.size + g_numSlackSlots;
+
+  std::vector <Connection> slots (numSlots);
+  index_t offset = 0;
+  for (auto& vs : m_vertexSlots) {
+    std::copy (m_slots.begin () + vs.offset,
+               m_slots.begin () + vs.offset + vs.size,
+               slots.begin () + offset);
+    vs.offset = offset;
+    vs.capacity = vs.size + g_numSlackSlots;
+    offset += vs.capacity;
+  }
+
+  m_slots.swap (slots);
+  m_numAbandonedSlots = 0;
+}
+
+bool EdgeMesh2d::insert_connection (index_t const from, index_t const to, Boundary boundary)
+{
+  auto const pseudoAngle = compute_pseudo_angle (from, to);
+  auto const next = std::lower_bound (slots_begin (from), slots_end (from), pseudoAngle,
+                                      [] (auto const& c, double const angle) {return c.pseudoAngle < angle;});
+
+  if (next != slots_end (from) && next->to == to)
+    return false;
+
+  auto const pos = next - slots_begin (from);
+  reserve_slot (from);
+
+  auto* begin = slots_begin (from);
+  auto* end = slots_end (from);
+  std::move_backward (begin + pos, end, end + 1);
+  begin [pos] = {to, boundary, pseudoAngle};
+  ++m_vertexSlots [from].size;
+  return true;
 }
 
 void EdgeMesh2d::remove_connection (index_t const from, index_t const to)
 {
-  auto& connections = vertex_connections (from);
-  auto const iter = find_connection (connections, to);
-  if (iter != connections.end ())
-    connections.erase (iter);
-  return;
+  auto* const c = find_connection (from, to);
+  if (c) {
+    std::move (c + 1, slots_end (from), c);
+    --m_vertexSlots [from].size;
+  }
 }
 
 double EdgeMesh2d::compute_pseudo_angle (index_t const iFrom, index_t const iTo) const
@@ -318,34 +424,31 @@ bool EdgeMesh2d::triangle_is_ccw (Coordinate const& a, Coordinate const& b, Coor
 
 bool EdgeMesh2d::is_valid (Edge const& edge) const
 {
-  return edge.from < m_connections.size () &&
-         edge.to < m_connections.size ();
+  return edge.from < m_vertexSlots.size () &&
+         edge.to < m_vertexSlots.size ();
 }
 
 bool EdgeMesh2d::has_connection (index_t const from, index_t const to) const
 {
-  auto& connections = vertex_connections (from);
-  return find_connection (connections, to) != connections.end ();
-}
-
-auto EdgeMesh2d::find_connection (Connections& connections, index_t const to) -> Connections::iterator
-{
-  return std::find_if (connections.begin (), connections.end (),
-                       [to] (auto const& c) {return c.to == to;});
+  return find_connection (from, to) != nullptr;
 }
 
-auto EdgeMesh2d::find_connection (Connections const& connections, index_t const to) const -> Connections::const_iterator
+auto EdgeMesh2d::find_connection (index_t const from, index_t const to) -> Connection*
 {
-  return std::find_if (connections.begin (), connections.end (),
-                       [to] (auto const& c) {return c.to == to;});
+  if (from >= m_vertexSlots.size ())
+    return nullptr;
+  auto* const end = slots_end (from);
+  auto* const c = std::find_if (slots_begin (from), end, [to] (auto const& c) {return c.to == to;});
+  return c != end ? c : nullptr;
 }
 
-auto EdgeMesh2d::find_connection_lower_bound (Connections& connections,
-                                              double const pseudoAngle)
--> Connections::iterator
+auto EdgeMesh2d::find_connection (index_t const from, index_t const to) const -> Connection const*
 {
-  return std::find_if (connections.begin (), connections.end (),
-                       [pseudoAngle] (auto const& c) {return c.pseudoAngle >= pseudoAngle;});
+  if (from >= m_vertexSlots.size ())
+    return nullptr;
+  auto const* const end = slots_end (from);
+  auto const* const c = std::find_if (slots_begin (from), end, [to] (auto const& c) {return c.to == to;});
+  return c != end ? c : nullptr;
 }
 
 auto EdgeMesh2d::swap_candidate (Edge const& edge) const -> std::optional <Edge>
@@ -355,8 +458,7 @@ auto EdgeMesh2d::swap_candidate (Edge const& edge) const -> std::optional <Edge>
   std::array <index_t, 2>  swapCandidates;
   size_t numSwapCandidates = 0;
 
-  auto const& connections = vertex_connections (edge.from);
-  for (auto const& c : connections) {
+  for (auto const& c : connections (edge.from)) {
     if (c.to == edge.to) {
       if (c.boundary != Boundary::None)
         return {}; // boundary edges cannot be swapped
@@ -373,13 +475,6 @@ auto EdgeMesh2d::swap_candidate (Edge const& edge) const -> std::optional <Edge>
   return {};
 }
 
-auto EdgeMesh2d::coordinate (index_t vertex) const -> Coordinate
-{
-  auto c = Coordinate::uninitialized (2);
-  std::tie (c [0], c [1]) = m_coordinateCallback (vertex);
-  return c;
-}
-
 auto EdgeMesh2d::direction (index_t const from, index_t const to) const -> Coordinate
 {
   return coordinate (to) - coordinate (from);
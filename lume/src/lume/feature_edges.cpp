@@ -0,0 +1,190 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/feature_edges.h>
+
+#include <algorithm>
+#include <cmath>
+#include <lume/array_annex.h>
+#include <lume/derived_data.h>
+#include <lume/parallel_for.h>
+#include <lume/math/raw/vector_math_raw.h>
+
+namespace lume
+{
+
+namespace
+{
+
+constexpr real_t g_radToDeg = real_t (180.0 / 3.14159265358979323846);
+
+/// Returns true if the given corners traverse the edge from `c0` to `c1`
+bool Traverses (ConstGrob const& face, index_t const c0, index_t const c1)
+{
+  index_t const n = face.num_corners ();
+  for (index_t i = 0; i < n; ++i) {
+    if (face.corner (i) == c0)
+      return face.corner ((i + 1) % n) == c1;
+  }
+  return false;
+}
+
+/// Computes the unit normal of a triangle or quadrilateral
+void FaceNormal (real_t* normalOut, ConstGrob const& face, real_t const* coords)
+{
+  real_t d0 [3], d1 [3];
+  if (face.num_corners () == 3) {
+    math::raw::VecSubtract (d0, 3, coords + 3 * face.corner (1), coords + 3 * face.corner (0));
+    math::raw::VecSubtract (d1, 3, coords + 3 * face.corner (2), coords + 3 * face.corner (0));
+  }
+  else {
+    math::raw::VecSubtract (d0, 3, coords + 3 * face.corner (2), coords + 3 * face.corner (0));
+    math::raw::VecSubtract (d1, 3, coords + 3 * face.corner (3), coords + 3 * face.corner (1));
+  }
+  math::raw::VecCross3 (normalOut, d0, d1);
+  math::raw::VecNormalizeInplace (normalOut, 3);
+}
+
+}// end of unnamed namespace
+
+
+FeatureEdges ExtractFeatureEdges (Mesh const& mesh, real_t const featureAngle, bool const includeBoundary)
+{
+  auto const& coordsAnnex = mesh.annex (keys::vertexCoords);
+  if (coordsAnnex.tuple_size () != 3)
+    throw BadTupleSizeError () << "ExtractFeatureEdges: Unsupported tuple size " << coordsAnnex.tuple_size ();
+  real_t const* coords = coordsAnnex.data ();
+
+  auto const sides = CachedGrobSides (mesh, FACES, EDGES);
+  GrobArray const& edges = sides->sides (EDGE);
+  index_t const numEdges = static_cast <index_t> (edges.size ());
+
+  // classify all edges in parallel
+  static constexpr uint8_t noFeature = 0xFF;
+  std::vector <uint8_t> types (numEdges, noFeature);
+  std::vector <real_t> angles (numEdges, 0);
+
+  parallel_for_blocks (index_t (0), numEdges, [&] (index_t const begin, index_t const end) {
+    for (index_t iedge = begin; iedge < end; ++iedge) {
+      GrobIndex const edge (EDGE, iedge);
+      index_t const numFaces = sides->num_incidences (edge);
+      if (numFaces != 2) {
+        if (numFaces > 2)
+          types [iedge] = static_cast <uint8_t> (FeatureEdgeType::NonManifold);
+        else if (includeBoundary)
+          types [iedge] = static_cast <uint8_t> (FeatureEdgeType::Boundary);
+        continue;
+      }
+
+      ConstGrob const face0 = mesh.grob (sides->incidence (edge, 0).grob);
+      ConstGrob const face1 = mesh.grob (sides->incidence (edge, 1).grob);
+
+      real_t n0 [3], n1 [3];
+      FaceNormal (n0, face0, coords);
+      FaceNormal (n1, face1, coords);
+
+      index_t const c0 = edges [iedge].corner (0);
+      index_t const c1 = edges [iedge].corner (1);
+      real_t cosAngle = math::raw::VecDot (n0, 3, n1);
+      if (Traverses (face0, c0, c1) == Traverses (face1, c0, c1))
+        cosAngle = -cosAngle;
+
+      real_t const angle = std::acos (std::min (real_t (1), std::max (real_t (-1), cosAngle))) * g_radToDeg;
+      if (angle > featureAngle) {
+        types [iedge] = static_cast <uint8_t> (FeatureEdgeType::Sharp);
+        angles [iedge] = angle;
+      }
+    }
+  });
+
+  FeatureEdges features;
+  std::vector <index_t> featureCorners;
+  for (index_t iedge = 0; iedge < numEdges; ++iedge) {
+    if (types [iedge] == noFeature)
+      continue;
+    featureCorners.push_back (edges [iedge].corner (0));
+    featureCorners.push_back (edges [iedge].corner (1));
+    features.types.push_back (static_cast <FeatureEdgeType> (types [iedge]));
+    features.dihedralAngles.push_back (angles [iedge]);
+  }
+  features.edges = GrobArray (EDGE, std::move (featureCorners));
+
+  // chain the edges into curves, starting at the vertices whose valence isn't 2
+  index_t const numFeatureEdges = static_cast <index_t> (features.edges.size ());
+  index_t const* corners = features.edges.data ();
+
+  std::vector <index_t> vertexOffsets (mesh.num (VERTEX) + 1, 0);
+  for (index_t i = 0; i < 2 * numFeatureEdges; ++i)
+    ++vertexOffsets [corners [i] + 1];
+  for (size_t i = 1; i < vertexOffsets.size (); ++i)
+    vertexOffsets [i] += vertexOffsets [i - 1];
+
+  std::vector <index_t> vertexEdges (2 * numFeatureEdges);
+  {
+    std::vector <index_t> cursors (vertexOffsets.begin (), vertexOffsets.end () - 1);
+    for (index_t i = 0; i < 2 * numFeatureEdges; ++i)
+      vertexEdges [cursors [corners [i]]++] = i / 2;
+  }
+
+  auto valence = [&] (index_t const v) {return vertexOffsets [v + 1] - vertexOffsets [v];};
+
+  std::vector <char> visited (numFeatureEdges, 0);
+  auto traceCurve = [&] (index_t const start, index_t const firstEdge) {
+    features.curveVertices.push_back (start);
+    index_t v = start;
+    index_t e = firstEdge;
+    while (true) {
+      visited [e] = 1;
+      v = corners [2 * e] == v ? corners [2 * e + 1] : corners [2 * e];
+      features.curveVertices.push_back (v);
+      if (v == start || valence (v) != 2)
+        break;
+
+      index_t const* ve = vertexEdges.data () + vertexOffsets [v];
+      e = ve [0] == e ? ve [1] : ve [0];
+      if (visited [e])
+        break;
+    }
+    features.curveOffsets.push_back (static_cast <index_t> (features.curveVertices.size ()));
+  };
+
+  for (index_t i = 0; i < 2 * numFeatureEdges; ++i) {
+    index_t const v = corners [i];
+    if (valence (v) == 2)
+      continue;
+    for (index_t j = vertexOffsets [v]; j < vertexOffsets [v + 1]; ++j) {
+      if (!visited [vertexEdges [j]])
+        traceCurve (v, vertexEdges [j]);
+    }
+  }
+
+  for (index_t e = 0; e < numFeatureEdges; ++e) {
+    if (!visited [e])
+      traceCurve (corners [2 * e], e);
+  }
+
+  return features;
+}
+
+}// end of namespace lume
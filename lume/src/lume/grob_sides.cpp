@@ -0,0 +1,386 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/grob_sides.h>
+
+#include <algorithm>
+#include <atomic>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+namespace
+{
+  constexpr index_t MAX_NUM_SIDE_CORNERS = 4;
+  using SideCorners = std::array <index_t, MAX_NUM_SIDE_CORNERS>;
+
+  /// Type and local corners of a side of a grob
+  struct LocalSideDesc
+  {
+    GrobType    sideType;
+    index_t     numCorners;
+    SideCorners corners;
+  };
+
+  using LocalSideDescs = std::vector <LocalSideDesc>;
+
+  LocalSideDescs GetLocalSideDescs (GrobType const grobType, index_t const sideDim)
+  {
+    GrobDesc const desc (grobType);
+    LocalSideDescs descs;
+
+    if (desc.dim () == sideDim) {
+      LocalSideDesc sideDesc {grobType, desc.num_corners (), {}};
+      for (index_t i = 0; i < desc.num_corners (); ++i) {
+        sideDesc.corners [i] = i;
+      }
+      descs.push_back (sideDesc);
+    }
+    else if (desc.dim () > sideDim) {
+      for (index_t side = 0; side < desc.num_sides (sideDim); ++side) {
+        LocalSideDesc sideDesc {desc.side_type (sideDim, side),
+                                desc.num_side_corners (sideDim, side),
+                                {}};
+        index_t const* localCorners = desc.local_side_corners (sideDim, side);
+        for (index_t i = 0; i < sideDesc.numCorners; ++i) {
+          sideDesc.corners [i] = localCorners [i];
+        }
+        descs.push_back (sideDesc);
+      }
+    }
+    return descs;
+  }
+
+  /// Sorted global corners of a side instance together with its slot
+  struct SideKey
+  {
+    SideCorners corners;
+    index_t     slot;
+
+    bool operator < (SideKey const& key) const
+    {
+      return corners < key.corners || (corners == key.corners && slot < key.slot);
+    }
+  };
+}// end of unnamed namespace
+
+
+GrobSides::GrobSides (Mesh const& mesh, GrobSet grobSet, GrobSet sideSet)
+  : m_sideSet (sideSet)
+{
+  std::vector <GrobType> grobTypes;
+  for (auto const grobType : grobSet) {
+    grobTypes.push_back (grobType);
+  }
+  init (mesh, grobTypes);
+}
+
+GrobSides::GrobSides (Mesh const& mesh, std::vector <GrobType> const& grobTypes, GrobSet sideSet)
+  : m_sideSet (sideSet)
+{
+  init (mesh, grobTypes);
+}
+
+GrobSides::Incidence GrobSides::incidence (GrobIndex const& side, index_t const i) const
+{
+  auto const& offsets = m_incidenceOffsets [side.grob_type ()];
+  return slot_to_incidence (m_incidences [side.grob_type ()][offsets [side.index ()] + i]);
+}
+
+GrobSides::Incidence GrobSides::slot_to_incidence (index_t const slot) const
+{
+  GrobType grobType = m_grobTypes.front ();
+  for (auto const gt : m_grobTypes) {
+    if (slot >= m_slotBaseInds [gt]) {
+      grobType = gt;
+    }
+  }
+
+  index_t const localSlot = slot - m_slotBaseInds [grobType];
+  index_t const numLocalSides = m_numLocalSides [grobType];
+  return Incidence {GrobIndex (grobType, localSlot / numLocalSides), localSlot % numLocalSides};
+}
+
+void GrobSides::init (Mesh const& mesh, std::vector <GrobType> const& grobTypes)
+{
+  index_t const sideDim = side_dim ();
+  if (sideDim >= MAX_GROB_DIM) {
+    throw LumeError () << "GrobSides: The side dimension has to be smaller than "
+                       << MAX_GROB_DIM << " but " << sideDim << " was given.";
+  }
+
+  m_sides.reserve (NUM_GROB_TYPES);
+  for (index_t i = 0; i < NUM_GROB_TYPES; ++i) {
+    m_sides.emplace_back (static_cast <GrobType> (i));
+  }
+
+  size_t numSlots = 0;
+  for (auto const grobType : grobTypes)
+  {
+    if (!mesh.has (grobType) ||
+        std::find (m_grobTypes.begin (), m_grobTypes.end (), grobType) != m_grobTypes.end ())
+    {
+      continue;
+    }
+
+    GrobDesc const desc (grobType);
+    index_t numLocalSides = 0;
+    if (desc.dim () > sideDim) {
+      numLocalSides = desc.num_sides (sideDim);
+    }
+    else if (desc.dim () == sideDim) {
+      for (auto const sideType : m_sideSet) {
+        if (sideType == grobType)
+          numLocalSides = 1;
+      }
+    }
+
+    if (numLocalSides == 0) {
+      continue;
+    }
+
+  //  grobs without any side in the side set don't have to be considered
+    bool hasSideInSideSet = false;
+    for (auto const& sideDesc : GetLocalSideDescs (grobType, sideDim)) {
+      for (auto const sideType : m_sideSet) {
+        if (sideDesc.sideType == sideType)
+          hasSideInSideSet = true;
+      }
+    }
+
+    if (!hasSideInSideSet) {
+      continue;
+    }
+
+    m_grobTypes.push_back (grobType);
+    m_numLocalSides [grobType] = numLocalSides;
+    m_slotBaseInds [grobType] = static_cast <index_t> (numSlots);
+    numSlots += mesh.num (grobType) * numLocalSides;
+
+    if (numSlots >= NO_INDEX) {
+      throw LumeError () << "GrobSides: Too many side instances (" << numSlots << ").";
+    }
+
+    m_sideIndices [grobType].assign (mesh.num (grobType) * numLocalSides, NO_INDEX);
+  }
+
+  for (auto const sideType : m_sideSet) {
+    collect_sides (mesh, sideType);
+  }
+}
+
+void GrobSides::collect_sides (Mesh const& mesh, GrobType const sideType)
+{
+  index_t const sideDim = side_dim ();
+  size_t const numVertices = mesh.num (VERTEX);
+
+  std::array <LocalSideDescs, NUM_GROB_TYPES> localSideDescs;
+  for (auto const grobType : m_grobTypes) {
+    localSideDescs [grobType] = GetLocalSideDescs (grobType, sideDim);
+  }
+
+  std::atomic <bool> invalidCorner (false);
+
+//  calls `func (slot, minCorner)` in parallel for each instance of a side of type `sideType`
+  auto forEachSideInstance = [&] (auto const& func)
+  {
+    for (auto const grobType : m_grobTypes)
+    {
+      auto const& descs = localSideDescs [grobType];
+      bool const hasSideType = std::any_of (descs.begin (), descs.end (),
+                                            [sideType] (LocalSideDesc const& d) {return d.sideType == sideType;});
+      if (!hasSideType) {
+        continue;
+      }
+
+      auto const& grobs = mesh.grobs (grobType);
+      index_t const* corners = grobs.data ();
+      index_t const numCorners = grobs.grob_desc ().num_corners ();
+      index_t const numLocalSides = m_numLocalSides [grobType];
+      index_t const slotBase = m_slotBaseInds [grobType];
+
+      parallel_for (size_t (0), grobs.size (), [&] (size_t const grobIndex)
+      {
+        index_t const* grobCorners = corners + grobIndex * numCorners;
+        for (index_t side = 0; side < numLocalSides; ++side)
+        {
+          auto const& desc = descs [side];
+          if (desc.sideType != sideType) {
+            continue;
+          }
+
+          index_t minCorner = grobCorners [desc.corners [0]];
+          for (index_t i = 1; i < desc.numCorners; ++i) {
+            minCorner = std::min (minCorner, grobCorners [desc.corners [i]]);
+          }
+
+          if (minCorner >= numVertices) {
+            invalidCorner = true;
+            continue;
+          }
+
+          func (static_cast <index_t> (slotBase + grobIndex * numLocalSides + side), minCorner);
+        }
+      });
+    }
+  };
+
+//  returns the global corners of the side instance in the given slot
+  auto getSideCorners = [&] (index_t const slot, SideCorners& cornersOut) -> index_t
+  {
+    Incidence const inc = slot_to_incidence (slot);
+    auto const& grobs = mesh.grobs (inc.grob.grob_type ());
+    index_t const* grobCorners = grobs.data () + inc.grob.index () * grobs.grob_desc ().num_corners ();
+    auto const& desc = localSideDescs [inc.grob.grob_type ()][inc.localSide];
+
+    cornersOut.fill (0);
+    for (index_t i = 0; i < desc.numCorners; ++i) {
+      cornersOut [i] = grobCorners [desc.corners [i]];
+    }
+    return desc.numCorners;
+  };
+
+//  count the side instances in each bucket. A bucket contains all side instances
+//  whose smallest corner is the bucket's vertex.
+  std::vector <std::atomic <index_t>> bucketCursors (numVertices);
+  forEachSideInstance ([&bucketCursors] (index_t, index_t const minCorner) {
+    bucketCursors [minCorner].fetch_add (1, std::memory_order_relaxed);
+  });
+
+  if (invalidCorner) {
+    throw LumeError () << "GrobSides: Encountered a corner index which is not smaller "
+                          "than the number of vertices (" << numVertices << ").";
+  }
+
+  std::vector <index_t> bucketOffsets (numVertices + 1);
+  {
+    size_t offset = 0;
+    for (size_t i = 0; i < numVertices; ++i) {
+      bucketOffsets [i] = static_cast <index_t> (offset);
+      offset += bucketCursors [i].load (std::memory_order_relaxed);
+      bucketCursors [i].store (bucketOffsets [i], std::memory_order_relaxed);
+    }
+    bucketOffsets [numVertices] = static_cast <index_t> (offset);
+  }
+
+//  scatter the side instances to their buckets
+  std::vector <index_t> instances (bucketOffsets.back ());
+  forEachSideInstance ([&bucketCursors, &instances] (index_t const slot, index_t const minCorner) {
+    instances [bucketCursors [minCorner].fetch_add (1, std::memory_order_relaxed)] = slot;
+  });
+
+  bucketCursors.clear ();
+  bucketCursors.shrink_to_fit ();
+
+//  sort each bucket so that instances of the same side are consecutive and
+//  the first instance of each side is the one with the smallest slot
+  std::vector <index_t> numSidesInBucket (numVertices + 1, 0);
+  std::vector <char>    isFirstInstance (instances.size (), 0);
+
+  parallel_for_blocks (size_t (0), numVertices, [&] (size_t const bucketBegin, size_t const bucketEnd)
+  {
+    std::vector <SideKey> keys;
+    for (size_t bucket = bucketBegin; bucket < bucketEnd; ++bucket)
+    {
+      index_t const begin = bucketOffsets [bucket];
+      index_t const end   = bucketOffsets [bucket + 1];
+      if (begin == end) {
+        continue;
+      }
+
+      keys.resize (end - begin);
+      for (index_t i = begin; i < end; ++i)
+      {
+        SideKey& key = keys [i - begin];
+        key.slot = instances [i];
+        index_t const numCorners = getSideCorners (key.slot, key.corners);
+        std::sort (key.corners.begin (), key.corners.begin () + numCorners);
+      }
+
+      std::sort (keys.begin (), keys.end ());
+
+      index_t numSides = 0;
+      for (index_t i = begin; i < end; ++i)
+      {
+        instances [i] = keys [i - begin].slot;
+        if (i == begin || keys [i - begin].corners != keys [i - begin - 1].corners) {
+          isFirstInstance [i] = 1;
+          ++numSides;
+        }
+      }
+      numSidesInBucket [bucket] = numSides;
+    }
+  });
+
+//  numSidesInBucket now becomes the index of the first side in each bucket
+  {
+    index_t offset = 0;
+    for (auto& n : numSidesInBucket) {
+      index_t const tmp = n;
+      n = offset;
+      offset += tmp;
+    }
+  }
+
+  size_t const numSides = numSidesInBucket.back ();
+
+  auto& sides = m_sides [sideType];
+  auto& incidenceOffsets = m_incidenceOffsets [sideType];
+  sides.resize (numSides);
+  incidenceOffsets.resize (numSides + 1);
+  incidenceOffsets [numSides] = static_cast <index_t> (instances.size ());
+
+  index_t* sideCorners = sides.data ();
+  index_t const numSideCorners = sides.grob_desc ().num_corners ();
+
+  parallel_for (size_t (0), numVertices, [&] (size_t const bucket)
+  {
+    index_t sideIndex = numSidesInBucket [bucket];
+    for (index_t i = bucketOffsets [bucket]; i < bucketOffsets [bucket + 1]; ++i)
+    {
+      index_t const slot = instances [i];
+      if (isFirstInstance [i])
+      {
+        if (i != bucketOffsets [bucket]) {
+          ++sideIndex;
+        }
+
+        incidenceOffsets [sideIndex] = i;
+        SideCorners corners;
+        getSideCorners (slot, corners);
+        std::copy (corners.begin (), corners.begin () + numSideCorners,
+                   sideCorners + sideIndex * numSideCorners);
+      }
+
+      Incidence const inc = slot_to_incidence (slot);
+      m_sideIndices [inc.grob.grob_type ()][slot - m_slotBaseInds [inc.grob.grob_type ()]] = sideIndex;
+    }
+  });
+
+  m_incidences [sideType] = std::move (instances);
+}
+
+}// end of namespace lume
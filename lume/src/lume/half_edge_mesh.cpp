@@ -0,0 +1,199 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/half_edge_mesh.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+HalfEdgeMesh::HalfEdgeMesh (Mesh const& mesh)
+  : HalfEdgeMesh (mesh.grobs (TRI), mesh.grobs (QUAD), static_cast <index_t> (mesh.num (VERTEX)))
+{}
+
+HalfEdgeMesh::HalfEdgeMesh (GrobArray const& tris, GrobArray const& quads, index_t const numVertices)
+  : m_numTris (static_cast <index_t> (tris.size ()))
+  , m_numQuads (static_cast <index_t> (quads.size ()))
+{
+  if (tris.grob_type () != TRI || quads.grob_type () != QUAD)
+    throw LumeError () << "HalfEdgeMesh: Expected arrays of triangles and quadrilaterals.";
+
+  size_t const numHalfEdges = 3 * tris.size () + 4 * quads.size ();
+  if (numHalfEdges >= NO_INDEX)
+    throw LumeError () << "HalfEdgeMesh: Too many half-edges for 32 bit indices.";
+
+  m_next.resize (numHalfEdges);
+  m_twin.resize (numHalfEdges, NO_INDEX);
+  m_vertex.resize (numHalfEdges);
+  m_face.resize (numHalfEdges);
+
+  // half-edges of each face
+  std::atomic <bool> badCorner {false};
+  auto initFaces = [&] (GrobArray const& faces, index_t const firstFace, index_t const firstHalfEdge) {
+    index_t const numCorners = faces.grob_desc ().num_corners ();
+    index_t const* corners = faces.data ();
+    parallel_for_blocks (index_t (0), static_cast <index_t> (faces.size ()), [&, numCorners, corners] (index_t const begin,
+                                                                                                    index_t const end)
+    {
+      for (index_t f = begin; f < end; ++f) {
+        index_t const base = firstHalfEdge + f * numCorners;
+        for (index_t i = 0; i < numCorners; ++i) {
+          index_t const corner = corners [f * numCorners + i];
+          if (corner >= numVertices)
+            badCorner.store (true, std::memory_order_relaxed);
+          m_vertex [base + i] = corner;
+          m_next [base + i] = base + (i + 1) % numCorners;
+          m_face [base + i] = firstFace + f;
+        }
+      }
+    });
+  };
+
+  initFaces (tris, 0, 0);
+  initFaces (quads, m_numTris, 3 * m_numTris);
+
+  if (badCorner) {
+    throw LumeError () << "HalfEdgeMesh: Encountered a corner index which is not smaller "
+                          "than the number of vertices (" << numVertices << ").";
+  }
+
+  // counting sort of all half-edges by their smaller vertex
+  auto minVertex = [this] (index_t const h) {return std::min (m_vertex [h], dest (h));};
+  auto maxVertex = [this] (index_t const h) {return std::max (m_vertex [h], dest (h));};
+
+  std::unique_ptr <std::atomic <index_t> []> counters (new std::atomic <index_t> [numVertices]);
+  parallel_for_blocks (index_t (0), numVertices, [&] (index_t const begin, index_t const end) {
+    for (index_t i = begin; i < end; ++i)
+      counters [i].store (0, std::memory_order_relaxed);
+  });
+
+  index_t const numHalfEdgesIdx = static_cast <index_t> (numHalfEdges);
+  parallel_for_blocks (index_t (0), numHalfEdgesIdx, [&] (index_t const begin, index_t const end) {
+    for (index_t h = begin; h < end; ++h)
+      counters [minVertex (h)].fetch_add (1, std::memory_order_relaxed);
+  });
+
+  std::vector <index_t> offsets (numVertices + 1);
+  offsets [0] = 0;
+  for (index_t i = 0; i < numVertices; ++i) {
+    offsets [i + 1] = offsets [i] + counters [i].load (std::memory_order_relaxed);
+    counters [i].store (offsets [i], std::memory_order_relaxed);
+  }
+
+  std::vector <index_t> buckets (numHalfEdges);
+  parallel_for_blocks (index_t (0), numHalfEdgesIdx, [&] (index_t const begin, index_t const end) {
+    for (index_t h = begin; h < end; ++h)
+      buckets [counters [minVertex (h)].fetch_add (1, std::memory_order_relaxed)] = h;
+  });
+
+  // each half-edge is contained in exactly one bucket, so buckets can be matched independently
+  std::vector <char> nonManifold (numHalfEdges, 0);
+  parallel_for_blocks (index_t (0), numVertices, [&] (index_t const begin, index_t const end) {
+    for (index_t v = begin; v < end; ++v) {
+      auto const bucketBegin = buckets.begin () + offsets [v];
+      auto const bucketEnd = buckets.begin () + offsets [v + 1];
+      std::sort (bucketBegin, bucketEnd, [&] (index_t const h0, index_t const h1) {
+        return std::make_pair (maxVertex (h0), h0) < std::make_pair (maxVertex (h1), h1);
+      });
+
+      for (auto run = bucketBegin; run != bucketEnd;) {
+        index_t const other = maxVertex (*run);
+        auto runEnd = run + 1;
+        while (runEnd != bucketEnd && maxVertex (*runEnd) == other)
+          ++runEnd;
+
+        if (runEnd - run == 2 && m_vertex [run [0]] == dest (run [1])) {
+          m_twin [run [0]] = run [1];
+          m_twin [run [1]] = run [0];
+        }
+        else if (runEnd - run > 1) {
+          for (auto h = run; h != runEnd; ++h)
+            nonManifold [*h] = 1;
+        }
+        run = runEnd;
+      }
+    }
+  });
+
+  for (index_t h = 0; h < numHalfEdgesIdx; ++h) {
+    if (nonManifold [h])
+      m_nonManifoldHalfEdges.push_back (h);
+  }
+
+  // outgoing half-edges. Boundary half-edges are preferred, so that fans can be traversed from their start.
+  m_vertexHalfEdges.assign (numVertices, NO_INDEX);
+  std::vector <index_t> numOutgoing (numVertices, 0);
+  for (index_t h = 0; h < numHalfEdgesIdx; ++h) {
+    index_t const v = m_vertex [h];
+    ++numOutgoing [v];
+    if (m_vertexHalfEdges [v] == NO_INDEX || m_twin [h] == NO_INDEX)
+      m_vertexHalfEdges [v] = h;
+  }
+
+  // a vertex is manifold if its fan contains all of its outgoing half-edges
+  std::vector <char> nonManifoldVertex (numVertices, 0);
+  parallel_for_blocks (index_t (0), numVertices, [&] (index_t const begin, index_t const end) {
+    for (index_t v = begin; v < end; ++v) {
+      index_t numVisited = 0;
+      for_each_outgoing (v, [&numVisited] (index_t) {++numVisited;});
+      nonManifoldVertex [v] = numVisited != numOutgoing [v];
+    }
+  });
+
+  for (index_t v = 0; v < numVertices; ++v) {
+    if (nonManifoldVertex [v])
+      m_nonManifoldVertices.push_back (v);
+  }
+}
+
+GrobArray HalfEdgeMesh::grobs (GrobType const grobType) const
+{
+  if (grobType != TRI && grobType != QUAD)
+    throw LumeError () << "HalfEdgeMesh::grobs: Only TRI and QUAD are supported.";
+
+  index_t const numCorners = grobType == TRI ? 3 : 4;
+  index_t const firstFace = grobType == TRI ? 0 : m_numTris;
+  index_t const numFaces = grobType == TRI ? m_numTris : m_numQuads;
+
+  std::vector <index_t> corners (static_cast <size_t> (numCorners) * numFaces);
+  parallel_for_blocks (index_t (0), numFaces, [&] (index_t const begin, index_t const end) {
+    for (index_t f = begin; f < end; ++f) {
+      index_t h = face_half_edge (firstFace + f);
+      for (index_t i = 0; i < numCorners; ++i) {
+        corners [f * numCorners + i] = m_vertex [h];
+        h = m_next [h];
+      }
+    }
+  });
+
+  return GrobArray (grobType, std::move (corners));
+}
+
+}// end of namespace lume
@@ -0,0 +1,447 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/mesh_hierarchy.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <type_traits>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+namespace
+{
+  template <class T>
+  void CheckTupleSizes (ArrayAnnex <T> const& source, ArrayAnnex <T> const& target)
+  {
+    if (source.tuple_size () != target.tuple_size ()) {
+      throw BadTupleSizeError () << "MeshHierarchy: tuple sizes of source ("
+                                 << source.tuple_size () << ") and target annex ("
+                                 << target.tuple_size () << ") don't match.";
+    }
+  }
+
+  /// Type in which weighted sums of values of type `T` are computed.
+  /** Integral values are interpolated in double precision and rounded afterwards.*/
+  template <class T>
+  using weighted_t = std::conditional_t <std::is_integral <T>::value, double, T>;
+
+  template <class T>
+  T FromWeighted (weighted_t <T> const value)
+  {
+    if constexpr (std::is_integral <T>::value)
+      return static_cast <T> (std::llround (value));
+    else
+      return value;
+  }
+}// end of unnamed namespace
+
+
+MeshHierarchy::MeshHierarchy (SPMesh baseMesh)
+{
+  set_base_mesh (std::move (baseMesh));
+}
+
+void MeshHierarchy::set_base_mesh (SPMesh baseMesh)
+{
+  m_levels.clear ();
+  m_levels.emplace_back ();
+  m_levels.back ().mesh = std::move (baseMesh);
+}
+
+SPMesh MeshHierarchy::refine (RefinementCallback const& callback)
+{
+  RefineMesh (top_mesh (), [this, &callback] (Hierarchy& hierarchy) {
+    if (callback) {
+      callback (hierarchy);
+    }
+    add_level (hierarchy);
+  });
+
+  return top_mesh ();
+}
+
+void MeshHierarchy::add_level (Hierarchy const& hierarchy)
+{
+  if (m_levels.empty () || &hierarchy.parent_mesh () != m_levels.back ().mesh.get ()) {
+    throw LumeError () << "MeshHierarchy::add_level: The parent mesh of the given "
+                          "hierarchy has to be the top mesh of the mesh hierarchy.";
+  }
+
+  Level& parentLevel = m_levels.back ();
+  Mesh const& parentMesh = *parentLevel.mesh;
+  Level level;
+  level.mesh = hierarchy.shared_child_mesh ();
+  Mesh const& mesh = *level.mesh;
+
+//  child -> parent and parent -> children
+  for (index_t ichild = 0; ichild < NUM_GROB_TYPES; ++ichild)
+  {
+    GrobType const childType = static_cast <GrobType> (ichild);
+    auto const& relations = hierarchy.relationsForChildType (childType);
+    if (relations.empty ()) {
+      continue;
+    }
+
+    auto& parentIndices = level.parentIndices [childType];
+    auto& parentTypes   = level.parentTypes [childType];
+    parentIndices.assign (mesh.num (childType), NO_INDEX);
+    parentTypes.assign (mesh.num (childType), 0);
+
+    for (index_t iparent = 0; iparent < NUM_GROB_TYPES; ++iparent)
+    {
+      GrobType const parentType = static_cast <GrobType> (iparent);
+      bool const hasParentType = std::any_of (relations.begin (), relations.end (),
+                                              [parentType] (Hierarchy::Relation const& r) {
+                                                return r.parentIndex != NO_INDEX &&
+                                                       r.parent.grob_type () == parentType;
+                                              });
+      if (hasParentType) {
+        auto& childRange = parentLevel.childRanges [parentType][childType];
+        childRange.firstChild.assign (parentMesh.num (parentType), NO_INDEX);
+        childRange.numChildren.assign (parentMesh.num (parentType), 0);
+      }
+    }
+
+    parallel_for (relations.begin (), relations.end (), [&] (Hierarchy::Relation const& relation)
+    {
+      GrobType const parentType = relation.parent.grob_type ();
+      for (index_t child : relation) {
+        parentIndices [child] = relation.parentIndex;
+        parentTypes [child] = static_cast <std::uint8_t> (parentType);
+      }
+
+      if (relation.parentIndex != NO_INDEX) {
+        auto& childRange = parentLevel.childRanges [parentType][childType];
+        childRange.firstChild [relation.parentIndex] = relation.firstChild;
+        childRange.numChildren [relation.parentIndex] = relation.numChildren;
+      }
+    });
+  }
+
+//  vertex stencils
+  size_t const numVertices = mesh.num (VERTEX);
+  size_t const numParentVertices = parentMesh.num (VERTEX);
+  auto const& vertexRelations = hierarchy.relationsForChildType (VERTEX);
+
+  level.stencilOffsets.assign (numVertices + 1, 0);
+  parallel_for (vertexRelations.begin (), vertexRelations.end (), [&] (Hierarchy::Relation const& relation) {
+    for (index_t child : relation) {
+      level.stencilOffsets [child] = relation.parent.num_corners ();
+    }
+  });
+
+  {
+    index_t offset = 0;
+    for (auto& o : level.stencilOffsets) {
+      index_t const numEntries = o;
+      o = offset;
+      offset += numEntries;
+    }
+  }
+
+  level.stencilVertices.resize (level.stencilOffsets.back ());
+  parallel_for (vertexRelations.begin (), vertexRelations.end (), [&] (Hierarchy::Relation const& relation) {
+    for (index_t child : relation) {
+      index_t* stencil = level.stencilVertices.data () + level.stencilOffsets [child];
+      for (index_t i = 0; i < relation.parent.num_corners (); ++i) {
+        stencil [i] = relation.parent.corner (i);
+      }
+    }
+  });
+
+//  transposed vertex stencils
+  {
+    std::vector <std::atomic <index_t>> cursors (numParentVertices);
+    parallel_for (size_t (0), level.stencilVertices.size (), [&] (size_t const i) {
+      cursors [level.stencilVertices [i]].fetch_add (1, std::memory_order_relaxed);
+    });
+
+    auto& offsets = parentLevel.transposedStencilOffsets;
+    offsets.resize (numParentVertices + 1);
+    index_t offset = 0;
+    for (size_t i = 0; i < numParentVertices; ++i) {
+      offsets [i] = offset;
+      offset += cursors [i].load (std::memory_order_relaxed);
+      cursors [i].store (offsets [i], std::memory_order_relaxed);
+    }
+    offsets [numParentVertices] = offset;
+
+    auto& children = parentLevel.transposedStencilVertices;
+    children.resize (offset);
+    parallel_for (size_t (0), numVertices, [&] (size_t const child) {
+      for (index_t i = level.stencilOffsets [child]; i < level.stencilOffsets [child + 1]; ++i) {
+        children [cursors [level.stencilVertices [i]].fetch_add (1, std::memory_order_relaxed)]
+            = static_cast <index_t> (child);
+      }
+    });
+
+  //  sorting the children makes restriction results independent of scheduling
+    parallel_for (size_t (0), numParentVertices, [&] (size_t const i) {
+      std::sort (children.begin () + offsets [i], children.begin () + offsets [i + 1]);
+    });
+  }
+
+  m_levels.push_back (std::move (level));
+}
+
+GrobIndex MeshHierarchy::parent (size_t const level, GrobIndex const& child) const
+{
+  auto const& l = m_levels.at (level);
+  auto const& parentIndices = l.parentIndices [child.grob_type ()];
+  if (parentIndices.empty () || parentIndices [child.index ()] == NO_INDEX) {
+    return GrobIndex ();
+  }
+  return GrobIndex (static_cast <GrobType> (l.parentTypes [child.grob_type ()][child.index ()]),
+                    parentIndices [child.index ()]);
+}
+
+index_t MeshHierarchy::num_children (size_t const level, GrobIndex const& parent, GrobType const childType) const
+{
+  auto const& childRange = m_levels.at (level).childRanges [parent.grob_type ()][childType];
+  if (childRange.numChildren.empty ()) {
+    return 0;
+  }
+  return childRange.numChildren [parent.index ()];
+}
+
+index_t MeshHierarchy::first_child (size_t const level, GrobIndex const& parent, GrobType const childType) const
+{
+  auto const& childRange = m_levels.at (level).childRanges [parent.grob_type ()][childType];
+  if (childRange.firstChild.empty ()) {
+    return NO_INDEX;
+  }
+  return childRange.firstChild [parent.index ()];
+}
+
+index_t MeshHierarchy::num_stencil_vertices (size_t const level, index_t const vertex) const
+{
+  auto const& offsets = m_levels.at (level).stencilOffsets;
+  return offsets [vertex + 1] - offsets [vertex];
+}
+
+index_t const* MeshHierarchy::stencil_vertices (size_t const level, index_t const vertex) const
+{
+  auto const& l = m_levels.at (level);
+  return l.stencilVertices.data () + l.stencilOffsets [vertex];
+}
+
+template <class T>
+void MeshHierarchy::
+prolongate_annex (size_t const fineLevel,
+                  ArrayAnnex <T> const& coarseValues,
+                  GrobType const coarseType,
+                  ArrayAnnex <T>& fineValuesOut,
+                  GrobType const fineType) const
+{
+  if (fineLevel == 0 || fineLevel >= m_levels.size ()) {
+    throw LumeError () << "MeshHierarchy::prolongate_annex: Invalid fine level " << fineLevel;
+  }
+
+  CheckTupleSizes (coarseValues, fineValuesOut);
+
+  Level const& level = m_levels [fineLevel];
+  fineValuesOut.update (*level.mesh, fineType);
+
+  index_t const tupleSize = static_cast <index_t> (coarseValues.tuple_size ());
+  T const* coarse = coarseValues.data ();
+  T*       fine   = fineValuesOut.data ();
+
+  if (coarseType == VERTEX && fineType == VERTEX)
+  {
+    parallel_for (size_t (0), level.mesh->num (VERTEX), [&] (size_t const vrt)
+    {
+      index_t const begin = level.stencilOffsets [vrt];
+      index_t const end   = level.stencilOffsets [vrt + 1];
+      if (begin == end) {
+        return;
+      }
+
+      using W = weighted_t <T>;
+      W const weight = W (1) / static_cast <W> (end - begin);
+      for (index_t i = 0; i < tupleSize; ++i)
+      {
+        W value = 0;
+        for (index_t j = begin; j < end; ++j) {
+          value += coarse [level.stencilVertices [j] * tupleSize + i];
+        }
+        fine [vrt * tupleSize + i] = FromWeighted <T> (value * weight);
+      }
+    });
+  }
+  else
+  {
+    auto const& parentIndices = level.parentIndices [fineType];
+    auto const& parentTypes = level.parentTypes [fineType];
+    if (parentIndices.empty ()) {
+      return;
+    }
+
+    parallel_for (size_t (0), parentIndices.size (), [&] (size_t const child)
+    {
+      index_t const parent = parentIndices [child];
+      if (parent == NO_INDEX || parentTypes [child] != coarseType) {
+        return;
+      }
+
+      std::copy (coarse + parent * tupleSize,
+                 coarse + (parent + 1) * tupleSize,
+                 fine + child * tupleSize);
+    });
+  }
+}
+
+template <class T>
+void MeshHierarchy::
+restrict_annex (size_t const coarseLevel,
+                ArrayAnnex <T> const& fineValues,
+                GrobType const fineType,
+                ArrayAnnex <T>& coarseValuesOut,
+                GrobType const coarseType,
+                RestrictionType const restrictionType) const
+{
+  if (coarseLevel + 1 >= m_levels.size ()) {
+    throw LumeError () << "MeshHierarchy::restrict_annex: Invalid coarse level " << coarseLevel;
+  }
+
+  CheckTupleSizes (fineValues, coarseValuesOut);
+
+  Level const& level = m_levels [coarseLevel];
+  Level const& fineLevel = m_levels [coarseLevel + 1];
+  coarseValuesOut.update (*level.mesh, coarseType);
+
+  index_t const tupleSize = static_cast <index_t> (fineValues.tuple_size ());
+  T const* fine   = fineValues.data ();
+  T*       coarse = coarseValuesOut.data ();
+  auto const& childRange = level.childRanges [coarseType][fineType];
+
+  if (restrictionType == RestrictionType::Injection)
+  {
+    if (coarseType != VERTEX || fineType != VERTEX) {
+      throw LumeError () << "MeshHierarchy::restrict_annex: Injection is only supported for vertices.";
+    }
+
+    if (childRange.firstChild.empty ()) {
+      return;
+    }
+
+    parallel_for (size_t (0), childRange.firstChild.size (), [&] (size_t const vrt)
+    {
+      if (childRange.numChildren [vrt] == 0) {
+        return;
+      }
+      index_t const child = childRange.firstChild [vrt];
+      std::copy (fine + child * tupleSize, fine + (child + 1) * tupleSize, coarse + vrt * tupleSize);
+    });
+  }
+  else if (coarseType == VERTEX && fineType == VERTEX)
+  {
+    auto const& offsets  = level.transposedStencilOffsets;
+    auto const& children = level.transposedStencilVertices;
+
+    parallel_for (size_t (0), level.mesh->num (VERTEX), [&] (size_t const vrt)
+    {
+      index_t const begin = offsets [vrt];
+      index_t const end   = offsets [vrt + 1];
+      if (begin == end) {
+        return;
+      }
+
+      using W = weighted_t <T>;
+      W weightSum = 0;
+      for (index_t j = begin; j < end; ++j) {
+        weightSum += W (1) / static_cast <W> (fineLevel.stencilOffsets [children [j] + 1] -
+                                              fineLevel.stencilOffsets [children [j]]);
+      }
+
+      for (index_t i = 0; i < tupleSize; ++i)
+      {
+        W value = 0;
+        for (index_t j = begin; j < end; ++j)
+        {
+          index_t const child = children [j];
+          W const weight = W (1) / static_cast <W> (fineLevel.stencilOffsets [child + 1] -
+                                                    fineLevel.stencilOffsets [child]);
+          value += weight * fine [child * tupleSize + i];
+        }
+
+        if (restrictionType == RestrictionType::Average)
+          value /= weightSum;
+
+        coarse [vrt * tupleSize + i] = FromWeighted <T> (value);
+      }
+    });
+  }
+  else
+  {
+    if (childRange.firstChild.empty ()) {
+      return;
+    }
+
+    parallel_for (size_t (0), childRange.firstChild.size (), [&] (size_t const parent)
+    {
+      index_t const numChildren = childRange.numChildren [parent];
+      if (numChildren == 0) {
+        return;
+      }
+
+      index_t const firstChild = childRange.firstChild [parent];
+      for (index_t i = 0; i < tupleSize; ++i)
+      {
+        weighted_t <T> value = 0;
+        for (index_t child = firstChild; child < firstChild + numChildren; ++child) {
+          value += fine [child * tupleSize + i];
+        }
+
+        if (restrictionType == RestrictionType::Average)
+          value /= static_cast <weighted_t <T>> (numChildren);
+
+        coarse [parent * tupleSize + i] = FromWeighted <T> (value);
+      }
+    });
+  }
+}
+
+template void MeshHierarchy::prolongate_annex <real_t> (size_t, ArrayAnnex <real_t> const&, GrobType,
+                                                         ArrayAnnex <real_t>&, GrobType) const;
+template void MeshHierarchy::prolongate_annex <double> (size_t, ArrayAnnex <double> const&, GrobType,
+                                                         ArrayAnnex <double>&, GrobType) const;
+template void MeshHierarchy::prolongate_annex <index_t> (size_t, ArrayAnnex <index_t> const&, GrobType,
+                                                          ArrayAnnex <index_t>&, GrobType) const;
+template void MeshHierarchy::prolongate_annex <int> (size_t, ArrayAnnex <int> const&, GrobType,
+                                                      ArrayAnnex <int>&, GrobType) const;
+template void MeshHierarchy::restrict_annex <real_t> (size_t, ArrayAnnex <real_t> const&, GrobType,
+                                                       ArrayAnnex <real_t>&, GrobType, RestrictionType) const;
+template void MeshHierarchy::restrict_annex <double> (size_t, ArrayAnnex <double> const&, GrobType,
+                                                       ArrayAnnex <double>&, GrobType, RestrictionType) const;
+template void MeshHierarchy::restrict_annex <index_t> (size_t, ArrayAnnex <index_t> const&, GrobType,
+                                                        ArrayAnnex <index_t>&, GrobType, RestrictionType) const;
+template void MeshHierarchy::restrict_annex <int> (size_t, ArrayAnnex <int> const&, GrobType,
+                                                    ArrayAnnex <int>&, GrobType, RestrictionType) const;
+
+}// end of namespace lume
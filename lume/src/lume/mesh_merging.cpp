@@ -0,0 +1,224 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/mesh_merging.h>
+
+#include <functional>
+#include <map>
+#include <lume/array_annex.h>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+#include <lume/subset_info_annex.h>
+#include <lume/vertex_welding.h>
+
+namespace lume
+{
+
+namespace
+{
+  constexpr size_t g_chunkSize = 1 << 16;
+
+  using CopyJobs = std::vector <std::function <void ()>>;
+
+  /// Adds jobs which call `func (begin, end)` for chunks of the range `[0, num)`.
+  template <class TFunc>
+  void AddChunkedJobs (CopyJobs& jobs, size_t const num, TFunc const& func)
+  {
+    for (size_t begin = 0; begin < num; begin += g_chunkSize) {
+      size_t const end = std::min (num, begin + g_chunkSize);
+      jobs.push_back ([func, begin, end] () {func (begin, end);});
+    }
+  }
+
+  bool IsSubsetInfoKey (Mesh const& mesh, AnnexKey const& key)
+  {
+    return !key.grob_type ()
+           && dynamic_cast <SubsetInfoAnnex const*> (&mesh.untyped_annex (key)) != nullptr;
+  }
+}// end of unnamed namespace
+
+
+SPMesh MergeMeshes (std::vector <CSPMesh> const& meshes, MergeOptions const& options)
+{
+  size_t const numMeshes = meshes.size ();
+
+  // offsets of the grobs of each mesh in the merged grob arrays
+  std::array <std::vector <index_t>, NUM_GROB_TYPES> offsets;
+  for (index_t gt = 0; gt < NUM_GROB_TYPES; ++gt) {
+    offsets [gt].resize (numMeshes + 1, 0);
+    for (size_t imesh = 0; imesh < numMeshes; ++imesh) {
+      offsets [gt][imesh + 1] = offsets [gt][imesh]
+                                + static_cast <index_t> (meshes [imesh]->num (static_cast <GrobType> (gt)));
+    }
+  }
+  auto const& vrtOffsets = offsets [VERTEX];
+
+  // merge subset tables. For each table and mesh, store the merged index of each local subset.
+  std::map <std::string, SubsetInfoAnnex> subsetInfos;
+  std::map <std::string, std::vector <std::vector <index_t>>> subsetMaps;
+  for (size_t imesh = 0; imesh < numMeshes; ++imesh) {
+    auto const& mesh = *meshes [imesh];
+    for (auto const& key : mesh.annex_keys ()) {
+      if (!IsSubsetInfoKey (mesh, key))
+        continue;
+
+      auto const& localInfo = dynamic_cast <SubsetInfoAnnex const&> (mesh.untyped_annex (key));
+      auto& mergedInfo = subsetInfos.try_emplace (key.name (), localInfo.name ()).first->second;
+      auto& localMaps = subsetMaps [key.name ()];
+      localMaps.resize (numMeshes);
+      auto& localMap = localMaps [imesh];
+
+      for (index_t i = 0; i < localInfo.num_subset_properties (); ++i) {
+        auto const& props = localInfo.subset_properties (i);
+        index_t merged = NO_INDEX;
+        for (index_t j = 0; j < mergedInfo.num_subset_properties (); ++j) {
+          if (mergedInfo.subset_properties (j).name == props.name) {
+            merged = j;
+            break;
+          }
+        }
+        if (merged == NO_INDEX) {
+          merged = mergedInfo.num_subset_properties ();
+          mergedInfo.add_subset (props);
+        }
+        localMap.push_back (merged);
+      }
+    }
+  }
+
+  auto mergedMesh = std::make_shared <Mesh> ();
+  mergedMesh->resize_vertices (vrtOffsets.back ());
+
+  CopyJobs jobs;
+
+  // grob arrays
+  for (index_t igt = 0; igt < NUM_GROB_TYPES; ++igt) {
+    GrobType const gt = static_cast <GrobType> (igt);
+    if (gt == VERTEX || offsets [gt].back () == 0)
+      continue;
+
+    index_t const numCorners = GrobDesc (gt).num_corners ();
+    mergedMesh->set_grobs (GrobArray (gt, std::vector <index_t> (offsets [gt].back () * numCorners)));
+    index_t* mergedCorners = mergedMesh->grobs (gt).data ();
+
+    for (size_t imesh = 0; imesh < numMeshes; ++imesh) {
+      if (!meshes [imesh]->has (gt))
+        continue;
+
+      index_t const* corners = meshes [imesh]->grobs (gt).data ();
+      index_t* dest = mergedCorners + offsets [gt][imesh] * numCorners;
+      index_t const vrtOffset = vrtOffsets [imesh];
+      AddChunkedJobs (jobs, meshes [imesh]->num_indices (gt),
+                      [corners, dest, vrtOffset] (size_t const begin, size_t const end) {
+                        for (size_t i = begin; i < end; ++i)
+                          dest [i] = corners [i] + vrtOffset;
+                      });
+    }
+  }
+
+  // array annexes of vertices and grobs
+  std::vector <AnnexKey> handledKeys;
+  auto isHandled = [&handledKeys] (AnnexKey const& key) {
+    for (auto const& k : handledKeys) {
+      if (k.name () == key.name () && k.grob_type () == key.grob_type ())
+        return true;
+    }
+    return false;
+  };
+
+  for (size_t ifirst = 0; ifirst < numMeshes; ++ifirst) {
+    for (auto const& key : meshes [ifirst]->annex_keys ()) {
+      if (!key.grob_type () || isHandled (key))
+        continue;
+
+      GrobType const gt = *key.grob_type ();
+      auto const subsetMapIter = subsetMaps.find (key.name ());
+      bool const isSubsetAnnex = subsetMapIter != subsetMaps.end ();
+
+      VisitArrayAnnex (meshes [ifirst]->untyped_annex (key), [&] (auto const& firstAnnex) {
+        using annex_t = std::decay_t <decltype (firstAnnex)>;
+        using value_t = typename annex_t::value_type;
+        size_t const tupleSize = firstAnnex.tuple_size ();
+
+        handledKeys.push_back (key);
+        TypedAnnexKey <annex_t> const typedKey (key.name (), gt);
+        mergedMesh->set_annex (typedKey,
+                               annex_t (tupleSize, std::vector <value_t> (offsets [gt].back () * tupleSize)));
+        value_t* mergedData = mergedMesh->annex (typedKey).data ();
+
+        for (size_t imesh = ifirst; imesh < numMeshes; ++imesh) {
+          auto const& mesh = *meshes [imesh];
+          if (!mesh.has_annex (key))
+            continue;
+
+          auto const* annex = dynamic_cast <annex_t const*> (&mesh.untyped_annex (key));
+          if (!annex) {
+            throw AnnexTypeError () << "MergeMeshes: Incompatible types of annex '" << key.name ()
+                                    << "' in meshes " << ifirst << " and " << imesh;
+          }
+          if (annex->tuple_size () != tupleSize) {
+            throw BadTupleSizeError () << "MergeMeshes: Tuple sizes of annex '" << key.name ()
+                                       << "' differ in meshes " << ifirst << " and " << imesh;
+          }
+
+          size_t const num = std::min <size_t> (annex->size (), mesh.num (gt) * tupleSize);
+          value_t const* src = annex->data ();
+          value_t* dest = mergedData + offsets [gt][imesh] * tupleSize;
+
+          bool remapped = false;
+          if constexpr (std::is_same <value_t, index_t>::value) {
+            if (isSubsetAnnex && !subsetMapIter->second [imesh].empty ()) {
+              std::vector <index_t> const* subsetMap = &subsetMapIter->second [imesh];
+              AddChunkedJobs (jobs, num, [src, dest, subsetMap] (size_t const begin, size_t const end) {
+                for (size_t i = begin; i < end; ++i) {
+                  // subset indices outside of the local table are kept
+                  dest [i] = src [i] < subsetMap->size () ? (*subsetMap) [src [i]] : src [i];
+                }
+              });
+              remapped = true;
+            }
+          }
+
+          if (!remapped) {
+            AddChunkedJobs (jobs, num, [src, dest] (size_t const begin, size_t const end) {
+              std::copy (src + begin, src + end, dest + begin);
+            });
+          }
+        }
+      });
+    }
+  }
+
+  parallel_for (jobs, [] (std::function <void ()>& job) {job ();});
+
+  for (auto& entry : subsetInfos)
+    mergedMesh->set_annex (AnnexKey (entry.first), std::move (entry.second));
+
+  if (options.weldVertices)
+    WeldVertices (*mergedMesh, options.weldTolerance);
+
+  return mergedMesh;
+}
+
+}// end of namespace lume
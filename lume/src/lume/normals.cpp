@@ -24,27 +24,189 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <cmath>
+#include <vector>
+
 #include "lume/array_annex.h"
+#include "lume/derived_data.h"
 #include "lume/normals.h"
 #include "lume/mesh.h"
-#include "lume/math/geometry.h"
-#include "lume/math/tuple_view.h"
+#include "lume/parallel_for.h"
+#include "lume/math/raw/vector_math_raw.h"
 
 namespace lume {
 
-void ComputeFaceVertexNormals3 (Mesh& mesh)
+namespace {
+
+/// Faces of a mesh which are considered during normal computations: all triangles followed by all quadrilaterals.
+struct NormalFaces
 {
-    if (!mesh.has_annex (keys::vertexCoords))
-        throw NoSuchAnnexError () << keys::vertexCoords.name ();
+    NormalFaces (Mesh const& mesh)
+        : triCorners (mesh.grobs (TRI).data ())
+        , quadCorners (mesh.grobs (QUAD).data ())
+        , numTris (mesh.num (TRI))
+        , numQuads (mesh.num (QUAD))
+    {}
+
+    size_t num () const                 {return numTris + numQuads;}
+    index_t num_corners (size_t const iface) const  {return iface < numTris ? 3 : 4;}
+
+    index_t const* corners (size_t const iface) const
+    {
+        return iface < numTris ? triCorners + 3 * iface : quadCorners + 4 * (iface - numTris);
+    }
+
+    index_t const* triCorners;
+    index_t const* quadCorners;
+    size_t numTris;
+    size_t numQuads;
+};
+
+/// Computes normals whose lengths equal the areas of the faces
+/** For triangles `cross (p1 - p0, p2 - p0) / 2` is computed, for quadrilaterals
+    `cross (p2 - p0, p3 - p1) / 2`.*/
+template <index_t numCorners>
+void ComputeAreaNormals (real_t* normalsOut,
+                         index_t const* corners,
+                         size_t const numFaces,
+                         real_t const* coords)
+{
+    parallel_for_blocks (size_t (0), numFaces, [=] (size_t const begin, size_t const end) {
+        for (size_t iface = begin; iface < end; ++iface) {
+            index_t const* c = corners + iface * numCorners;
+            real_t d0 [3], d1 [3];
+            if constexpr (numCorners == 3) {
+                math::raw::VecSubtract (d0, 3, coords + 3 * c [1], coords + 3 * c [0]);
+                math::raw::VecSubtract (d1, 3, coords + 3 * c [2], coords + 3 * c [0]);
+            }
+            else {
+                math::raw::VecSubtract (d0, 3, coords + 3 * c [2], coords + 3 * c [0]);
+                math::raw::VecSubtract (d1, 3, coords + 3 * c [3], coords + 3 * c [1]);
+            }
+
+            real_t* n = normalsOut + 3 * iface;
+            math::raw::VecCross3 (n, d0, d1);
+            math::raw::VecScaleInplace (n, 3, real_t (0.5));
+        }
+    });
+}
+
+std::vector <real_t> ComputeAreaNormals (NormalFaces const& faces, real_t const* coords)
+{
+    std::vector <real_t> normals (3 * faces.num ());
+    ComputeAreaNormals <3> (normals.data (), faces.triCorners, faces.numTris, coords);
+    ComputeAreaNormals <4> (normals.data () + 3 * faces.numTris, faces.quadCorners, faces.numQuads, coords);
+    return normals;
+}
+
+/// Index of the given vertex in the corner list of a face
+index_t LocalCornerIndex (NormalFaces const& faces, size_t const iface, size_t const vertex)
+{
+    index_t const* c = faces.corners (iface);
+    index_t i = 0;
+    while (i + 1 < faces.num_corners (iface) && c [i] != vertex)
+        ++i;
+    return i;
+}
+
+/// Interior angle of a face at its local corner `icorner`
+real_t CornerAngle (NormalFaces const& faces, size_t const iface, index_t const icorner, real_t const* coords)
+{
+    index_t const* c = faces.corners (iface);
+    index_t const numCorners = faces.num_corners (iface);
+    real_t const* p = coords + 3 * c [icorner];
+
+    real_t d0 [3], d1 [3];
+    math::raw::VecSubtract (d0, 3, coords + 3 * c [(icorner + 1) % numCorners], p);
+    math::raw::VecSubtract (d1, 3, coords + 3 * c [(icorner + numCorners - 1) % numCorners], p);
+
+    real_t const l = math::raw::VecLen (d0, 3) * math::raw::VecLen (d1, 3);
+    if (l == 0)
+        return 0;
+
+    real_t const cosAngle = math::raw::VecDot (d0, 3, d1) / l;
+    return std::acos (std::min (real_t (1), std::max (real_t (-1), cosAngle)));
+}
+
+void ComputeVertexNormals3 (Mesh const& mesh,
+                            real_t const* coords,
+                            real_t* normalsOut,
+                            size_t const numVertices,
+                            NormalWeighting const weighting)
+{
+    NormalFaces const faces (mesh);
+    std::vector <real_t> const areaNormals = ComputeAreaNormals (faces, coords);
+    auto const incidence = CachedVertexIncidence (mesh, FACES);
 
-    ComputeFaceVertexNormals3 (mesh,
-                               mesh.annex (keys::vertexCoords),
-                               mesh.annex (keys::vertexNormals));
+    parallel_for_blocks (size_t (0), numVertices, [&] (size_t const begin, size_t const end) {
+        for (size_t ivrt = begin; ivrt < end; ++ivrt) {
+            real_t* n = normalsOut + 3 * ivrt;
+            math::raw::VecSet (n, 3, 0);
+
+            if (ivrt >= incidence->num_vertices ())
+                continue;
+
+            for (GrobType const faceType : {TRI, QUAD}) {
+                size_t const faceOffset = faceType == TRI ? 0 : faces.numTris;
+                for (index_t const ifaceOfType : incidence->incidences (static_cast <index_t> (ivrt), faceType)) {
+                    size_t const iface = faceOffset + ifaceOfType;
+                    real_t const* faceNormal = areaNormals.data () + 3 * iface;
+
+                    real_t weight = 1;
+                    if (weighting != NormalWeighting::Area) {
+                        real_t const area = math::raw::VecLen (faceNormal, 3);
+                        if (area == 0)
+                            continue;
+                        weight /= area;
+                        if (weighting == NormalWeighting::Angle)
+                            weight *= CornerAngle (faces, iface, LocalCornerIndex (faces, iface, ivrt), coords);
+                    }
+
+                    math::raw::VecAxpy (n, 3, weight, faceNormal);
+                }
+            }
+
+            math::raw::VecNormalizeInplace (n, 3);
+        }
+    });
+}
+
+}// end of unnamed namespace
+
+
+void ComputeFaceVertexNormals3 (Mesh& mesh)
+{
+    ComputeVertexNormals3 (mesh, NormalWeighting::Uniform);
 }
 
 void ComputeFaceVertexNormals3 (Mesh& mesh,
                                 math::ConstTupleView <real_t> coords,
                                 math::TupleView <real_t> normals)
+{
+    ComputeVertexNormals3 (static_cast <Mesh const&> (mesh),
+                           math::ConstTupleView <real_t> (coords.data (), coords.size (), coords.tuple_size ()),
+                           math::TupleView <real_t> (normals.data (), normals.size (), normals.tuple_size ()),
+                           NormalWeighting::Uniform);
+}
+
+void ComputeVertexNormals3 (Mesh& mesh, NormalWeighting const weighting)
+{
+    if (!mesh.has_annex (keys::vertexCoords))
+        throw NoSuchAnnexError () << keys::vertexCoords.name ();
+
+    if (!mesh.has_annex (keys::vertexNormals))
+        mesh.set_annex (keys::vertexNormals, RealArrayAnnex (3));
+
+    ComputeVertexNormals3 (mesh,
+                           mesh.annex (keys::vertexCoords),
+                           mesh.annex (keys::vertexNormals),
+                           weighting);
+}
+
+void ComputeVertexNormals3 (Mesh const& mesh,
+                            math::ConstTupleView <real_t> coords,
+                            math::TupleView <real_t> normals,
+                            NormalWeighting const weighting)
 {
     if (coords.tuple_size() != 3)
         throw BadTupleSizeError () << coords.tuple_size();
@@ -55,19 +217,24 @@ void ComputeFaceVertexNormals3 (Mesh& mesh,
     if (normals.size () != coords.size ())
         throw AnnexError () << "Provided coordinate and normal annexes have different size.";
 
-    normals = 0;
+    ComputeVertexNormals3 (mesh, coords.data (), normals.data (), coords.size (), weighting);
+}
 
-    for (auto const grob : mesh.grobs (TRI))
-    {
-        std::array <real_t, 3> n;
-        math::TriangleNormal3 (n, coords [grob.corner (0)], coords [grob.corner (1)], coords [grob.corner (2)]);
+void ComputeFaceNormals3 (Mesh& mesh)
+{
+    auto const& coords = mesh.annex (keys::vertexCoords);
+    if (coords.tuple_size() != 3)
+        throw BadTupleSizeError () << coords.tuple_size();
 
-        for(int i = 0; i < 3; ++i) {
-            normals [grob.corner (i)] += n;
-        }
-    }
+    NormalFaces const faces (mesh);
+    std::vector <real_t> normals = ComputeAreaNormals (faces, coords.data ());
+    math::raw::VecTupNormalizeInplace <3> (normals.data (), normals.size ());
 
-    normals.normalize ();
+    auto const quadsBegin = normals.begin () + 3 * faces.numTris;
+    if (faces.numTris > 0)
+        mesh.set_annex (keys::triNormals, RealArrayAnnex (3, std::vector <real_t> (normals.begin (), quadsBegin)));
+    if (faces.numQuads > 0)
+        mesh.set_annex (keys::quadNormals, RealArrayAnnex (3, std::vector <real_t> (quadsBegin, normals.end ())));
 }
 
 }// end of namespace lume
@@ -0,0 +1,257 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/orientation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <lume/array_annex.h>
+#include <lume/derived_data.h>
+#include <lume/parallel_for.h>
+#include <lume/math/raw/vector_math_raw.h>
+
+namespace lume
+{
+
+namespace
+{
+
+constexpr index_t g_maxFaceCorners = 4;
+constexpr size_t g_minParallelFrontier = 1024;
+
+enum FaceState : uint8_t {
+  Unvisited = 0,
+  Keep      = 1,
+  Flip      = 2
+};
+
+/// Gives access to the corners of all triangles followed by all quadrilaterals
+struct FaceCorners
+{
+  explicit FaceCorners (Mesh& mesh)
+    : tris (mesh.grobs (TRI).data ())
+    , quads (mesh.grobs (QUAD).data ())
+    , numTris (static_cast <index_t> (mesh.num (TRI)))
+    , numFaces (static_cast <index_t> (mesh.num (TRI) + mesh.num (QUAD)))
+  {}
+
+  index_t num_corners (index_t const face) const  {return face < numTris ? 3 : 4;}
+  index_t* corners (index_t const face) const     {return face < numTris ? tris + 3 * face : quads + 4 * (face - numTris);}
+  GrobIndex grob_index (index_t const face) const {return face < numTris ? GrobIndex (TRI, face) : GrobIndex (QUAD, face - numTris);}
+  index_t face_index (GrobIndex const& gi) const  {return gi.grob_type () == TRI ? gi.index () : numTris + gi.index ();}
+
+  /// Returns true if the face traverses the edge from `c0` to `c1`
+  bool traverses (index_t const face, index_t const c0, index_t const c1) const
+  {
+    index_t const* c = corners (face);
+    index_t const n = num_corners (face);
+    for (index_t i = 0; i < n; ++i) {
+      if (c [i] == c0)
+        return c [(i + 1) % n] == c1;
+    }
+    return false;
+  }
+
+  void flip (index_t const face) const
+  {
+    index_t* c = corners (face);
+    std::reverse (c + 1, c + num_corners (face));
+  }
+
+  index_t* tris;
+  index_t* quads;
+  index_t  numTris;
+  index_t  numFaces;
+};
+
+/// Six times the signed volume of the tetrahedron spanned by the origin and the given triangle
+real_t SignedVolume6 (real_t const* coords, index_t const i0, index_t const i1, index_t const i2)
+{
+  real_t cross [3];
+  math::raw::VecCross3 (cross, coords + 3 * i1, coords + 3 * i2);
+  return math::raw::VecDot (coords + 3 * i0, 3, cross);
+}
+
+}// end of unnamed namespace
+
+
+OrientationInfo OrientFacesConsistently (Mesh& mesh)
+{
+  OrientationInfo info;
+  FaceCorners const faces (mesh);
+  index_t const numFaces = faces.numFaces;
+  if (numFaces == 0)
+    return info;
+
+  auto const sides = CachedGrobSides (mesh, FACES, EDGES);
+  GrobArray const& edges = sides->sides (EDGE);
+
+  // neighbors across manifold edges. `sameDirection` is set if both faces traverse
+  // the shared edge in the same direction, i.e., if they are oriented inconsistently.
+  std::vector <index_t> neighbors (numFaces * g_maxFaceCorners, NO_INDEX);
+  std::vector <char> sameDirection (numFaces * g_maxFaceCorners, 0);
+  std::vector <char> hasOpenEdge (numFaces, 0);
+
+  parallel_for_blocks (index_t (0), numFaces, [&] (index_t const begin, index_t const end) {
+    for (index_t face = begin; face < end; ++face) {
+      GrobIndex const gi = faces.grob_index (face);
+      for (index_t i = 0; i < faces.num_corners (face); ++i) {
+        index_t const edge = sides->side_index (gi, i);
+        GrobIndex const edgeIndex (EDGE, edge);
+        if (sides->num_incidences (edgeIndex) != 2) {
+          hasOpenEdge [face] = 1;
+          continue;
+        }
+
+        GrobSides::Incidence other = sides->incidence (edgeIndex, 0);
+        if (faces.face_index (other.grob) == face && other.localSide == i)
+          other = sides->incidence (edgeIndex, 1);
+
+        index_t const nbr = faces.face_index (other.grob);
+        index_t const c0 = edges [edge].corner (0);
+        index_t const c1 = edges [edge].corner (1);
+        neighbors [face * g_maxFaceCorners + i] = nbr;
+        sameDirection [face * g_maxFaceCorners + i] = faces.traverses (face, c0, c1) == faces.traverses (nbr, c0, c1);
+      }
+    }
+  });
+
+  // propagate orientations
+  std::unique_ptr <std::atomic <uint8_t> []> states (new std::atomic <uint8_t> [numFaces]);
+  for (index_t i = 0; i < numFaces; ++i)
+    states [i].store (Unvisited, std::memory_order_relaxed);
+
+  std::vector <index_t> components (numFaces);
+  std::vector <char> orientable;
+  std::vector <index_t> frontier, nextFrontier;
+
+  for (index_t seed = 0; seed < numFaces; ++seed) {
+    if (states [seed].load (std::memory_order_relaxed) != Unvisited)
+      continue;
+
+    index_t const component = info.numComponents++;
+    std::atomic <bool> conflict {false};
+    states [seed].store (Keep, std::memory_order_relaxed);
+    components [seed] = component;
+    frontier.assign (1, seed);
+
+    auto visit = [&] (size_t const begin, size_t const end, std::vector <index_t>& visitedOut) {
+      for (size_t i = begin; i < end; ++i) {
+        index_t const face = frontier [i];
+        bool const flipFace = states [face].load (std::memory_order_relaxed) == Flip;
+        for (index_t j = 0; j < faces.num_corners (face); ++j) {
+          index_t const nbr = neighbors [face * g_maxFaceCorners + j];
+          if (nbr == NO_INDEX)
+            continue;
+
+          uint8_t const required = (flipFace != bool (sameDirection [face * g_maxFaceCorners + j])) ? Flip : Keep;
+          uint8_t expected = Unvisited;
+          if (states [nbr].compare_exchange_strong (expected, required, std::memory_order_relaxed)) {
+            components [nbr] = component;
+            visitedOut.push_back (nbr);
+          }
+          else if (expected != required)
+            conflict.store (true, std::memory_order_relaxed);
+        }
+      }
+    };
+
+    while (!frontier.empty ()) {
+      nextFrontier.clear ();
+      if (frontier.size () < g_minParallelFrontier)
+        visit (0, frontier.size (), nextFrontier);
+      else {
+        size_t const numChunks = (frontier.size () + g_minParallelFrontier - 1) / g_minParallelFrontier;
+        std::vector <std::vector <index_t>> chunks (numChunks);
+        parallel_for (size_t (0), numChunks, [&] (size_t const ichunk) {
+          visit (ichunk * g_minParallelFrontier,
+                 std::min (frontier.size (), (ichunk + 1) * g_minParallelFrontier),
+                 chunks [ichunk]);
+        }, 1);
+        for (auto const& chunk : chunks)
+          nextFrontier.insert (nextFrontier.end (), chunk.begin (), chunk.end ());
+      }
+      frontier.swap (nextFrontier);
+    }
+
+    orientable.push_back (!conflict.load ());
+    if (!orientable.back ())
+      info.nonOrientableComponents.push_back (faces.grob_index (seed));
+  }
+
+  // choose the orientation of each component
+  real_t const* coords = nullptr;
+  if (mesh.has_annex (keys::vertexCoords) && mesh.annex (keys::vertexCoords).tuple_size () == 3)
+    coords = mesh.annex (keys::vertexCoords).data ();
+
+  std::vector <char> closed (info.numComponents, coords != nullptr);
+  std::vector <double> volumes (info.numComponents, 0);
+  std::vector <index_t> numFlips (info.numComponents, 0);
+  std::vector <index_t> sizes (info.numComponents, 0);
+
+  for (index_t face = 0; face < numFaces; ++face) {
+    index_t const component = components [face];
+    bool const flip = states [face].load (std::memory_order_relaxed) == Flip;
+    ++sizes [component];
+    numFlips [component] += flip;
+    if (hasOpenEdge [face])
+      closed [component] = 0;
+
+    if (coords && closed [component]) {
+      index_t const* c = faces.corners (face);
+      real_t vol = SignedVolume6 (coords, c [0], c [1], c [2]);
+      if (faces.num_corners (face) == 4)
+        vol += SignedVolume6 (coords, c [0], c [2], c [3]);
+      volumes [component] += flip ? -vol : vol;
+    }
+  }
+
+  std::vector <char> invert (info.numComponents, 0);
+  for (index_t i = 0; i < info.numComponents; ++i)
+    invert [i] = closed [i] ? volumes [i] < 0 : 2 * numFlips [i] > sizes [i];
+
+  std::atomic <index_t> numFlipped {0};
+  parallel_for_blocks (index_t (0), numFaces, [&] (index_t const begin, index_t const end) {
+    index_t localNumFlipped = 0;
+    for (index_t face = begin; face < end; ++face) {
+      index_t const component = components [face];
+      bool const flip = states [face].load (std::memory_order_relaxed) == Flip;
+      if (orientable [component] && flip != bool (invert [component])) {
+        faces.flip (face);
+        ++localNumFlipped;
+      }
+    }
+    numFlipped += localNumFlipped;
+  });
+
+  info.numFlippedFaces = numFlipped;
+  if (info.numFlippedFaces > 0)
+    mesh.invalidate_derived_data ();
+
+  return info;
+}
+
+}// end of namespace lume
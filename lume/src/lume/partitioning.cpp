@@ -0,0 +1,1047 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/partitioning.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <future>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <lume/derived_data.h>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+#include <lume/subset_info_annex.h>
+#include <lume/math/grob_math.h>
+
+namespace lume
+{
+
+namespace
+{
+
+/// Numbers the grobs of a grob set consecutively, type by type in the order of the grob set
+struct GrobNumbering
+{
+  GrobNumbering (Mesh const& mesh, GrobSet const grobSet)
+  {
+    for (auto const grobType : grobSet) {
+      baseInds [grobType] = num;
+      num += static_cast <index_t> (mesh.num (grobType));
+      grobTypes.push_back (grobType);
+    }
+  }
+
+  index_t global_index (GrobIndex const& grob) const {return baseInds [grob.grob_type ()] + grob.index ();}
+
+  GrobIndex grob_index (index_t const globalIndex) const
+  {
+    GrobType grobType = grobTypes.front ();
+    for (auto const t : grobTypes) {
+      if (baseInds [t] <= globalIndex)
+        grobType = t;
+    }
+    return GrobIndex (grobType, globalIndex - baseInds [grobType]);
+  }
+
+  std::array <index_t, NUM_GROB_TYPES> baseInds {};
+  std::vector <GrobType>               grobTypes;
+  index_t                              num {0};
+};
+
+/// Undirected graph with vertex and edge weights in compressed row storage
+struct Graph
+{
+  index_t num_vertices () const           {return static_cast <index_t> (vertexWeights.size ());}
+  index_t total_weight () const           {return std::accumulate (vertexWeights.begin (), vertexWeights.end (), index_t (0));}
+
+  std::vector <index_t> offsets {0};
+  std::vector <index_t> adjacent;
+  std::vector <index_t> edgeWeights;
+  std::vector <index_t> vertexWeights;
+};
+
+/// Connects grobs which share a side of dimension `grobSet.dim () - 1`.
+Graph DualGraph (Mesh const& mesh, GrobSet const grobSet, GrobNumbering const& numbering)
+{
+  Graph graph;
+  graph.vertexWeights.assign (numbering.num, 1);
+  graph.offsets.assign (numbering.num + 1, 0);
+
+  if (grobSet.dim () == 0)
+    return graph;
+
+  GrobSet const sideSet = GrobSetTypeByDim (grobSet.dim () - 1);
+  auto const sides = CachedGrobSides (mesh, grobSet, sideSet);
+
+  auto forEachEdge = [&] (auto const& func) {
+    for (auto const sideType : sideSet) {
+      for (index_t iside = 0; iside < sides->num_sides (sideType); ++iside) {
+        GrobIndex const side (sideType, iside);
+        index_t const numIncidences = sides->num_incidences (side);
+        for (index_t i = 0; i < numIncidences; ++i) {
+          index_t const a = numbering.global_index (sides->incidence (side, i).grob);
+          for (index_t j = i + 1; j < numIncidences; ++j) {
+            index_t const b = numbering.global_index (sides->incidence (side, j).grob);
+            if (a != b)
+              func (a, b);
+          }
+        }
+      }
+    }
+  };
+
+  forEachEdge ([&] (index_t const a, index_t const b) {
+    ++graph.offsets [a + 1];
+    ++graph.offsets [b + 1];
+  });
+
+  std::partial_sum (graph.offsets.begin (), graph.offsets.end (), graph.offsets.begin ());
+  graph.adjacent.resize (graph.offsets.back ());
+  graph.edgeWeights.assign (graph.offsets.back (), 1);
+
+  std::vector <index_t> cursors (graph.offsets.begin (), graph.offsets.end () - 1);
+  forEachEdge ([&] (index_t const a, index_t const b) {
+    graph.adjacent [cursors [a]++] = b;
+    graph.adjacent [cursors [b]++] = a;
+  });
+
+  return graph;
+}
+
+PartitionInfo EvaluatePartition (Graph const& graph, std::vector <index_t> const& partition, index_t const numPartitions)
+{
+  PartitionInfo info;
+  info.numPartitions = numPartitions;
+  info.partitionSizes.assign (numPartitions, 0);
+
+  for (index_t v = 0; v < graph.num_vertices (); ++v) {
+    ++info.partitionSizes [partition [v]];
+    for (index_t e = graph.offsets [v]; e < graph.offsets [v + 1]; ++e) {
+      if (v < graph.adjacent [e] && partition [v] != partition [graph.adjacent [e]])
+        info.edgeCut += graph.edgeWeights [e];
+    }
+  }
+
+  if (graph.num_vertices () > 0) {
+    index_t const maxSize = *std::max_element (info.partitionSizes.begin (), info.partitionSizes.end ());
+    info.imbalance = static_cast <real_t> (maxSize) * static_cast <real_t> (numPartitions)
+                     / static_cast <real_t> (graph.num_vertices ());
+  }
+  return info;
+}
+
+void StorePartition (Mesh& mesh,
+                     GrobSet const grobSet,
+                     GrobNumbering const& numbering,
+                     std::vector <index_t> const& partition)
+{
+  for (auto const grobType : grobSet) {
+    index_t const num = static_cast <index_t> (mesh.num (grobType));
+    if (num == 0)
+      continue;
+
+    auto const first = partition.begin () + numbering.baseInds [grobType];
+    mesh.set_annex (PartitionAnnexKey (grobType), IndexArrayAnnex (1, std::vector <index_t> (first, first + num)));
+  }
+}
+
+void CheckNumPartitions (index_t const numPartitions)
+{
+  if (numPartitions == 0)
+    throw LumeError () << "Partitioning: The number of partitions has to be positive.";
+}
+
+/// Reads the partition index of each grob from the annexes with the given name
+std::vector <index_t> ReadPartition (Mesh const& mesh,
+                                     std::string const& annexName,
+                                     GrobSet const grobSet,
+                                     GrobNumbering const& numbering,
+                                     index_t const numPartitions)
+{
+  std::vector <index_t> partition (numbering.num);
+  for (auto const grobType : grobSet) {
+    if (mesh.num (grobType) == 0)
+      continue;
+
+    auto const& annex = mesh.annex (TypedAnnexKey <IndexArrayAnnex> (annexName, grobType));
+    if (annex.size () != mesh.num (grobType))
+      throw AnnexError () << "Partitioning: Bad size of partition annex of " << GrobTypeName (grobType);
+
+    for (index_t i = 0; i < annex.size (); ++i) {
+      if (annex [i] >= numPartitions)
+        throw LumeError () << "Partitioning: Invalid partition index " << annex [i];
+      partition [numbering.baseInds [grobType] + i] = annex [i];
+    }
+  }
+  return partition;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//  Recursive coordinate bisection
+
+/// Assigns the partitions `[firstPart, firstPart + numParts)` to the centers indexed by `[begin, end)`
+void RecursiveCoordinateBisection (index_t* const begin,
+                                   index_t* const end,
+                                   index_t const firstPart,
+                                   index_t const numParts,
+                                   std::vector <real_t> const& centers,
+                                   index_t const dim,
+                                   std::vector <index_t>& partitionOut)
+{
+  size_t const size = static_cast <size_t> (end - begin);
+  if (numParts == 1 || size == 0) {
+    for (index_t* i = begin; i != end; ++i)
+      partitionOut [*i] = firstPart;
+    return;
+  }
+
+  std::array <real_t, 3> minCoord, maxCoord;
+  for (index_t d = 0; d < dim; ++d)
+    minCoord [d] = maxCoord [d] = centers [*begin * dim + d];
+
+  for (index_t* i = begin; i != end; ++i) {
+    for (index_t d = 0; d < dim; ++d) {
+      minCoord [d] = std::min (minCoord [d], centers [*i * dim + d]);
+      maxCoord [d] = std::max (maxCoord [d], centers [*i * dim + d]);
+    }
+  }
+
+  index_t axis = 0;
+  for (index_t d = 1; d < dim; ++d) {
+    if (maxCoord [d] - minCoord [d] > maxCoord [axis] - minCoord [axis])
+      axis = d;
+  }
+
+  // ties are broken by index so that the result does not depend on the input order
+  index_t const numLeftParts = numParts / 2;
+  index_t* const mid = begin + size * numLeftParts / numParts;
+  std::nth_element (begin, mid, end, [&] (index_t const a, index_t const b) {
+    real_t const ca = centers [a * dim + axis];
+    real_t const cb = centers [b * dim + axis];
+    return ca < cb || (ca == cb && a < b);
+  });
+
+  auto bisectLeft = [&] () {
+    RecursiveCoordinateBisection (begin, mid, firstPart, numLeftParts, centers, dim, partitionOut);
+  };
+  auto bisectRight = [&] () {
+    RecursiveCoordinateBisection (mid, end, firstPart + numLeftParts, numParts - numLeftParts,
+                                  centers, dim, partitionOut);
+  };
+
+  static constexpr size_t minParallelSize = 8192;
+  if (size >= minParallelSize) {
+    auto left = std::async (std::launch::async, bisectLeft);
+    bisectRight ();
+    left.get ();
+  }
+  else {
+    bisectLeft ();
+    bisectRight ();
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//  Multilevel graph partitioning
+
+/// Contracts pairs of vertices which are connected by heavy edges.
+/** \param coarseMapOut  Receives the index of the coarse vertex of each vertex of `fine`.*/
+Graph CoarsenByHeavyEdgeMatching (Graph const& fine, std::vector <index_t>& coarseMapOut, std::mt19937& rng)
+{
+  index_t const numFine = fine.num_vertices ();
+
+  std::vector <index_t> order (numFine);
+  std::iota (order.begin (), order.end (), index_t (0));
+  std::shuffle (order.begin (), order.end (), rng);
+
+  std::vector <index_t> match (numFine, NO_INDEX);
+  for (index_t const u : order) {
+    if (match [u] != NO_INDEX)
+      continue;
+
+    index_t best = u;
+    index_t bestWeight = 0;
+    for (index_t e = fine.offsets [u]; e < fine.offsets [u + 1]; ++e) {
+      index_t const v = fine.adjacent [e];
+      if (match [v] == NO_INDEX && v != u && fine.edgeWeights [e] > bestWeight) {
+        best = v;
+        bestWeight = fine.edgeWeights [e];
+      }
+    }
+    match [u] = best;
+    match [best] = u;
+  }
+
+  coarseMapOut.assign (numFine, NO_INDEX);
+  index_t numCoarse = 0;
+  for (index_t u = 0; u < numFine; ++u) {
+    if (coarseMapOut [u] == NO_INDEX)
+      coarseMapOut [u] = coarseMapOut [match [u]] = numCoarse++;
+  }
+
+  Graph coarse;
+  coarse.offsets.reserve (numCoarse + 1);
+  coarse.vertexWeights.reserve (numCoarse);
+
+  // position of the edge to a coarse vertex in the adjacency list of the current coarse vertex
+  std::vector <index_t> edgePos (numCoarse, NO_INDEX);
+
+  for (index_t u = 0; u < numFine; ++u) {
+    index_t const c = coarseMapOut [u];
+    if (c != coarse.num_vertices ())
+      continue;
+
+    index_t const rowBegin = static_cast <index_t> (coarse.adjacent.size ());
+    index_t weight = 0;
+    index_t const members [] = {u, match [u]};
+    index_t const numMembers = match [u] == u ? 1 : 2;
+    for (index_t i = 0; i < numMembers; ++i) {
+      index_t const w = members [i];
+      weight += fine.vertexWeights [w];
+      for (index_t e = fine.offsets [w]; e < fine.offsets [w + 1]; ++e) {
+        index_t const nbr = coarseMapOut [fine.adjacent [e]];
+        if (nbr == c)
+          continue;
+
+        index_t const pos = edgePos [nbr];
+        if (pos != NO_INDEX && pos >= rowBegin && coarse.adjacent [pos] == nbr)
+          coarse.edgeWeights [pos] += fine.edgeWeights [e];
+        else {
+          edgePos [nbr] = static_cast <index_t> (coarse.adjacent.size ());
+          coarse.adjacent.push_back (nbr);
+          coarse.edgeWeights.push_back (fine.edgeWeights [e]);
+        }
+      }
+    }
+
+    coarse.vertexWeights.push_back (weight);
+    coarse.offsets.push_back (static_cast <index_t> (coarse.adjacent.size ()));
+  }
+
+  return coarse;
+}
+
+/// Returns the subgraph spanned by the vertices `v` with `sides [v] == side`.
+/** \param idsOut  Receives for each vertex of the subgraph the id of its vertex in `graph`.*/
+Graph InducedSubgraph (Graph const& graph,
+                       std::vector <index_t> const& sides,
+                       index_t const side,
+                       std::vector <index_t>& idsOut)
+{
+  idsOut.clear ();
+  std::vector <index_t> localInds (graph.num_vertices (), NO_INDEX);
+  for (index_t v = 0; v < graph.num_vertices (); ++v) {
+    if (sides [v] == side) {
+      localInds [v] = static_cast <index_t> (idsOut.size ());
+      idsOut.push_back (v);
+    }
+  }
+
+  Graph sub;
+  sub.offsets.reserve (idsOut.size () + 1);
+  sub.vertexWeights.reserve (idsOut.size ());
+  for (index_t const v : idsOut) {
+    for (index_t e = graph.offsets [v]; e < graph.offsets [v + 1]; ++e) {
+      index_t const nbr = localInds [graph.adjacent [e]];
+      if (nbr != NO_INDEX) {
+        sub.adjacent.push_back (nbr);
+        sub.edgeWeights.push_back (graph.edgeWeights [e]);
+      }
+    }
+    sub.vertexWeights.push_back (graph.vertexWeights [v]);
+    sub.offsets.push_back (static_cast <index_t> (sub.adjacent.size ()));
+  }
+  return sub;
+}
+
+index_t EdgeCut (Graph const& graph, std::vector <index_t> const& partition)
+{
+  index_t cut = 0;
+  for (index_t v = 0; v < graph.num_vertices (); ++v) {
+    for (index_t e = graph.offsets [v]; e < graph.offsets [v + 1]; ++e) {
+      if (partition [v] != partition [graph.adjacent [e]])
+        cut += graph.edgeWeights [e];
+    }
+  }
+  return cut / 2;
+}
+
+/// Improves a bisection with the Fiduccia-Mattheyses heuristic.
+/** Each pass tentatively moves unlocked vertices with the largest gain to the other side,
+  while the weight of side 0 stays within `[target0 - tolerance, target0 + tolerance]`
+  (or approaches that interval, if it isn't met). The pass is then rolled back to the
+  best intermediate state. Candidates are kept in one max-heap per side, whose outdated
+  entries are skipped lazily.*/
+void RefineBisectionFM (Graph const& graph,
+                        std::vector <index_t>& sides,
+                        index_t const target0,
+                        index_t const tolerance)
+{
+  static constexpr int maxPasses = 8;
+  static constexpr size_t maxMovesWithoutImprovement = 64;
+
+  using Candidate = std::pair <int64_t, index_t>;
+
+  index_t const numVertices = graph.num_vertices ();
+  auto deviation = [&] (int64_t const weight0) {return std::abs (weight0 - int64_t (target0));};
+
+  int64_t weight0 = 0;
+  for (index_t v = 0; v < numVertices; ++v) {
+    if (sides [v] == 0)
+      weight0 += graph.vertexWeights [v];
+  }
+
+  std::vector <int64_t> gains (numVertices);
+  std::vector <char> locked (numVertices);
+  std::vector <index_t> moves;
+  std::array <std::priority_queue <Candidate>, 2> candidates;
+
+  auto topCandidate = [&] (index_t const side) {
+    auto& heap = candidates [side];
+    while (!heap.empty ()) {
+      auto const [gain, v] = heap.top ();
+      if (!locked [v] && sides [v] == side && gains [v] == gain)
+        return v;
+      heap.pop ();
+    }
+    return NO_INDEX;
+  };
+
+  for (int pass = 0; pass < maxPasses; ++pass) {
+    for (auto& heap : candidates)
+      heap = {};
+
+    // interior vertices are candidates, too, since they may be required to balance disconnected graphs
+    for (index_t v = 0; v < numVertices; ++v) {
+      gains [v] = 0;
+      for (index_t e = graph.offsets [v]; e < graph.offsets [v + 1]; ++e)
+        gains [v] += sides [graph.adjacent [e]] != sides [v] ? graph.edgeWeights [e] : -int64_t (graph.edgeWeights [e]);
+      candidates [sides [v]].emplace (gains [v], v);
+    }
+    std::fill (locked.begin (), locked.end (), 0);
+    moves.clear ();
+
+    int64_t gain = 0;
+    int64_t bestGain = 0;
+    int64_t bestDeviation = deviation (weight0);
+    size_t bestNumMoves = 0;
+
+    while (moves.size () - bestNumMoves < maxMovesWithoutImprovement) {
+      auto admissible = [&] (index_t const v) {
+        if (v == NO_INDEX)
+          return false;
+        int64_t const newWeight0 = sides [v] == 0 ? weight0 - graph.vertexWeights [v] : weight0 + graph.vertexWeights [v];
+        return deviation (weight0) <= tolerance ? deviation (newWeight0) <= tolerance
+                                                : deviation (newWeight0) < deviation (weight0);
+      };
+
+      index_t const c0 = topCandidate (0);
+      index_t const c1 = topCandidate (1);
+      index_t best = NO_INDEX;
+      if (admissible (c0))
+        best = c0;
+      if (admissible (c1) && (best == NO_INDEX || gains [c1] > gains [best]))
+        best = c1;
+
+      if (best == NO_INDEX)
+        break;
+
+      index_t const oldSide = sides [best];
+      sides [best] = 1 - oldSide;
+      weight0 += oldSide == 0 ? -int64_t (graph.vertexWeights [best]) : int64_t (graph.vertexWeights [best]);
+      gain += gains [best];
+      locked [best] = 1;
+      moves.push_back (best);
+
+      gains [best] = -gains [best];
+      for (index_t e = graph.offsets [best]; e < graph.offsets [best + 1]; ++e) {
+        index_t const nbr = graph.adjacent [e];
+        int64_t const w = 2 * int64_t (graph.edgeWeights [e]);
+        gains [nbr] += sides [nbr] == oldSide ? w : -w;
+        if (!locked [nbr])
+          candidates [sides [nbr]].emplace (gains [nbr], nbr);
+      }
+
+      // balanced states are preferred over unbalanced ones, then larger gains, then smaller deviations
+      int64_t const dev = deviation (weight0);
+      bool const wasBalanced = bestDeviation <= tolerance;
+      bool const isBalanced = dev <= tolerance;
+      if ((isBalanced && !wasBalanced)
+          || (isBalanced == wasBalanced && (gain > bestGain || (gain == bestGain && dev < bestDeviation))))
+      {
+        bestGain = gain;
+        bestDeviation = dev;
+        bestNumMoves = moves.size ();
+      }
+    }
+
+    for (size_t i = moves.size (); i > bestNumMoves; --i) {
+      index_t const v = moves [i - 1];
+      sides [v] = 1 - sides [v];
+      weight0 += sides [v] == 0 ? int64_t (graph.vertexWeights [v]) : -int64_t (graph.vertexWeights [v]);
+    }
+
+    if (bestNumMoves == 0)
+      break;
+  }
+}
+
+/// Returns the admissible deviation of the weight of side 0 from `target0` during a bisection
+index_t BisectionTolerance (Graph const& graph, index_t const target0, real_t const relativeTolerance)
+{
+  index_t const maxVertexWeight = *std::max_element (graph.vertexWeights.begin (), graph.vertexWeights.end ());
+  return std::max (maxVertexWeight, static_cast <index_t> (relativeTolerance * static_cast <real_t> (target0)));
+}
+
+/// Splits the graph into two sides, where side 0 should receive the weight `target0`.
+/** Several bisections are grown by breadth first searches from random seeds and refined
+  by `RefineBisectionFM`. The one with the smallest edge cut is returned.*/
+std::vector <index_t> GrowBisection (Graph const& graph,
+                                     index_t const target0,
+                                     real_t const relativeTolerance,
+                                     std::mt19937& rng)
+{
+  static constexpr int numTrials = 4;
+
+  index_t const numVertices = graph.num_vertices ();
+  index_t const tolerance = BisectionTolerance (graph, target0, relativeTolerance);
+
+  std::vector <index_t> best;
+  index_t bestCut = 0;
+  std::vector <index_t> queue;
+  std::vector <char> visited;
+  std::uniform_int_distribution <index_t> seedDist (0, numVertices - 1);
+
+  for (int trial = 0; trial < numTrials; ++trial) {
+    std::vector <index_t> sides (numVertices, 1);
+    visited.assign (numVertices, 0);
+    index_t weight0 = 0;
+    index_t nextUnvisited = 0;
+    queue.assign (1, seedDist (rng));
+    visited [queue.front ()] = 1;
+
+    for (size_t head = 0; weight0 < target0; ++head) {
+      if (head == queue.size ()) {
+        // disconnected graph: continue with an arbitrary unvisited vertex
+        while (nextUnvisited < numVertices && visited [nextUnvisited])
+          ++nextUnvisited;
+        if (nextUnvisited == numVertices)
+          break;
+        visited [nextUnvisited] = 1;
+        queue.push_back (nextUnvisited);
+      }
+
+      index_t const v = queue [head];
+      sides [v] = 0;
+      weight0 += graph.vertexWeights [v];
+      for (index_t e = graph.offsets [v]; e < graph.offsets [v + 1]; ++e) {
+        index_t const nbr = graph.adjacent [e];
+        if (!visited [nbr]) {
+          visited [nbr] = 1;
+          queue.push_back (nbr);
+        }
+      }
+    }
+
+    RefineBisectionFM (graph, sides, target0, tolerance);
+
+    index_t const cut = EdgeCut (graph, sides);
+    if (best.empty () || cut < bestCut) {
+      best.swap (sides);
+      bestCut = cut;
+    }
+  }
+
+  return best;
+}
+
+/// Splits the graph into two sides, where side 0 should receive the weight `target0`.
+/** The graph is coarsened by heavy edge matching and the coarsest graph is bisected by
+  `GrowBisection`. The bisection is then projected back to the finer graphs and
+  refined by `RefineBisectionFM` on each level.*/
+std::vector <index_t> MultilevelBisection (Graph const& graph,
+                                           index_t const target0,
+                                           real_t const relativeTolerance,
+                                           std::mt19937& rng)
+{
+  static constexpr index_t coarsestSize = 128;
+
+  std::deque <Graph> levels;
+  std::deque <std::vector <index_t>> coarseMaps;
+
+  Graph const* current = &graph;
+  while (current->num_vertices () > coarsestSize) {
+    std::vector <index_t> coarseMap;
+    Graph coarse = CoarsenByHeavyEdgeMatching (*current, coarseMap, rng);
+    if (coarse.num_vertices () > current->num_vertices () * 0.95)
+      break;
+
+    levels.push_back (std::move (coarse));
+    coarseMaps.push_back (std::move (coarseMap));
+    current = &levels.back ();
+  }
+
+  std::vector <index_t> sides = GrowBisection (*current, target0, relativeTolerance, rng);
+
+  for (size_t level = levels.size (); level > 0; --level) {
+    Graph const& fine = level > 1 ? levels [level - 2] : graph;
+    std::vector <index_t> const& coarseMap = coarseMaps [level - 1];
+
+    std::vector <index_t> fineSides (fine.num_vertices ());
+    for (index_t v = 0; v < fine.num_vertices (); ++v)
+      fineSides [v] = sides [coarseMap [v]];
+
+    sides.swap (fineSides);
+    RefineBisectionFM (fine, sides, target0, BisectionTolerance (fine, target0, relativeTolerance));
+  }
+
+  return sides;
+}
+
+/// Assigns the partitions `[firstPart, firstPart + numParts)` to the vertices of `graph`.
+/** \param ids  The ids of the vertices of `graph` in `partitionOut`.*/
+void RecursiveGraphBisection (Graph const& graph,
+                              std::vector <index_t> const& ids,
+                              index_t const firstPart,
+                              index_t const numParts,
+                              real_t const relativeTolerance,
+                              std::mt19937& rng,
+                              std::vector <index_t>& partitionOut)
+{
+  if (numParts == 1 || graph.num_vertices () <= 1) {
+    for (index_t const id : ids)
+      partitionOut [id] = firstPart;
+    return;
+  }
+
+  index_t const numLeftParts = numParts / 2;
+  index_t const target0 = static_cast <index_t> (
+    std::llround (double (graph.total_weight ()) * numLeftParts / numParts));
+
+  std::vector <index_t> const sides = MultilevelBisection (graph, target0, relativeTolerance, rng);
+
+  std::vector <index_t> subIds;
+  for (index_t side = 0; side < 2; ++side) {
+    Graph const sub = InducedSubgraph (graph, sides, side, subIds);
+    for (index_t& id : subIds)
+      id = ids [id];
+
+    if (side == 0)
+      RecursiveGraphBisection (sub, subIds, firstPart, numLeftParts, relativeTolerance, rng, partitionOut);
+    else
+      RecursiveGraphBisection (sub, subIds, firstPart + numLeftParts, numParts - numLeftParts,
+                               relativeTolerance, rng, partitionOut);
+  }
+}
+
+/// Greedily moves boundary vertices to the adjacent partition to which they are connected most strongly.
+/** A move is performed if it reduces the edge cut or the imbalance without violating
+  `maxPartitionWeight`. Vertices of overweight partitions are moved regardless of their gain.*/
+void RefineKWay (Graph const& graph,
+                 std::vector <index_t>& partition,
+                 index_t const numPartitions,
+                 index_t const maxPartitionWeight)
+{
+  static constexpr int maxPasses = 8;
+
+  std::vector <index_t> partitionWeights (numPartitions, 0);
+  for (index_t v = 0; v < graph.num_vertices (); ++v)
+    partitionWeights [partition [v]] += graph.vertexWeights [v];
+
+  std::vector <std::pair <index_t, index_t>> connections;
+
+  for (int pass = 0; pass < maxPasses; ++pass) {
+    index_t numMoves = 0;
+    for (index_t v = 0; v < graph.num_vertices (); ++v) {
+      index_t const own = partition [v];
+      index_t const weight = graph.vertexWeights [v];
+      index_t internal = 0;
+      connections.clear ();
+
+      for (index_t e = graph.offsets [v]; e < graph.offsets [v + 1]; ++e) {
+        index_t const p = partition [graph.adjacent [e]];
+        if (p == own) {
+          internal += graph.edgeWeights [e];
+          continue;
+        }
+        auto const c = std::find_if (connections.begin (), connections.end (), [p] (auto const& c) {return c.first == p;});
+        if (c == connections.end ())
+          connections.emplace_back (p, graph.edgeWeights [e]);
+        else
+          c->second += graph.edgeWeights [e];
+      }
+
+      bool const overweight = partitionWeights [own] > maxPartitionWeight;
+      index_t target = NO_INDEX;
+      int64_t targetGain = 0;
+      for (auto const& [p, external] : connections) {
+        if (partitionWeights [p] + weight > maxPartitionWeight)
+          continue;
+
+        int64_t const gain = int64_t (external) - int64_t (internal);
+        bool const improvesBalance = partitionWeights [p] + weight < partitionWeights [own];
+        if (!(gain > 0 || (gain == 0 && improvesBalance) || overweight))
+          continue;
+
+        if (target == NO_INDEX || gain > targetGain
+            || (gain == targetGain && partitionWeights [p] < partitionWeights [target]))
+        {
+          target = p;
+          targetGain = gain;
+        }
+      }
+
+      if (target != NO_INDEX) {
+        partition [v] = target;
+        partitionWeights [own] -= weight;
+        partitionWeights [target] += weight;
+        ++numMoves;
+      }
+    }
+
+    if (numMoves == 0)
+      break;
+  }
+}
+
+std::vector <index_t> PartitionGraphMultilevel (Graph const& graph,
+                                                index_t const numPartitions,
+                                                real_t const maxImbalance)
+{
+  // a fixed seed makes the partition reproducible
+  std::mt19937 rng (0);
+
+  // the admissible imbalance is distributed among the levels of the bisection tree
+  index_t const numBisectionLevels = static_cast <index_t> (std::ceil (std::log2 (double (numPartitions))));
+  real_t const relativeTolerance = (maxImbalance - 1) / static_cast <real_t> (std::max <index_t> (1, numBisectionLevels));
+
+  std::vector <index_t> partition (graph.num_vertices ());
+  std::vector <index_t> ids (graph.num_vertices ());
+  std::iota (ids.begin (), ids.end (), index_t (0));
+  RecursiveGraphBisection (graph, ids, 0, numPartitions, relativeTolerance, rng, partition);
+
+  index_t const totalWeight = graph.total_weight ();
+  index_t const maxPartitionWeight = std::max (
+    static_cast <index_t> (maxImbalance * static_cast <real_t> (totalWeight) / static_cast <real_t> (numPartitions)),
+    (totalWeight + numPartitions - 1) / numPartitions);
+
+  RefineKWay (graph, partition, numPartitions, maxPartitionWeight);
+  return partition;
+}
+
+}// end of unnamed namespace
+
+
+PartitionInfo PartitionRCB (Mesh& mesh, index_t const numPartitions, GrobSet const grobSet)
+{
+  CheckNumPartitions (numPartitions);
+
+  auto const& coordsAnnex = mesh.annex (keys::vertexCoords);
+  index_t const dim = static_cast <index_t> (coordsAnnex.tuple_size ());
+  if (dim == 0 || dim > 3)
+    throw BadTupleSizeError () << "PartitionRCB: Unsupported tuple size " << dim;
+
+  math::ConstTupleView <real_t> const coords (coordsAnnex.data (), coordsAnnex.num_tuples (), dim);
+  GrobNumbering const numbering (mesh, grobSet);
+
+  std::vector <real_t> centers (numbering.num * dim);
+  for (auto const grobType : grobSet) {
+    GrobArray const& grobs = mesh.grobs (grobType);
+    index_t const baseInd = numbering.baseInds [grobType];
+    parallel_for_blocks (size_t (0), grobs.size (), [&] (size_t const begin, size_t const end) {
+      for (size_t i = begin; i < end; ++i) {
+        auto const center = math::GrobCenter (grobs [i], coords);
+        for (index_t d = 0; d < dim; ++d)
+          centers [(baseInd + i) * dim + d] = center [d];
+      }
+    });
+  }
+
+  std::vector <index_t> ids (numbering.num);
+  std::iota (ids.begin (), ids.end (), index_t (0));
+  std::vector <index_t> partition (numbering.num);
+  RecursiveCoordinateBisection (ids.data (), ids.data () + ids.size (), 0, numPartitions, centers, dim, partition);
+
+  StorePartition (mesh, grobSet, numbering, partition);
+  return EvaluatePartition (DualGraph (mesh, grobSet, numbering), partition, numPartitions);
+}
+
+
+PartitionInfo PartitionMultilevel (Mesh& mesh,
+                                   index_t const numPartitions,
+                                   GrobSet const grobSet,
+                                   real_t const maxImbalance)
+{
+  CheckNumPartitions (numPartitions);
+  if (maxImbalance < 1)
+    throw LumeError () << "PartitionMultilevel: maxImbalance has to be at least 1, but is " << maxImbalance;
+
+  GrobNumbering const numbering (mesh, grobSet);
+  Graph const graph = DualGraph (mesh, grobSet, numbering);
+
+  std::vector <index_t> const partition = PartitionGraphMultilevel (graph, numPartitions, maxImbalance);
+
+  StorePartition (mesh, grobSet, numbering, partition);
+  return EvaluatePartition (graph, partition, numPartitions);
+}
+
+
+PartitionInfo ComputePartitionInfo (Mesh const& mesh, index_t const numPartitions, GrobSet const grobSet)
+{
+  CheckNumPartitions (numPartitions);
+  GrobNumbering const numbering (mesh, grobSet);
+  std::vector <index_t> const partition = ReadPartition (mesh, PartitionAnnexKey (VERTEX).name (), grobSet,
+                                                         numbering, numPartitions);
+  return EvaluatePartition (DualGraph (mesh, grobSet, numbering), partition, numPartitions);
+}
+
+
+std::vector <SPMesh> ExtractPartitions (Mesh const& mesh,
+                                        index_t const numPartitions,
+                                        GrobSet const grobSet,
+                                        index_t const numGhostLayers)
+{
+  return ExtractPartitions (mesh, PartitionAnnexKey (VERTEX).name (), numPartitions, grobSet, numGhostLayers);
+}
+
+
+std::vector <SPMesh> ExtractPartitions (Mesh const& mesh,
+                                        std::string const& partitionAnnexName,
+                                        index_t const numPartitions,
+                                        GrobSet const grobSet,
+                                        index_t const numGhostLayers)
+{
+  CheckNumPartitions (numPartitions);
+  if (grobSet.dim () == 0)
+    throw LumeError () << "ExtractPartitions: Vertices can't be partitioned directly.";
+
+  GrobNumbering const numbering (mesh, grobSet);
+  std::vector <index_t> const partition = ReadPartition (mesh, partitionAnnexName, grobSet, numbering, numPartitions);
+  index_t const numVertices = static_cast <index_t> (mesh.num (VERTEX));
+
+  // owned grobs of each partition, sorted by their global index
+  std::vector <index_t> ownedOffsets (numPartitions + 1, 0);
+  for (index_t const p : partition)
+    ++ownedOffsets [p + 1];
+  std::partial_sum (ownedOffsets.begin (), ownedOffsets.end (), ownedOffsets.begin ());
+
+  std::vector <index_t> owned (numbering.num);
+  {
+    std::vector <index_t> cursors (ownedOffsets.begin (), ownedOffsets.end () - 1);
+    for (index_t i = 0; i < numbering.num; ++i)
+      owned [cursors [partition [i]]++] = i;
+  }
+
+  std::shared_ptr <VertexIncidence const> incidence;
+  if (numGhostLayers > 0)
+    incidence = CachedVertexIncidence (mesh, grobSet);
+
+  // source indices of the grobs of each submesh. Vertices are sorted, grobs of the grob set
+  // are ordered by ghost layer first (owned grobs form layer 0) and by index second.
+  using SubmeshGrobs = std::array <std::vector <index_t>, NUM_GROB_TYPES>;
+  std::vector <SubmeshGrobs> submeshGrobs (numPartitions);
+
+  // Scratch arrays are shared by all partitions processed by the same thread. Since
+  // entries are stamped with the partition index, they never have to be reset.
+  parallel_for_blocks (index_t (0), numPartitions, [&] (index_t const partBegin, index_t const partEnd) {
+    std::vector <index_t> grobStamps (numbering.num, NO_INDEX);
+    std::vector <index_t> vertexStamps (numVertices, NO_INDEX);
+    std::vector <index_t> grobs, layer, nextLayer;
+
+    for (index_t p = partBegin; p < partEnd; ++p) {
+      layer.assign (owned.begin () + ownedOffsets [p], owned.begin () + ownedOffsets [p + 1]);
+      for (index_t const g : layer)
+        grobStamps [g] = p;
+      grobs = layer;
+
+      for (index_t ilayer = 0; ilayer < numGhostLayers && !layer.empty (); ++ilayer) {
+        nextLayer.clear ();
+        for (index_t const g : layer) {
+          GrobIndex const gi = numbering.grob_index (g);
+          auto const grob = mesh.grobs (gi.grob_type ())[gi.index ()];
+          for (index_t icorner = 0; icorner < grob.num_corners (); ++icorner) {
+            for (auto const grobType : numbering.grobTypes) {
+              for (index_t const nbr : incidence->incidences (grob.corner (icorner), grobType)) {
+                index_t const nbrGlobal = numbering.baseInds [grobType] + nbr;
+                if (grobStamps [nbrGlobal] != p) {
+                  grobStamps [nbrGlobal] = p;
+                  nextLayer.push_back (nbrGlobal);
+                }
+              }
+            }
+          }
+        }
+        std::sort (nextLayer.begin (), nextLayer.end ());
+        grobs.insert (grobs.end (), nextLayer.begin (), nextLayer.end ());
+        layer.swap (nextLayer);
+      }
+
+      SubmeshGrobs& out = submeshGrobs [p];
+      for (index_t const g : grobs) {
+        GrobIndex const gi = numbering.grob_index (g);
+        out [gi.grob_type ()].push_back (gi.index ());
+
+        auto const grob = mesh.grobs (gi.grob_type ())[gi.index ()];
+        for (index_t icorner = 0; icorner < grob.num_corners (); ++icorner) {
+          index_t const corner = grob.corner (icorner);
+          if (vertexStamps [corner] != p) {
+            vertexStamps [corner] = p;
+            out [VERTEX].push_back (corner);
+          }
+        }
+      }
+      std::sort (out [VERTEX].begin (), out [VERTEX].end ());
+    }
+  });
+
+  // grobs of types outside of the grob set are added to each submesh which contains all of their corners
+  std::vector <index_t> vertexSubmeshOffsets (numVertices + 1, 0);
+  for (auto const& grobs : submeshGrobs) {
+    for (index_t const v : grobs [VERTEX])
+      ++vertexSubmeshOffsets [v + 1];
+  }
+  std::partial_sum (vertexSubmeshOffsets.begin (), vertexSubmeshOffsets.end (), vertexSubmeshOffsets.begin ());
+
+  std::vector <index_t> vertexSubmeshes (vertexSubmeshOffsets.back ());
+  {
+    std::vector <index_t> cursors (vertexSubmeshOffsets.begin (), vertexSubmeshOffsets.end () - 1);
+    for (index_t p = 0; p < numPartitions; ++p) {
+      for (index_t const v : submeshGrobs [p][VERTEX])
+        vertexSubmeshes [cursors [v]++] = p;
+    }
+  }
+
+  for (index_t igt = VERTEX + 1; igt < NUM_GROB_TYPES; ++igt) {
+    GrobType const grobType = static_cast <GrobType> (igt);
+    bool const inGrobSet = std::find (numbering.grobTypes.begin (), numbering.grobTypes.end (), grobType)
+                           != numbering.grobTypes.end ();
+    if (inGrobSet || mesh.num (grobType) == 0)
+      continue;
+
+    GrobArray const& grobs = mesh.grobs (grobType);
+    index_t const numCorners = GrobDesc (grobType).num_corners ();
+
+    // each chunk collects pairs (submesh, grob). Chunks are concatenated in order.
+    static constexpr size_t chunkSize = 1 << 14;
+    size_t const numChunks = (grobs.size () + chunkSize - 1) / chunkSize;
+    std::vector <std::vector <std::pair <index_t, index_t>>> chunks (numChunks);
+
+    parallel_for (size_t (0), numChunks, [&] (size_t const ichunk) {
+      size_t const end = std::min (grobs.size (), (ichunk + 1) * chunkSize);
+      for (size_t igrob = ichunk * chunkSize; igrob < end; ++igrob) {
+        index_t const* corners = grobs.data () + igrob * numCorners;
+        for (index_t i = vertexSubmeshOffsets [corners [0]]; i < vertexSubmeshOffsets [corners [0] + 1]; ++i) {
+          index_t const p = vertexSubmeshes [i];
+          auto const& vertices = submeshGrobs [p][VERTEX];
+          bool const containsAll = std::all_of (corners + 1, corners + numCorners, [&] (index_t const c) {
+            return std::binary_search (vertices.begin (), vertices.end (), c);
+          });
+          if (containsAll)
+            chunks [ichunk].emplace_back (p, static_cast <index_t> (igrob));
+        }
+      }
+    }, 1);
+
+    for (auto const& chunk : chunks) {
+      for (auto const& [p, igrob] : chunk)
+        submeshGrobs [p][grobType].push_back (igrob);
+    }
+  }
+
+  // assemble the submeshes
+  std::vector <AnnexKey> const annexKeys = mesh.annex_keys ();
+  std::vector <SPMesh> submeshes (numPartitions);
+
+  parallel_for_blocks (index_t (0), numPartitions, [&] (index_t const partBegin, index_t const partEnd) {
+    std::vector <index_t> localVertexInds (numVertices, NO_INDEX);
+
+    for (index_t p = partBegin; p < partEnd; ++p) {
+      SubmeshGrobs const& grobs = submeshGrobs [p];
+      auto submesh = std::make_shared <Mesh> ();
+
+      for (index_t i = 0; i < grobs [VERTEX].size (); ++i)
+        localVertexInds [grobs [VERTEX][i]] = i;
+      submesh->resize_vertices (grobs [VERTEX].size ());
+
+      for (index_t igt = VERTEX + 1; igt < NUM_GROB_TYPES; ++igt) {
+        GrobType const grobType = static_cast <GrobType> (igt);
+        if (grobs [grobType].empty ())
+          continue;
+
+        index_t const numCorners = GrobDesc (grobType).num_corners ();
+        index_t const* srcCorners = mesh.grobs (grobType).data ();
+        std::vector <index_t> corners;
+        corners.reserve (grobs [grobType].size () * numCorners);
+        for (index_t const igrob : grobs [grobType]) {
+          for (index_t i = 0; i < numCorners; ++i)
+            corners.push_back (localVertexInds [srcCorners [igrob * numCorners + i]]);
+        }
+        submesh->set_grobs (GrobArray (grobType, std::move (corners)));
+      }
+
+      for (auto const& key : annexKeys) {
+        if (!key.grob_type ()) {
+          auto const* subsetInfo = dynamic_cast <SubsetInfoAnnex const*> (&mesh.untyped_annex (key));
+          if (subsetInfo)
+            submesh->set_annex (key, SubsetInfoAnnex (*subsetInfo));
+          continue;
+        }
+
+        GrobType const grobType = *key.grob_type ();
+        std::vector <index_t> const& srcInds = grobs [grobType];
+        VisitArrayAnnex (mesh.untyped_annex (key), [&] (auto const& annex) {
+          using annex_t = std::decay_t <decltype (annex)>;
+          using value_t = typename annex_t::value_type;
+          size_t const tupleSize = annex.tuple_size ();
+
+          std::vector <value_t> data (srcInds.size () * tupleSize, value_t ());
+          for (size_t i = 0; i < srcInds.size (); ++i) {
+            size_t const src = srcInds [i] * tupleSize;
+            if (src + tupleSize <= annex.size ())
+              std::copy (annex.data () + src, annex.data () + src + tupleSize, data.data () + i * tupleSize);
+          }
+          submesh->set_annex (TypedAnnexKey <annex_t> (key.name (), grobType), annex_t (tupleSize, std::move (data)));
+        });
+      }
+
+      for (index_t igt = 0; igt < NUM_GROB_TYPES; ++igt) {
+        GrobType const grobType = static_cast <GrobType> (igt);
+        if (!grobs [grobType].empty ())
+          submesh->set_annex (GlobalIndexAnnexKey (grobType), IndexArrayAnnex (1, std::vector <index_t> (grobs [grobType])));
+      }
+
+      submeshes [p] = std::move (submesh);
+    }
+  });
+
+  return submeshes;
+}
+
+}// end of namespace lume
@@ -0,0 +1,447 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/point_locator.h>
+
+#include <cmath>
+#include <lume/array_annex.h>
+#include <lume/grob_sides.h>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+namespace
+{
+  using dvec3 = std::array <double, 3>;
+
+  inline bool SameGrob (GrobIndex const& a, GrobIndex const& b)
+  {
+    return a.grob_type () == b.grob_type () && a.index () == b.index ();
+  }
+
+  /// Solves `J x = b` with Cramer's rule, where `J [r][c]` is stored row major. Returns false if `J` is singular.
+  bool Solve3 (double const (&J) [3][3], double const* b, double* x)
+  {
+    double const det =   J[0][0] * (J[1][1] * J[2][2] - J[1][2] * J[2][1])
+                       - J[0][1] * (J[1][0] * J[2][2] - J[1][2] * J[2][0])
+                       + J[0][2] * (J[1][0] * J[2][1] - J[1][1] * J[2][0]);
+    if (det == 0)
+      return false;
+
+    double const invDet = 1. / det;
+    for (int c = 0; c < 3; ++c) {
+      double M [3][3];
+      for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j)
+          M[i][j] = (j == c) ? b[i] : J[i][j];
+      }
+      x[c] = invDet * (  M[0][0] * (M[1][1] * M[2][2] - M[1][2] * M[2][1])
+                       - M[0][1] * (M[1][0] * M[2][2] - M[1][2] * M[2][0])
+                       + M[0][2] * (M[1][0] * M[2][1] - M[1][1] * M[2][0]));
+    }
+    return true;
+  }
+
+  /// Evaluates a mapping given by shape functions `N` and their derivatives `dN`
+  template <size_t numCorners>
+  void EvaluateMapping (std::array <dvec3, numCorners> const& corners,
+                        double const* N,
+                        double const (&dN) [3][numCorners],
+                        double* xOut,
+                        double (&JOut) [3][3])
+  {
+    for (int r = 0; r < 3; ++r) {
+      xOut [r] = 0;
+      for (int c = 0; c < 3; ++c)
+        JOut [r][c] = 0;
+      for (size_t i = 0; i < numCorners; ++i) {
+        xOut [r] += N [i] * corners [i][r];
+        for (int c = 0; c < 3; ++c)
+          JOut [r][c] += dN [c][i] * corners [i][r];
+      }
+    }
+  }
+
+  /// Trilinear mapping of the unit cube
+  struct HexMapping
+  {
+    std::array <dvec3, 8> corners;
+
+    void operator () (double const* xi, double* x, double (&J) [3][3]) const
+    {
+      double const u = xi[0], v = xi[1], w = xi[2];
+      double const N [8] = {(1-u)*(1-v)*(1-w), u*(1-v)*(1-w), u*v*(1-w), (1-u)*v*(1-w),
+                            (1-u)*(1-v)*w,     u*(1-v)*w,     u*v*w,     (1-u)*v*w};
+      double const dN [3][8] = {
+        {-(1-v)*(1-w), (1-v)*(1-w), v*(1-w), -v*(1-w), -(1-v)*w, (1-v)*w, v*w, -v*w},
+        {-(1-u)*(1-w), -u*(1-w), u*(1-w), (1-u)*(1-w), -(1-u)*w, -u*w, u*w, (1-u)*w},
+        {-(1-u)*(1-v), -u*(1-v), -u*v, -(1-u)*v, (1-u)*(1-v), u*(1-v), u*v, (1-u)*v}};
+      EvaluateMapping (corners, N, dN, x, J);
+    }
+  };
+
+  /// Mapping of the reference prism, linear on the triangles and along the z-axis
+  struct PrismMapping
+  {
+    std::array <dvec3, 6> corners;
+
+    void operator () (double const* xi, double* x, double (&J) [3][3]) const
+    {
+      double const a = xi[0], b = xi[1], z = xi[2];
+      double const t = 1 - a - b;
+      double const N [6] = {t*(1-z), a*(1-z), b*(1-z), t*z, a*z, b*z};
+      double const dN [3][6] = {
+        {-(1-z), 1-z, 0, -z, z, 0},
+        {-(1-z), 0, 1-z, -z, 0, z},
+        {-t, -a, -b, t, a, b}};
+      EvaluateMapping (corners, N, dN, x, J);
+    }
+  };
+
+  /// Inverts the mapping with Newton's method, starting at `xi`.
+  template <class TMapping>
+  bool InvertMapping (TMapping const& mapping, dvec3 const& p, double const sizeSq, double* xi)
+  {
+    for (int iteration = 0; iteration < 20; ++iteration) {
+      double x [3];
+      double J [3][3];
+      mapping (xi, x, J);
+
+      double const r [3] = {p[0] - x[0], p[1] - x[1], p[2] - x[2]};
+      if (r[0] * r[0] + r[1] * r[1] + r[2] * r[2] <= 1.e-24 * sizeSq)
+        return true;
+
+      double dxi [3];
+      if (!Solve3 (J, r, dxi))
+        return false;
+
+      for (int i = 0; i < 3; ++i)
+        xi [i] += dxi [i];
+
+      if (dxi[0] * dxi[0] + dxi[1] * dxi[1] + dxi[2] * dxi[2] < 1.e-24)
+        return true;
+    }
+    return false;
+  }
+}// end of unnamed namespace
+
+
+PointLocator::PointLocator (CSPMesh mesh, real_t const tolerance)
+  : m_bvh (mesh, CELLS)
+  , m_tolerance (tolerance)
+{
+  auto const& coords = mesh->annex (keys::vertexCoords);
+  if (coords.tuple_size () != 3)
+    throw BadTupleSizeError () << "PointLocator: Vertex coordinates have to have tuple size 3, "
+                                  "but have tuple size " << coords.tuple_size ();
+
+  // store the neighbor behind each face of each cell
+  GrobSides const faces (*mesh, CELLS, FACES);
+  for (auto gt : GrobSet (CELLS)) {
+    index_t const numCells = static_cast <index_t> (mesh->num (gt));
+    if (numCells == 0)
+      continue;
+
+    index_t const numLocalFaces = faces.num_local_sides (gt);
+    auto& nbrs = m_neighbors [gt];
+    nbrs.resize (numCells * numLocalFaces);
+
+    parallel_for_blocks (index_t (0), numCells, [&] (index_t const begin, index_t const end) {
+      for (index_t icell = begin; icell < end; ++icell) {
+        GrobIndex const cell (gt, icell);
+        auto const grob = mesh->grob (cell);
+        for (index_t iface = 0; iface < numLocalFaces; ++iface) {
+          GrobIndex const face (grob.side_desc (2, iface).grob_type (), faces.side_index (cell, iface));
+          index_t const numIncidences = faces.num_incidences (face);
+          for (index_t i = 0; i < numIncidences; ++i) {
+            GrobIndex const nbr = faces.incidence (face, i).grob;
+            if (!SameGrob (nbr, cell)) {
+              nbrs [icell * numLocalFaces + iface] = nbr;
+              break;
+            }
+          }
+        }
+      }
+    });
+  }
+
+  m_maxWalkSteps = 16 + static_cast <index_t> (4 * std::cbrt (static_cast <double> (mesh->num (CELLS))));
+}
+
+
+bool PointLocator::local_coordinates (GrobIndex const& cellIndex, real_t const* p, real_t* localCoordsOut) const
+{
+  double xi [3];
+  bool inside;
+  if (!compute_local_coordinates (cellIndex, p, xi, inside))
+    return false;
+
+  for (int i = 0; i < 3; ++i)
+    localCoordsOut [i] = static_cast <real_t> (xi [i]);
+  return inside;
+}
+
+
+bool PointLocator::compute_local_coordinates (GrobIndex const& cellIndex,
+                                              real_t const* p,
+                                              double* xi,
+                                              bool& insideOut) const
+{
+  auto const cell = m_bvh.mesh ()->grob (cellIndex);
+  auto const& coords = m_bvh.coordinates ();
+
+  auto corner = [&] (index_t const i) {
+    real_t const* c = coords.data () + cell.corner (i) * 3;
+    return dvec3 {c[0], c[1], c[2]};
+  };
+
+  dvec3 const pd {p[0], p[1], p[2]};
+  double const tol = m_tolerance;
+
+  auto sizeSq = [&] () {
+    double maxDistSq = 0;
+    dvec3 const c0 = corner (0);
+    for (index_t i = 1; i < cell.num_corners (); ++i) {
+      dvec3 const c = corner (i);
+      maxDistSq = std::max (maxDistSq, (c[0]-c0[0])*(c[0]-c0[0]) + (c[1]-c0[1])*(c[1]-c0[1]) + (c[2]-c0[2])*(c[2]-c0[2]));
+    }
+    return maxDistSq;
+  };
+
+  bool& inside = insideOut;
+  switch (cell.grob_type ()) {
+    case TET: {
+      dvec3 const c0 = corner (0);
+      double J [3][3];
+      for (index_t c = 0; c < 3; ++c) {
+        dvec3 const ci = corner (c + 1);
+        for (int r = 0; r < 3; ++r)
+          J [r][c] = ci [r] - c0 [r];
+      }
+      double const b [3] = {pd[0] - c0[0], pd[1] - c0[1], pd[2] - c0[2]};
+      if (!Solve3 (J, b, xi))
+        return false;
+      inside = xi[0] >= -tol && xi[1] >= -tol && xi[2] >= -tol && xi[0] + xi[1] + xi[2] <= 1 + tol;
+      break;
+    }
+
+    case HEX: {
+      HexMapping mapping;
+      for (index_t i = 0; i < 8; ++i)
+        mapping.corners [i] = corner (i);
+      xi[0] = xi[1] = xi[2] = 0.5;
+      if (!InvertMapping (mapping, pd, sizeSq (), xi))
+        return false;
+      inside = true;
+      for (int i = 0; i < 3; ++i)
+        inside &= xi[i] >= -tol && xi[i] <= 1 + tol;
+      break;
+    }
+
+    case PRISM: {
+      PrismMapping mapping;
+      for (index_t i = 0; i < 6; ++i)
+        mapping.corners [i] = corner (i);
+      xi[0] = xi[1] = 1. / 3.;
+      xi[2] = 0.5;
+      if (!InvertMapping (mapping, pd, sizeSq (), xi))
+        return false;
+      inside =    xi[0] >= -tol && xi[1] >= -tol && xi[0] + xi[1] <= 1 + tol
+               && xi[2] >= -tol && xi[2] <= 1 + tol;
+      break;
+    }
+
+    case PYRA: {
+      // a pyramid is a hexahedron whose top face collapsed to the apex
+      HexMapping mapping;
+      for (index_t i = 0; i < 4; ++i)
+        mapping.corners [i] = corner (i);
+      for (index_t i = 4; i < 8; ++i)
+        mapping.corners [i] = corner (4);
+      xi[0] = xi[1] = 0.5;
+      xi[2] = 0.25;
+      if (!InvertMapping (mapping, pd, sizeSq (), xi))
+        return false;
+      inside = true;
+      for (int i = 0; i < 3; ++i)
+        inside &= xi[i] >= -tol && xi[i] <= 1 + tol;
+      xi[0] *= 1 - xi[2];
+      xi[1] *= 1 - xi[2];
+      break;
+    }
+
+    default:
+      throw LumeError () << "PointLocator: Unsupported grob type " << GrobTypeName (cell.grob_type ());
+  }
+
+  return true;
+}
+
+
+std::optional <PointLocation>
+PointLocator::locate_bvh (real_t const* p, std::vector <GrobIndex>& candidates) const
+{
+  BoundingBox box;
+  box.extend (p);
+  m_bvh.box_overlaps (box, candidates);
+
+  PointLocation location;
+  for (auto const& cell : candidates) {
+    if (local_coordinates (cell, p, location.localCoords.data ())) {
+      location.cell = cell;
+      return location;
+    }
+  }
+  return std::nullopt;
+}
+
+
+std::optional <PointLocation>
+PointLocator::locate_walk (real_t const* p, GrobIndex cell) const
+{
+  // local index of the face opposite to each corner of a tetrahedron
+  static constexpr index_t tetOppositeFace [4] = {2, 3, 1, 0};
+
+  auto const& mesh = *m_bvh.mesh ();
+  auto const& coords = m_bvh.coordinates ();
+  GrobIndex previous;
+
+  for (index_t step = 0; step < m_maxWalkSteps; ++step) {
+    double xi [3];
+    bool inside = false;
+    bool const valid = compute_local_coordinates (cell, p, xi, inside);
+    if (valid && inside)
+      return PointLocation {cell, {real_t (xi[0]), real_t (xi[1]), real_t (xi[2])}};
+
+    auto const grob = mesh.grob (cell);
+    index_t exitFace = NO_INDEX;
+
+    if (valid && cell.grob_type () == TET) {
+      // leave the tetrahedron through the face opposite to the smallest barycentric coordinate
+      double const bary [4] = {1 - xi[0] - xi[1] - xi[2], xi[0], xi[1], xi[2]};
+      index_t minCorner = 0;
+      for (index_t i = 1; i < 4; ++i) {
+        if (bary [i] < bary [minCorner])
+          minCorner = i;
+      }
+      exitFace = tetOppositeFace [minCorner];
+    }
+    else {
+      // leave the cell through the face whose plane is farthest below the point
+      real_t center [3] = {0, 0, 0};
+      index_t const numCorners = grob.num_corners ();
+      for (index_t i = 0; i < numCorners; ++i) {
+        for (int j = 0; j < 3; ++j)
+          center [j] += coords [grob.corner (i) * 3 + j] / real_t (numCorners);
+      }
+
+      real_t maxDist = 0;
+      index_t const numFaces = grob.num_sides (2);
+      for (index_t iface = 0; iface < numFaces; ++iface) {
+        auto const face = grob.side (2, iface);
+        real_t const* f0 = coords.data () + face.corner (0) * 3;
+        real_t const* f1 = coords.data () + face.corner (1) * 3;
+        real_t const* f2 = coords.data () + face.corner (2) * 3;
+        real_t const a [3] = {f1[0] - f0[0], f1[1] - f0[1], f1[2] - f0[2]};
+        real_t const b [3] = {f2[0] - f0[0], f2[1] - f0[1], f2[2] - f0[2]};
+        real_t const n [3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+        real_t const len = std::sqrt (n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len == 0)
+          continue;
+
+        real_t dist = (n[0] * (p[0] - f0[0]) + n[1] * (p[1] - f0[1]) + n[2] * (p[2] - f0[2])) / len;
+        if (n[0] * (center[0] - f0[0]) + n[1] * (center[1] - f0[1]) + n[2] * (center[2] - f0[2]) > 0)
+          dist = -dist;
+
+        if (dist > maxDist) {
+          maxDist = dist;
+          exitFace = iface;
+        }
+      }
+    }
+
+    if (exitFace == NO_INDEX)
+      return std::nullopt;
+
+    index_t const numLocalFaces = grob.num_sides (2);
+    GrobIndex const next = m_neighbors [cell.grob_type ()][cell.index () * numLocalFaces + exitFace];
+
+    // stop at the boundary and if the walk would return to the previous cell
+    if (!next.valid () || SameGrob (next, previous))
+      return std::nullopt;
+
+    previous = cell;
+    cell = next;
+  }
+
+  return std::nullopt;
+}
+
+
+std::optional <PointLocation> PointLocator::locate (real_t const* p) const
+{
+  std::vector <GrobIndex> candidates;
+  return locate_bvh (p, candidates);
+}
+
+
+std::optional <PointLocation> PointLocator::locate (real_t const* p, GrobIndex const& seed) const
+{
+  if (auto location = locate_walk (p, seed))
+    return location;
+  return locate (p);
+}
+
+
+std::vector <std::optional <PointLocation>>
+PointLocator::locate (std::vector <real_t> const& points) const
+{
+  if (points.size () % 3 != 0)
+    throw BadTupleSizeError () << "PointLocator::locate: The number of components has to be a multiple of 3";
+
+  size_t const numPoints = points.size () / 3;
+  std::vector <std::optional <PointLocation>> locations (numPoints);
+
+  parallel_for_blocks (size_t (0), numPoints, [&] (size_t const begin, size_t const end) {
+    std::vector <GrobIndex> candidates;
+    GrobIndex seed;
+    for (size_t i = begin; i < end; ++i) {
+      real_t const* p = points.data () + 3 * i;
+      std::optional <PointLocation> location;
+      if (seed.valid ())
+        location = locate_walk (p, seed);
+      if (!location)
+        location = locate_bvh (p, candidates);
+      if (location)
+        seed = location->cell;
+      locations [i] = location;
+    }
+  });
+
+  return locations;
+}
+
+}// end of namespace lume
@@ -0,0 +1,480 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/quality.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+namespace
+{
+  constexpr index_t g_blockSize = 64;
+  constexpr real_t  g_radToDeg = real_t (180.0 / 3.14159265358979323846);
+
+  struct V3
+  {
+    real_t x, y, z;
+  };
+
+  inline V3 operator - (V3 const& a, V3 const& b)  {return {a.x - b.x, a.y - b.y, a.z - b.z};}
+  inline V3 operator + (V3 const& a, V3 const& b)  {return {a.x + b.x, a.y + b.y, a.z + b.z};}
+  inline real_t Dot (V3 const& a, V3 const& b)     {return a.x * b.x + a.y * b.y + a.z * b.z;}
+  inline real_t Len (V3 const& a)                  {return std::sqrt (Dot (a, a));}
+
+  inline V3 Cross (V3 const& a, V3 const& b)
+  {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+  }
+
+  /// Angle between `a` and `b` in degrees. 0 if one of the vectors vanishes.
+  inline real_t Angle (V3 const& a, V3 const& b)
+  {
+    real_t const l = Len (a) * Len (b);
+    if (l == 0)
+      return 0;
+    return std::acos (std::min (real_t (1), std::max (real_t (-1), Dot (a, b) / l))) * g_radToDeg;
+  }
+
+  /// Corner coordinates of a block of grobs, stored as structure of arrays.
+  template <index_t numCorners>
+  struct Block
+  {
+    real_t x [numCorners][g_blockSize];
+    real_t y [numCorners][g_blockSize];
+    real_t z [numCorners][g_blockSize];
+
+    V3 p (index_t const corner, index_t const i) const
+    {
+      return {x [corner][i], y [corner][i], z [corner][i]};
+    }
+  };
+
+  // Element descriptions. Faces of cells are ordered as in `GrobDesc` and are
+  // oriented outwards for positively oriented elements. `cornerNbrs` lists the
+  // corners adjacent to each corner, so that the corner Jacobian of the reference
+  // element has a positive determinant. `jacobianScale` normalizes the scaled
+  // Jacobian of the ideal element to 1.
+  template <GrobType gt> struct Traits;
+
+  template <> struct Traits <TRI>
+  {
+    static constexpr index_t dim = 2;
+    static constexpr index_t numCorners = 3;
+    static constexpr index_t cornerNbrs [3][2] = {{1, 2}, {2, 0}, {0, 1}};
+    static constexpr real_t  jacobianScale = real_t (1.1547005383792515); // 2/sqrt(3)
+  };
+
+  template <> struct Traits <QUAD>
+  {
+    static constexpr index_t dim = 2;
+    static constexpr index_t numCorners = 4;
+    static constexpr index_t cornerNbrs [4][2] = {{1, 3}, {2, 0}, {3, 1}, {0, 2}};
+    static constexpr real_t  jacobianScale = 1;
+  };
+
+  template <> struct Traits <TET>
+  {
+    static constexpr index_t dim = 3;
+    static constexpr index_t numCorners = 4;
+    static constexpr index_t numFaces = 4;
+    static constexpr index_t faces [4][4] = {{0, 2, 1, NO_INDEX}, {0, 1, 3, NO_INDEX},
+                                             {1, 2, 3, NO_INDEX}, {2, 0, 3, NO_INDEX}};
+    static constexpr index_t numJacobianCorners = 4;
+    static constexpr index_t cornerNbrs [4][3] = {{1, 2, 3}, {2, 0, 3}, {0, 1, 3}, {0, 2, 1}};
+    static constexpr real_t  jacobianScale = real_t (1.4142135623730951); // sqrt(2)
+  };
+
+  template <> struct Traits <HEX>
+  {
+    static constexpr index_t dim = 3;
+    static constexpr index_t numCorners = 8;
+    static constexpr index_t numFaces = 6;
+    static constexpr index_t faces [6][4] = {{0, 3, 2, 1}, {0, 1, 5, 4}, {1, 2, 6, 5},
+                                             {2, 3, 7, 6}, {3, 0, 4, 7}, {4, 5, 6, 7}};
+    static constexpr index_t numJacobianCorners = 8;
+    static constexpr index_t cornerNbrs [8][3] = {{1, 3, 4}, {2, 0, 5}, {3, 1, 6}, {0, 2, 7},
+                                                  {7, 5, 0}, {4, 6, 1}, {5, 7, 2}, {6, 4, 3}};
+    static constexpr real_t  jacobianScale = 1;
+  };
+
+  template <> struct Traits <PRISM>
+  {
+    static constexpr index_t dim = 3;
+    static constexpr index_t numCorners = 6;
+    static constexpr index_t numFaces = 5;
+    static constexpr index_t faces [5][4] = {{0, 2, 1, NO_INDEX}, {0, 1, 4, 3}, {1, 2, 5, 4},
+                                             {2, 0, 3, 5}, {3, 4, 5, NO_INDEX}};
+    static constexpr index_t numJacobianCorners = 6;
+    static constexpr index_t cornerNbrs [6][3] = {{1, 2, 3}, {2, 0, 4}, {0, 1, 5},
+                                                  {5, 4, 0}, {3, 5, 1}, {4, 3, 2}};
+    static constexpr real_t  jacobianScale = real_t (1.1547005383792515); // 2/sqrt(3)
+  };
+
+  template <> struct Traits <PYRA>
+  {
+    static constexpr index_t dim = 3;
+    static constexpr index_t numCorners = 5;
+    static constexpr index_t numFaces = 5;
+    static constexpr index_t faces [5][4] = {{0, 3, 2, 1}, {0, 1, 4, NO_INDEX}, {1, 2, 4, NO_INDEX},
+                                             {2, 3, 4, NO_INDEX}, {3, 0, 4, NO_INDEX}};
+    // the apex has four adjacent corners and is thus not considered
+    static constexpr index_t numJacobianCorners = 4;
+    static constexpr index_t cornerNbrs [4][3] = {{1, 3, 4}, {2, 0, 4}, {3, 1, 4}, {0, 2, 4}};
+    static constexpr real_t  jacobianScale = real_t (1.4142135623730951); // sqrt(2)
+  };
+
+  /// An edge of a cell together with the two faces which contain it
+  struct CellEdge
+  {
+    index_t c0, c1;
+    index_t f0, f1;
+  };
+
+  template <class T>
+  constexpr index_t NumFaceCorners (index_t const iface)
+  {
+    return T::faces [iface][3] == NO_INDEX ? 3 : 4;
+  }
+
+  /// Collects the edges of a cell and their adjacent faces from the face table at compile time.
+  template <class T>
+  constexpr auto CellEdges ()
+  {
+    std::array <CellEdge, 12> edges {};
+    index_t numEdges = 0;
+    for (index_t iface = 0; iface < T::numFaces; ++iface) {
+      index_t const nc = NumFaceCorners <T> (iface);
+      for (index_t k = 0; k < nc; ++k) {
+        index_t const a = T::faces [iface][k];
+        index_t const b = T::faces [iface][(k + 1) % nc];
+        bool found = false;
+        for (index_t i = 0; i < numEdges; ++i) {
+          if ((edges [i].c0 == a && edges [i].c1 == b) || (edges [i].c0 == b && edges [i].c1 == a)) {
+            edges [i].f1 = iface;
+            found = true;
+          }
+        }
+        if (!found)
+          edges [numEdges++] = CellEdge {a, b, iface, NO_INDEX};
+      }
+    }
+    return std::make_pair (edges, numEdges);
+  }
+
+  template <class T>
+  struct CellEdgeTable
+  {
+    static constexpr auto table = CellEdges <T> ();
+    static constexpr auto& edges = table.first;
+    static constexpr index_t numEdges = table.second;
+  };
+
+  /// Outward normal of a face of a cell (not normalized)
+  template <class T, class TBlock>
+  inline V3 FaceNormal (TBlock const& block, index_t const iface, index_t const i)
+  {
+    auto const& f = T::faces [iface];
+    if (f [3] == NO_INDEX)
+      return Cross (block.p (f [1], i) - block.p (f [0], i), block.p (f [2], i) - block.p (f [0], i));
+    return Cross (block.p (f [2], i) - block.p (f [0], i), block.p (f [3], i) - block.p (f [1], i));
+  }
+
+  /// Normal of a face element (not normalized)
+  template <class T, class TBlock>
+  inline V3 ElementNormal (TBlock const& block, index_t const i)
+  {
+    if constexpr (T::numCorners == 3)
+      return Cross (block.p (1, i) - block.p (0, i), block.p (2, i) - block.p (0, i));
+    else
+      return Cross (block.p (2, i) - block.p (0, i), block.p (3, i) - block.p (1, i));
+  }
+
+  template <class T, class TBlock>
+  inline real_t Area (TBlock const& block, index_t const i)
+  {
+    return real_t (0.5) * Len (ElementNormal <T> (block, i));
+  }
+
+  template <class T, class TBlock>
+  inline real_t Volume (TBlock const& block, index_t const i)
+  {
+    // divergence theorem over the triangulated boundary, relative to corner 0
+    V3 const p0 = block.p (0, i);
+    real_t vol = 0;
+    for (index_t iface = 0; iface < T::numFaces; ++iface) {
+      auto const& f = T::faces [iface];
+      V3 const a = block.p (f [0], i) - p0;
+      V3 const b = block.p (f [1], i) - p0;
+      V3 const c = block.p (f [2], i) - p0;
+      vol += Dot (a, Cross (b, c));
+      if (f [3] != NO_INDEX)
+        vol += Dot (a, Cross (c, block.p (f [3], i) - p0));
+    }
+    return vol / 6;
+  }
+
+  template <class T, class TBlock>
+  inline void EdgeLengthRange (TBlock const& block, index_t const i, real_t& minOut, real_t& maxOut)
+  {
+    minOut = std::numeric_limits <real_t>::max ();
+    maxOut = 0;
+    auto update = [&] (index_t const c0, index_t const c1) {
+      real_t const l = Len (block.p (c1, i) - block.p (c0, i));
+      minOut = std::min (minOut, l);
+      maxOut = std::max (maxOut, l);
+    };
+
+    if constexpr (T::dim == 2) {
+      for (index_t c = 0; c < T::numCorners; ++c)
+        update (c, (c + 1) % T::numCorners);
+    }
+    else {
+      using table = CellEdgeTable <T>;
+      for (index_t e = 0; e < table::numEdges; ++e)
+        update (table::edges [e].c0, table::edges [e].c1);
+    }
+  }
+
+  template <class T, class TBlock>
+  inline real_t AspectRatio (TBlock const& block, index_t const i)
+  {
+    constexpr real_t inf = std::numeric_limits <real_t>::infinity ();
+    real_t minLen, maxLen;
+    EdgeLengthRange <T> (block, i, minLen, maxLen);
+
+    if constexpr (T::numCorners == 3 && T::dim == 2) {
+      real_t const perimeter =   Len (block.p (1, i) - block.p (0, i))
+                               + Len (block.p (2, i) - block.p (1, i))
+                               + Len (block.p (0, i) - block.p (2, i));
+      real_t const area = Area <T> (block, i);
+      return area > 0 ? maxLen * perimeter / (real_t (6.928203230275509) * area) : inf; // 4 sqrt(3)
+    }
+    else if constexpr (T::numCorners == 4 && T::dim == 3) {
+      real_t faceArea = 0;
+      for (index_t iface = 0; iface < T::numFaces; ++iface)
+        faceArea += real_t (0.5) * Len (FaceNormal <T> (block, iface, i));
+      real_t const vol = std::abs (Volume <T> (block, i));
+      return vol > 0 ? maxLen * faceArea / (real_t (14.696938456699067) * vol) : inf; // 6 sqrt(6)
+    }
+    else
+      return minLen > 0 ? maxLen / minLen : inf;
+  }
+
+  template <class T, class TBlock>
+  inline real_t MinAngle (TBlock const& block, index_t const i)
+  {
+    real_t minAngle = 180;
+    if constexpr (T::dim == 2) {
+      for (index_t c = 0; c < T::numCorners; ++c) {
+        V3 const p = block.p (c, i);
+        minAngle = std::min (minAngle, Angle (block.p (T::cornerNbrs [c][0], i) - p,
+                                              block.p (T::cornerNbrs [c][1], i) - p));
+      }
+    }
+    else {
+      using table = CellEdgeTable <T>;
+      for (index_t e = 0; e < table::numEdges; ++e) {
+        V3 const n0 = FaceNormal <T> (block, table::edges [e].f0, i);
+        V3 const n1 = FaceNormal <T> (block, table::edges [e].f1, i);
+        minAngle = std::min (minAngle, 180 - Angle (n0, n1));
+      }
+    }
+    return minAngle;
+  }
+
+  /// Computes the minimal corner Jacobian determinant. If `scaled`, each determinant is divided by the edge lengths.
+  template <class T, class TBlock>
+  inline real_t MinCornerJacobian (TBlock const& block, index_t const i, bool const planar, bool const scaled)
+  {
+    real_t minDet = std::numeric_limits <real_t>::max ();
+    if constexpr (T::dim == 2) {
+      V3 n {0, 0, 1};
+      if (!planar) {
+        n = ElementNormal <T> (block, i);
+        real_t const l = Len (n);
+        if (l == 0)
+          return 0;
+        n = {n.x / l, n.y / l, n.z / l};
+      }
+
+      for (index_t c = 0; c < T::numCorners; ++c) {
+        V3 const p = block.p (c, i);
+        V3 const e0 = block.p (T::cornerNbrs [c][0], i) - p;
+        V3 const e1 = block.p (T::cornerNbrs [c][1], i) - p;
+        real_t det = Dot (Cross (e0, e1), n);
+        if (scaled) {
+          real_t const l = Len (e0) * Len (e1);
+          det = l > 0 ? det * T::jacobianScale / l : 0;
+        }
+        minDet = std::min (minDet, det);
+      }
+    }
+    else {
+      for (index_t c = 0; c < T::numJacobianCorners; ++c) {
+        V3 const p = block.p (c, i);
+        V3 const e0 = block.p (T::cornerNbrs [c][0], i) - p;
+        V3 const e1 = block.p (T::cornerNbrs [c][1], i) - p;
+        V3 const e2 = block.p (T::cornerNbrs [c][2], i) - p;
+        real_t det = Dot (e0, Cross (e1, e2));
+        if (scaled) {
+          real_t const l = Len (e0) * Len (e1) * Len (e2);
+          det = l > 0 ? det * T::jacobianScale / l : 0;
+        }
+        minDet = std::min (minDet, det);
+      }
+    }
+    // tall pyramids would otherwise exceed the value of the ideal element
+    return scaled ? std::min (real_t (1), minDet) : minDet;
+  }
+
+  /// Gathers the corners of blocks of grobs and evaluates `kernel (block, i)` for each grob.
+  template <GrobType gt, class TKernel>
+  void Evaluate (Mesh const& mesh, real_t* out, TKernel const& kernel)
+  {
+    using T = Traits <gt>;
+    auto const& coords = mesh.annex (keys::vertexCoords);
+    index_t const dim = static_cast <index_t> (coords.tuple_size ());
+    if (dim < 2 || dim > 3)
+      throw BadTupleSizeError () << "ComputeQuality: Unsupported coordinate tuple size " << dim;
+
+    real_t const* coordData = coords.data ();
+    index_t const* corners = mesh.grobs (gt).data ();
+    size_t const numGrobs = mesh.num (gt);
+    size_t const numBlocks = (numGrobs + g_blockSize - 1) / g_blockSize;
+
+    parallel_for_blocks (size_t (0), numBlocks, [&] (size_t const blocksBegin, size_t const blocksEnd) {
+      Block <T::numCorners> block;
+      for (size_t iblock = blocksBegin; iblock < blocksEnd; ++iblock) {
+        size_t const first = iblock * g_blockSize;
+        index_t const num = static_cast <index_t> (std::min <size_t> (g_blockSize, numGrobs - first));
+        index_t const* blockCorners = corners + first * T::numCorners;
+
+        for (index_t c = 0; c < T::numCorners; ++c) {
+          for (index_t i = 0; i < num; ++i) {
+            real_t const* p = coordData + blockCorners [i * T::numCorners + c] * dim;
+            block.x [c][i] = p [0];
+            block.y [c][i] = p [1];
+            block.z [c][i] = dim == 3 ? p [2] : 0;
+          }
+        }
+
+        real_t* blockOut = out + first;
+        for (index_t i = 0; i < num; ++i)
+          blockOut [i] = kernel (block, i);
+      }
+    });
+  }
+
+  template <GrobType gt>
+  void ComputeQualityForType (Mesh const& mesh, QualityMetric const metric, real_t* out)
+  {
+    using T = Traits <gt>;
+    bool const planar = mesh.annex (keys::vertexCoords).tuple_size () < 3;
+
+    switch (metric) {
+      case QualityMetric::Area:
+        if constexpr (T::dim == 2)
+          Evaluate <gt> (mesh, out, [] (auto const& b, index_t i) {return Area <T> (b, i);});
+        break;
+      case QualityMetric::Volume:
+        if constexpr (T::dim == 3)
+          Evaluate <gt> (mesh, out, [] (auto const& b, index_t i) {return Volume <T> (b, i);});
+        break;
+      case QualityMetric::AspectRatio:
+        Evaluate <gt> (mesh, out, [] (auto const& b, index_t i) {return AspectRatio <T> (b, i);});
+        break;
+      case QualityMetric::MinAngle:
+        Evaluate <gt> (mesh, out, [] (auto const& b, index_t i) {return MinAngle <T> (b, i);});
+        break;
+      case QualityMetric::JacobianDeterminant:
+        Evaluate <gt> (mesh, out, [planar] (auto const& b, index_t i) {
+          return MinCornerJacobian <T> (b, i, planar, false);
+        });
+        break;
+      case QualityMetric::ScaledJacobian:
+        Evaluate <gt> (mesh, out, [planar] (auto const& b, index_t i) {
+          return MinCornerJacobian <T> (b, i, planar, true);
+        });
+        break;
+    }
+  }
+}// end of unnamed namespace
+
+
+std::string QualityMetricName (QualityMetric const metric)
+{
+  switch (metric) {
+    case QualityMetric::Area:                 return "Area";
+    case QualityMetric::Volume:               return "Volume";
+    case QualityMetric::AspectRatio:          return "AspectRatio";
+    case QualityMetric::MinAngle:             return "MinAngle";
+    case QualityMetric::JacobianDeterminant:  return "JacobianDeterminant";
+    case QualityMetric::ScaledJacobian:       return "ScaledJacobian";
+  }
+  return "";
+}
+
+
+bool IsQualityMetricSupported (QualityMetric const metric, GrobType const grobType)
+{
+  index_t const dim = GrobDesc (grobType).dim ();
+  switch (metric) {
+    case QualityMetric::Area:    return dim == 2;
+    case QualityMetric::Volume:  return dim == 3;
+    default:                     return dim >= 2;
+  }
+}
+
+
+RealArrayAnnex ComputeQuality (Mesh const& mesh, GrobType const grobType, QualityMetric const metric)
+{
+  if (!IsQualityMetricSupported (metric, grobType)) {
+    throw LumeError () << "ComputeQuality: Metric " << QualityMetricName (metric)
+                       << " is not supported for grob type " << GrobTypeName (grobType);
+  }
+
+  std::vector <real_t> values (mesh.num (grobType));
+  if (!values.empty ()) {
+    switch (grobType) {
+      case TRI:   ComputeQualityForType <TRI> (mesh, metric, values.data ()); break;
+      case QUAD:  ComputeQualityForType <QUAD> (mesh, metric, values.data ()); break;
+      case TET:   ComputeQualityForType <TET> (mesh, metric, values.data ()); break;
+      case HEX:   ComputeQualityForType <HEX> (mesh, metric, values.data ()); break;
+      case PRISM: ComputeQualityForType <PRISM> (mesh, metric, values.data ()); break;
+      case PYRA:  ComputeQualityForType <PYRA> (mesh, metric, values.data ()); break;
+      default: break;
+    }
+  }
+
+  return RealArrayAnnex (1, std::move (values));
+}
+
+}// end of namespace lume
@@ -24,118 +24,290 @@
 
 #include <lume/refinement.h>
 
-#include <lume/math/tuple_view.h>
-#include <lume/math/grob_math.h>
-#include <lume/grob_hash.h>
+#include <algorithm>
+#include <array>
+
+#include <lume/array_annex.h>
+#include <lume/derived_data.h>
+#include <lume/grob_sides.h>
 #include <lume/hierarchy.h>
+#include <lume/impl/tet_refinement.h>
+#include <lume/lume_error.h>
 #include <lume/parallel_for.h>
-#include <lume/topology.h>
 
 namespace lume
 {
 
-void RefinementCallback (Hierarchy hierarchy)
+namespace
 {
-  Mesh const& parentMesh = hierarchy.parent_mesh ();
-  Mesh&       childMesh  = hierarchy.child_mesh ();
+  /** A set of children of one grob type, given through local refinement vertices.
+    The local refinement vertices of a grob are its corners, followed by the centers
+    of its edges, followed by the centers of its quadrilateral sides (or its own center
+    if it is a quadrilateral) and, for hexahedra, the center of the cell. Edges and sides
+    are ordered as in the local numbering of `GrobDesc`.*/
+  struct ChildTemplate
+  {
+    GrobType       childType;
+    index_t        numChildren;
+    index_t const* corners;
+  };
+
+  constexpr index_t MAX_NUM_CHILD_TEMPLATES     = 2;
+  constexpr index_t MAX_NUM_REFINEMENT_VERTICES = 27;
+
+  struct RefinementTemplate
+  {
+    index_t       numChildTemplates;
+    ChildTemplate childTemplates [MAX_NUM_CHILD_TEMPLATES];
+  };
+
+  index_t const g_edgeChildren [] = {0, 2,  2, 1};
+
+  index_t const g_triChildren [] = {0, 3, 5,  1, 4, 3,  2, 5, 4,  3, 4, 5};
 
-  auto const& parentCoords = math::MakeTupleView (parentMesh.annex (keys::vertexCoords));
-  auto const  tupleSize = parentCoords.tuple_size ();
+  index_t const g_quadChildren [] = {0, 4, 8, 7,  1, 5, 8, 4,  2, 6, 8, 5,  3, 7, 8, 6};
 
-  RealArrayAnnex childCoordsAnnex (tupleSize, childMesh.num (VERTEX));
-  auto childCoords = math::MakeTupleView (childCoordsAnnex);
+  index_t const g_hexChildren [] = {
+     0,  8, 20, 11, 12, 21, 26, 24,    8,  1,  9, 20, 21, 13, 22, 26,
+    20,  9,  2, 10, 26, 22, 14, 23,   11, 20, 10,  3, 24, 26, 23, 15,
+    12, 21, 26, 24,  4, 16, 25, 19,   21, 13, 22, 26, 16,  5, 17, 25,
+    26, 22, 14, 23, 25, 17,  6, 18,   24, 26, 23, 15, 19, 25, 18,  7};
 
-  auto const& relations = hierarchy.relationsForChildType (VERTEX);
-  for (auto const& relation : relations)
+  index_t const g_pyraChildPyras [] = {
+     0,  5, 13,  8,  9,    1,  6, 13,  5, 10,    2,  7, 13,  6, 11,
+     3,  8, 13,  7, 12,    9, 10, 11, 12,  4,    9, 12, 11, 10, 13};
+
+  index_t const g_pyraChildTets [] = {5, 13, 9, 10,  6, 13, 10, 11,  7, 13, 11, 12,  8, 13, 12, 9};
+
+  index_t const g_prismChildren [] = {
+     0,  6,  8,  9, 15, 17,    1,  7,  6, 10, 16, 15,    2,  8,  7, 11, 17, 16,
+     6,  7,  8, 15, 16, 17,    9, 15, 17,  3, 12, 14,   10, 16, 15,  4, 13, 12,
+    11, 17, 16,  5, 14, 13,   15, 16, 17, 12, 13, 14};
+
+  using impl::g_tetChildren;
+  using impl::ShortestOctahedronDiagonal;
+
+/// `variant` is only relevant for tetrahedra and specifies the diagonal of the inner octahedron
+  RefinementTemplate const& GetRefinementTemplate (GrobType const grobType, index_t const variant)
   {
-    for (index_t childIndex : relation) {
-      childCoords [childIndex] = math::GrobCenter (relation.parent, parentCoords);
+    static RefinementTemplate const noTemplate {0, {}};
+    static RefinementTemplate const edgeTemplate {1, {{EDGE, 2, g_edgeChildren}}};
+    static RefinementTemplate const triTemplate {1, {{TRI, 4, g_triChildren}}};
+    static RefinementTemplate const quadTemplate {1, {{QUAD, 4, g_quadChildren}}};
+    static RefinementTemplate const tetTemplates [3] = {{1, {{TET, 8, g_tetChildren [0]}}},
+                                                        {1, {{TET, 8, g_tetChildren [1]}}},
+                                                        {1, {{TET, 8, g_tetChildren [2]}}}};
+    static RefinementTemplate const hexTemplate {1, {{HEX, 8, g_hexChildren}}};
+    static RefinementTemplate const pyraTemplate {2, {{PYRA, 6, g_pyraChildPyras},
+                                                      {TET, 4, g_pyraChildTets}}};
+    static RefinementTemplate const prismTemplate {1, {{PRISM, 8, g_prismChildren}}};
+
+    switch (grobType) {
+      case EDGE:  return edgeTemplate;
+      case TRI:   return triTemplate;
+      case QUAD:  return quadTemplate;
+      case TET:   return tetTemplates [variant];
+      case HEX:   return hexTemplate;
+      case PYRA:  return pyraTemplate;
+      case PRISM: return prismTemplate;
+      default:    return noTemplate;
     }
   }
 
-  childMesh.set_annex (keys::vertexCoords, std::move (childCoordsAnnex));
-}
+  SPMesh RefineGrobs (CSPMesh meshIn,
+                      std::vector <GrobType> const& grobTypes,
+                      RefinementCallback const& callback)
+  {
+    if (meshIn == nullptr) {
+      return {};
+    }
 
-std::vector <index_t> CreateTriangles (Mesh const& parentMesh,
-                                       GrobHashMap <index_t> const& parentEdges)
-{
-  std::vector <index_t> newTris;
-  newTris.resize (parentMesh.num_indices (TRIS) * 4);
-  
-  auto const& grobs = parentMesh.grobs (TRI);
+    Mesh const& parentMesh = *meshIn;
 
-  lume::parallel_for (0, grobs.size (), [&grobs, &parentEdges, &newTris] (size_t grobIndex)
-  {
-    auto const& grob = grobs [grobIndex];
-    std::array <index_t, 3> parentEdgeIndices;
-    for(index_t i = 0; i < 3; ++i) {
-        parentEdgeIndices [i] = parentEdges.at (grob.side (1, i));
+    std::vector <GrobType> parentTypes;
+    for (auto const grobType : grobTypes) {
+      if (GetRefinementTemplate (grobType, 0).numChildTemplates > 0 &&
+          parentMesh.has (grobType) &&
+          std::find (parentTypes.begin (), parentTypes.end (), grobType) == parentTypes.end ())
+      {
+        parentTypes.push_back (grobType);
+      }
     }
 
-    size_t ito = grobIndex * 12;
-    for (index_t i = 0; i < 3; ++i)
+    auto const parentEdgesPtr = CachedGrobSides (parentMesh, parentTypes, EDGES);
+    auto const parentQuadsPtr = CachedGrobSides (parentMesh, parentTypes, QUADS);
+    GrobSides const& parentEdges = *parentEdgesPtr;
+    GrobSides const& parentQuads = *parentQuadsPtr;
+
+    auto const& edges = parentEdges.sides (EDGE);
+    auto const& quads = parentQuads.sides (QUAD);
+    bool const refineHexes = std::find (parentTypes.begin (), parentTypes.end (), HEX) != parentTypes.end ();
+
+    size_t const numParentVertices = parentMesh.num (VERTEX);
+    size_t const firstEdgeVertex   = numParentVertices;
+    size_t const firstQuadVertex   = firstEdgeVertex + edges.size ();
+    size_t const firstHexVertex    = firstQuadVertex + quads.size ();
+    size_t const numChildVertices  = firstHexVertex + (refineHexes ? parentMesh.num (HEX) : 0);
+
+    if (numChildVertices >= NO_INDEX) {
+      throw LumeError () << "RefineMesh: Too many vertices in refined mesh (" << numChildVertices << ").";
+    }
+
+    auto childMesh = std::make_shared <Mesh> ();
+    childMesh->resize_vertices (numChildVertices);
+
+    Hierarchy hierarchy (meshIn, childMesh);
+    hierarchy.resize (VERTEX, numChildVertices);
+
+    auto const& parentVertices = parentMesh.grobs (VERTEX);
+    parallel_for (size_t (0), numParentVertices, [&] (size_t const i) {
+      hierarchy.set_relation (i, parentVertices [i], VERTEX, static_cast <index_t> (i), 1, static_cast <index_t> (i));
+    });
+
+    parallel_for (size_t (0), edges.size (), [&] (size_t const i) {
+      hierarchy.set_relation (firstEdgeVertex + i, edges [i], VERTEX, static_cast <index_t> (firstEdgeVertex + i), 1);
+    });
+
+    parallel_for (size_t (0), quads.size (), [&] (size_t const i) {
+      hierarchy.set_relation (firstQuadVertex + i, quads [i], VERTEX, static_cast <index_t> (firstQuadVertex + i), 1);
+    });
+
+    if (refineHexes) {
+      auto const& hexes = parentMesh.grobs (HEX);
+      parallel_for (size_t (0), hexes.size (), [&] (size_t const i) {
+        hierarchy.set_relation (firstHexVertex + i, hexes [i], VERTEX,
+                                static_cast <index_t> (firstHexVertex + i), 1, static_cast <index_t> (i));
+      });
+    }
+
+  //  all children of a given type are stored consecutively for each parent type
+    std::array <size_t, NUM_GROB_TYPES> numChildren {};
+    std::array <size_t, NUM_GROB_TYPES> numRelations {};
+    std::array <std::array <size_t, NUM_GROB_TYPES>, NUM_GROB_TYPES> firstChild {};
+    std::array <std::array <size_t, NUM_GROB_TYPES>, NUM_GROB_TYPES> firstRelation {};
+
+    for (auto const parentType : parentTypes)
     {
-        newTris [ito++] = grob.corner (i);
-        newTris [ito++] = parentEdgeIndices [i];
-        newTris [ito++] = parentEdgeIndices [(i+2) % 3];
+      auto const& refTemplate = GetRefinementTemplate (parentType, 0);
+      for (index_t i = 0; i < refTemplate.numChildTemplates; ++i)
+      {
+        auto const& childTemplate = refTemplate.childTemplates [i];
+        GrobType const childType = childTemplate.childType;
+        firstChild [parentType][childType] = numChildren [childType];
+        firstRelation [parentType][childType] = numRelations [childType];
+        numChildren [childType] += parentMesh.num (parentType) * childTemplate.numChildren;
+        numRelations [childType] += parentMesh.num (parentType);
+      }
     }
 
-    newTris [ito++] = parentEdgeIndices [0];
-    newTris [ito++] = parentEdgeIndices [1];
-    newTris [ito++] = parentEdgeIndices [2];
-  });
+    std::vector <GrobArray> childGrobs;
+    childGrobs.reserve (NUM_GROB_TYPES);
+    for (index_t i = 0; i < NUM_GROB_TYPES; ++i)
+    {
+      GrobType const childType = static_cast <GrobType> (i);
+      childGrobs.emplace_back (childType);
+      if (numChildren [childType] > 0) {
+        if (numChildren [childType] >= NO_INDEX) {
+          throw LumeError () << "RefineMesh: Too many children of type "
+                             << GrobTypeName (childType) << " (" << numChildren [childType] << ").";
+        }
+        childGrobs.back ().resize (numChildren [childType]);
+        hierarchy.resize (childType, numRelations [childType]);
+      }
+    }
 
-  return newTris;
-}
+    bool const hasCoords = parentMesh.has_annex (keys::vertexCoords);
 
-SPMesh RefineTriangles (CSPMesh meshIn)
-{
-  if (meshIn == nullptr) {
-    return {};
-  }
+    for (auto const parentType : parentTypes)
+    {
+      auto const& parentGrobs = parentMesh.grobs (parentType);
 
-  Mesh const& parentMesh = *meshIn;
-  index_t const numOldVertices = static_cast <index_t> (parentMesh.num (VERTEX));
+      real_t const* coords = nullptr;
+      index_t coordsTupleSize = 0;
+      if (parentType == TET && hasCoords) {
+        auto const& coordsAnnex = parentMesh.annex (keys::vertexCoords);
+        coords = coordsAnnex.data ();
+        coordsTupleSize = coordsAnnex.tuple_size ();
+      }
 
-  GrobHashMap <index_t> parentEdges;
-  parentEdges.reserve (parentMesh.num (EDGE));
-  FindUniqueSidesNumbered (parentEdges, parentMesh, TRIS, 1, numOldVertices);
+      parallel_for (size_t (0), parentGrobs.size (), [&] (size_t const grobIndex)
+      {
+        ConstGrob const grob = parentGrobs [grobIndex];
+        GrobIndex const grobIndexWithType (parentType, static_cast <index_t> (grobIndex));
 
-  index_t const numParentEdges = static_cast <index_t> (parentEdges.size ());
-  index_t const numNewVertices   = numOldVertices + numParentEdges;
+        std::array <index_t, MAX_NUM_REFINEMENT_VERTICES> refVrts;
+        index_t numRefVrts = 0;
 
-  auto childMesh = std::make_shared <Mesh> ();
+        for (index_t i = 0; i < grob.num_corners (); ++i) {
+          refVrts [numRefVrts++] = grob.corner (i);
+        }
 
-  childMesh->resize_vertices (numNewVertices);
+        for (index_t i = 0; i < parentEdges.num_local_sides (parentType); ++i) {
+          refVrts [numRefVrts++] = static_cast <index_t> (firstEdgeVertex + parentEdges.side_index (grobIndexWithType, i));
+        }
 
-  Hierarchy hierarchy (meshIn, childMesh);
-  hierarchy.reserve (VERTEX, numNewVertices);
+        for (index_t i = 0; i < parentQuads.num_local_sides (parentType); ++i) {
+          index_t const quadIndex = parentQuads.side_index (grobIndexWithType, i);
+          if (quadIndex != NO_INDEX) {
+            refVrts [numRefVrts++] = static_cast <index_t> (firstQuadVertex + quadIndex);
+          }
+        }
 
-  auto const& parentVertices = parentMesh.grobs (VERTEX);
-  for (size_t i = 0; i < parentVertices.size (); ++i) {
-    hierarchy.add_relation (parentVertices [i], VERTEX, static_cast <index_t> (i), 1);
-  }
+        if (parentType == HEX) {
+          refVrts [numRefVrts++] = static_cast <index_t> (firstHexVertex + grobIndex);
+        }
 
-  for (auto const& entry : parentEdges) {
-    hierarchy.add_relation (entry.first, VERTEX, entry.second, 1);
-  }
+        index_t const variant = coords ? ShortestOctahedronDiagonal (grob, coords, coordsTupleSize) : 0;
+        auto const& refTemplate = GetRefinementTemplate (parentType, variant);
 
-  std::vector <index_t> newTris = CreateTriangles (parentMesh, parentEdges);
+        for (index_t i = 0; i < refTemplate.numChildTemplates; ++i)
+        {
+          auto const& childTemplate = refTemplate.childTemplates [i];
+          GrobType const childType = childTemplate.childType;
+          index_t const numCorners = childGrobs [childType].grob_desc ().num_corners ();
+          size_t const firstChildIndex = firstChild [parentType][childType] + grobIndex * childTemplate.numChildren;
 
-  childMesh->set_grobs (GrobArray (TRI, std::move (newTris)));
+          index_t* childCorners = childGrobs [childType].data () + firstChildIndex * numCorners;
+          index_t const numChildCorners = childTemplate.numChildren * numCorners;
+          for (index_t j = 0; j < numChildCorners; ++j) {
+            childCorners [j] = refVrts [childTemplate.corners [j]];
+          }
 
-  auto const& parentTris = parentMesh.grobs (TRI);
-  hierarchy.reserve (TRI, parentTris.size ());
-  for (size_t i = 0; i < parentTris.size (); ++i) {
-    hierarchy.add_relation (parentTris [i], TRI, static_cast <index_t> (i), 4);
-  }
+          hierarchy.set_relation (firstRelation [parentType][childType] + grobIndex,
+                                  grob,
+                                  childType,
+                                  static_cast <index_t> (firstChildIndex),
+                                  childTemplate.numChildren,
+                                  static_cast <index_t> (grobIndex));
+        }
+      });
+    }
+
+    for (auto& grobs : childGrobs) {
+      if (!grobs.empty ()) {
+        childMesh->set_grobs (std::move (grobs));
+      }
+    }
+
+    if (callback) {
+      callback (hierarchy);
+    }
 
-  auto cleanUpFuture = std::async (std::launch::async, [&parentEdges] () {GrobHashMap <index_t> hashDeleter (std::move (parentEdges));});
+    return childMesh;
+  }
+}// end of unnamed namespace
 
-  RefinementCallback (std::move (hierarchy));
+SPMesh RefineMesh (CSPMesh mesh, RefinementCallback const& callback)
+{
+  if (mesh == nullptr) {
+    return {};
+  }
+  return RefineGrobs (mesh, mesh->grob_types (), callback);
+}
 
-  cleanUpFuture.wait ();
-  return childMesh;
+SPMesh RefineTriangles (CSPMesh mesh, RefinementCallback const& callback)
+{
+  return RefineGrobs (mesh, {TRI}, callback);
 }
 
 }// end of namespace lume
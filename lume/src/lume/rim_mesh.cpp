@@ -25,6 +25,7 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "lume/rim_mesh.h"
+#include "lume/derived_data.h"
 #include "lume/neighborhoods.h"
 
 namespace lume {
@@ -40,10 +41,10 @@ void CreateRimMesh (SPMesh rimMeshOut,
 
 	GrobSet rimGrobSet = grobSet.side_set ();
 
-	Neighborhoods localNbrhds;
+	std::shared_ptr <Neighborhoods const> cachedNbrhds;
 	if (!nbrhds) {
-		localNbrhds.refresh (mesh, rimGrobSet, grobSet);
-		nbrhds = &localNbrhds;
+		cachedNbrhds = CachedNeighborhoods (mesh, rimGrobSet, grobSet);
+		nbrhds = cachedNbrhds.get ();
 	}
 	else if (nbrhds->center_grob_set() != rimGrobSet || nbrhds->neighbor_grob_set() != grobSet)
 		throw LumeError () << "CreateRimMesh can't operate on provided neighborhoods instance.";
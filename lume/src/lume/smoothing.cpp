@@ -0,0 +1,286 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/smoothing.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <lume/array_annex.h>
+#include <lume/derived_data.h>
+#include <lume/grob_set_types.h>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+#include <lume/math/raw/vector_math_raw.h>
+
+namespace lume
+{
+
+namespace
+{
+
+/// Neighbors of all vertices in compressed rows
+struct VertexAdjacency
+{
+  std::vector <index_t> offsets;
+  std::vector <index_t> neighbors;
+  /// Normalized weights of the neighbors. Empty for uniform weights.
+  std::vector <real_t>  weights;
+};
+
+/// Sum of the halved cotangents of the angles opposite to each edge
+std::vector <real_t> CotangentEdgeWeights (Mesh const& mesh,
+                                           GrobSides const& edgeSides,
+                                           real_t const* coords,
+                                           index_t const tupleSize)
+{
+  GrobArray const& edges = edgeSides.sides (EDGE);
+  std::vector <real_t> weights (edges.size (), 0);
+
+  parallel_for_blocks (size_t (0), edges.size (), [&] (size_t const begin, size_t const end) {
+    for (size_t iedge = begin; iedge < end; ++iedge) {
+      GrobIndex const edge (EDGE, static_cast <index_t> (iedge));
+      index_t const c0 = edges [iedge].corner (0);
+      index_t const c1 = edges [iedge].corner (1);
+
+      real_t weight = 0;
+      for (index_t i = 0; i < edgeSides.num_incidences (edge); ++i) {
+        ConstGrob const tri = mesh.grob (edgeSides.incidence (edge, i).grob);
+        index_t opposite = NO_INDEX;
+        for (index_t j = 0; j < tri.num_corners (); ++j) {
+          if (tri.corner (j) != c0 && tri.corner (j) != c1) {
+            opposite = tri.corner (j);
+            break;
+          }
+        }
+
+      // degenerate triangles don't have an opposite corner
+        if (opposite == NO_INDEX)
+          continue;
+
+        real_t const* o = coords + tupleSize * opposite;
+        real_t const* a = coords + tupleSize * c0;
+        real_t const* b = coords + tupleSize * c1;
+        real_t dot = 0, lenSqA = 0, lenSqB = 0;
+        for (index_t k = 0; k < tupleSize; ++k) {
+          real_t const da = a [k] - o [k];
+          real_t const db = b [k] - o [k];
+          dot += da * db;
+          lenSqA += da * da;
+          lenSqB += db * db;
+        }
+
+        // the squared length of the cross product by Lagrange's identity
+        real_t const crossLen = std::sqrt (std::max (real_t (0), lenSqA * lenSqB - dot * dot));
+        if (crossLen > 0)
+          weight += real_t (0.5) * dot / crossLen;
+      }
+
+      weights [iedge] = std::max (real_t (0), weight);
+    }
+  });
+
+  return weights;
+}
+
+VertexAdjacency CreateVertexAdjacency (index_t const numVertices,
+                                       GrobArray const& edges,
+                                       std::vector <real_t> const& edgeWeights)
+{
+  VertexAdjacency adj;
+  adj.offsets.assign (numVertices + 1, 0);
+  for (auto const& edge : edges) {
+    ++adj.offsets [edge.corner (0) + 1];
+    ++adj.offsets [edge.corner (1) + 1];
+  }
+  for (index_t i = 0; i < numVertices; ++i)
+    adj.offsets [i + 1] += adj.offsets [i];
+
+  bool const weighted = !edgeWeights.empty ();
+  adj.neighbors.resize (adj.offsets.back ());
+  if (weighted)
+    adj.weights.resize (adj.offsets.back ());
+
+  std::vector <index_t> cursors (adj.offsets.begin (), adj.offsets.end () - 1);
+  for (size_t iedge = 0; iedge < edges.size (); ++iedge) {
+    index_t const c0 = edges [iedge].corner (0);
+    index_t const c1 = edges [iedge].corner (1);
+    if (weighted) {
+      adj.weights [cursors [c0]] = edgeWeights [iedge];
+      adj.weights [cursors [c1]] = edgeWeights [iedge];
+    }
+    adj.neighbors [cursors [c0]++] = c1;
+    adj.neighbors [cursors [c1]++] = c0;
+  }
+
+  if (weighted) {
+    parallel_for_blocks (index_t (0), numVertices, [&] (index_t const begin, index_t const end) {
+      for (index_t v = begin; v < end; ++v) {
+        real_t* w = adj.weights.data () + adj.offsets [v];
+        index_t const num = adj.offsets [v + 1] - adj.offsets [v];
+        real_t sum = 0;
+        for (index_t i = 0; i < num; ++i)
+          sum += w [i];
+        // fall back to uniform weights if all weights were clamped
+        for (index_t i = 0; i < num; ++i)
+          w [i] = sum > 0 ? w [i] / sum : real_t (1) / num;
+      }
+    });
+  }
+
+  return adj;
+}
+
+/// Writes the smoothed positions of `in` to `out`
+/** `N` is the tuple size, or 0 if it is only known at runtime.*/
+template <index_t N, bool weighted>
+void SmoothingIteration (real_t* out,
+                         real_t const* in,
+                         index_t const tupleSize,
+                         VertexAdjacency const& adj,
+                         std::vector <char> const& pinned,
+                         real_t const factor)
+{
+  index_t const n = N ? N : tupleSize;
+  index_t const numVertices = static_cast <index_t> (pinned.size ());
+
+  parallel_for_blocks (index_t (0), numVertices, [&] (index_t const begin, index_t const end) {
+    real_t avg [N ? N : 4];
+    std::vector <real_t> dynamicAvg (N ? 0 : n);
+    real_t* const sum = N ? avg : dynamicAvg.data ();
+
+    for (index_t v = begin; v < end; ++v) {
+      real_t const* p = in + v * n;
+      real_t* q = out + v * n;
+      index_t const first = adj.offsets [v];
+      index_t const last = adj.offsets [v + 1];
+
+      if (pinned [v] || first == last) {
+        for (index_t k = 0; k < n; ++k)
+          q [k] = p [k];
+        continue;
+      }
+
+      for (index_t k = 0; k < n; ++k)
+        sum [k] = 0;
+
+      for (index_t i = first; i < last; ++i) {
+        real_t const* neighbor = in + adj.neighbors [i] * n;
+        real_t const w = weighted ? adj.weights [i] : real_t (1);
+        for (index_t k = 0; k < n; ++k)
+          sum [k] += w * neighbor [k];
+      }
+
+      real_t const scale = weighted ? real_t (1) : real_t (1) / real_t (last - first);
+      for (index_t k = 0; k < n; ++k)
+        q [k] = p [k] + factor * (scale * sum [k] - p [k]);
+    }
+  });
+}
+
+template <bool weighted>
+void SmoothingIteration (real_t* out,
+                         real_t const* in,
+                         index_t const tupleSize,
+                         VertexAdjacency const& adj,
+                         std::vector <char> const& pinned,
+                         real_t const factor)
+{
+  switch (tupleSize) {
+    case 2: SmoothingIteration <2, weighted> (out, in, tupleSize, adj, pinned, factor); break;
+    case 3: SmoothingIteration <3, weighted> (out, in, tupleSize, adj, pinned, factor); break;
+    default: SmoothingIteration <0, weighted> (out, in, tupleSize, adj, pinned, factor); break;
+  }
+}
+
+}// end of unnamed namespace
+
+
+void SmoothVertices (Mesh& mesh, GrobSet const grobSet, SmoothingOptions const& options)
+{
+  if (grobSet.dim () < 2)
+    throw LumeError () << "SmoothVertices: Only faces and cells are supported, but got " << grobSet.name ();
+
+  auto& coordsAnnex = mesh.annex (keys::vertexCoords);
+  index_t const tupleSize = static_cast <index_t> (coordsAnnex.tuple_size ());
+  index_t const numVertices = static_cast <index_t> (mesh.num (VERTEX));
+  if (numVertices == 0 || options.numIterations == 0)
+    return;
+
+  auto const edgeSides = CachedGrobSides (mesh, grobSet, EDGES);
+
+  std::vector <real_t> edgeWeights;
+  if (options.weights == SmoothingWeights::Cotangent) {
+    for (auto const grobType : grobSet) {
+      if (grobType != TRI && mesh.num (grobType) > 0)
+        throw LumeError () << "SmoothVertices: Cotangent weights require a mesh which only consists of triangles.";
+    }
+    edgeWeights = CotangentEdgeWeights (mesh, *edgeSides, coordsAnnex.data (), tupleSize);
+  }
+
+  VertexAdjacency const adj = CreateVertexAdjacency (numVertices, edgeSides->sides (EDGE), edgeWeights);
+
+  std::vector <char> pinned (numVertices, 0);
+  if (options.pinBoundary) {
+    GrobSet const sideSet = GrobSetTypeByDim (grobSet.dim () - 1);
+    auto const sides = CachedGrobSides (mesh, grobSet, sideSet);
+    for (auto const sideType : sideSet) {
+      GrobArray const& sideGrobs = sides->sides (sideType);
+      for (index_t i = 0; i < sideGrobs.size (); ++i) {
+        if (sides->num_incidences (GrobIndex (sideType, i)) != 1)
+          continue;
+        ConstGrob const side = sideGrobs [i];
+        for (index_t j = 0; j < side.num_corners (); ++j)
+          pinned [side.corner (j)] = 1;
+      }
+    }
+  }
+
+  TypedAnnexKey <IndexArrayAnnex> const pinMaskKey (options.pinMaskName, VERTEX);
+  if (!options.pinMaskName.empty () && mesh.has_annex (pinMaskKey)) {
+    auto const& mask = mesh.annex (pinMaskKey);
+    for (index_t v = 0; v < numVertices && v < mask.size (); ++v)
+      pinned [v] |= mask [v] != 0;
+  }
+
+  std::vector <real_t> buffer (coordsAnnex.size ());
+  real_t* in = coordsAnnex.data ();
+  real_t* out = buffer.data ();
+
+  for (index_t iteration = 0; iteration < options.numIterations; ++iteration) {
+    real_t const factor = options.mu != 0 && iteration % 2 == 1 ? options.mu : options.lambda;
+    if (adj.weights.empty ())
+      SmoothingIteration <false> (out, in, tupleSize, adj, pinned, factor);
+    else
+      SmoothingIteration <true> (out, in, tupleSize, adj, pinned, factor);
+    std::swap (in, out);
+  }
+
+  if (in != coordsAnnex.data ())
+    std::copy (buffer.begin (), buffer.end (), coordsAnnex.data ());
+
+  mesh.invalidate_derived_data ();
+}
+
+}// end of namespace lume
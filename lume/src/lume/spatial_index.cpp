@@ -0,0 +1,443 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/spatial_index.h>
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+namespace
+{
+  constexpr index_t g_kdLeafSize = 8;
+  constexpr index_t g_kdParallelBuildThreshold = 8192;
+
+  /// Copies points with `dim` components to an array with 3 components per point
+  std::vector <real_t> PadTo3 (real_t const* coords, size_t const numPoints, index_t const dim)
+  {
+    if (dim < 1 || dim > 3)
+      throw BadTupleSizeError () << "Spatial index: Unsupported number of point components " << dim;
+
+    std::vector <real_t> padded (numPoints * 3, 0);
+    for (size_t i = 0; i < numPoints; ++i) {
+      for (index_t j = 0; j < dim; ++j)
+        padded [i * 3 + j] = coords [i * dim + j];
+    }
+    return padded;
+  }
+
+  inline real_t DistSq (real_t const* a, real_t const* b, index_t const dim)
+  {
+    real_t d = 0;
+    for (index_t i = 0; i < dim; ++i)
+      d += (a[i] - b[i]) * (a[i] - b[i]);
+    return d;
+  }
+
+  class KNearestVisitor
+  {
+  public:
+    KNearestVisitor (index_t const k) : m_k (k)  {m_heap.reserve (k);}
+
+    real_t max_dist_sq () const
+    {
+      return m_heap.size () < m_k ? std::numeric_limits <real_t>::max () : m_heap.front ().first;
+    }
+
+    void visit (index_t const i, real_t const distSq)
+    {
+      if (m_heap.size () < m_k) {
+        m_heap.emplace_back (distSq, i);
+        std::push_heap (m_heap.begin (), m_heap.end ());
+      }
+      else if (distSq < m_heap.front ().first) {
+        std::pop_heap (m_heap.begin (), m_heap.end ());
+        m_heap.back () = {distSq, i};
+        std::push_heap (m_heap.begin (), m_heap.end ());
+      }
+    }
+
+    /// Returns the positions of the found points in the tree, sorted by distance.
+    std::vector <std::pair <real_t, index_t>>& sorted ()
+    {
+      std::sort_heap (m_heap.begin (), m_heap.end ());
+      return m_heap;
+    }
+
+  private:
+    index_t const m_k;
+    std::vector <std::pair <real_t, index_t>> m_heap;
+  };
+
+  class InRadiusVisitor
+  {
+  public:
+    InRadiusVisitor (real_t const radius, std::vector <index_t>& positionsOut)
+      : m_radiusSq (radius * radius)
+      , m_positions (positionsOut)
+    {}
+
+    real_t max_dist_sq () const  {return m_radiusSq;}
+
+    void visit (index_t const i, real_t const distSq)
+    {
+      if (distSq <= m_radiusSq)
+        m_positions.push_back (i);
+    }
+
+  private:
+    real_t const m_radiusSq;
+    std::vector <index_t>& m_positions;
+  };
+
+  /// Executes `index.in_radius` for each point in parallel and concatenates the results.
+  template <class TIndex>
+  void BatchedInRadius (TIndex const& index,
+                        std::vector <real_t> const& points,
+                        real_t const radius,
+                        std::vector <index_t>& offsetsOut,
+                        std::vector <index_t>& indicesOut)
+  {
+    index_t const dim = index.dim ();
+    if (points.size () % dim != 0)
+      throw BadTupleSizeError () << "Spatial index: The number of components has to be a multiple of " << dim;
+
+    size_t const numPoints = points.size () / dim;
+
+    struct BlockResult
+    {
+      std::vector <index_t> counts;
+      std::vector <index_t> indices;
+    };
+
+    std::mutex resultMutex;
+    std::map <size_t, BlockResult> blockResults;
+
+    parallel_for_blocks (size_t (0), numPoints, [&] (size_t const begin, size_t const end) {
+      BlockResult result;
+      result.counts.reserve (end - begin);
+      std::vector <index_t> found;
+      for (size_t i = begin; i < end; ++i) {
+        index.in_radius (points.data () + i * dim, radius, found);
+        result.counts.push_back (static_cast <index_t> (found.size ()));
+        result.indices.insert (result.indices.end (), found.begin (), found.end ());
+      }
+      std::lock_guard <std::mutex> lock (resultMutex);
+      blockResults [begin] = std::move (result);
+    });
+
+    offsetsOut.resize (numPoints + 1);
+    offsetsOut [0] = 0;
+    indicesOut.clear ();
+    size_t ipoint = 0;
+    for (auto& entry : blockResults) {
+      for (auto count : entry.second.counts) {
+        offsetsOut [ipoint + 1] = offsetsOut [ipoint] + count;
+        ++ipoint;
+      }
+      indicesOut.insert (indicesOut.end (), entry.second.indices.begin (), entry.second.indices.end ());
+    }
+  }
+}// end of unnamed namespace
+
+
+////////////////////////////////////////////////////////////////////////////////
+// KdTree
+
+KdTree::KdTree (RealArrayAnnex const& coords)
+  : KdTree (coords.data (), coords.num_tuples (), static_cast <index_t> (coords.tuple_size ()))
+{}
+
+
+KdTree::KdTree (real_t const* coords, size_t const numPoints, index_t const dim)
+  : m_dim (dim)
+  , m_points (PadTo3 (coords, numPoints, dim))
+  , m_indices (numPoints)
+  , m_axes (numPoints, 0)
+{
+  std::iota (m_indices.begin (), m_indices.end (), 0);
+
+  int parallelDepth = 0;
+  for (unsigned numThreads = std::thread::hardware_concurrency (); numThreads > 1; numThreads /= 2)
+    ++parallelDepth;
+
+  build (0, static_cast <index_t> (numPoints), parallelDepth);
+
+  // store the points in tree order
+  std::vector <real_t> sorted (m_points.size ());
+  for (size_t i = 0; i < numPoints; ++i) {
+    for (int j = 0; j < 3; ++j)
+      sorted [i * 3 + j] = m_points [m_indices [i] * 3 + j];
+  }
+  m_points.swap (sorted);
+}
+
+
+void KdTree::build (index_t const begin, index_t const end, int const parallelDepth)
+{
+  if (end - begin <= g_kdLeafSize)
+    return;
+
+  real_t min [3], max [3];
+  std::fill (min, min + 3, std::numeric_limits <real_t>::max ());
+  std::fill (max, max + 3, std::numeric_limits <real_t>::lowest ());
+  for (index_t i = begin; i < end; ++i) {
+    real_t const* p = m_points.data () + m_indices [i] * 3;
+    for (index_t j = 0; j < m_dim; ++j) {
+      min [j] = std::min (min [j], p [j]);
+      max [j] = std::max (max [j], p [j]);
+    }
+  }
+
+  int axis = 0;
+  for (index_t j = 1; j < m_dim; ++j) {
+    if (max [j] - min [j] > max [axis] - min [axis])
+      axis = static_cast <int> (j);
+  }
+
+  index_t const mid = begin + (end - begin) / 2;
+  std::nth_element (m_indices.begin () + begin,
+                    m_indices.begin () + mid,
+                    m_indices.begin () + end,
+                    [this, axis] (index_t const a, index_t const b) {
+                      return m_points [a * 3 + axis] < m_points [b * 3 + axis];
+                    });
+  m_axes [mid] = static_cast <int8_t> (axis);
+
+  if (parallelDepth > 0 && end - begin >= g_kdParallelBuildThreshold) {
+    auto future = std::async (std::launch::async, [=] () {build (mid + 1, end, parallelDepth - 1);});
+    build (begin, mid, parallelDepth - 1);
+    future.get ();
+  }
+  else {
+    build (begin, mid, 0);
+    build (mid + 1, end, 0);
+  }
+}
+
+
+template <class TVisitor>
+void KdTree::search (index_t const begin, index_t const end, real_t const* p, TVisitor& visitor) const
+{
+  if (end - begin <= g_kdLeafSize) {
+    for (index_t i = begin; i < end; ++i)
+      visitor.visit (i, DistSq (p, m_points.data () + i * 3, m_dim));
+    return;
+  }
+
+  index_t const mid = begin + (end - begin) / 2;
+  real_t const* midPoint = m_points.data () + mid * 3;
+  visitor.visit (mid, DistSq (p, midPoint, m_dim));
+
+  int const axis = m_axes [mid];
+  real_t const diff = p [axis] - midPoint [axis];
+  if (diff < 0) {
+    search (begin, mid, p, visitor);
+    if (diff * diff <= visitor.max_dist_sq ())
+      search (mid + 1, end, p, visitor);
+  }
+  else {
+    search (mid + 1, end, p, visitor);
+    if (diff * diff <= visitor.max_dist_sq ())
+      search (begin, mid, p, visitor);
+  }
+}
+
+
+index_t KdTree::nearest (real_t const* p) const
+{
+  KNearestVisitor visitor (1);
+  search (0, static_cast <index_t> (m_indices.size ()), p, visitor);
+  auto const& found = visitor.sorted ();
+  return found.empty () ? NO_INDEX : m_indices [found.front ().second];
+}
+
+
+void KdTree::k_nearest (real_t const* p, index_t const k, std::vector <index_t>& indicesOut) const
+{
+  indicesOut.clear ();
+  if (k == 0)
+    return;
+
+  KNearestVisitor visitor (k);
+  search (0, static_cast <index_t> (m_indices.size ()), p, visitor);
+  for (auto const& entry : visitor.sorted ())
+    indicesOut.push_back (m_indices [entry.second]);
+}
+
+
+void KdTree::in_radius (real_t const* p, real_t const radius, std::vector <index_t>& indicesOut) const
+{
+  indicesOut.clear ();
+  InRadiusVisitor visitor (radius, indicesOut);
+  search (0, static_cast <index_t> (m_indices.size ()), p, visitor);
+  for (auto& i : indicesOut)
+    i = m_indices [i];
+}
+
+
+std::vector <index_t> KdTree::k_nearest (std::vector <real_t> const& points, index_t const k) const
+{
+  if (points.size () % m_dim != 0)
+    throw BadTupleSizeError () << "KdTree::k_nearest: The number of components has to be a multiple of " << m_dim;
+
+  size_t const numPoints = points.size () / m_dim;
+  std::vector <index_t> result (numPoints * k, NO_INDEX);
+
+  parallel_for_blocks (size_t (0), numPoints, [&] (size_t const begin, size_t const end) {
+    std::vector <index_t> found;
+    for (size_t i = begin; i < end; ++i) {
+      k_nearest (points.data () + i * m_dim, k, found);
+      std::copy (found.begin (), found.end (), result.begin () + i * k);
+    }
+  });
+
+  return result;
+}
+
+
+void KdTree::in_radius (std::vector <real_t> const& points,
+                        real_t const radius,
+                        std::vector <index_t>& offsetsOut,
+                        std::vector <index_t>& indicesOut) const
+{
+  BatchedInRadius (*this, points, radius, offsetsOut, indicesOut);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// PointGrid
+
+PointGrid::PointGrid (RealArrayAnnex const& coords, real_t const cellSize)
+  : PointGrid (coords.data (), coords.num_tuples (), static_cast <index_t> (coords.tuple_size ()), cellSize)
+{}
+
+
+PointGrid::PointGrid (real_t const* coords, size_t const numPoints, index_t const dim, real_t const cellSize)
+  : m_dim (dim)
+  , m_cellSize (cellSize)
+{
+  if (!(cellSize > 0))
+    throw LumeError () << "PointGrid: The cell size has to be positive, but is " << cellSize;
+
+  std::vector <real_t> const points = PadTo3 (coords, numPoints, dim);
+
+  size_t numBuckets = 1;
+  while (numBuckets < 2 * numPoints)
+    numBuckets *= 2;
+  m_bucketMask = numBuckets - 1;
+
+  std::vector <index_t> buckets (numPoints);
+  parallel_for_blocks (size_t (0), numPoints, [&] (size_t const begin, size_t const end) {
+    for (size_t i = begin; i < end; ++i)
+      buckets [i] = static_cast <index_t> (bucket (cell (points.data () + i * 3)));
+  });
+
+  // counting sort of the points by bucket
+  m_bucketOffsets.assign (numBuckets + 1, 0);
+  for (auto b : buckets)
+    ++m_bucketOffsets [b + 1];
+  for (size_t i = 0; i < numBuckets; ++i)
+    m_bucketOffsets [i + 1] += m_bucketOffsets [i];
+
+  std::vector <index_t> fill (m_bucketOffsets.begin (), m_bucketOffsets.end () - 1);
+  m_indices.resize (numPoints);
+  m_points.resize (numPoints * 3);
+  for (size_t i = 0; i < numPoints; ++i) {
+    index_t const slot = fill [buckets [i]]++;
+    m_indices [slot] = static_cast <index_t> (i);
+    std::copy (points.begin () + i * 3, points.begin () + i * 3 + 3, m_points.begin () + slot * 3);
+  }
+}
+
+
+PointGrid::Cell PointGrid::cell (real_t const* p) const
+{
+  Cell c {0, 0, 0};
+  for (index_t i = 0; i < m_dim; ++i)
+    c [i] = static_cast <int64_t> (std::floor (p [i] / m_cellSize));
+  return c;
+}
+
+
+size_t PointGrid::bucket (Cell const& c) const
+{
+  uint64_t const h =   static_cast <uint64_t> (c [0]) * 73856093u
+                     ^ static_cast <uint64_t> (c [1]) * 19349663u
+                     ^ static_cast <uint64_t> (c [2]) * 83492791u;
+  return static_cast <size_t> (h & m_bucketMask);
+}
+
+
+void PointGrid::in_radius (real_t const* p, real_t const radius, std::vector <index_t>& indicesOut) const
+{
+  indicesOut.clear ();
+  if (m_indices.empty ())
+    return;
+
+  real_t lo [3] = {0, 0, 0};
+  real_t hi [3] = {0, 0, 0};
+  for (index_t i = 0; i < m_dim; ++i) {
+    lo [i] = p [i] - radius;
+    hi [i] = p [i] + radius;
+  }
+  Cell const loCell = cell (lo);
+  Cell const hiCell = cell (hi);
+  real_t const radiusSq = radius * radius;
+
+  Cell c;
+  for (c [2] = loCell [2]; c [2] <= hiCell [2]; ++c [2]) {
+    for (c [1] = loCell [1]; c [1] <= hiCell [1]; ++c [1]) {
+      for (c [0] = loCell [0]; c [0] <= hiCell [0]; ++c [0]) {
+        size_t const b = bucket (c);
+        for (index_t i = m_bucketOffsets [b]; i < m_bucketOffsets [b + 1]; ++i) {
+          real_t const* q = m_points.data () + i * 3;
+          // different cells may share a bucket. Each point is only reported for its own cell.
+          if (DistSq (p, q, m_dim) <= radiusSq && cell (q) == c)
+            indicesOut.push_back (m_indices [i]);
+        }
+      }
+    }
+  }
+}
+
+
+void PointGrid::in_radius (std::vector <real_t> const& points,
+                           real_t const radius,
+                           std::vector <index_t>& offsetsOut,
+                           std::vector <index_t>& indicesOut) const
+{
+  BatchedInRadius (*this, points, radius, offsetsOut, indicesOut);
+}
+
+}// end of namespace lume
@@ -42,6 +42,13 @@ SubsetInfoAnnex(const std::string& name) :
 	m_name (name)
 {}
 
+SubsetInfoAnnex::
+SubsetInfoAnnex (const SubsetInfoAnnex& sia) :
+    m_name (sia.m_name),
+    m_subsetProps (sia.m_subsetProps)
+{
+}
+
 SubsetInfoAnnex::
 SubsetInfoAnnex (SubsetInfoAnnex&& sia) :
     m_name (std::move (sia.m_name)),
@@ -23,19 +23,53 @@
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "lume/surface_analytics.h"
-#include "lume/topology.h"
+#include "lume/derived_data.h"
 
 namespace lume {
 
+namespace {
+
+/// Returns a vector which stores at position `i` the number of edges with `i` adjacent faces.
+/** Equivalent to `ValenceHistogram (mesh, EDGES, FACES)`, but the edges are taken from the
+    mesh's derived data cache.*/
+std::vector <index_t> EdgeFaceValenceHistogram (const Mesh& mesh)
+{
+    const auto sides = CachedGrobSides (mesh, {EDGE, TRI, QUAD}, EDGES);
+
+    std::vector <index_t> histogram;
+    for (index_t iedge = 0; iedge < sides->num_sides (EDGE); ++iedge)
+    {
+        const GrobIndex edge (EDGE, iedge);
+        const index_t numIncidences = sides->num_incidences (edge);
+
+        index_t valence = 0;
+        for (index_t i = 0; i < numIncidences; ++i)
+        {
+            // explicitly stored edges are regarded as their own sides
+            if (sides->incidence (edge, i).grob.grob_type () != EDGE)
+                ++valence;
+        }
+
+        if (valence >= static_cast <index_t> (histogram.size ()))
+            histogram.resize (valence + 1, 0);
+
+        ++histogram [valence];
+    }
+
+    return histogram;
+}
+
+}// end of unnamed namespace
+
 bool IsManifoldMesh (const Mesh& mesh)
 {
-    auto histogram = ValenceHistogram (mesh, EDGES, FACES);
+    auto histogram = EdgeFaceValenceHistogram (mesh);
     return histogram.size () <= 3;
 }
 
 bool IsClosedManifoldMesh (const Mesh& mesh)
 {
-    auto histogram = ValenceHistogram (mesh, EDGES, FACES);
+    auto histogram = EdgeFaceValenceHistogram (mesh);
     return histogram.size () == 3
            && histogram [0] == 0
            && histogram [1] == 0
@@ -0,0 +1,109 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/vertex_incidence.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <lume/lume_error.h>
+#include <lume/parallel_for.h>
+
+namespace lume
+{
+
+VertexIncidence::VertexIncidence (Mesh const& mesh, GrobSet const grobSet)
+  : m_grobSet (grobSet)
+  , m_numVertices (mesh.num (VERTEX))
+  , m_numSlots (std::max <index_t> (1, grobSet.size ()))
+{
+  m_typeSlots.fill (NO_INDEX);
+  for (index_t i = 0; i < grobSet.size (); ++i)
+    m_typeSlots [grobSet.grob_type (i)] = i;
+
+  size_t const numSegments = m_numVertices * m_numSlots;
+  if (numSegments >= NO_INDEX || mesh.num_indices (grobSet) >= NO_INDEX) {
+    throw LumeError () << "VertexIncidence: Too many incidences for 32 bit indices.";
+  }
+
+  // counters are used for counting in the first pass and as insertion cursors in the second pass
+  std::unique_ptr <std::atomic <index_t> []> counters (new std::atomic <index_t> [numSegments]);
+  parallel_for_blocks (size_t (0), numSegments, [&] (size_t const begin, size_t const end) {
+    for (size_t i = begin; i < end; ++i)
+      counters [i].store (0, std::memory_order_relaxed);
+  });
+
+  // exceptions can't leave the parallel passes, invalid corners are thus skipped and reported afterwards
+  std::atomic <bool> badCorner {false};
+  auto forEachCorner = [&] (auto const& func) {
+    for (index_t slot = 0; slot < grobSet.size (); ++slot) {
+      GrobType const grobType = grobSet.grob_type (slot);
+      index_t const numCorners = GrobDesc (grobType).num_corners ();
+      index_t const* corners = mesh.grobs (grobType).data ();
+      parallel_for_blocks (size_t (0), mesh.num (grobType), [&, slot, numCorners, corners] (size_t const begin,
+                                                                                            size_t const end)
+      {
+        for (size_t igrob = begin; igrob < end; ++igrob) {
+          for (index_t i = 0; i < numCorners; ++i) {
+            index_t const corner = corners [igrob * numCorners + i];
+            if (corner >= m_numVertices) {
+              badCorner.store (true, std::memory_order_relaxed);
+              continue;
+            }
+            func (static_cast <size_t> (corner) * m_numSlots + slot, static_cast <index_t> (igrob));
+          }
+        }
+      });
+    }
+  };
+
+  forEachCorner ([&] (size_t const segment, index_t) {
+    counters [segment].fetch_add (1, std::memory_order_relaxed);
+  });
+
+  if (badCorner) {
+    throw LumeError () << "VertexIncidence: Encountered a corner index which is not smaller "
+                          "than the number of vertices (" << m_numVertices << ").";
+  }
+
+  m_offsets.resize (numSegments + 1);
+  m_offsets [0] = 0;
+  for (size_t i = 0; i < numSegments; ++i) {
+    m_offsets [i + 1] = m_offsets [i] + counters [i].load (std::memory_order_relaxed);
+    counters [i].store (m_offsets [i], std::memory_order_relaxed);
+  }
+
+  m_grobs.resize (m_offsets.back ());
+  forEachCorner ([&] (size_t const segment, index_t const grob) {
+    m_grobs [counters [segment].fetch_add (1, std::memory_order_relaxed)] = grob;
+  });
+
+  // the order of the scatter depends on the thread schedule
+  parallel_for_blocks (size_t (0), numSegments, [&] (size_t const begin, size_t const end) {
+    for (size_t i = begin; i < end; ++i)
+      std::sort (m_grobs.begin () + m_offsets [i], m_grobs.begin () + m_offsets [i + 1]);
+  });
+}
+
+}// end of namespace lume
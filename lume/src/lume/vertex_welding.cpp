@@ -0,0 +1,188 @@
+// This file is part of lume, a C++ library for lightweight unstructured meshes
+//
+// Copyright (C) 2019 Sebastian Reiter <s.b.reiter@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+// THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <lume/vertex_welding.h>
+
+#include <algorithm>
+#include <cmath>
+#include <lume/array_annex.h>
+#include <lume/parallel_for.h>
+#include <lume/spatial_index.h>
+
+namespace lume
+{
+
+namespace
+{
+  index_t FindRoot (std::vector <index_t>& parents, index_t i)
+  {
+    while (parents [i] != i) {
+      parents [i] = parents [parents [i]];
+      i = parents [i];
+    }
+    return i;
+  }
+
+  /// Moves the tuples `keep [i]` of all array annexes of the given grob type to position `i`.
+  /** `keep` has to be sorted in ascending order.*/
+  void CompactAnnexes (Mesh& mesh, GrobType const grobType, std::vector <index_t> const& keep)
+  {
+    for (auto const& key : mesh.annex_keys ()) {
+      if (!key.grob_type () || *key.grob_type () != grobType)
+        continue;
+
+      VisitArrayAnnex (mesh.untyped_annex (key), [&keep] (auto& annex) {
+        size_t const tupleSize = annex.tuple_size ();
+        if (annex.num_tuples () < keep.size ())
+          return;
+        for (size_t i = 0; i < keep.size (); ++i) {
+          std::copy (annex.data () + keep [i] * tupleSize,
+                     annex.data () + (keep [i] + 1) * tupleSize,
+                     annex.data () + i * tupleSize);
+        }
+      });
+    }
+  }
+
+  bool HasRepeatedCorners (index_t const* corners, index_t const numCorners)
+  {
+    for (index_t i = 0; i < numCorners; ++i) {
+      for (index_t j = i + 1; j < numCorners; ++j) {
+        if (corners [i] == corners [j])
+          return true;
+      }
+    }
+    return false;
+  }
+}// end of unnamed namespace
+
+
+std::vector <index_t> WeldVertices (Mesh& mesh, real_t const tolerance)
+{
+  auto const& coords = mesh.annex (keys::vertexCoords);
+  index_t const numVertices = static_cast <index_t> (mesh.num (VERTEX));
+  index_t const dim = static_cast <index_t> (coords.tuple_size ());
+
+  std::vector <index_t> newIndices (numVertices);
+  if (numVertices == 0)
+    return newIndices;
+
+  // for exact matches, any positive cell size works. Choose one which is
+  // proportional to the average spacing of the vertices.
+  real_t cellSize = tolerance;
+  if (!(cellSize > 0)) {
+    real_t min [3], max [3];
+    std::fill (min, min + 3, std::numeric_limits <real_t>::max ());
+    std::fill (max, max + 3, std::numeric_limits <real_t>::lowest ());
+    for (index_t i = 0; i < numVertices; ++i) {
+      for (index_t j = 0; j < dim; ++j) {
+        min [j] = std::min (min [j], coords [i * dim + j]);
+        max [j] = std::max (max [j], coords [i * dim + j]);
+      }
+    }
+    real_t diagSq = 0;
+    for (index_t j = 0; j < dim; ++j)
+      diagSq += (max [j] - min [j]) * (max [j] - min [j]);
+    cellSize = std::sqrt (diagSq) / std::cbrt (static_cast <real_t> (numVertices));
+    if (!(cellSize > 0))
+      cellSize = 1;
+  }
+
+  PointGrid const grid (coords, cellSize);
+  std::vector <real_t> const points (coords.begin (), coords.begin () + numVertices * dim);
+  std::vector <index_t> offsets, nbrs;
+  grid.in_radius (points, std::max (tolerance, real_t (0)), offsets, nbrs);
+
+  // cluster close vertices. The root of each cluster is its smallest vertex.
+  std::vector <index_t> parents (numVertices);
+  for (index_t i = 0; i < numVertices; ++i)
+    parents [i] = i;
+
+  for (index_t i = 0; i < numVertices; ++i) {
+    for (index_t j = offsets [i]; j < offsets [i + 1]; ++j) {
+      index_t const a = FindRoot (parents, i);
+      index_t const b = FindRoot (parents, nbrs [j]);
+      if (a < b)
+        parents [b] = a;
+      else if (b < a)
+        parents [a] = b;
+    }
+  }
+
+  std::vector <index_t> keptVertices;
+  for (index_t i = 0; i < numVertices; ++i) {
+    index_t const root = FindRoot (parents, i);
+    if (root == i) {
+      newIndices [i] = static_cast <index_t> (keptVertices.size ());
+      keptVertices.push_back (i);
+    }
+    else
+      newIndices [i] = newIndices [root];
+  }
+
+  if (keptVertices.size () == numVertices)
+    return newIndices;
+
+  // remap corners and remove degenerated grobs
+  for (auto const grobType : mesh.grob_types ()) {
+    if (grobType == VERTEX)
+      continue;
+
+    auto const& grobs = mesh.grobs (grobType);
+    index_t const numCorners = grobs.grob_desc ().num_corners ();
+    index_t const numGrobs = static_cast <index_t> (grobs.size ());
+
+    std::vector <index_t> corners (grobs.data (), grobs.data () + numGrobs * numCorners);
+    parallel_for_blocks (size_t (0), corners.size (), [&] (size_t const begin, size_t const end) {
+      for (size_t i = begin; i < end; ++i)
+        corners [i] = newIndices [corners [i]];
+    });
+
+    std::vector <index_t> keptGrobs;
+    keptGrobs.reserve (numGrobs);
+    for (index_t i = 0; i < numGrobs; ++i) {
+      if (!HasRepeatedCorners (corners.data () + i * numCorners, numCorners))
+        keptGrobs.push_back (i);
+    }
+
+    if (keptGrobs.size () < numGrobs) {
+      for (size_t i = 0; i < keptGrobs.size (); ++i) {
+        std::copy (corners.begin () + keptGrobs [i] * numCorners,
+                   corners.begin () + (keptGrobs [i] + 1) * numCorners,
+                   corners.begin () + i * numCorners);
+      }
+      corners.resize (keptGrobs.size () * numCorners);
+      CompactAnnexes (mesh, grobType, keptGrobs);
+    }
+
+    mesh.set_grobs (GrobArray (grobType, std::move (corners)));
+  }
+
+  CompactAnnexes (mesh, VERTEX, keptVertices);
+  mesh.resize_vertices (keptVertices.size ());
+
+  return newIndices;
+}
+
+}// end of namespace lume
@@ -22,9 +22,15 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
 // THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include "lume/components.h"
 #include "lume/mesh.h"
 #include "lume/file_io.h"
+#include "lume/quality.h"
 #include "lume/surface_analytics.h"
 #include "lume/commands/commander.h"
 
@@ -91,6 +97,108 @@ namespace commands {
         }
     };
 
+    class Quality : public Command
+    {
+    public:
+        Quality ()
+            : Command ("Quality", "Prints statistics and histograms of element quality metrics for all faces and cells.",
+                       {ArgumentDesc (Type::Mesh, "mesh", "The mesh whose elements will be analyzed.")})
+        {}
+
+    protected:
+        void run (const Arguments& args) override
+        {
+            const index_t numBins = 10;
+            const QualityMetric metrics [] = {QualityMetric::Area,
+                                              QualityMetric::Volume,
+                                              QualityMetric::AspectRatio,
+                                              QualityMetric::MinAngle,
+                                              QualityMetric::JacobianDeterminant,
+                                              QualityMetric::ScaledJacobian};
+
+            auto mesh = args.get <SPMesh> ("mesh");
+            for (auto gt : mesh->grob_types ()) {
+                if (GrobDesc (gt).dim () < 2 || mesh->num (gt) == 0)
+                    continue;
+
+                cout << GrobSet (gt).name () << " (" << mesh->num (gt) << "):" << endl;
+                for (auto metric : metrics) {
+                    if (!IsQualityMetricSupported (metric, gt))
+                        continue;
+
+                    const auto quality = ComputeQuality (*mesh, gt, metric);
+                    const auto minMax = std::minmax_element (quality.begin (), quality.end ());
+                    const real_t minVal = *minMax.first;
+                    const real_t maxVal = *minMax.second;
+                    double sum = 0;
+                    for (auto v : quality)
+                        sum += v;
+
+                    cout << "  " << QualityMetricName (metric) << ":  min: " << minVal
+                         << ",  max: " << maxVal << ",  mean: " << sum / quality.size () << endl;
+
+                    if (!std::isfinite (minVal) || !std::isfinite (maxVal))
+                        continue;
+
+                    std::vector <index_t> bins (numBins, 0);
+                    const real_t binWidth = (maxVal - minVal) / numBins;
+                    for (auto v : quality) {
+                        const index_t bin = binWidth > 0 ?
+                                            static_cast <index_t> ((v - minVal) / binWidth) : 0;
+                        ++bins [std::min (bin, numBins - 1)];
+                    }
+
+                    const index_t maxCount = *std::max_element (bins.begin (), bins.end ());
+                    for (index_t i = 0; i < numBins; ++i) {
+                        cout << "    [" << std::setw (12) << minVal + i * binWidth << ", "
+                             << std::setw (12) << minVal + (i + 1) * binWidth << "]  "
+                             << std::setw (8) << bins [i] << "  "
+                             << std::string (bins [i] * 40 / maxCount, '#') << endl;
+                    }
+                }
+            }
+        }
+    };
+
+    class Components : public Command
+    {
+    public:
+        Components ()
+            : Command ("Components", "Prints the number and sizes of the connected components of the highest dimensional elements.",
+                       {ArgumentDesc (Type::Mesh, "mesh", "The mesh which will be analyzed.")})
+        {}
+
+    protected:
+        void run (const Arguments& args) override
+        {
+            auto mesh = args.get <SPMesh> ("mesh");
+
+            GrobSet grobSet;
+            for (auto gs : {CELLS, FACES, EDGES}) {
+                if (mesh->num (GrobSet (gs)) > 0) {
+                    grobSet = gs;
+                    break;
+                }
+            }
+
+            if (grobSet.dim () == 0) {
+                cout << "No edges, faces, or cells found.\n";
+                return;
+            }
+
+            const ComponentInfo info = LabelComponents (*mesh, grobSet);
+            cout << "Components of " << grobSet.name () << ": " << info.numComponents << endl;
+
+            std::vector <index_t> sizes = info.componentSizes;
+            std::sort (sizes.begin (), sizes.end (), std::greater <index_t> ());
+            const size_t maxNumPrinted = 20;
+            for (size_t i = 0; i < std::min (sizes.size (), maxNumPrinted); ++i)
+                cout << "  " << std::setw (8) << sizes [i] << endl;
+            if (sizes.size () > maxNumPrinted)
+                cout << "  ... (" << sizes.size () - maxNumPrinted << " more)" << endl;
+        }
+    };
+
     class Help : public Command
     {
     public:
@@ -141,6 +249,8 @@ int main (int argc, char** argv)
         commander->add <lume::commands::PrintMeshContents> ();
         commander->add <lume::commands::IsManifoldMesh> ();
         commander->add <lume::commands::IsClosedManifoldMesh> ();
+        commander->add <lume::commands::Quality> ();
+        commander->add <lume::commands::Components> ();
 
         bool printHelp = true;
         if (argc >= 2)
@@ -27,20 +27,51 @@
 
 #include <lume/lume_error.h>
 #include <lume/grob.h>
+#include <lume/edge_mesh_2d.h>
+#include <lume/feature_edges.h>
 #include <lume/file_io.h>
+#include <lume/adaptive_refinement.h>
+#include <lume/bvh.h>
+#include <lume/coloring.h>
+#include <lume/components.h>
+#include <lume/grob_sides.h>
+#include <lume/half_edge_mesh.h>
 #include <lume/parallel_for.h>
+#include <lume/partitioning.h>
+#include <lume/point_locator.h>
+#include <lume/quality.h>
 #include <lume/topology.h>
 #include <lume/neighborhoods.h>
+#include <lume/orientation.h>
 #include <lume/rim_mesh.h>
+#include <lume/smoothing.h>
+#include <lume/surface_analytics.h>
+#include <lume/spatial_index.h>
 #include <lume/subset_info_annex.h>
 #include <lume/normals.h>
+#include <lume/mesh_hierarchy.h>
+#include <lume/mesh_merging.h>
+#include <lume/refinement.h>
+#include <lume/annex_transfer.h>
+#include <lume/decimation.h>
+#include <lume/delaunay.h>
+#include <lume/derived_data.h>
+#include <lume/vertex_welding.h>
+#include <lume/math/grob_math.h>
 #include <lume/math/tuple_view.h>
 
 #include "pettyprof/pettyprof.h"
 
 #include "tests.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -325,6 +356,56 @@ namespace impl {
 	}
 }// end of namespace impl
 
+namespace impl {
+	/** compares the sides found by `GrobSides` with the reference-counted sides
+	 * found by `FindUniqueSidesRefCounted`.*/
+	static void TestGrobSides (SPMesh mesh, GrobSet grobSet, GrobSet sideSet)
+	{
+		if (!mesh->has (grobSet))
+			return;
+
+		GrobSides grobSides (*mesh, grobSet, sideSet);
+
+		GrobHashMap <index_t> refCounts;
+		FindUniqueSidesRefCounted (refCounts, *mesh, grobSet, sideSet.dim());
+
+		size_t numSides = 0;
+		for(auto sideType : sideSet) {
+			auto const& sides = grobSides.sides (sideType);
+			numSides += sides.size();
+
+			for(index_t iside = 0; iside < sides.size(); ++iside) {
+				const GrobIndex sideIndex (sideType, iside);
+				auto refCount = refCounts.find (sides [iside]);
+				COND_FAIL (refCount == refCounts.end(), "GrobSides contains an invalid side");
+				COND_FAIL (refCount->second != grobSides.num_incidences (sideIndex),
+				           "Number of incidences (" << grobSides.num_incidences (sideIndex)
+				           << ") doesn't match reference count (" << refCount->second << ")");
+
+				for(index_t i = 0; i < grobSides.num_incidences (sideIndex); ++i) {
+					const auto inc = grobSides.incidence (sideIndex, i);
+					COND_FAIL (mesh->grob (inc.grob).side (sideSet.dim(), inc.localSide) != sides [iside],
+					           "Incidence doesn't reference the side");
+					COND_FAIL (grobSides.side_index (inc.grob, inc.localSide) != iside,
+					           "Side index of incidence doesn't match");
+				}
+			}
+		}
+
+		COND_FAIL (numSides != refCounts.size(),
+		           "Number of sides (" << numSides << ") doesn't match number of "
+		           "unique sides (" << refCounts.size() << ")");
+	}
+}// end of namespace impl
+
+static void TestGrobSides (SPMesh mesh)
+{
+	impl::TestGrobSides (mesh, FACES, EDGES);
+	impl::TestGrobSides (mesh, CELLS, EDGES);
+	impl::TestGrobSides (mesh, CELLS, FACES);
+}
+
+
 static void TestFillGrobToIndexMap (SPMesh mesh)
 {
 	impl::TestFillGrobToIndexMap (mesh, VERTICES);
@@ -617,6 +698,44 @@ static void TestComputeFaceVertexNormals3 ()
     }
 }
 
+static void TestComputeVertexNormals3 ()
+{
+	auto sphere = CreateMeshFromFile ("meshes/sphere.stl");
+	auto const& coords = sphere->annex (keys::vertexCoords);
+
+	for(auto weighting : {NormalWeighting::Uniform, NormalWeighting::Area, NormalWeighting::Angle}) {
+		ComputeVertexNormals3 (*sphere, weighting);
+		auto const& normals = sphere->annex (keys::vertexNormals);
+		for(size_t ivrt = 0; ivrt < sphere->num (VERTEX); ++ivrt) {
+			std::array <real_t, 3> n;
+			math::raw::VecNormalize (n.data (), 3, coords.data () + 3 * ivrt);
+			const real_t deviation = math::raw::VecDistSq (n.data (), 3, normals.data () + 3 * ivrt);
+			COND_FAIL (deviation > 1.e-4f, "Vertex normal deviates from normalized coordinate: " << deviation);
+		}
+	}
+
+//	a planar mesh of triangles and quadrilaterals in the xy-plane
+	auto planar = std::make_shared <Mesh> ();
+	planar->resize_vertices (6);
+	planar->set_annex (keys::vertexCoords, RealArrayAnnex (3, std::vector <real_t> {
+		0, 0, 0,  1, 0, 0,  2, 0, 0,  0, 1, 0,  1, 1, 0,  2, 1, 0}));
+	planar->set_grobs (GrobArray (QUAD, std::vector <index_t> {0, 1, 4, 3}));
+	planar->set_grobs (GrobArray (TRI, std::vector <index_t> {1, 2, 5,  1, 5, 4}));
+
+	ComputeVertexNormals3 (*planar, NormalWeighting::Angle);
+	auto const& normals = planar->annex (keys::vertexNormals);
+	for(size_t ivrt = 0; ivrt < planar->num (VERTEX); ++ivrt) {
+		COND_FAIL (normals [3 * ivrt] != 0 || normals [3 * ivrt + 1] != 0 || normals [3 * ivrt + 2] != 1,
+		           "Bad normal of vertex " << ivrt << " of planar mesh");
+	}
+
+	ComputeFaceNormals3 (*planar);
+	COND_FAIL (planar->annex (keys::quadNormals).num_tuples () != 1 ||
+	           planar->annex (keys::triNormals).num_tuples () != 2, "Bad size of face normal annexes");
+	COND_FAIL (planar->annex (keys::quadNormals) [2] != 1 || planar->annex (keys::triNormals) [5] != 1,
+	           "Bad face normals");
+}
+
 namespace impl {
 	static void TestNeighborValence (NeighborIndices nbrs,
 	                                 const index_t expectedValence,
@@ -750,6 +869,1686 @@ static void TestSubsets ()
 }
 
 
+static void TestRefineTriangles ()
+{
+	auto mesh = CreateMeshFromFile ("meshes/sphere.stl");
+	GrobSides const edges (*mesh, TRIS, EDGES);
+
+	auto refinedMesh = RefineTriangles (mesh);
+
+	COND_FAIL (refinedMesh->num (VERTEX) != mesh->num (VERTEX) + edges.num_sides (EDGE),
+	           "Unexpected number of vertices in refined mesh: " << refinedMesh->num (VERTEX));
+	COND_FAIL (refinedMesh->num (TRI) != 4 * mesh->num (TRI),
+	           "Unexpected number of triangles in refined mesh: " << refinedMesh->num (TRI));
+
+	GrobSides const refinedEdges (*refinedMesh, TRIS, EDGES);
+	COND_FAIL (refinedEdges.num_sides (EDGE) != 2 * edges.num_sides (EDGE) + 3 * mesh->num (TRI),
+	           "Unexpected number of edges in refined mesh: " << refinedEdges.num_sides (EDGE));
+
+	for(index_t i = 0; i < refinedEdges.num_sides (EDGE); ++i) {
+		COND_FAIL (refinedEdges.num_incidences (GrobIndex (EDGE, i)) != 2,
+		           "Refined mesh is not a closed manifold");
+	}
+
+//	the corners of the inner child triangle have to lie at the centers of the parent's edges
+	auto const& coords = mesh->annex (keys::vertexCoords);
+	auto const& refinedCoords = refinedMesh->annex (keys::vertexCoords);
+	auto const& tris = mesh->grobs (TRI);
+	auto const& refinedTris = refinedMesh->grobs (TRI);
+
+	for(index_t itri = 0; itri < tris.size(); ++itri) {
+		const auto tri = tris [itri];
+		const auto innerTri = refinedTris [itri * 4 + 3];
+		for(index_t i = 0; i < 3; ++i) {
+			for(index_t j = 0; j < 3; ++j) {
+				const real_t center = real_t (0.5) * (coords [tri.corner (i) * 3 + j] +
+				                                      coords [tri.corner ((i + 1) % 3) * 3 + j]);
+				COND_FAIL (std::abs (center - refinedCoords [innerTri.corner (i) * 3 + j]) > 1.e-5,
+				           "Bad coordinate of refined edge vertex");
+			}
+		}
+	}
+}
+
+
+namespace impl {
+	static index_t NumBoundaryFaces (Mesh const& mesh)
+	{
+		GrobSides faces (mesh, CELLS, FACES);
+		index_t numBndFaces = 0;
+		for(auto faceType : GrobSet (FACES)) {
+			for(index_t i = 0; i < faces.num_sides (faceType); ++i) {
+				const index_t numInc = faces.num_incidences (GrobIndex (faceType, i));
+				COND_FAIL (numInc > 2, "Face with more than 2 adjacent cells encountered");
+				if (numInc == 1)
+					++numBndFaces;
+			}
+		}
+		return numBndFaces;
+	}
+}// end of namespace impl
+
+static void TestRefineMesh ()
+{
+	auto mesh = CreateMeshFromFile ("meshes/elems.ugx");
+	auto expectedMesh = CreateMeshFromFile ("meshes/elems_refined.ugx");
+
+	auto refinedMesh = RefineMesh (mesh);
+
+	for(auto grobType : GrobSet (CELLS)) {
+		COND_FAIL (refinedMesh->num (grobType) != expectedMesh->num (grobType),
+		           "Unexpected number of " << GrobTypeName (grobType) << " in refined mesh: "
+		           << refinedMesh->num (grobType) << " (expected " << expectedMesh->num (grobType) << ")");
+	}
+
+	COND_FAIL (refinedMesh->num (VERTEX) != expectedMesh->num (VERTEX),
+	           "Unexpected number of vertices in refined mesh: " << refinedMesh->num (VERTEX));
+	COND_FAIL (refinedMesh->num (EDGE) != 2 * mesh->num (EDGE),
+	           "Unexpected number of edges in refined mesh: " << refinedMesh->num (EDGE));
+	COND_FAIL (refinedMesh->num (TRI) != 4 * mesh->num (TRI),
+	           "Unexpected number of triangles in refined mesh: " << refinedMesh->num (TRI));
+	COND_FAIL (refinedMesh->num (QUAD) != 4 * mesh->num (QUAD),
+	           "Unexpected number of quadrilaterals in refined mesh: " << refinedMesh->num (QUAD));
+
+//	if children of neighboring cells are not connected, the number of boundary faces increases
+	const index_t numBndFaces = impl::NumBoundaryFaces (*mesh);
+	const index_t numRefinedBndFaces = impl::NumBoundaryFaces (*refinedMesh);
+	COND_FAIL (numRefinedBndFaces != 4 * numBndFaces,
+	           "Unexpected number of boundary faces in refined mesh: " << numRefinedBndFaces
+	           << " (expected " << 4 * numBndFaces << ")");
+}
+
+
+static void TestRefinementAnnexTransfer ()
+{
+	const string subsetInfoName = "defSH";
+	auto mesh = CreateMeshFromFile ("meshes/circle_with_subsets.ugx");
+
+	bool customPolicyCalled = false;
+	AnnexTransfer transfer;
+	transfer.set_policy (keys::vertexCoords, [&customPolicyCalled] (Hierarchy& hierarchy, const AnnexKey& key) {
+		customPolicyCalled = true;
+		InterpolateVertexAnnex (hierarchy, key);
+	});
+
+	auto refinedMesh = RefineMesh (mesh, transfer);
+
+	COND_FAIL (!customPolicyCalled, "Custom transfer policy wasn't called");
+	COND_FAIL (!refinedMesh->has_annex (TypedAnnexKey <SubsetInfoAnnex> (subsetInfoName)),
+	           "SubsetInfoAnnex wasn't transferred");
+
+	for(auto grobType : GrobSet(FACES)) {
+		const TypedAnnexKey <IndexArrayAnnex> annexKey (subsetInfoName, grobType);
+		if (!mesh->has_annex (annexKey))
+			continue;
+
+		COND_FAIL (!refinedMesh->has_annex (annexKey),
+		           "Subset indices of " << GrobTypeName (grobType) << " weren't transferred");
+
+		auto& subsetInds = mesh->annex (annexKey);
+		auto& refinedSubsetInds = refinedMesh->annex (annexKey);
+		COND_FAIL (refinedSubsetInds.size () != 4 * subsetInds.size (),
+		           "Bad size of transferred subset index annex: " << refinedSubsetInds.size ());
+
+		for(index_t i = 0; i < refinedSubsetInds.size (); ++i) {
+			COND_FAIL (refinedSubsetInds [i] != subsetInds [i / 4],
+			           "Child " << i << " has subset index " << refinedSubsetInds [i]
+			           << " but its parent has subset index " << subsetInds [i / 4]);
+		}
+	}
+
+	auto& coords = refinedMesh->annex (keys::vertexCoords);
+	COND_FAIL (coords.num_tuples () != refinedMesh->num (VERTEX),
+	           "Bad number of vertex coordinates in refined mesh: " << coords.num_tuples ());
+
+//	element annexes must not leak into vertex annexes of the same name
+	auto mixedMesh = std::make_shared <Mesh> ();
+	mixedMesh->resize_vertices (12);
+	mixedMesh->set_annex (keys::vertexCoords, RealArrayAnnex (3, std::vector <real_t> {
+		0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0,  0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 1, 1,
+		0, 0, 2,  1, 0, 2,  1, 1, 2,  0, 1, 2}));
+	mixedMesh->set_grobs (GrobArray (HEX, std::vector <index_t> {0, 1, 2, 3, 4, 5, 6, 7}));
+	mixedMesh->set_grobs (GrobArray (QUAD, std::vector <index_t> {8, 9, 10, 11}));
+
+	const TypedAnnexKey <IndexArrayAnnex> quadKey ("subsetIndex", QUAD);
+	const TypedAnnexKey <IndexArrayAnnex> hexKey ("subsetIndex", HEX);
+	const TypedAnnexKey <IndexArrayAnnex> vrtKey ("subsetIndex", VERTEX);
+	mixedMesh->set_annex (quadKey, IndexArrayAnnex (1, std::vector <index_t> {7}));
+	mixedMesh->set_annex (hexKey, IndexArrayAnnex (1, std::vector <index_t> {5}));
+
+	auto refinedQuadHex = RefineMesh (mixedMesh);
+	COND_FAIL (refinedQuadHex->has_annex (vrtKey), "A vertex annex was created from an element annex");
+
+	mixedMesh->set_annex (vrtKey, IndexArrayAnnex (1, std::vector <index_t> (12, 1)));
+	refinedQuadHex = RefineMesh (mixedMesh);
+	for(auto const& key : {quadKey, hexKey}) {
+		const GrobType grobType = *key.grob_type ();
+		for(auto value : refinedQuadHex->annex (key)) {
+			COND_FAIL (value != mixedMesh->annex (key) [0],
+			           "Bad transferred value at " << GrobTypeName (grobType) << ": " << value);
+		}
+	}
+
+	auto const& refinedVrtInds = refinedQuadHex->annex (vrtKey);
+	COND_FAIL (refinedVrtInds.size () != refinedQuadHex->num (VERTEX), "Bad size of transferred vertex annex");
+	for(index_t i = 0; i < refinedVrtInds.size (); ++i)
+		COND_FAIL (refinedVrtInds [i] != 1, "Element value was written to vertex " << i << ": " << refinedVrtInds [i]);
+}
+
+
+namespace impl {
+	static real_t TriangleArea (Mesh const& mesh)
+	{
+		auto const& coords = mesh.annex (keys::vertexCoords);
+		real_t area = 0;
+		for(auto tri : mesh.grobs (TRI)) {
+			real_t d [2][3];
+			for(index_t i = 0; i < 2; ++i) {
+				for(index_t j = 0; j < 3; ++j)
+					d [i][j] = coords [tri.corner (i + 1) * 3 + j] - coords [tri.corner (0) * 3 + j];
+			}
+			const real_t n [3] = {d[0][1] * d[1][2] - d[0][2] * d[1][1],
+			                      d[0][2] * d[1][0] - d[0][0] * d[1][2],
+			                      d[0][0] * d[1][1] - d[0][1] * d[1][0]};
+			area += real_t (0.5) * std::sqrt (n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		}
+		return area;
+	}
+}// end of namespace impl
+
+static void TestAdaptiveRefinement ()
+{
+	auto mesh = CreateMeshFromFile ("meshes/sphere.stl");
+	const TypedAnnexKey <IndexArrayAnnex> valueKey ("value", TRI);
+	auto& values = mesh->set_annex (valueKey, IndexArrayAnnex (1, index_t (0)));
+	for(index_t i = 0; i < values.size (); ++i)
+		values [i] = i;
+	const std::vector <index_t> initialValues (values.begin (), values.end ());
+
+	const real_t area = impl::TriangleArea (*mesh);
+	AdaptiveRefiner refiner (mesh);
+
+//	refine around the first triangle several times. Marking green triangles forces
+//	the removal of green families.
+	std::vector <index_t> marked = {0, 1, 2};
+	for(int cycle = 0; cycle < 4; ++cycle) {
+		const index_t numTris = static_cast <index_t> (mesh->num (TRI));
+		refiner.refine (marked);
+
+		COND_FAIL (mesh->num (TRI) <= numTris, "No triangles were created in cycle " << cycle);
+		COND_FAIL (mesh->annex (keys::vertexCoords).num_tuples () != mesh->num (VERTEX),
+		           "Vertex coordinates weren't resized");
+
+		GrobSides const edges (*mesh, TRIS, EDGES);
+		for(index_t i = 0; i < edges.num_sides (EDGE); ++i) {
+			COND_FAIL (edges.num_incidences (GrobIndex (EDGE, i)) != 2,
+			           "Adaptively refined mesh is not a closed conforming manifold (cycle " << cycle << ")");
+		}
+
+		COND_FAIL (mesh->num (VERTEX) + mesh->num (TRI) != edges.num_sides (EDGE) + 2,
+		           "Bad Euler characteristic of adaptively refined mesh");
+
+		COND_FAIL (std::abs (impl::TriangleArea (*mesh) - area) > 1.e-3 * area,
+		           "Adaptive refinement changed the surface area");
+
+		auto const& tris = mesh->grobs (TRI);
+		for(index_t itri = 0; itri < tris.size (); ++itri) {
+			for(index_t side = 0; side < 3; ++side) {
+				const index_t nbr = refiner.neighbor (itri, side);
+				COND_FAIL (nbr == NO_INDEX, "Missing neighbor in closed mesh");
+				const index_t a = tris [itri].corner (side);
+				const index_t b = tris [itri].corner ((side + 1) % 3);
+				bool sharesEdge = false;
+				for(index_t i = 0; i < 3; ++i) {
+					sharesEdge |= tris [nbr].corner (i) == b && tris [nbr].corner ((i + 1) % 3) == a;
+				}
+				COND_FAIL (!sharesEdge, "Neighbor doesn't share the edge with opposite orientation");
+			}
+		}
+
+		auto const& refinedValues = mesh->annex (valueKey);
+		COND_FAIL (refinedValues.size () != mesh->num (TRI), "Triangle annex wasn't resized");
+		for(index_t i = 0; i < refinedValues.size (); ++i) {
+			COND_FAIL (refinedValues [i] >= initialValues.size (), "Triangle annex wasn't copied to children");
+		}
+
+		marked.clear ();
+		for(index_t i = numTris; i < tris.size (); i += 7)
+			marked.push_back (i);
+		for(index_t i = 0; i < tris.size () && marked.size () < 12; ++i) {
+			if (refiner.is_green (i))
+				marked.push_back (i);
+		}
+	}
+}
+
+
+namespace impl {
+	static real_t TetVolume (real_t const* coords, ConstGrob const& tet)
+	{
+		real_t d [3][3];
+		for(index_t i = 0; i < 3; ++i) {
+			for(index_t j = 0; j < 3; ++j)
+				d [i][j] = coords [tet.corner (i + 1) * 3 + j] - coords [tet.corner (0) * 3 + j];
+		}
+		return (d[0][0] * (d[1][1] * d[2][2] - d[1][2] * d[2][1])
+		        - d[0][1] * (d[1][0] * d[2][2] - d[1][2] * d[2][0])
+		        + d[0][2] * (d[1][0] * d[2][1] - d[1][1] * d[2][0])) / 6;
+	}
+}// end of namespace impl
+
+static void TestAdaptiveTetRefinement ()
+{
+//	a cube of edge length 2, made up of 8 unit cubes, each split into 6 tetrahedra
+	auto mesh = std::make_shared <Mesh> ();
+	std::vector <real_t> coords;
+	for(index_t z = 0; z < 3; ++z) {
+		for(index_t y = 0; y < 3; ++y) {
+			for(index_t x = 0; x < 3; ++x)
+				coords.insert (coords.end (), {real_t (x), real_t (y), real_t (z)});
+		}
+	}
+
+	const index_t axisOffsets [3] = {1, 3, 9};
+	const index_t axisOrders [6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+	std::vector <index_t> tets;
+	for(index_t z = 0; z < 2; ++z) {
+		for(index_t y = 0; y < 2; ++y) {
+			for(index_t x = 0; x < 2; ++x) {
+				for(auto const& order : axisOrders) {
+					index_t vrt = x + 3 * y + 9 * z;
+					tets.push_back (vrt);
+					for(index_t i = 0; i < 3; ++i) {
+						vrt += axisOffsets [order [i]];
+						tets.push_back (vrt);
+					}
+				}
+			}
+		}
+	}
+
+	mesh->resize_vertices (coords.size () / 3);
+	mesh->set_annex (keys::vertexCoords, RealArrayAnnex (3, std::move (coords)));
+	mesh->set_grobs (GrobArray (TET, std::move (tets)));
+
+	const TypedAnnexKey <IndexArrayAnnex> valueKey ("value", TET);
+	auto& values = mesh->set_annex (valueKey, IndexArrayAnnex (1, index_t (0)));
+	for(index_t i = 0; i < values.size (); ++i)
+		values [i] = i;
+	const index_t numInitialTets = static_cast <index_t> (mesh->num (TET));
+
+	auto refiner = std::make_unique <AdaptiveRefiner> (mesh);
+	COND_FAIL (refiner->element_type () != TET, "Tetrahedral mesh wasn't recognized");
+
+	std::vector <index_t> marked = {0};
+	bool closureTriggered = false;
+	for(int cycle = 0; cycle < 4; ++cycle) {
+		const index_t numTets = static_cast <index_t> (mesh->num (TET));
+		refiner->refine (marked);
+		COND_FAIL (mesh->num (TET) < numTets + 7 * marked.size (), "Not all marked tetrahedra were refined in cycle " << cycle);
+		closureTriggered |= mesh->num (TET) > numTets + 7 * marked.size ();
+
+		auto const& crds = mesh->annex (keys::vertexCoords);
+		auto const& constraints = mesh->annex (keys::hangingNodeConstraints);
+		auto const& tetGrobs = mesh->grobs (TET);
+		COND_FAIL (crds.num_tuples () != mesh->num (VERTEX), "Vertex coordinates weren't resized");
+		COND_FAIL (constraints.num_tuples () != mesh->num (VERTEX), "Hanging node constraints weren't resized");
+
+		real_t volume = 0;
+		std::set <std::pair <index_t, index_t>> edges;
+		for(auto const& tet : tetGrobs) {
+			const real_t v = std::abs (impl::TetVolume (crds.data (), tet));
+			COND_FAIL (v < 1.e-6f, "Degenerate tetrahedron");
+			volume += v;
+			for(index_t i = 0; i < 4; ++i) {
+				for(index_t j = i + 1; j < 4; ++j)
+					edges.emplace (std::minmax (tet.corner (i), tet.corner (j)));
+			}
+		}
+		COND_FAIL (std::abs (volume - 8) > 1.e-4f, "Adaptive refinement changed the volume: " << volume);
+
+	//	hanging vertices lie at the centers of existing edges between regular vertices
+		index_t numHanging = 0;
+		auto isHanging = [&constraints] (index_t const vrt) {return constraints [vrt * 2] != NO_INDEX;};
+		for(index_t vrt = 0; vrt < constraints.num_tuples (); ++vrt) {
+			if (!isHanging (vrt))
+				continue;
+			++numHanging;
+			const index_t a = constraints [vrt * 2];
+			const index_t b = constraints [vrt * 2 + 1];
+			COND_FAIL (isHanging (a) || isHanging (b), "Hanging vertex is constrained by a hanging vertex");
+			COND_FAIL (edges.count (std::minmax (a, b)) == 0, "Constraining edge doesn't exist");
+			for(index_t i = 0; i < 3; ++i) {
+				COND_FAIL (std::abs (crds [vrt * 3 + i] - (crds [a * 3 + i] + crds [b * 3 + i]) / 2) > 1.e-6f,
+				           "Hanging vertex doesn't lie at the center of its constraining edge");
+			}
+		}
+		COND_FAIL (numHanging == 0, "No hanging vertices were created in cycle " << cycle);
+
+	//	inner faces without a neighbor either contain a hanging vertex or are split by hanging vertices
+		GrobSides const faces (*mesh, CELLS, FACES);
+		for(index_t iface = 0; iface < faces.num_sides (TRI); ++iface) {
+			const GrobIndex face (TRI, iface);
+			COND_FAIL (faces.num_incidences (face) > 2, "A face is shared by more than two tetrahedra");
+			if (faces.num_incidences (face) == 2)
+				continue;
+
+			const ConstGrob tri = faces.sides (TRI) [iface];
+			bool onBoundary = false;
+			for(index_t i = 0; i < 3; ++i) {
+				const real_t c = crds [tri.corner (0) * 3 + i];
+				onBoundary |= (c == 0 || c == 2) &&
+				              crds [tri.corner (1) * 3 + i] == c && crds [tri.corner (2) * 3 + i] == c;
+			}
+			if (onBoundary)
+				continue;
+
+			bool hasHangingCorner = false;
+			bool splitEdges = true;
+			for(index_t i = 0; i < 3; ++i) {
+				hasHangingCorner |= isHanging (tri.corner (i));
+				const auto edge = std::minmax (tri.corner (i), tri.corner ((i + 1) % 3));
+				bool isSplit = false;
+				for(index_t vrt = 0; vrt < constraints.num_tuples () && !isSplit; ++vrt)
+					isSplit = std::minmax (constraints [vrt * 2], constraints [vrt * 2 + 1]) == edge;
+				splitEdges &= isSplit;
+			}
+			COND_FAIL (!hasHangingCorner && !splitEdges, "Non-conforming face without hanging vertices in cycle " << cycle);
+		}
+
+		auto const& refinedValues = mesh->annex (valueKey);
+		COND_FAIL (refinedValues.size () != mesh->num (TET), "Tetrahedron annex wasn't resized");
+		for(index_t i = 0; i < refinedValues.size (); ++i)
+			COND_FAIL (refinedValues [i] >= numInitialTets, "Tetrahedron annex wasn't copied to children");
+
+	//	refine fine tetrahedra with hanging corners to enforce the closure. A new refiner
+	//	has to pick up the existing constraints.
+		marked.clear ();
+		for(index_t i = numTets; i < tetGrobs.size () && marked.size () < 4; ++i) {
+			const ConstGrob tet = tetGrobs [i];
+			if (isHanging (tet.corner (0)) || isHanging (tet.corner (1)) ||
+			    isHanging (tet.corner (2)) || isHanging (tet.corner (3)))
+			{
+				marked.push_back (i);
+			}
+		}
+		if (cycle == 1)
+			refiner = std::make_unique <AdaptiveRefiner> (mesh);
+	}
+	COND_FAIL (!closureTriggered, "Refining tetrahedra with hanging corners didn't refine coarser tetrahedra");
+
+	mesh->set_grobs (GrobArray (TRI, std::vector <index_t> {0, 1, 3}));
+	bool caught = false;
+	try {AdaptiveRefiner mixed (mesh);}
+	catch (LumeError&) {caught = true;}
+	COND_FAIL (!caught, "Expected an error for a mesh with triangles and tetrahedra");
+}
+
+namespace impl {
+	static index_t NumBoundaryEdges (Mesh const& mesh)
+	{
+		GrobSides edges (mesh, TRIS, EDGES);
+		index_t numBndEdges = 0;
+		for(index_t i = 0; i < edges.num_sides (EDGE); ++i) {
+			if (edges.num_incidences (GrobIndex (EDGE, i)) == 1)
+				++numBndEdges;
+		}
+		return numBndEdges;
+	}
+}// end of namespace impl
+
+static void TestDecimateTriangles ()
+{
+	{
+		auto mesh = CreateMeshFromFile ("meshes/sphere.stl");
+		const std::vector <index_t> targets = {2000, 500};
+		auto lods = DecimateTrianglesLOD (mesh, targets);
+
+		COND_FAIL (lods.size () != targets.size (), "Unexpected number of LOD meshes: " << lods.size ());
+		for(size_t i = 0; i < lods.size (); ++i) {
+			auto const& lod = *lods [i];
+			COND_FAIL (lod.num (TRI) > targets [i] || lod.num (TRI) + 10 < targets [i],
+			           "Unexpected number of triangles in LOD " << i << ": " << lod.num (TRI));
+			COND_FAIL (lod.annex (keys::vertexCoords).num_tuples () != lod.num (VERTEX),
+			           "Bad number of vertex coordinates in LOD " << i);
+
+			GrobSides const edges (lod, TRIS, EDGES);
+			for(index_t e = 0; e < edges.num_sides (EDGE); ++e) {
+				COND_FAIL (edges.num_incidences (GrobIndex (EDGE, e)) != 2,
+				           "Decimated mesh is not a closed manifold");
+			}
+			COND_FAIL (lod.num (VERTEX) + lod.num (TRI) != edges.num_sides (EDGE) + 2,
+			           "Bad Euler characteristic of decimated mesh");
+		}
+	}
+
+	{
+	//	boundary edges and subsets have to be preserved
+		auto mesh = RefineMesh (RefineMesh (CreateMeshFromFile ("meshes/circle_12.ugx")));
+		const index_t numBndEdges = impl::NumBoundaryEdges (*mesh);
+
+		DecimationOptions options;
+		options.targetNumTris = static_cast <index_t> (mesh->num (TRI) / 4);
+		options.numPartitions = 4;
+		auto decimated = DecimateTriangles (mesh, options);
+
+		COND_FAIL (decimated->num (TRI) >= mesh->num (TRI) / 2, "Mesh wasn't decimated");
+		COND_FAIL (impl::NumBoundaryEdges (*decimated) != numBndEdges, "Boundary wasn't preserved");
+
+		const TypedAnnexKey <IndexArrayAnnex> subsetKey ("defSH", TRI);
+		COND_FAIL (!decimated->has_annex (subsetKey), "Subset indices weren't carried over");
+		COND_FAIL (decimated->annex (subsetKey).size () != decimated->num (TRI),
+		           "Bad size of subset index annex");
+	}
+}
+
+
+namespace impl {
+	static std::vector <real_t> RandomPointsInBox (BoundingBox const& box, size_t const num)
+	{
+		std::mt19937 gen (1);
+		std::vector <real_t> points (num * 3);
+		for(size_t i = 0; i < points.size (); ++i) {
+			const int c = i % 3;
+			const real_t ext = box.max [c] - box.min [c];
+			std::uniform_real_distribution <real_t> dist (box.min [c] - ext / 4, box.max [c] + ext / 4);
+			points [i] = dist (gen);
+		}
+		return points;
+	}
+
+	static void TestBVHQueries (CSPMesh mesh, GrobSet grobSet)
+	{
+	//	a bvh with a single leaf performs all queries by linear search
+		BVH bvh (mesh, grobSet);
+		BVH linear (mesh, grobSet, static_cast <index_t> (mesh->num (grobSet)));
+
+		COND_FAIL (bvh.grobs ().size () != mesh->num (grobSet), "Bad number of grobs in BVH");
+		COND_FAIL (bvh.nodes ().size () < 2 * mesh->num (grobSet) / 4 - 1, "BVH has too few nodes");
+
+		const auto points = RandomPointsInBox (bvh.bounds (), 200);
+		const auto closest = bvh.closest_points (points);
+		const auto bounds = bvh.bounds ();
+		const real_t eps = 1.e-4f * bounds.half_area ();
+
+		std::vector <Ray> rays;
+		for(size_t i = 0; i < closest.size (); ++i) {
+			const auto ref = linear.closest_point (points.data () + 3 * i);
+			COND_FAIL (!closest [i] || !ref, "Closest point query failed");
+			COND_FAIL (std::abs (closest [i]->distanceSq - ref->distanceSq) > eps,
+			           "Closest point mismatch: " << closest [i]->distanceSq << " vs. " << ref->distanceSq);
+
+			Ray ray;
+			for(int j = 0; j < 3; ++j) {
+				ray.origin [j] = points [3 * i + j];
+				ray.direction [j] = real_t (0.5) * (bounds.min [j] + bounds.max [j]) - ray.origin [j];
+			}
+			rays.push_back (ray);
+		}
+
+		const auto hits = bvh.ray_first_hits (rays);
+		std::vector <RayHit> allHits;
+		for(size_t i = 0; i < rays.size (); ++i) {
+			const auto hit = bvh.ray_first_hit (rays [i]);
+			const auto ref = linear.ray_first_hit (rays [i]);
+			COND_FAIL (hit.has_value () != ref.has_value () || hits [i].has_value () != ref.has_value (),
+			           "Ray hit mismatch for ray " << i);
+			if (!ref)
+				continue;
+			COND_FAIL (std::abs (hit->t - ref->t) > 1.e-5f || std::abs (hits [i]->t - ref->t) > 1.e-5f,
+			           "Ray hit parameter mismatch for ray " << i);
+
+			bvh.ray_all_hits (rays [i], allHits);
+			COND_FAIL (allHits.empty () || std::abs (allHits.front ().t - ref->t) > 1.e-5f,
+			           "First of all hits doesn't match first hit for ray " << i);
+		}
+
+		BoundingBox box;
+		box.extend (points.data ());
+		box.extend (points.data () + 3);
+		std::vector <GrobIndex> overlaps, refOverlaps;
+		bvh.box_overlaps (box, overlaps);
+		linear.box_overlaps (box, refOverlaps);
+		COND_FAIL (overlaps.size () != refOverlaps.size (), "Box overlap mismatch");
+	}
+}// end of namespace impl
+
+static void TestBVH ()
+{
+	impl::TestBVHQueries (CreateMeshFromFile ("meshes/sphere.stl"), TRIS);
+	impl::TestBVHQueries (CreateMeshFromFile ("meshes/tet_refined.ugx"), CELLS);
+	impl::TestBVHQueries (CreateMeshFromFile ("meshes/tris_and_quads.ugx"), FACES);
+
+	{
+	//	rays through the center of a closed sphere hit it twice
+		BVH bvh (CreateMeshFromFile ("meshes/sphere.stl"), TRIS);
+		const auto bounds = bvh.bounds ();
+		Ray ray;
+		for(int i = 0; i < 3; ++i)
+			ray.origin [i] = real_t (0.5) * (bounds.min [i] + bounds.max [i]);
+		ray.origin [0] = 2 * bounds.min [0] - bounds.max [0];
+		ray.direction = {1, 0.0123f, 0.0371f};
+
+		std::vector <RayHit> hits;
+		bvh.ray_all_hits (ray, hits);
+		COND_FAIL (hits.size () != 2, "Expected 2 hits but got " << hits.size ());
+	}
+}
+
+
+static void TestPointLocator ()
+{
+	auto mesh = RefineMesh (CreateMeshFromFile ("meshes/elems_refined.ugx"));
+	PointLocator locator (mesh);
+	auto const& coords = locator.bvh ().coordinates ();
+
+//	corner averages of cells and their local coordinates
+	std::vector <real_t> centers;
+	std::vector <GrobIndex> cells;
+	std::vector <std::array <real_t, 3>> expectedLocalCoords;
+	for(auto gt : GrobSet (CELLS)) {
+		std::array <real_t, 3> local;
+		switch (gt) {
+			case TET:   local = {0.25f, 0.25f, 0.25f}; break;
+			case HEX:   local = {0.5f, 0.5f, 0.5f}; break;
+			case PRISM: local = {1.f / 3.f, 1.f / 3.f, 0.5f}; break;
+			default:    local = {0.4f, 0.4f, 0.2f}; break;
+		}
+
+		for(index_t i = 0; i < mesh->num (gt); ++i) {
+			auto const grob = mesh->grob (GrobIndex (gt, i));
+			real_t center [3] = {0, 0, 0};
+			for(index_t j = 0; j < grob.num_corners (); ++j) {
+				for(int k = 0; k < 3; ++k)
+					center [k] += coords [grob.corner (j) * 3 + k] / real_t (grob.num_corners ());
+			}
+			centers.insert (centers.end (), center, center + 3);
+			cells.push_back (GrobIndex (gt, i));
+			expectedLocalCoords.push_back (local);
+		}
+	}
+
+	const auto locations = locator.locate (centers);
+	for(size_t i = 0; i < cells.size (); ++i) {
+		const auto single = locator.locate (centers.data () + 3 * i);
+		const auto walked = locator.locate (centers.data () + 3 * i, cells.front ());
+		for(auto const& location : {locations [i], single, walked}) {
+			COND_FAIL (!location, "Couldn't locate center of cell " << i);
+			COND_FAIL (location->cell.grob_type () != cells [i].grob_type ()
+			           || location->cell.index () != cells [i].index (),
+			           "Center of cell " << i << " was located in wrong cell");
+			for(int k = 0; k < 3; ++k) {
+				COND_FAIL (std::abs (location->localCoords [k] - expectedLocalCoords [i][k]) > 1.e-4f,
+				           "Bad local coordinates in cell " << i << " of type "
+				           << GrobTypeName (cells [i].grob_type ()));
+			}
+		}
+	}
+
+	const auto bounds = locator.bvh ().bounds ();
+	real_t outside [3] = {2 * bounds.max [0] - bounds.min [0], bounds.max [1], bounds.max [2]};
+	COND_FAIL (locator.locate (outside), "Located a point outside of the mesh");
+	COND_FAIL (locator.locate (outside, cells.front ()), "Located a point outside of the mesh by walking");
+}
+
+
+static void TestSpatialIndex ()
+{
+	auto mesh = CreateMeshFromFile ("meshes/sphere.stl");
+	auto const& coords = mesh->annex (keys::vertexCoords);
+	const size_t numVertices = coords.num_tuples ();
+
+	KdTree kdTree (coords);
+	PointGrid grid (coords, 0.1f);
+
+	BoundingBox bounds;
+	for(size_t i = 0; i < numVertices; ++i)
+		bounds.extend (coords.data () + 3 * i);
+	const auto points = impl::RandomPointsInBox (bounds, 100);
+	const real_t radius = 0.15f;
+	const index_t k = 5;
+
+	const auto nearest = kdTree.k_nearest (points, k);
+	std::vector <index_t> kdOffsets, kdInds, gridOffsets, gridInds;
+	kdTree.in_radius (points, radius, kdOffsets, kdInds);
+	grid.in_radius (points, radius, gridOffsets, gridInds);
+
+	for(size_t ipnt = 0; ipnt < points.size () / 3; ++ipnt) {
+		const real_t* p = points.data () + 3 * ipnt;
+		std::vector <real_t> distSq (numVertices);
+		for(size_t i = 0; i < numVertices; ++i) {
+			distSq [i] = 0;
+			for(int j = 0; j < 3; ++j)
+				distSq [i] += (coords [3 * i + j] - p [j]) * (coords [3 * i + j] - p [j]);
+		}
+
+		const size_t numInRadius = std::count_if (distSq.begin (), distSq.end (),
+		                                          [radius] (real_t d) {return d <= radius * radius;});
+		COND_FAIL (kdOffsets [ipnt + 1] - kdOffsets [ipnt] != numInRadius,
+		           "KdTree radius query mismatch for point " << ipnt);
+		COND_FAIL (gridOffsets [ipnt + 1] - gridOffsets [ipnt] != numInRadius,
+		           "PointGrid radius query mismatch for point " << ipnt);
+
+		std::vector <real_t> sortedDistSq = distSq;
+		std::sort (sortedDistSq.begin (), sortedDistSq.end ());
+		for(index_t i = 0; i < k; ++i) {
+			COND_FAIL (distSq [nearest [ipnt * k + i]] != sortedDistSq [i],
+			           "KdTree k-nearest query mismatch for point " << ipnt);
+		}
+	}
+}
+
+
+static void TestWeldVertices ()
+{
+//	create a triangle soup from a sphere, where shared vertices differ slightly
+	auto sphere = CreateMeshFromFile ("meshes/sphere.stl");
+	auto const& sphereCoords = sphere->annex (keys::vertexCoords);
+	auto const& tris = sphere->grobs (TRI);
+
+	std::vector <real_t> coords;
+	std::vector <index_t> corners;
+	for(size_t itri = 0; itri < tris.size (); ++itri) {
+		for(index_t i = 0; i < 3; ++i) {
+			const index_t c = tris [itri].corner (i);
+			for(int j = 0; j < 3; ++j)
+				coords.push_back (sphereCoords [3 * c + j] + 1.e-6f * real_t ((itri + i + j) % 3));
+			corners.push_back (static_cast <index_t> (corners.size ()));
+		}
+	}
+
+//	a tiny triangle which collapses to a single vertex
+	for(index_t i = 0; i < 3; ++i) {
+		for(int j = 0; j < 3; ++j)
+			coords.push_back (sphereCoords [j] + 1.e-6f * real_t (i));
+		corners.push_back (static_cast <index_t> (corners.size ()));
+	}
+
+	auto mesh = std::make_shared <Mesh> ();
+	mesh->resize_vertices (coords.size () / 3);
+	mesh->set_annex (keys::vertexCoords, RealArrayAnnex (3, std::move (coords)));
+	mesh->set_grobs (GrobArray (TRI, std::move (corners)));
+	mesh->set_annex (TypedAnnexKey <IndexArrayAnnex> ("triIndex", TRI),
+	                 IndexArrayAnnex (1, std::vector <index_t> (tris.size () + 1, 7)));
+
+	const auto newIndices = WeldVertices (*mesh, 1.e-5f);
+
+	COND_FAIL (newIndices.size () != 3 * (tris.size () + 1), "Bad size of vertex index map");
+	COND_FAIL (mesh->num (VERTEX) != sphere->num (VERTEX),
+	           "Expected " << sphere->num (VERTEX) << " vertices but got " << mesh->num (VERTEX));
+	COND_FAIL (mesh->num (TRI) != sphere->num (TRI),
+	           "Expected " << sphere->num (TRI) << " triangles but got " << mesh->num (TRI));
+	COND_FAIL (mesh->annex (keys::vertexCoords).num_tuples () != mesh->num (VERTEX),
+	           "Vertex coordinates weren't compacted");
+	COND_FAIL (mesh->annex (TypedAnnexKey <IndexArrayAnnex> ("triIndex", TRI)).size () != mesh->num (TRI),
+	           "Triangle annex wasn't compacted");
+
+	GrobSides const edges (*mesh, TRIS, EDGES);
+	for(index_t e = 0; e < edges.num_sides (EDGE); ++e) {
+		COND_FAIL (edges.num_incidences (GrobIndex (EDGE, e)) != 2, "Welded mesh is not closed");
+	}
+}
+
+
+static void TestMergeMeshes ()
+{
+	CSPMesh circle = CreateMeshFromFile ("meshes/circle_12.ugx");
+	CSPMesh bunny = CreateMeshFromFile ("meshes/bunny_coarse.ugx");
+	const TypedAnnexKey <SubsetInfoAnnex> infoKey ("defSH");
+	const TypedAnnexKey <IndexArrayAnnex> triSubsetKey ("defSH", TRI);
+
+	auto merged = MergeMeshes ({circle, bunny});
+
+	const index_t numCircleVrts = static_cast <index_t> (circle->num (VERTEX));
+	COND_FAIL (merged->num (VERTEX) != circle->num (VERTEX) + bunny->num (VERTEX), "Bad number of vertices");
+	COND_FAIL (merged->num (TRI) != circle->num (TRI) + bunny->num (TRI), "Bad number of triangles");
+	COND_FAIL (merged->annex (keys::vertexCoords).num_tuples () != merged->num (VERTEX),
+	           "Bad number of vertex coordinates");
+
+	for(size_t i = 0; i < bunny->num (TRI); ++i) {
+		const auto tri = merged->grobs (TRI) [circle->num (TRI) + i];
+		for(index_t j = 0; j < 3; ++j) {
+			COND_FAIL (tri.corner (j) != bunny->grobs (TRI) [i].corner (j) + numCircleVrts,
+			           "Corners of appended triangles weren't offset");
+		}
+	}
+
+//	subsets with equal names are mapped to the same merged subset
+	auto const& mergedInfo = merged->annex (infoKey);
+	auto const& mergedSubsets = merged->annex (triSubsetKey);
+	for(auto const& part : {std::make_pair (circle, size_t (0)), std::make_pair (bunny, circle->num (TRI))}) {
+		auto const& info = part.first->annex (infoKey);
+		auto const& subsets = part.first->annex (triSubsetKey);
+		for(size_t i = 0; i < part.first->num (TRI); ++i) {
+			COND_FAIL (mergedInfo.subset_properties (mergedSubsets [part.second + i]).name
+			           != info.subset_properties (subsets [i]).name,
+			           "Subset of merged triangle doesn't match its original subset");
+		}
+	}
+
+	auto welded = MergeMeshes ({circle, circle}, MergeOptions {true, 1.e-5f});
+	COND_FAIL (welded->num (VERTEX) != circle->num (VERTEX),
+	           "Expected " << circle->num (VERTEX) << " vertices after welding, but got " << welded->num (VERTEX));
+	COND_FAIL (welded->annex (infoKey).num_subset_properties () != circle->annex (infoKey).num_subset_properties (),
+	           "Subset tables weren't merged by name");
+}
+
+
+static void TestQuality ()
+{
+//	a unit cube, a regular tetrahedron and an inverted copy of that tetrahedron
+	std::vector <real_t> coords = {0, 0, 0,  1, 0, 0,  1, 1, 0,  0, 1, 0,
+	                               0, 0, 1,  1, 0, 1,  1, 1, 1,  0, 1, 1};
+	auto mesh = std::make_shared <Mesh> ();
+	mesh->resize_vertices (coords.size () / 3);
+	mesh->set_annex (keys::vertexCoords, RealArrayAnnex (3, std::move (coords)));
+	mesh->set_grobs (GrobArray (HEX, std::vector <index_t> {0, 1, 2, 3, 4, 5, 6, 7}));
+	mesh->set_grobs (GrobArray (TET, std::vector <index_t> {0, 5, 2, 7,  0, 2, 5, 7}));
+
+	const real_t eps = 1.e-5f;
+	auto check = [&] (GrobType gt, QualityMetric metric, std::vector <real_t> const& expected) {
+		const auto quality = ComputeQuality (*mesh, gt, metric);
+		COND_FAIL (quality.size () != expected.size (), "Bad number of values for " << QualityMetricName (metric));
+		for(size_t i = 0; i < expected.size (); ++i) {
+			COND_FAIL (std::abs (quality [i] - expected [i]) > eps,
+			           QualityMetricName (metric) << " of " << GrobTypeName (gt) << " " << i << ": expected "
+			           << expected [i] << " but got " << quality [i]);
+		}
+	};
+
+	check (HEX, QualityMetric::Volume, {1});
+	check (HEX, QualityMetric::AspectRatio, {1});
+	check (HEX, QualityMetric::MinAngle, {90});
+	check (HEX, QualityMetric::JacobianDeterminant, {1});
+	check (HEX, QualityMetric::ScaledJacobian, {1});
+
+	check (TET, QualityMetric::Volume, {1.f / 3.f, -1.f / 3.f});
+	check (TET, QualityMetric::AspectRatio, {1, 1});
+	check (TET, QualityMetric::MinAngle, {70.528779f, 70.528779f});
+	check (TET, QualityMetric::ScaledJacobian, {1, -1});
+
+	bool caught = false;
+	try {ComputeQuality (*mesh, TET, QualityMetric::Area);}
+	catch (LumeError&) {caught = true;}
+	COND_FAIL (!caught, "Expected an error for an unsupported metric");
+
+//	refinement preserves the total volume and face area
+	auto coarse = CreateMeshFromFile ("meshes/elems.ugx");
+	auto fine = RefineMesh (coarse);
+	for(auto gs : {CELLS, FACES}) {
+		const auto metric = gs == CELLS ? QualityMetric::Volume : QualityMetric::Area;
+		double coarseSum = 0, fineSum = 0;
+		for(auto gt : GrobSet (gs)) {
+			for(auto v : ComputeQuality (*coarse, gt, metric)) coarseSum += v;
+			for(auto v : ComputeQuality (*fine, gt, metric)) fineSum += v;
+		}
+		COND_FAIL (coarseSum <= 0 || std::abs (coarseSum - fineSum) > eps * coarseSum,
+		           QualityMetricName (metric) << " of coarse (" << coarseSum << ") and refined ("
+		           << fineSum << ") mesh differ");
+	}
+}
+
+
+static void TestFixedSizeTupleViews ()
+{
+	auto mesh = CreateMeshFromFile ("meshes/sphere.stl");
+	auto const& coords = mesh->annex (keys::vertexCoords);
+	const real_t eps = 1.e-5f;
+
+	auto coords3 = math::MakeTupleView <3> (coords);
+	auto coordsDyn = math::MakeTupleView (coords);
+	COND_FAIL (coords3.size () != coordsDyn.size () || coords3.tuple_size () != 3, "Bad size of fixed size view");
+
+	for(auto tri : mesh->grobs (TRI)) {
+		const auto c3 = math::GrobCenter (tri, coords3);
+		const auto cDyn = math::GrobCenter (tri, coordsDyn);
+		static_assert (decltype (c3)::staticSize == 3, "Expected a compile-time tuple size");
+		COND_FAIL (c3.distance (cDyn) > eps, "Centers of fixed and dynamic size views differ");
+	}
+
+//	bulk kernels with compile-time tuple size have to match the generic implementation
+	std::vector <real_t> normalized (coords.begin (), coords.end ());
+	math::raw::VecTupNormalizeInplace <3> (normalized.data (), normalized.size ());
+	for(size_t i = 0; i < coords.num_tuples (); ++i) {
+		std::vector <real_t> v (coords.data () + 3 * i, coords.data () + 3 * (i + 1));
+		math::VecNormalizeInplace (v);
+		COND_FAIL (math::raw::VecDistSq (v.data (), 3, normalized.data () + 3 * i) > eps * eps,
+		           "Fixed size normalization differs from generic normalization");
+	}
+
+	std::array <real_t, 3> center, minCorner, maxCorner;
+	math::raw::VecTupAverage (center.data (), coords.data (), coords.size (), 3);
+	math::raw::VecTupBoundingBox (minCorner.data (), maxCorner.data (), coords.data (), coords.size (), 3);
+	std::array <real_t, 3> expectedMin = {coords [0], coords [1], coords [2]};
+	std::array <real_t, 3> expectedMax = expectedMin;
+	std::array <double, 3> expectedCenter = {0, 0, 0};
+	for(size_t i = 0; i < coords.size (); ++i) {
+		expectedMin [i % 3] = std::min (expectedMin [i % 3], coords [i]);
+		expectedMax [i % 3] = std::max (expectedMax [i % 3], coords [i]);
+		expectedCenter [i % 3] += coords [i];
+	}
+	for(size_t j = 0; j < 3; ++j) {
+		COND_FAIL (minCorner [j] != expectedMin [j] || maxCorner [j] != expectedMax [j], "Bad bounding box");
+		COND_FAIL (std::abs (center [j] - expectedCenter [j] / coords.num_tuples ()) > eps, "Bad centroid");
+	}
+
+	std::vector <real_t> axpy (coords.size (), 1);
+	math::VecAxpy (axpy, 2, std::vector <real_t> (coords.begin (), coords.end ()));
+	for(size_t i = 0; i < coords.size (); ++i)
+		COND_FAIL (axpy [i] != 1 + 2 * coords [i], "Bad result of VecAxpy");
+}
+
+
+static void TestDerivedDataCache ()
+{
+	auto mesh = CreateMeshFromFile ("meshes/sphere.stl");
+
+	COND_FAIL (!IsClosedManifoldMesh (*mesh), "sphere.stl should be a closed manifold mesh");
+	auto const edges = CachedGrobSides (*mesh, TRIS, EDGES);
+	COND_FAIL (edges != CachedGrobSides (*mesh, TRIS, EDGES), "Cached sides were rebuilt");
+	COND_FAIL (edges->num_sides (EDGE) != 7680, "Unexpected number of edges: " << edges->num_sides (EDGE));
+
+//	concurrent requests share a single build
+	std::atomic <int> numBuilds {0};
+	std::vector <std::shared_ptr <int const>> results (8);
+	parallel_for (size_t (0), results.size (), [&] (size_t i) {
+		results [i] = mesh->derived_data <int> ("answer", DerivedDataCache::grob_type_mask ({TRIS}), {}, [&] () {
+			++numBuilds;
+			std::this_thread::sleep_for (std::chrono::milliseconds (10));
+			return 42;
+		});
+	}, 1);
+	COND_FAIL (numBuilds != 1, "Derived data was built " << numBuilds << " times");
+	for(auto const& r : results)
+		COND_FAIL (r != results [0] || *r != 42, "Concurrent requests received different instances");
+
+//	failed builds aren't cached
+	bool caught = false;
+	try {mesh->derived_data <int> ("fails", {}, {}, [] () -> int {throw LumeError () << "build failed";});}
+	catch (LumeError&) {caught = true;}
+	COND_FAIL (!caught, "Exception of failed build wasn't propagated");
+	COND_FAIL (*mesh->derived_data <int> ("fails", {}, {}, [] () {return 1;}) != 1, "Failed build was cached");
+
+	const BoundingBox box = CachedBoundingBox (*mesh);
+	COND_FAIL (box.empty () || box.min [0] >= box.max [0], "Bad bounding box");
+
+//	replacing the coordinates invalidates the bounding box but not the sides
+	std::vector <real_t> coords (mesh->annex (keys::vertexCoords).begin (), mesh->annex (keys::vertexCoords).end ());
+	for(auto& c : coords)
+		c *= 2;
+	mesh->set_annex (keys::vertexCoords, RealArrayAnnex (3, std::move (coords)));
+	COND_FAIL (CachedBoundingBox (*mesh).max [0] != 2 * box.max [0], "Bounding box wasn't invalidated");
+	COND_FAIL (edges != CachedGrobSides (*mesh, TRIS, EDGES), "Sides were invalidated by an annex change");
+
+//	changing triangles invalidates all data which depends on them
+	index_t corners [] = {0, 1, 2};
+	mesh->insert_grob (Grob (TRI, corners));
+	COND_FAIL (edges == CachedGrobSides (*mesh, TRIS, EDGES), "Sides weren't invalidated");
+	COND_FAIL (IsClosedManifoldMesh (*mesh), "Valences weren't updated after inserting a triangle");
+
+	auto const nbrhds = CachedNeighborhoods (mesh, VERTICES, FACES);
+	COND_FAIL (nbrhds.get () != CachedNeighborhoods (mesh, VERTICES, FACES).get (), "Cached neighborhoods were rebuilt");
+	mesh->invalidate_derived_data ();
+	COND_FAIL (mesh->num_derived_data () != 0, "Derived data wasn't cleared");
+}
+
+
+static void TestVertexIncidence ()
+{
+	for(auto const& [filename, grobSet] : {std::make_pair ("meshes/elems.ugx", GrobSet (CELLS)),
+	                                       std::make_pair ("meshes/sphere.stl", GrobSet (TRIS))})
+	{
+		auto mesh = CreateMeshFromFile (filename);
+		VertexIncidence const incidence (*mesh, grobSet);
+		COND_FAIL (incidence.num_vertices () != mesh->num (VERTEX), "Bad number of vertices in " << filename);
+
+	//	brute force reference
+		std::vector <std::vector <std::vector <index_t>>> expected (grobSet.size (),
+		                                                            std::vector <std::vector <index_t>> (mesh->num (VERTEX)));
+		for(index_t i = 0; i < grobSet.size (); ++i) {
+			GrobType const grobType = grobSet.grob_type (i);
+			GrobArray const& grobs = mesh->grobs (grobType);
+			for(index_t igrob = 0; igrob < grobs.size (); ++igrob) {
+				auto const grob = grobs [igrob];
+				for(index_t icorner = 0; icorner < grob.num_corners (); ++icorner)
+					expected [i][grob.corner (icorner)].push_back (igrob);
+			}
+		}
+
+		for(index_t ivrt = 0; ivrt < mesh->num (VERTEX); ++ivrt) {
+			index_t numIncidences = 0;
+			for(index_t i = 0; i < grobSet.size (); ++i) {
+				IndexSpan const span = incidence.incidences (ivrt, grobSet.grob_type (i));
+				COND_FAIL (!std::equal (span.begin (), span.end (), expected [i][ivrt].begin (), expected [i][ivrt].end ()),
+				           "Bad incidences of vertex " << ivrt << " in " << filename);
+				numIncidences += static_cast <index_t> (span.size ());
+			}
+			COND_FAIL (numIncidences != incidence.num_incidences (ivrt) || numIncidences != incidence.incidences (ivrt).size (),
+			           "Bad number of incidences of vertex " << ivrt << " in " << filename);
+			COND_FAIL (!incidence.incidences (ivrt, EDGE).empty (), "Incidences of a type outside the grob set were found");
+		}
+
+		COND_FAIL (CachedVertexIncidence (*mesh, grobSet) != CachedVertexIncidence (*mesh, grobSet),
+		           "Cached vertex incidences were rebuilt");
+	}
+
+//	corner indices have to reference existing vertices
+	Mesh invalid;
+	invalid.resize_vertices (3);
+	invalid.set_grobs (GrobArray (TRI, std::vector <index_t> {0, 1, 7}));
+	bool caught = false;
+	try {VertexIncidence (invalid, GrobSet (TRIS));}
+	catch (LumeError&) {caught = true;}
+	COND_FAIL (!caught, "Expected an error for an invalid corner index");
+}
+
+
+static void TestPartitioning ()
+{
+	MeshHierarchy mh (CreateMeshFromFile ("meshes/elems.ugx"));
+	mh.refine ();
+	mh.refine ();
+
+	for(auto const& [mesh, grobSet] : {std::make_pair (mh.top_mesh (), GrobSet (CELLS)),
+	                                   std::make_pair (CreateMeshFromFile ("meshes/sphere.stl"), GrobSet (FACES))})
+	{
+		index_t numGrobs = 0;
+		for(auto const grobType : grobSet)
+			numGrobs += static_cast <index_t> (mesh->num (grobType));
+
+		for(index_t const numPartitions : {1, 4, 7}) {
+			real_t const maxSize = std::max (std::ceil (real_t (numGrobs) / numPartitions),
+			                                 real_t (1.03) * numGrobs / numPartitions);
+
+			PartitionInfo const rcb = PartitionRCB (*mesh, numPartitions, grobSet);
+			auto const [minRCB, maxRCB] = std::minmax_element (rcb.partitionSizes.begin (), rcb.partitionSizes.end ());
+			COND_FAIL (*maxRCB - *minRCB > 1, "Unbalanced RCB partition for " << numPartitions << " partitions");
+
+			PartitionInfo const ml = PartitionMultilevel (*mesh, numPartitions, grobSet);
+			COND_FAIL (*std::max_element (ml.partitionSizes.begin (), ml.partitionSizes.end ()) > maxSize,
+			           "Bad multilevel imbalance " << ml.imbalance << " for " << numPartitions << " partitions");
+			COND_FAIL (ml.edgeCut > rcb.edgeCut * 1.2, "Multilevel edge cut " << ml.edgeCut << " much larger than RCB edge cut " << rcb.edgeCut);
+			COND_FAIL ((numPartitions == 1) != (ml.edgeCut == 0), "Unexpected edge cut " << ml.edgeCut);
+
+			PartitionInfo const info = ComputePartitionInfo (*mesh, numPartitions, grobSet);
+			COND_FAIL (info.edgeCut != ml.edgeCut || info.partitionSizes != ml.partitionSizes,
+			           "Stored partition differs from computed partition");
+			COND_FAIL (std::accumulate (info.partitionSizes.begin (), info.partitionSizes.end (), index_t (0)) != numGrobs,
+			           "Not all grobs were assigned to a partition");
+		}
+	}
+}
+
+
+static void TestExtractPartitions ()
+{
+	MeshHierarchy mh (CreateMeshFromFile ("meshes/elems.ugx"));
+	mh.refine ();
+	mh.refine ();
+	auto mesh = mh.top_mesh ();
+
+	const index_t numPartitions = 4;
+	PartitionMultilevel (*mesh, numPartitions);
+	auto const& coords = mesh->annex (keys::vertexCoords);
+
+	for(index_t numGhostLayers : {0, 1}) {
+		std::vector <SPMesh> const submeshes = ExtractPartitions (*mesh, numPartitions, CELLS, numGhostLayers);
+		COND_FAIL (submeshes.size () != numPartitions, "Bad number of submeshes");
+
+		index_t numOwned = 0;
+		index_t numGhosts = 0;
+		for(index_t p = 0; p < numPartitions; ++p) {
+			Mesh const& submesh = *submeshes [p];
+			auto const& vrtMap = submesh.annex (GlobalIndexAnnexKey (VERTEX));
+			auto const& subCoords = submesh.annex (keys::vertexCoords);
+			COND_FAIL (vrtMap.size () != submesh.num (VERTEX), "Bad size of vertex map");
+			for(index_t i = 0; i < vrtMap.size (); ++i) {
+				COND_FAIL (i > 0 && vrtMap [i] <= vrtMap [i - 1], "Local vertices aren't ordered by their global indices");
+				for(index_t d = 0; d < 3; ++d)
+					COND_FAIL (subCoords [i * 3 + d] != coords [vrtMap [i] * 3 + d], "Bad sliced coordinates");
+			}
+
+		//	owned and ghost cells
+			std::set <index_t> ownedVertices;
+			for(auto const grobType : GrobSet (CELLS)) {
+				if (submesh.num (grobType) == 0)
+					continue;
+				auto const& grobMap = submesh.annex (GlobalIndexAnnexKey (grobType));
+				auto const& subPartition = submesh.annex (PartitionAnnexKey (grobType));
+				auto const& partition = mesh->annex (PartitionAnnexKey (grobType));
+				for(index_t i = 0; i < submesh.num (grobType); ++i) {
+					auto const local = submesh.grobs (grobType)[i];
+					auto const global = mesh->grobs (grobType)[grobMap [i]];
+					for(index_t j = 0; j < local.num_corners (); ++j)
+						COND_FAIL (vrtMap [local.corner (j)] != global.corner (j), "Bad corners of local grob");
+
+					COND_FAIL (subPartition [i] != partition [grobMap [i]], "Bad sliced partition annex");
+					if (subPartition [i] == p) {
+						++numOwned;
+						for(index_t j = 0; j < global.num_corners (); ++j)
+							ownedVertices.insert (global.corner (j));
+					}
+					else
+						++numGhosts;
+				}
+			}
+
+		//	each cell which touches an owned cell is contained in the ghost layer
+			if (numGhostLayers == 1) {
+				index_t numExpected = 0;
+				index_t numContained = 0;
+				for(auto const grobType : GrobSet (CELLS)) {
+					for(auto const& grob : mesh->grobs (grobType)) {
+						bool touches = false;
+						for(index_t j = 0; j < grob.num_corners (); ++j)
+							touches |= ownedVertices.count (grob.corner (j)) > 0;
+						if (touches)
+							++numExpected;
+					}
+					numContained += static_cast <index_t> (submesh.num (grobType));
+				}
+				COND_FAIL (numExpected != numContained, "Bad ghost layer: expected " << numExpected << " cells, found " << numContained);
+			}
+		}
+
+		COND_FAIL (numOwned != mesh->num (CELLS), "Not all cells were extracted exactly once");
+		COND_FAIL ((numGhosts == 0) != (numGhostLayers == 0), "Unexpected number of ghosts " << numGhosts);
+	}
+}
+
+
+static void TestComponents ()
+{
+	auto sphere = CreateMeshFromFile ("meshes/sphere.stl");
+	auto mesh = MergeMeshes ({sphere, sphere, sphere});
+
+	for(index_t connectionDim : {0, 1}) {
+		ComponentInfo const info = LabelComponents (*mesh, TRIS, connectionDim);
+		COND_FAIL (info.numComponents != 3, "Expected 3 components but found " << info.numComponents);
+		for(index_t i = 0; i < info.numComponents; ++i)
+			COND_FAIL (info.componentSizes [i] != sphere->num (TRI), "Bad size of component " << i);
+
+		auto const& components = mesh->annex (ComponentAnnexKey (TRI));
+		for(index_t i = 0; i < components.size (); ++i)
+			COND_FAIL (components [i] != i / sphere->num (TRI), "Bad component of triangle " << i);
+	}
+
+	auto const parts = SplitComponents (*mesh, FACES);
+	COND_FAIL (parts.size () != 3, "Bad number of split meshes");
+	for(auto const& part : parts) {
+		COND_FAIL (part->num (VERTEX) != sphere->num (VERTEX) || part->num (TRI) != sphere->num (TRI),
+		           "Bad size of split mesh");
+		COND_FAIL (!IsClosedManifoldMesh (*part), "Split mesh should be closed and manifold");
+	}
+
+//	cells which only share vertices or edges are separate components if connected through faces
+	auto elems = CreateMeshFromFile ("meshes/elems.ugx");
+	ComponentInfo const byVertices = LabelComponents (*elems, CELLS, 0);
+	ComponentInfo const byFaces = LabelComponents (*elems, CELLS, 2);
+	COND_FAIL (byVertices.numComponents == 0 || byFaces.numComponents < byVertices.numComponents,
+	           "Bad number of components: " << byVertices.numComponents << " and " << byFaces.numComponents);
+}
+
+
+static void TestGrobColoring ()
+{
+	MeshHierarchy mh (CreateMeshFromFile ("meshes/elems.ugx"));
+	mh.refine ();
+	mh.refine ();
+
+	for(auto const& [mesh, grobSet] : {std::make_pair (mh.top_mesh (), GrobSet (CELLS)),
+	                                   std::make_pair (CreateMeshFromFile ("meshes/sphere.stl"), GrobSet (TRIS))})
+	{
+		GrobColoring const& coloring = *CachedGrobColoring (*mesh, grobSet);
+		COND_FAIL (coloring.num_colors () == 0, "No colors were created");
+
+	//	each grob has exactly one color and grobs of the same color don't share vertices
+		index_t numGrobs = 0;
+		for(index_t color = 0; color < coloring.num_colors (); ++color) {
+			std::vector <char> touched (mesh->num (VERTEX), 0);
+			for(auto const grobType : grobSet) {
+				for(index_t const igrob : coloring.grobs (color, grobType)) {
+					auto const grob = mesh->grobs (grobType)[igrob];
+					for(index_t i = 0; i < grob.num_corners (); ++i) {
+						COND_FAIL (touched [grob.corner (i)], "Grobs of color " << color << " share a vertex");
+						touched [grob.corner (i)] = 1;
+					}
+				}
+			}
+			numGrobs += coloring.num_grobs (color);
+		}
+		COND_FAIL (numGrobs != mesh->num (grobSet), "Not all grobs were colored");
+
+	//	unsynchronized scatter to the corners
+		std::vector <index_t> valences (mesh->num (VERTEX), 0);
+		parallel_for_colored (*mesh, grobSet, [&] (GrobIndex const gi) {
+			auto const grob = mesh->grobs (gi.grob_type ())[gi.index ()];
+			for(index_t i = 0; i < grob.num_corners (); ++i)
+				++valences [grob.corner (i)];
+		});
+
+		VertexIncidence const incidence (*mesh, grobSet);
+		for(index_t i = 0; i < mesh->num (VERTEX); ++i)
+			COND_FAIL (valences [i] != incidence.num_incidences (i), "Bad valence of vertex " << i);
+	}
+}
+
+
+static void TestOrientFacesConsistently ()
+{
+	auto sphere = CreateMeshFromFile ("meshes/sphere.stl");
+	auto mesh = MergeMeshes ({sphere, sphere});
+	auto& tris = mesh->grobs (TRI);
+
+//	flip every third triangle and all triangles of the second sphere
+	for(index_t i = 0; i < tris.size (); ++i) {
+		if ((i % 3 == 0) != (i >= sphere->num (TRI))) {
+			auto tri = tris [i];
+			const index_t c = tri.corner (1);
+			tri.set_corner (1, tri.corner (2));
+			tri.set_corner (2, c);
+		}
+	}
+
+	OrientationInfo const info = OrientFacesConsistently (*mesh);
+	COND_FAIL (info.numComponents != 2, "Expected 2 components but found " << info.numComponents);
+	COND_FAIL (!info.nonOrientableComponents.empty (), "Spheres should be orientable");
+	COND_FAIL (info.numFlippedFaces == 0, "No faces were flipped");
+
+//	each directed edge is traversed exactly once and the spheres have positive volume
+	std::set <std::pair <index_t, index_t>> directedEdges;
+	auto const& coords = mesh->annex (keys::vertexCoords);
+	double volume = 0;
+	for(auto const& tri : mesh->grobs (TRI)) {
+		for(index_t i = 0; i < 3; ++i) {
+			bool const inserted = directedEdges.emplace (tri.corner (i), tri.corner ((i + 1) % 3)).second;
+			COND_FAIL (!inserted, "Inconsistently oriented triangles");
+		}
+		real_t const* p0 = coords.data () + 3 * tri.corner (0);
+		real_t const* p1 = coords.data () + 3 * tri.corner (1);
+		real_t const* p2 = coords.data () + 3 * tri.corner (2);
+		volume += p0 [0] * (p1 [1] * p2 [2] - p1 [2] * p2 [1])
+		          - p0 [1] * (p1 [0] * p2 [2] - p1 [2] * p2 [0])
+		          + p0 [2] * (p1 [0] * p2 [1] - p1 [1] * p2 [0]);
+	}
+	COND_FAIL (volume <= 0, "Spheres should have positive volume after orientation");
+
+//	a moebius strip can't be oriented and is left unchanged
+	const index_t n = 6;
+	Mesh moebius;
+	moebius.resize_vertices (2 * n);
+	std::vector <index_t> quads;
+	for(index_t i = 0; i + 1 < n; ++i)
+		quads.insert (quads.end (), {i, n + i, n + i + 1, i + 1});
+	quads.insert (quads.end (), {n - 1, 2 * n - 1, 0, n});
+	moebius.set_grobs (GrobArray (QUAD, std::vector <index_t> (quads)));
+
+	OrientationInfo const moebiusInfo = OrientFacesConsistently (moebius);
+	COND_FAIL (moebiusInfo.nonOrientableComponents.size () != 1, "Moebius strip wasn't reported as non-orientable");
+	COND_FAIL (moebiusInfo.numFlippedFaces != 0 || !std::equal (quads.begin (), quads.end (), moebius.grobs (QUAD).data ()),
+	           "Non-orientable component was modified");
+}
+
+
+static void TestFeatureEdges ()
+{
+//	unit cube. Vertex i is located at (i & 1, (i >> 1) & 1, (i >> 2) & 1)
+	Mesh cube;
+	cube.resize_vertices (8);
+	std::vector <real_t> coords;
+	for(index_t i = 0; i < 8; ++i)
+		coords.insert (coords.end (), {real_t (i & 1), real_t ((i >> 1) & 1), real_t ((i >> 2) & 1)});
+	cube.set_annex (keys::vertexCoords, RealArrayAnnex (3, std::move (coords)));
+	cube.set_grobs (GrobArray (QUAD, std::vector <index_t> {0, 2, 3, 1,  4, 5, 7, 6,  0, 1, 5, 4,
+	                                                         2, 6, 7, 3,  0, 4, 6, 2,  1, 3, 7, 5}));
+
+	FeatureEdges const cubeEdges = ExtractFeatureEdges (cube, 30);
+	COND_FAIL (cubeEdges.edges.size () != 12, "Expected 12 feature edges but found " << cubeEdges.edges.size ());
+	for(size_t i = 0; i < cubeEdges.types.size (); ++i) {
+		COND_FAIL (cubeEdges.types [i] != FeatureEdgeType::Sharp, "Cube edges should be sharp");
+		COND_FAIL (std::abs (cubeEdges.dihedralAngles [i] - 90) > 1.e-3,
+		           "Bad dihedral angle: " << cubeEdges.dihedralAngles [i]);
+	}
+//	all vertices are incident to 3 feature edges, so each edge forms its own curve
+	COND_FAIL (cubeEdges.num_curves () != 12, "Expected 12 curves but found " << cubeEdges.num_curves ());
+	COND_FAIL (cubeEdges.curveVertices.size () != 24, "Bad number of curve vertices");
+
+	COND_FAIL (ExtractFeatureEdges (cube, 95).edges.size () != 0, "No edge exceeds 95 degrees");
+
+//	a flat 2x2 grid of quads has a single closed boundary curve
+	Mesh grid;
+	grid.resize_vertices (9);
+	coords.clear ();
+	for(index_t i = 0; i < 9; ++i)
+		coords.insert (coords.end (), {real_t (i % 3), real_t (i / 3), 0});
+	grid.set_annex (keys::vertexCoords, RealArrayAnnex (3, std::move (coords)));
+	grid.set_grobs (GrobArray (QUAD, std::vector <index_t> {0, 1, 4, 3,  1, 2, 5, 4,  3, 4, 7, 6,  4, 5, 8, 7}));
+
+	FeatureEdges const gridEdges = ExtractFeatureEdges (grid, 1);
+	COND_FAIL (gridEdges.edges.size () != 8, "Expected 8 boundary edges but found " << gridEdges.edges.size ());
+	COND_FAIL (std::count (gridEdges.types.begin (), gridEdges.types.end (), FeatureEdgeType::Boundary) != 8,
+	           "Grid edges should be boundary edges");
+	COND_FAIL (gridEdges.num_curves () != 1, "Expected 1 curve but found " << gridEdges.num_curves ());
+	COND_FAIL (gridEdges.curveVertices.size () != 9 || gridEdges.curveVertices.front () != gridEdges.curveVertices.back (),
+	           "Boundary curve should be closed");
+	COND_FAIL (ExtractFeatureEdges (grid, 1, false).edges.size () != 0, "Boundary edges weren't excluded");
+
+//	the sphere is closed and smooth
+	auto sphere = CreateMeshFromFile ("meshes/sphere.stl");
+	COND_FAIL (ExtractFeatureEdges (*sphere, 30).edges.size () != 0, "Sphere shouldn't have feature edges");
+}
+
+
+static void TestEdgeMesh2d ()
+{
+//	a 3x3 grid of vertices, where each quad is split into two triangles along (i, i + 4)
+	std::vector <std::array <double, 2>> positions;
+	for(index_t i = 0; i < 9; ++i)
+		positions.push_back ({double (i % 3), double (i / 3)});
+
+	std::vector <index_t> triCorners;
+	for(index_t y = 0; y < 2; ++y) {
+		for(index_t x = 0; x < 2; ++x) {
+			index_t const i = x + 3 * y;
+			triCorners.insert (triCorners.end (), {i, i + 1, i + 4,  i, i + 4, i + 3});
+		}
+	}
+
+	auto edgeMesh = EdgeMesh2d::fromTrianglesCCW (GrobArray (TRI, std::move (triCorners)), positions);
+	COND_FAIL (edgeMesh.num_vertices () != 9, "Bad number of vertices: " << edgeMesh.num_vertices ());
+	COND_FAIL (edgeMesh.connections (4).size () != 6, "Center vertex should have 6 connections");
+	COND_FAIL (edgeMesh.create_triangles ().size () != 8, "Expected 8 triangles");
+
+	COND_FAIL (edgeMesh.swap_edge ({0, 1}), "Boundary edges can't be swapped");
+	COND_FAIL (!edgeMesh.swap_edge ({0, 4}), "Edge (0, 4) couldn't be swapped");
+	COND_FAIL (edgeMesh.has_edge ({0, 4}) || !edgeMesh.has_edge ({3, 1}), "Edge swap had no effect");
+	COND_FAIL (edgeMesh.create_triangles ().size () != 8, "Expected 8 triangles after swap");
+
+//	a fan around a center vertex. The many insertions at the center force relocations of its slots.
+	const index_t n = 40;
+	EdgeMesh2d fan ([n] (index_t i) {
+		if (i == n)
+			return std::make_tuple (0., 0.);
+		double const a = 2. * 3.14159265358979323846 * i / n;
+		return std::make_tuple (std::cos (a), std::sin (a));
+	});
+
+	for(index_t i = 0; i < n; ++i) {
+		COND_FAIL (!fan.add_edge ({n, i}), "Couldn't add edge");
+		COND_FAIL (!fan.add_edge ({i, (i + 1) % n}, EdgeMesh2d::Boundary::Right), "Couldn't add edge");
+	}
+	COND_FAIL (fan.add_edge ({0, n}), "Duplicate edge was added");
+
+	auto const centerCons = fan.connections (n);
+	COND_FAIL (centerCons.size () != n, "Center vertex should have " << n << " connections");
+	for(size_t i = 1; i < centerCons.size (); ++i)
+		COND_FAIL (centerCons [i - 1].pseudoAngle > centerCons [i].pseudoAngle, "Connections aren't sorted");
+	COND_FAIL (fan.create_triangles ().size () != n, "Expected " << n << " triangles");
+
+	fan.remove_edge ({n, 0});
+	COND_FAIL (fan.has_edge ({0, n}) || fan.connections (n).size () != n - 1, "Edge wasn't removed");
+}
+
+
+static void TestDelaunay ()
+{
+	auto orient = [] (real_t const* a, real_t const* b, real_t const* c) {
+		return (double (b [0]) - a [0]) * (double (c [1]) - a [1]) - (double (b [1]) - a [1]) * (double (c [0]) - a [0]);
+	};
+
+//	checks orientation and covered area and that all unconstrained edges are locally Delaunay
+	auto checkDelaunay = [&orient] (GrobArray const& tris, RealArrayAnnex const& coords, double const expectedArea,
+	                                std::set <std::pair <index_t, index_t>> const& constrained)
+	{
+		double area = 0;
+		std::map <std::pair <index_t, index_t>, index_t> opposite;
+		for(auto const& tri : tris) {
+			double const a = orient (coords.data () + 2 * tri.corner (0),
+			                         coords.data () + 2 * tri.corner (1),
+			                         coords.data () + 2 * tri.corner (2));
+			COND_FAIL (a <= 0, "Triangle isn't counterclockwise oriented");
+			area += 0.5 * a;
+			for(index_t i = 0; i < 3; ++i)
+				opposite [{tri.corner (i), tri.corner ((i + 1) % 3)}] = tri.corner ((i + 2) % 3);
+		}
+		COND_FAIL (std::abs (area - expectedArea) > 1.e-3 * expectedArea,
+		           "Triangles cover an area of " << area << " instead of " << expectedArea);
+
+		for(auto const& entry : opposite) {
+			index_t const v0 = entry.first.first;
+			index_t const v1 = entry.first.second;
+			auto const twin = opposite.find ({v1, v0});
+			if (twin == opposite.end () || constrained.count ({std::min (v0, v1), std::max (v0, v1)}))
+				continue;
+
+			real_t const* p [3] = {coords.data () + 2 * v0, coords.data () + 2 * v1, coords.data () + 2 * entry.second};
+			double const dx = coords [2 * twin->second], dy = coords [2 * twin->second + 1];
+			double const adx = p [0][0] - dx, ady = p [0][1] - dy;
+			double const bdx = p [1][0] - dx, bdy = p [1][1] - dy;
+			double const cdx = p [2][0] - dx, cdy = p [2][1] - dy;
+			double const det = (adx * adx + ady * ady) * (bdx * cdy - bdy * cdx)
+			                 + (bdx * bdx + bdy * bdy) * (cdx * ady - cdy * adx)
+			                 + (cdx * cdx + cdy * cdy) * (adx * bdy - ady * bdx);
+			COND_FAIL (det > 1.e-4, "Edge (" << v0 << ", " << v1 << ") isn't locally Delaunay");
+		}
+	};
+
+//	random points in the unit square, including its corners
+	std::mt19937 rng (5);
+	std::uniform_real_distribution <real_t> dist (0, 1);
+	std::vector <real_t> randomCoords {0, 0,  1, 0,  0, 1,  1, 1};
+	for(index_t i = 0; i < 2000; ++i)
+		randomCoords.insert (randomCoords.end (), {dist (rng), dist (rng)});
+	RealArrayAnnex const randomPoints (2, std::move (randomCoords));
+
+	GrobArray const randomTris = DelaunayTriangulation (randomPoints);
+//	the convex hull consists of the 4 corners
+	COND_FAIL (randomTris.size () != 2 * randomPoints.num_tuples () - 6, "Bad number of triangles: " << randomTris.size ());
+	checkDelaunay (randomTris, randomPoints, 1, {});
+
+//	a regular 10x10 grid with collinear and cocircular points
+	const index_t n = 10;
+	std::vector <real_t> gridCoords;
+	for(index_t i = 0; i < n * n; ++i)
+		gridCoords.insert (gridCoords.end (), {real_t (i % n), real_t (i / n)});
+	RealArrayAnnex const gridPoints (2, std::move (gridCoords));
+
+	GrobArray const gridTris = DelaunayTriangulation (gridPoints);
+	COND_FAIL (gridTris.size () != 2 * (n - 1) * (n - 1), "Bad number of grid triangles: " << gridTris.size ());
+	checkDelaunay (gridTris, gridPoints, 81, {});
+
+//	the first constrained edge passes through the grid points (3, 1) and (6, 2)
+	GrobArray const constraints (EDGE, std::vector <index_t> {0, 3 * n + 9,  9 * n, 5 * n + 9});
+	GrobArray const cdtTris = DelaunayTriangulation (gridPoints, constraints);
+	COND_FAIL (cdtTris.size () != 2 * (n - 1) * (n - 1), "Bad number of constrained triangles: " << cdtTris.size ());
+
+	std::set <std::pair <index_t, index_t>> cdtEdges;
+	for(auto const& tri : cdtTris) {
+		for(index_t i = 0; i < 3; ++i)
+			cdtEdges.emplace (std::min (tri.corner (i), tri.corner ((i + 1) % 3)), std::max (tri.corner (i), tri.corner ((i + 1) % 3)));
+	}
+
+	std::set <std::pair <index_t, index_t>> const constrained {{0, n + 3}, {n + 3, 2 * n + 6}, {2 * n + 6, 3 * n + 9}, {5 * n + 9, 9 * n}};
+	for(auto const& edge : constrained)
+		COND_FAIL (cdtEdges.count (edge) == 0, "Constrained edge (" << edge.first << ", " << edge.second << ") is missing");
+	checkDelaunay (cdtTris, gridPoints, 81, constrained);
+
+//	a perturbed grid, where all quads are split along the same diagonal
+	auto mesh = std::make_shared <Mesh> ();
+	std::vector <real_t> meshCoords;
+	std::uniform_real_distribution <real_t> perturbation (-0.3f, 0.3f);
+	for(index_t i = 0; i < n * n; ++i) {
+		bool const boundary = i % n == 0 || i % n == n - 1 || i / n == 0 || i / n == n - 1;
+		meshCoords.insert (meshCoords.end (), {real_t (i % n) + (boundary ? 0 : perturbation (rng)),
+		                                       real_t (i / n) + (boundary ? 0 : perturbation (rng))});
+	}
+	mesh->resize_vertices (n * n);
+	mesh->set_annex (keys::vertexCoords, RealArrayAnnex (2, std::move (meshCoords)));
+
+	std::vector <index_t> triCorners;
+	for(index_t y = 0; y + 1 < n; ++y) {
+		for(index_t x = 0; x + 1 < n; ++x) {
+			index_t const i = x + n * y;
+			triCorners.insert (triCorners.end (), {i, i + 1, i + n + 1,  i, i + n + 1, i + n});
+		}
+	}
+	mesh->set_grobs (GrobArray (TRI, std::move (triCorners)));
+
+	COND_FAIL (MakeDelaunay (*mesh) == 0, "No edges were flipped");
+	COND_FAIL (mesh->num (TRI) != 2 * (n - 1) * (n - 1), "Number of triangles changed");
+	checkDelaunay (mesh->grobs (TRI), mesh->annex (keys::vertexCoords), 81, {});
+	COND_FAIL (MakeDelaunay (*mesh) != 0, "Delaunay mesh shouldn't require flips");
+}
+
+
+static void TestHalfEdgeMesh ()
+{
+	auto sphere = CreateMeshFromFile ("meshes/sphere.stl");
+	HalfEdgeMesh const sphereHE (*sphere);
+
+	COND_FAIL (!sphereHE.is_manifold (), "Sphere should be manifold");
+	COND_FAIL (sphereHE.num_half_edges () != 3 * sphere->num (TRI), "Bad number of half-edges");
+	for(index_t h = 0; h < sphereHE.num_half_edges (); ++h) {
+		index_t const twin = sphereHE.twin (h);
+		COND_FAIL (twin == NO_INDEX, "Closed surfaces don't have boundary half-edges");
+		COND_FAIL (sphereHE.twin (twin) != h || sphereHE.vertex (twin) != sphereHE.dest (h), "Bad twin");
+		COND_FAIL (sphereHE.next (sphereHE.prev (h)) != h, "prev and next don't match");
+	}
+
+	index_t numOneRingVertices = 0;
+	for(index_t v = 0; v < sphereHE.num_vertices (); ++v)
+		sphereHE.for_each_neighbor (v, [&] (index_t) {++numOneRingVertices;});
+	COND_FAIL (numOneRingVertices != sphereHE.num_half_edges (), "Each edge should be visited from both sides");
+
+	GrobArray const tris = sphereHE.grobs (TRI);
+	COND_FAIL (!std::equal (tris.data (), tris.data () + 3 * tris.size (), sphere->grobs (TRI).data ()),
+	           "Triangles weren't reconstructed losslessly");
+
+//	an open 3x3 grid of quads
+	const index_t n = 4;
+	std::vector <index_t> quadCorners;
+	for(index_t y = 0; y + 1 < n; ++y) {
+		for(index_t x = 0; x + 1 < n; ++x) {
+			index_t const i = x + n * y;
+			quadCorners.insert (quadCorners.end (), {i, i + 1, i + n + 1, i + n});
+		}
+	}
+	GrobArray const quads (QUAD, std::vector <index_t> (quadCorners));
+	HalfEdgeMesh const grid (GrobArray (TRI), quads, n * n);
+
+	COND_FAIL (!grid.is_manifold (), "Grid should be manifold");
+	index_t numBoundary = 0;
+	for(index_t h = 0; h < grid.num_half_edges (); ++h)
+		numBoundary += grid.is_boundary (h);
+	COND_FAIL (numBoundary != 4 * (n - 1), "Expected " << 4 * (n - 1) << " boundary half-edges but found " << numBoundary);
+
+	std::vector <index_t> ring;
+	grid.for_each_neighbor (0, [&] (index_t const w) {ring.push_back (w);});
+	COND_FAIL (ring != std::vector <index_t> ({1, n}), "Bad one-ring of corner vertex");
+	ring.clear ();
+	grid.for_each_neighbor (n + 1, [&] (index_t const w) {ring.push_back (w);});
+	COND_FAIL (ring.size () != 4, "Inner vertex should have 4 neighbors");
+
+	index_t numCornerFaces = 0;
+	grid.for_each_outgoing (1, [&] (index_t) {++numCornerFaces;});
+	COND_FAIL (numCornerFaces != 2, "Boundary vertex 1 should have 2 faces");
+	COND_FAIL (!std::equal (quadCorners.begin (), quadCorners.end (), grid.grobs (QUAD).data ()),
+	           "Quadrilaterals weren't reconstructed losslessly");
+
+//	three triangles sharing an edge and two triangles touching at a vertex
+	HalfEdgeMesh const fin (GrobArray (TRI, std::vector <index_t> {0, 1, 2,  1, 0, 3,  0, 1, 4}), GrobArray (QUAD), 5);
+	COND_FAIL (fin.non_manifold_half_edges ().size () != 3, "Shared edge should be non-manifold");
+
+	HalfEdgeMesh const bowtie (GrobArray (TRI, std::vector <index_t> {0, 1, 2,  0, 3, 4}), GrobArray (QUAD), 5);
+	COND_FAIL (bowtie.non_manifold_vertices () != std::vector <index_t> ({0}), "Vertex 0 should be non-manifold");
+	COND_FAIL (!bowtie.non_manifold_half_edges ().empty (), "Bowtie doesn't have non-manifold edges");
+}
+
+
+static void TestSmoothing ()
+{
+	std::mt19937 rng (7);
+	std::uniform_real_distribution <real_t> noise (-0.02f, 0.02f);
+
+//	returns the mean and the standard deviation of the distances of the vertices to their centroid
+	auto radiusStats = [] (Mesh const& mesh) {
+		auto const& coords = mesh.annex (keys::vertexCoords);
+		const index_t numVertices = static_cast <index_t> (mesh.num (VERTEX));
+		double center [3] = {0, 0, 0};
+		for(index_t i = 0; i < numVertices; ++i) {
+			for(index_t k = 0; k < 3; ++k)
+				center [k] += coords [3 * i + k] / numVertices;
+		}
+		double sum = 0, sumSq = 0;
+		for(index_t i = 0; i < numVertices; ++i) {
+			double r = 0;
+			for(index_t k = 0; k < 3; ++k)
+				r += (coords [3 * i + k] - center [k]) * (coords [3 * i + k] - center [k]);
+			r = std::sqrt (r);
+			sum += r;
+			sumSq += r * r;
+		}
+		double const mean = sum / numVertices;
+		return std::make_pair (mean, std::sqrt (std::max (0., sumSq / numVertices - mean * mean)));
+	};
+
+	auto noisySphere = [&] () {
+		auto sphere = CreateMeshFromFile ("meshes/sphere.stl");
+		auto& coords = sphere->annex (keys::vertexCoords);
+		auto const radius = radiusStats (*sphere).first;
+		for(index_t i = 0; i < coords.num_tuples (); ++i) {
+			real_t const s = 1 + noise (rng);
+			for(index_t k = 0; k < 3; ++k)
+				coords [3 * i + k] *= s;
+		}
+		COND_FAIL (radiusStats (*sphere).second < 0.005 * radius, "Noise wasn't applied");
+		return sphere;
+	};
+
+	auto const original = radiusStats (*CreateMeshFromFile ("meshes/sphere.stl"));
+
+	SmoothingOptions laplace;
+	laplace.numIterations = 20;
+	auto laplaceSphere = noisySphere ();
+	auto const noisy = radiusStats (*laplaceSphere);
+	SmoothVertices (*laplaceSphere, TRIS, laplace);
+	auto const laplaceStats = radiusStats (*laplaceSphere);
+	COND_FAIL (laplaceStats.second > 0.5 * noisy.second, "Laplacian smoothing didn't reduce the noise");
+
+	SmoothingOptions taubin = laplace;
+	taubin.mu = -0.53f;
+	auto taubinSphere = noisySphere ();
+	SmoothVertices (*taubinSphere, TRIS, taubin);
+	auto const taubinStats = radiusStats (*taubinSphere);
+	COND_FAIL (taubinStats.second > 0.5 * noisy.second, "Taubin smoothing didn't reduce the noise");
+	COND_FAIL (std::abs (taubinStats.first - original.first) > 0.5 * std::abs (laplaceStats.first - original.first),
+	           "Taubin smoothing should shrink less than Laplacian smoothing");
+
+//	cotangent weights with a pinned vertex
+	SmoothingOptions cotan = laplace;
+	cotan.weights = SmoothingWeights::Cotangent;
+	auto cotanSphere = noisySphere ();
+	auto& pinMask = cotanSphere->set_annex (TypedAnnexKey <IndexArrayAnnex> (cotan.pinMaskName, VERTEX),
+	                                        IndexArrayAnnex (1, std::vector <index_t> (cotanSphere->num (VERTEX), 0)));
+	pinMask [0] = 1;
+	std::vector <real_t> const pinnedCoord (cotanSphere->annex (keys::vertexCoords).data (),
+	                                        cotanSphere->annex (keys::vertexCoords).data () + 3);
+	SmoothVertices (*cotanSphere, TRIS, cotan);
+	COND_FAIL (radiusStats (*cotanSphere).second > 0.5 * noisy.second, "Cotangent smoothing didn't reduce the noise");
+	COND_FAIL (!std::equal (pinnedCoord.begin (), pinnedCoord.end (), cotanSphere->annex (keys::vertexCoords).data ()),
+	           "Pinned vertex was moved");
+
+//	boundary vertices of a plane with noisy heights are pinned
+	const index_t n = 10;
+	Mesh grid;
+	grid.resize_vertices (n * n);
+	std::vector <real_t> gridCoords;
+	for(index_t i = 0; i < n * n; ++i)
+		gridCoords.insert (gridCoords.end (), {real_t (i % n), real_t (i / n), noise (rng)});
+	grid.set_annex (keys::vertexCoords, RealArrayAnnex (3, std::vector <real_t> (gridCoords)));
+
+	std::vector <index_t> quadCorners;
+	for(index_t y = 0; y + 1 < n; ++y) {
+		for(index_t x = 0; x + 1 < n; ++x)
+			quadCorners.insert (quadCorners.end (), {x + n * y, x + 1 + n * y, x + 1 + n * (y + 1), x + n * (y + 1)});
+	}
+	grid.set_grobs (GrobArray (QUAD, std::move (quadCorners)));
+
+	SmoothVertices (grid, FACES, laplace);
+	auto const& smoothed = grid.annex (keys::vertexCoords);
+	real_t maxInnerHeight = 0;
+	for(index_t i = 0; i < n * n; ++i) {
+		bool const boundary = i % n == 0 || i % n == n - 1 || i / n == 0 || i / n == n - 1;
+		if (boundary) {
+			COND_FAIL (!std::equal (smoothed.data () + 3 * i, smoothed.data () + 3 * i + 3, gridCoords.data () + 3 * i),
+			           "Boundary vertex " << i << " was moved");
+		}
+		else
+			maxInnerHeight = std::max (maxInnerHeight, std::abs (smoothed [3 * i + 2]));
+	}
+	COND_FAIL (maxInnerHeight > 0.02f, "Inner vertices weren't smoothed");
+}
+
+
+static void TestMeshHierarchy ()
+{
+	MeshHierarchy mh (CreateMeshFromFile ("meshes/elems.ugx"));
+	mh.refine ();
+	mh.refine ();
+
+	COND_FAIL (mh.num_levels () != 3, "Unexpected number of levels: " << mh.num_levels ());
+
+	for(size_t lvl = 1; lvl < mh.num_levels (); ++lvl) {
+	//	prolongated coordinates have to match the coordinates of the refined mesh
+		RealArrayAnnex prolongatedCoords (3);
+		mh.prolongate_annex (lvl, mh.mesh (lvl - 1)->annex (keys::vertexCoords), VERTEX,
+		                     prolongatedCoords, VERTEX);
+
+		auto const& coords = mh.mesh (lvl)->annex (keys::vertexCoords);
+		COND_FAIL (prolongatedCoords.size () != coords.size (), "Bad size of prolongated coordinates");
+		for(size_t i = 0; i < coords.size (); ++i) {
+			COND_FAIL (std::abs (prolongatedCoords [i] - coords [i]) > 1.e-5,
+			           "Prolongated coordinate doesn't match coordinate of refined mesh");
+		}
+
+	//	injection has to restore the coordinates of the coarse mesh
+		RealArrayAnnex restrictedCoords (3);
+		mh.restrict_annex (lvl - 1, coords, VERTEX, restrictedCoords, VERTEX, RestrictionType::Injection);
+		auto const& coarseCoords = mh.mesh (lvl - 1)->annex (keys::vertexCoords);
+		for(size_t i = 0; i < coarseCoords.size (); ++i) {
+			COND_FAIL (restrictedCoords [i] != coarseCoords [i], "Injected coordinate doesn't match");
+		}
+	}
+
+//	element values are copied to children and averaged during restriction
+	const TypedAnnexKey <RealArrayAnnex> key ("value", HEX);
+	auto& values = mh.mesh (0)->set_annex (key, RealArrayAnnex (1, real_t (0)));
+	for(size_t i = 0; i < values.size (); ++i)
+		values [i] = real_t (i + 1);
+
+	mh.prolongate_annex (key, 1);
+	mh.prolongate_annex (key, 2);
+
+	auto const& fineValues = mh.mesh (2)->annex (key);
+	COND_FAIL (fineValues.size () != mh.mesh (2)->num (HEX), "Bad size of prolongated element annex");
+	for(index_t i = 0; i < fineValues.size (); ++i) {
+		const GrobIndex parent = mh.parent (2, GrobIndex (HEX, i));
+		COND_FAIL (!parent.valid () || parent.grob_type () != HEX, "Invalid parent");
+		const GrobIndex grandParent = mh.parent (1, parent);
+		COND_FAIL (fineValues [i] != values [grandParent.index ()], "Bad prolongated element value");
+
+		const index_t firstChild = mh.first_child (1, parent, HEX);
+		COND_FAIL (i < firstChild || i >= firstChild + mh.num_children (1, parent, HEX),
+		           "Child is not contained in the children of its parent");
+	}
+
+	mh.mesh (0)->remove_annex (key);
+	mh.restrict_annex (key, 1, RestrictionType::Average);
+	mh.restrict_annex (key, 0, RestrictionType::Average);
+
+	auto const& restrictedValues = mh.mesh (0)->annex (key);
+	for(size_t i = 0; i < restrictedValues.size (); ++i) {
+		COND_FAIL (restrictedValues [i] != real_t (i + 1), "Bad restricted element value");
+	}
+
+//	integral annexes are supported, too
+	const TypedAnnexKey <IndexArrayAnnex> indexKey ("index", HEX);
+	auto& indices = mh.mesh (0)->set_annex (indexKey, IndexArrayAnnex (1, index_t (0)));
+	for(index_t i = 0; i < indices.size (); ++i)
+		indices [i] = i;
+
+	mh.prolongate_annex (indexKey, 1);
+	mh.mesh (0)->remove_annex (indexKey);
+	mh.restrict_annex (indexKey, 0, RestrictionType::Transposed);
+
+	auto const& restrictedIndices = mh.mesh (0)->annex (indexKey);
+	for(index_t i = 0; i < restrictedIndices.size (); ++i) {
+		COND_FAIL (restrictedIndices [i] != i * mh.num_children (0, GrobIndex (HEX, i), HEX),
+		           "Bad restricted index value");
+	}
+}
+
+
 namespace impl {
 	void TestParallelFor (const size_t size, const int minBlockSize = 0)
 	{
@@ -904,14 +2703,42 @@ bool RunTests ()
 	RUN_TEST_ON_MESHES(testStats, TestConsistentTopology, topologymeshes);
 	RUN_TEST_ON_MESHES(testStats, TestFillGrobToIndexMap, topologymeshes);
 	RUN_TEST_ON_MESHES(testStats, TestGrobToIndexMapSideLookup, topologymeshes);
+	RUN_TEST_ON_MESHES(testStats, TestGrobSides, topologymeshes);
 	RUN_TEST(testStats, TestGrobValences);
 	RUN_TEST_ON_MESHES(testStats, TestFillLowerDimNeighborOffsetMap, topologymeshes);
 	RUN_TEST_ON_MESHES(testStats, TestFillHigherDimNeighborOffsetMap, topologymeshes);
 	RUN_TEST_ON_MESHES(testStats, TestNeighborhoods, topologymeshes);
     RUN_TEST(testStats, TestComputeFaceVertexNormals3);
+	RUN_TEST(testStats, TestComputeVertexNormals3);
 	RUN_TEST(testStats, TestFaceNeighbors);
 	RUN_TEST(testStats, TestCreateRimMesh);
 	RUN_TEST(testStats, TestSubsets);
+	RUN_TEST(testStats, TestRefineTriangles);
+	RUN_TEST(testStats, TestRefineMesh);
+	RUN_TEST(testStats, TestRefinementAnnexTransfer);
+	RUN_TEST(testStats, TestMeshHierarchy);
+	RUN_TEST(testStats, TestAdaptiveRefinement);
+	RUN_TEST(testStats, TestAdaptiveTetRefinement);
+	RUN_TEST(testStats, TestDecimateTriangles);
+	RUN_TEST(testStats, TestBVH);
+	RUN_TEST(testStats, TestPointLocator);
+	RUN_TEST(testStats, TestSpatialIndex);
+	RUN_TEST(testStats, TestWeldVertices);
+	RUN_TEST(testStats, TestMergeMeshes);
+	RUN_TEST(testStats, TestQuality);
+	RUN_TEST(testStats, TestFixedSizeTupleViews);
+	RUN_TEST(testStats, TestDerivedDataCache);
+	RUN_TEST(testStats, TestVertexIncidence);
+	RUN_TEST(testStats, TestPartitioning);
+	RUN_TEST(testStats, TestExtractPartitions);
+	RUN_TEST(testStats, TestComponents);
+	RUN_TEST(testStats, TestGrobColoring);
+	RUN_TEST(testStats, TestOrientFacesConsistently);
+	RUN_TEST(testStats, TestFeatureEdges);
+	RUN_TEST(testStats, TestEdgeMesh2d);
+	RUN_TEST(testStats, TestDelaunay);
+	RUN_TEST(testStats, TestHalfEdgeMesh);
+	RUN_TEST(testStats, TestSmoothing);
 	RUN_TEST(testStats, TestParallelFor);
 
 	// RUN_TEST_ON_MESHES(testStats, TestFaceCellNeighborhoods, largeMeshes);
@@ -55,9 +55,7 @@ public:
             return RunResult::Done;
 
         meshContent->set_status (lumeview::mesh::Status::Refining);
-        auto refinedMesh = lume::RefineTriangles (mesh);
-
-        // todo: transfer annex data from mesh to refinedMesh
+        auto refinedMesh = lume::RefineMesh (mesh, lume::AnnexTransfer ());
 
         meshContent->set_mesh (refinedMesh);
         return RunResult::Done;